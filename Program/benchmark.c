@@ -0,0 +1,828 @@
+/*
+ * End-to-End Benchmark Suite for the Logic Solver
+ * Builds a reproducible corpus, runs every engine configuration on it and
+ * compares the timings against a stored baseline
+ */
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <windows.h>
+#else
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+// Configuration constants
+#define MAX_PATH_LEN 512
+#define MAX_NAME_LEN 96
+#define MAX_INSTANCES 256
+#define MAX_REPEATS 100
+#define MAX_OUTPUT 65536
+#define MAX_LINE 1024
+#define DEFAULT_REPEATS 3
+#define DEFAULT_TIMEOUT 10.0
+#define DEFAULT_THRESHOLD 10.0
+#define DEFAULT_LEVELS 3
+#define NOISE_FLOOR_SECONDS 0.005
+#define RANDOM_3SAT_RATIO 4.26
+
+#ifdef _WIN32
+#define DEFAULT_SOLVER "logic_solver.exe"
+#define DEFAULT_GENERATOR "input_generator.exe"
+#else
+#define DEFAULT_SOLVER "./logic_solver"
+#define DEFAULT_GENERATOR "./input_generator"
+#endif
+
+// Expected outcome of a corpus instance
+typedef enum { EXPECT_UNKNOWN, EXPECT_SAT, EXPECT_UNSAT } Expectation;
+
+// Structure describing one corpus instance
+typedef struct {
+  char name[MAX_NAME_LEN];
+  char family[32];
+  char path[MAX_PATH_LEN];
+  Expectation expected;
+} BenchInstance;
+
+// Structure describing one solver configuration
+typedef struct {
+  const char *name;
+  const char *arguments;
+} BenchConfig;
+
+// Every engine and configuration the suite exercises
+static const BenchConfig BENCH_CONFIGS[] = {
+    {"auto", ""},
+    {"resolution", "--engine=resolution"},
+    {"cdcl", "--engine=cdcl"},
+    {"walksat", "--engine=walksat --flips=10000000"},
+    {"probsat", "--engine=probsat --flips=10000000"},
+    {"cubes", "--engine=cubes"},
+};
+#define CONFIG_COUNT ((int)(sizeof(BENCH_CONFIGS) / sizeof(BENCH_CONFIGS[0])))
+
+// Structure describing one formula with a known number of models
+typedef struct {
+  const char *name;
+  const char *text;
+  const char *arguments;
+  unsigned long long models;
+} CountCheck;
+
+// Formulas whose clauses need definition or counter variables, which must
+// not change the number of models reported, whatever the encoding
+static const CountCheck COUNT_CHECKS[] = {
+    {"count_two_products", "(a & b) | (c & d)\n", "", 7},
+    {"count_or_of_and", "a | (b & c)\n", "", 5},
+    {"count_equivalence", "(a <-> b) | !(c & (d | e))\n", "", 26},
+    {"count_atmost_sequential", "atmost 2 a b c d e f g h\n",
+     "--cardinality=sequential", 37},
+    {"count_atmost_totalizer", "atmost 2 a b c d e f g h\n",
+     "--cardinality=totalizer", 37},
+    {"count_atmost_network", "atmost 2 a b c d e f g h\n",
+     "--cardinality=network", 37},
+    {"count_exactly_sequential", "exactly 3 a b c d e !f g\n",
+     "--cardinality=sequential", 35},
+    {"count_exactly_totalizer", "exactly 3 a b c d e !f g\n",
+     "--cardinality=totalizer", 35},
+    {"count_exactly_network", "exactly 3 a b c d e !f g\n",
+     "--cardinality=network", 35},
+};
+#define COUNT_CHECK_COUNT                                                     \
+  ((int)(sizeof(COUNT_CHECKS) / sizeof(COUNT_CHECKS[0])))
+
+// Structure describing one mode that reports a model count
+typedef struct {
+  const char *arguments;
+  const char *marker;
+} CountMode;
+
+// Every mode that counts models, with the text its count follows
+static const CountMode COUNT_MODES[] = {
+    {"--count", "Models: "},
+    {"--all --model=none", "covering "},
+    {"--bdd", " nodes, "},
+};
+#define COUNT_MODE_COUNT ((int)(sizeof(COUNT_MODES) / sizeof(COUNT_MODES[0])))
+
+// Structure holding the aggregated measurements of one run
+typedef struct {
+  char instance[MAX_NAME_LEN];
+  char config[MAX_NAME_LEN];
+  char result[16];
+  int runs;
+  double median_seconds;
+  double min_seconds;
+  double wall_seconds;
+  unsigned long long peak_rss_bytes;
+} BenchResult;
+
+// Structure for the benchmark options
+typedef struct {
+  const char *solver_path;
+  const char *generator_path;
+  const char *corpus_dir;
+  const char *output_path;
+  const char *baseline_path;
+  int repeats;
+  int levels;
+  double timeout;
+  double threshold;
+} BenchOptions;
+
+// Function to read a monotonic clock, in seconds
+double bench_now() {
+#ifdef _WIN32
+  static LARGE_INTEGER frequency;
+  LARGE_INTEGER counter;
+  if (frequency.QuadPart == 0)
+    QueryPerformanceFrequency(&frequency);
+  QueryPerformanceCounter(&counter);
+  return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+// Function to create a directory if it does not exist yet
+bool ensure_directory(const char *path) {
+#ifdef _WIN32
+  if (_mkdir(path) == 0 || errno == EEXIST)
+    return true;
+#else
+  if (mkdir(path, 0755) == 0 || errno == EEXIST)
+    return true;
+#endif
+  printf("Error: Unable to create directory %s\n", path);
+  return false;
+}
+
+// Process execution
+
+// Function to run a program with a timeout, given its space-separated
+// arguments and a last one that may hold spaces, capturing its stderr, or
+// with keep_stdout its stdout, while the other is discarded. Returns false
+// when the process could not be started, failed to start or timed out.
+bool run_process(const BenchOptions *options, const char *program,
+                 const char *arguments, const char *last_argument,
+                 bool keep_stdout, char *output, size_t output_size,
+                 double *wall_seconds) {
+  char capture_path[MAX_PATH_LEN];
+  snprintf(capture_path, sizeof(capture_path), "%s/.capture.txt",
+           options->corpus_dir);
+  bool finished = false;
+  double start = bench_now();
+
+#ifdef _WIN32
+  char command[MAX_LINE * 2];
+  snprintf(command, sizeof(command), "\"%s\" %s \"%s\"", program,
+           arguments, last_argument);
+
+  SECURITY_ATTRIBUTES security = {sizeof(security), NULL, TRUE};
+  HANDLE capture = CreateFile(capture_path, GENERIC_WRITE, FILE_SHARE_READ,
+                              &security, CREATE_ALWAYS, 0, NULL);
+  if (capture == INVALID_HANDLE_VALUE)
+    return false;
+
+  HANDLE discard = CreateFile("NUL", GENERIC_WRITE, FILE_SHARE_WRITE,
+                              &security, OPEN_EXISTING, 0, NULL);
+  if (discard == INVALID_HANDLE_VALUE) {
+    CloseHandle(capture);
+    return false;
+  }
+
+  STARTUPINFO startup = {0};
+  PROCESS_INFORMATION process = {0};
+  startup.cb = sizeof(startup);
+  startup.dwFlags = STARTF_USESTDHANDLES;
+  startup.hStdOutput = keep_stdout ? capture : discard;
+  startup.hStdError = keep_stdout ? discard : capture;
+  if (!CreateProcess(NULL, command, NULL, NULL, TRUE, CREATE_NO_WINDOW, NULL,
+                     NULL, &startup, &process)) {
+    CloseHandle(discard);
+    CloseHandle(capture);
+    return false;
+  }
+  DWORD wait = WaitForSingleObject(process.hProcess,
+                                   (DWORD)(options->timeout * 1000.0));
+  if (wait == WAIT_OBJECT_0) {
+    finished = true;
+  } else {
+    TerminateProcess(process.hProcess, 1);
+    WaitForSingleObject(process.hProcess, INFINITE);
+  }
+  CloseHandle(process.hProcess);
+  CloseHandle(process.hThread);
+  CloseHandle(discard);
+  CloseHandle(capture);
+#else
+  char *argv[64];
+  int argc = 0;
+  char argument_copy[MAX_LINE + 16];
+  snprintf(argument_copy, sizeof(argument_copy), "%s", arguments);
+  argv[argc++] = (char *)program;
+  for (char *token = strtok(argument_copy, " "); token && argc < 62;
+       token = strtok(NULL, " "))
+    argv[argc++] = token;
+  argv[argc++] = (char *)last_argument;
+  argv[argc] = NULL;
+
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid < 0)
+    return false;
+  if (pid == 0) {
+    if (!freopen(keep_stdout ? capture_path : "/dev/null", "w", stdout) ||
+        !freopen(keep_stdout ? "/dev/null" : capture_path, "w", stderr))
+      _exit(127);
+    execv(argv[0], argv);
+    _exit(127);
+  }
+
+  int status = 0;
+  struct timespec pause = {0, 1000000};
+  while (true) {
+    pid_t done = waitpid(pid, &status, WNOHANG);
+    if (done == pid) {
+      finished = WIFEXITED(status) && WEXITSTATUS(status) != 127;
+      break;
+    }
+    if (bench_now() - start > options->timeout) {
+      kill(pid, SIGKILL);
+      waitpid(pid, &status, 0);
+      break;
+    }
+    nanosleep(&pause, NULL);
+  }
+#endif
+
+  *wall_seconds = bench_now() - start;
+
+  output[0] = '\0';
+  FILE *file = fopen(capture_path, "r");
+  if (file) {
+    size_t length = fread(output, 1, output_size - 1, file);
+    output[length] = '\0';
+    fclose(file);
+  }
+  remove(capture_path);
+  return finished;
+}
+
+// Corpus construction
+
+// Function to open a new corpus file and register its instance
+FILE *open_instance(const BenchOptions *options, BenchInstance *instances,
+                    int *instance_count, const char *family,
+                    Expectation expected, const char *name_format, ...) {
+  if (*instance_count >= MAX_INSTANCES)
+    return NULL;
+
+  BenchInstance *instance = &instances[*instance_count];
+  va_list args;
+  va_start(args, name_format);
+  vsnprintf(instance->name, sizeof(instance->name), name_format, args);
+  va_end(args);
+  snprintf(instance->family, sizeof(instance->family), "%s", family);
+  snprintf(instance->path, sizeof(instance->path), "%s/%s.cnf",
+           options->corpus_dir, instance->name);
+  instance->expected = expected;
+
+  FILE *file = fopen(instance->path, "w");
+  if (!file) {
+    printf("Error: Unable to create %s\n", instance->path);
+    return NULL;
+  }
+  fprintf(file, "# Benchmark corpus: %s\n", instance->name);
+  (*instance_count)++;
+  return file;
+}
+
+// Function to read the expected result an input_generator file states in
+// its header comment
+Expectation read_expectation(const char *path) {
+  FILE *file = fopen(path, "r");
+  if (!file)
+    return EXPECT_UNKNOWN;
+  char line[MAX_LINE];
+  Expectation expected = EXPECT_UNKNOWN;
+  for (int n = 0; n < 4 && fgets(line, sizeof(line), file); n++) {
+    const char *found = strstr(line, "expected: ");
+    if (found) {
+      found += strlen("expected: ");
+      if (strncmp(found, "SATISFIABLE", 11) == 0)
+        expected = EXPECT_SAT;
+      else if (strncmp(found, "UNSATISFIABLE", 13) == 0)
+        expected = EXPECT_UNSAT;
+      break;
+    }
+  }
+  fclose(file);
+  return expected;
+}
+
+// Function to have input_generator write a new corpus file from the given
+// arguments and register its instance, with the expected result the
+// generator states for it
+bool generate_instance(const BenchOptions *options, BenchInstance *instances,
+                       int *instance_count, const char *family,
+                       const char *arguments, const char *name_format, ...) {
+  if (*instance_count >= MAX_INSTANCES)
+    return false;
+
+  BenchInstance *instance = &instances[*instance_count];
+  va_list args;
+  va_start(args, name_format);
+  vsnprintf(instance->name, sizeof(instance->name), name_format, args);
+  va_end(args);
+  snprintf(instance->family, sizeof(instance->family), "%s", family);
+  snprintf(instance->path, sizeof(instance->path), "%s/%s.cnf",
+           options->corpus_dir, instance->name);
+
+  // A file left from an earlier run must not pass for this one
+  remove(instance->path);
+  char output[MAX_LINE];
+  char target[MAX_PATH_LEN + 16];
+  snprintf(target, sizeof(target), "--output=%s", instance->path);
+  double wall;
+  FILE *file = NULL;
+  if (run_process(options, options->generator_path, arguments, target, true,
+                  output, sizeof(output), &wall))
+    file = fopen(instance->path, "r");
+  if (!file) {
+    printf("Error: Unable to generate %s with %s %s\n", instance->path,
+           options->generator_path, arguments);
+    return false;
+  }
+  fclose(file);
+  instance->expected = read_expectation(instance->path);
+  (*instance_count)++;
+  return true;
+}
+
+// Function to add the small inputs that once got a wrong answer, so every
+// run of the suite checks their verdicts again
+bool build_regressions(const BenchOptions *options, BenchInstance *instances,
+                       int *count) {
+  // Refuting cubes that leave part of the search space out proves nothing
+  FILE *file = open_instance(options, instances, count, "regression",
+                             EXPECT_SAT, "regression_partial_cubes");
+  if (!file)
+    return false;
+  fprintf(file, "p inccnf\n1 2 0\na -1 -2 0\n");
+  fclose(file);
+
+  // A native clause on a symbol named c is not a DIMACS comment
+  file = open_instance(options, instances, count, "regression", EXPECT_UNSAT,
+                       "regression_native_symbol_c");
+  if (!file)
+    return false;
+  fprintf(file, "c d\n!c\n!d\n");
+  fclose(file);
+
+  // Nor is one on a symbol named h the marker of a hard WCNF clause
+  file = open_instance(options, instances, count, "regression", EXPECT_SAT,
+                       "regression_native_symbol_h");
+  if (!file)
+    return false;
+  fprintf(file, "h !b\n3 a\n1 b\n");
+  fclose(file);
+  return true;
+}
+
+// Function to build the full corpus from input_generator's seeded
+// families, sized so that the complete engines take from milliseconds at
+// level 1 to seconds at level 3
+int build_corpus(const BenchOptions *options, BenchInstance *instances) {
+  int count = 0;
+  char arguments[MAX_LINE];
+
+  if (!ensure_directory(options->corpus_dir) ||
+      !build_regressions(options, instances, &count))
+    return -1;
+
+  for (int level = 1; level <= options->levels; level++) {
+    // Random 3-SAT at the threshold, where the hardest instances are
+    int variables = 150 + 25 * level;
+    int clauses = (int)(variables * RANDOM_3SAT_RATIO + 0.5);
+    for (int seed = 1; seed <= 3; seed++) {
+      snprintf(arguments, sizeof(arguments), "%d %d 3 --exact --seed=%d",
+               variables, clauses, seed);
+      if (!generate_instance(options, instances, &count, "random3sat",
+                             arguments, "random3sat_v%d_s%d", variables,
+                             seed))
+        return -1;
+    }
+
+    int planted = 150 * level;
+    snprintf(arguments, sizeof(arguments),
+             "--family=planted %d %d 3 --seed=%d", planted, 4 * planted,
+             level);
+    if (!generate_instance(options, instances, &count, "planted", arguments,
+                           "planted_v%d", planted))
+      return -1;
+
+    int holes = 5 + level;
+    snprintf(arguments, sizeof(arguments), "--family=php --holes=%d", holes);
+    if (!generate_instance(options, instances, &count, "pigeonhole",
+                           arguments, "php_%d_%d", holes + 1, holes))
+      return -1;
+
+    int vertices = 250 * level;
+    for (int sat = 0; sat <= 1; sat++) {
+      snprintf(arguments, sizeof(arguments),
+               "--family=tseitin --vertices=%d --degree=4 --seed=%d%s",
+               vertices, level, sat ? " --sat" : "");
+      if (!generate_instance(options, instances, &count, "tseitin",
+                             arguments, "tseitin_%d_%s", vertices,
+                             sat ? "sat" : "unsat"))
+        return -1;
+    }
+
+    int graph = 1000 * level;
+    snprintf(arguments, sizeof(arguments),
+             "--family=colouring --vertices=%d --edges=%d --colours=3 "
+             "--sat --seed=%d",
+             graph, graph * 21 / 10, level);
+    if (!generate_instance(options, instances, &count, "colouring",
+                           arguments, "colour_%d_k3", graph))
+      return -1;
+
+    // The counter reaches the target within the steps, or just misses it
+    int steps = 20 * level;
+    for (int reach = 0; reach <= 1; reach++) {
+      snprintf(arguments, sizeof(arguments),
+               "--family=bmc --steps=%d --width=%d --target=%d", steps,
+               4 + level, reach ? steps : steps + 1);
+      if (!generate_instance(options, instances, &count, "bmc", arguments,
+                             "bmc_%d_%s", steps, reach ? "sat" : "unsat"))
+        return -1;
+    }
+  }
+  return count;
+}
+
+// Solver execution
+
+// Function to run the solver on one input with a timeout, capturing its
+// output: the JSON statistics on stderr, or with keep_stdout the report on
+// stdout. Returns false when the process could not be started or timed
+// out.
+bool run_command(const BenchOptions *options, const char *arguments,
+                 const char *input_path, bool keep_stdout, char *output,
+                 size_t output_size, double *wall_seconds) {
+  char solver_arguments[MAX_LINE + 16];
+  snprintf(solver_arguments, sizeof(solver_arguments), "--stats=json %s",
+           arguments);
+  return run_process(options, options->solver_path, solver_arguments,
+                     input_path, keep_stdout, output, output_size,
+                     wall_seconds);
+}
+
+// Function to extract a numeric field from the solver's JSON statistics
+bool json_number(const char *json, const char *key, double *value) {
+  char pattern[64];
+  snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+  const char *found = strstr(json, pattern);
+  if (!found)
+    return false;
+  *value = strtod(found + strlen(pattern), NULL);
+  return true;
+}
+
+// Function to compare doubles for qsort
+int compare_doubles(const void *a, const void *b) {
+  double x = *(const double *)a;
+  double y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+// Function to benchmark one instance under one configuration
+void run_benchmark(const BenchOptions *options, const BenchInstance *instance,
+                   const BenchConfig *config, BenchResult *result) {
+  static char output[MAX_OUTPUT];
+  double times[MAX_REPEATS];
+  double walls[MAX_REPEATS];
+
+  snprintf(result->instance, sizeof(result->instance), "%s", instance->name);
+  snprintf(result->config, sizeof(result->config), "%s", config->name);
+  snprintf(result->result, sizeof(result->result), "ERROR");
+  result->runs = 0;
+  result->peak_rss_bytes = 0;
+
+  for (int r = 0; r < options->repeats; r++) {
+    double wall;
+    if (!run_command(options, config->arguments, instance->path, false,
+                     output, sizeof(output), &wall)) {
+      snprintf(result->result, sizeof(result->result), "TIMEOUT");
+      result->runs = 0;
+      result->median_seconds = result->min_seconds = options->timeout;
+      result->wall_seconds = wall;
+      return;
+    }
+
+    // Without statistics the run crashed or failed, whatever earlier
+    // repetitions said
+    const char *json = strstr(output, "{\"result\":\"");
+    if (!json) {
+      snprintf(result->result, sizeof(result->result), "ERROR");
+      result->runs = 0;
+      result->median_seconds = result->min_seconds = 0.0;
+      result->wall_seconds = wall;
+      return;
+    }
+    const char *verdict = json + strlen("{\"result\":\"");
+    size_t length = strcspn(verdict, "\"");
+    if (length >= sizeof(result->result))
+      length = sizeof(result->result) - 1;
+    memcpy(result->result, verdict, length);
+    result->result[length] = '\0';
+
+    double parse_time = 0.0, solve_time = 0.0, rss = 0.0;
+    json_number(json, "parse_time", &parse_time);
+    json_number(json, "solve_time", &solve_time);
+    json_number(json, "peak_rss_bytes", &rss);
+    times[result->runs] = parse_time + solve_time;
+    walls[result->runs] = wall;
+    if ((unsigned long long)rss > result->peak_rss_bytes)
+      result->peak_rss_bytes = (unsigned long long)rss;
+    result->runs++;
+  }
+
+  qsort(times, result->runs, sizeof(double), compare_doubles);
+  qsort(walls, result->runs, sizeof(double), compare_doubles);
+  result->median_seconds = times[result->runs / 2];
+  result->min_seconds = times[0];
+  result->wall_seconds = walls[result->runs / 2];
+}
+
+// Function to check a verdict against the instance's known answer
+bool result_matches(const BenchInstance *instance, const char *result) {
+  if (instance->expected == EXPECT_SAT)
+    return strcmp(result, "UNSATISFIABLE") != 0 &&
+           strcmp(result, "ERROR") != 0;
+  if (instance->expected == EXPECT_UNSAT)
+    return strcmp(result, "SATISFIABLE") != 0 && strcmp(result, "ERROR") != 0;
+  return strcmp(result, "ERROR") != 0;
+}
+
+// Function to run every count check in every counting mode, printing the
+// counts; returns the number of counts that differ from the known one
+int run_count_checks(const BenchOptions *options) {
+  static char output[MAX_OUTPUT];
+  int wrong = 0;
+
+  printf("\n%-28s %-44s %10s %10s\n", "formula", "mode", "expected",
+         "models");
+  for (int i = 0; i < COUNT_CHECK_COUNT; i++) {
+    const CountCheck *check = &COUNT_CHECKS[i];
+    char path[MAX_PATH_LEN];
+    snprintf(path, sizeof(path), "%s/%s.txt", options->corpus_dir,
+             check->name);
+    FILE *file = fopen(path, "w");
+    if (!file) {
+      printf("Error: Unable to create %s\n", path);
+      return wrong + COUNT_MODE_COUNT;
+    }
+    fputs(check->text, file);
+    fclose(file);
+
+    for (int m = 0; m < COUNT_MODE_COUNT; m++) {
+      char arguments[MAX_LINE];
+      snprintf(arguments, sizeof(arguments), "%s %s", COUNT_MODES[m].arguments,
+               check->arguments);
+      double wall;
+      const char *found = NULL;
+      if (run_command(options, arguments, path, true, output, sizeof(output),
+                      &wall))
+        found = strstr(output, COUNT_MODES[m].marker);
+      unsigned long long models = 0;
+      if (found)
+        models = strtoull(found + strlen(COUNT_MODES[m].marker), NULL, 10);
+      bool correct = found && models == check->models;
+      if (!correct)
+        wrong++;
+      printf("%-28s %-44s %10llu %10llu%s\n", check->name, arguments,
+             check->models, models, correct ? "" : "  WRONG");
+    }
+  }
+  return wrong;
+}
+
+// Baseline handling
+
+// Function to write all results as CSV
+bool write_results(const char *path, const BenchResult *results, int count) {
+  FILE *file = fopen(path, "w");
+  if (!file) {
+    printf("Error: Unable to write %s\n", path);
+    return false;
+  }
+  fprintf(file, "instance,config,result,runs,median_s,min_s,wall_s,"
+                "peak_rss_bytes\n");
+  for (int i = 0; i < count; i++) {
+    fprintf(file, "%s,%s,%s,%d,%.6f,%.6f,%.6f,%llu\n", results[i].instance,
+            results[i].config, results[i].result, results[i].runs,
+            results[i].median_seconds, results[i].min_seconds,
+            results[i].wall_seconds, results[i].peak_rss_bytes);
+  }
+  fclose(file);
+  return true;
+}
+
+// Function to compare results against a baseline CSV; returns the number of
+// regressions (slower beyond the threshold, or a changed verdict)
+int compare_with_baseline(const BenchOptions *options,
+                          const BenchResult *results, int count) {
+  FILE *file = fopen(options->baseline_path, "r");
+  if (!file) {
+    printf("Error: Unable to open baseline %s\n", options->baseline_path);
+    return -1;
+  }
+
+  char line[MAX_LINE];
+  int regressions = 0;
+  int compared = 0;
+  printf("\nComparison against %s (threshold %.1f%%):\n",
+         options->baseline_path, options->threshold);
+
+  while (fgets(line, sizeof(line), file)) {
+    char instance[MAX_NAME_LEN], config[MAX_NAME_LEN], verdict[16];
+    int runs;
+    double median, min_seconds, wall;
+    unsigned long long rss;
+    if (sscanf(line, "%95[^,],%95[^,],%15[^,],%d,%lf,%lf,%lf,%llu", instance,
+               config, verdict, &runs, &median, &min_seconds, &wall,
+               &rss) != 8)
+      continue;
+
+    for (int i = 0; i < count; i++) {
+      if (strcmp(results[i].instance, instance) != 0 ||
+          strcmp(results[i].config, config) != 0)
+        continue;
+      compared++;
+
+      bool decided_before = strcmp(verdict, "SATISFIABLE") == 0 ||
+                            strcmp(verdict, "UNSATISFIABLE") == 0;
+      bool decided_now = strcmp(results[i].result, "SATISFIABLE") == 0 ||
+                         strcmp(results[i].result, "UNSATISFIABLE") == 0;
+      double change = median > 0.0
+                          ? (results[i].median_seconds - median) / median * 100
+                          : 0.0;
+
+      if (decided_before && decided_now &&
+          strcmp(verdict, results[i].result) != 0) {
+        printf("  MISMATCH    %-28s %-14s %s -> %s\n", instance, config,
+               verdict, results[i].result);
+        regressions++;
+      } else if (decided_before && !decided_now) {
+        printf("  REGRESSION  %-28s %-14s %s -> %s\n", instance, config,
+               verdict, results[i].result);
+        regressions++;
+      } else if (change > options->threshold &&
+                 results[i].median_seconds - median > NOISE_FLOOR_SECONDS) {
+        printf("  REGRESSION  %-28s %-14s %.4fs -> %.4fs (%+.1f%%)\n",
+               instance, config, median, results[i].median_seconds, change);
+        regressions++;
+      } else if (change < -options->threshold &&
+                 median - results[i].median_seconds > NOISE_FLOOR_SECONDS) {
+        printf("  IMPROVED    %-28s %-14s %.4fs -> %.4fs (%+.1f%%)\n",
+               instance, config, median, results[i].median_seconds, change);
+      }
+    }
+  }
+  fclose(file);
+
+  printf("  %d measurements compared, %d regressions\n", compared,
+         regressions);
+  return regressions;
+}
+
+// Function to parse command line arguments
+bool parse_args(int argc, char *argv[], BenchOptions *options) {
+  options->solver_path = DEFAULT_SOLVER;
+  options->generator_path = DEFAULT_GENERATOR;
+  options->corpus_dir = "bench_corpus";
+  options->output_path = NULL;
+  options->baseline_path = NULL;
+  options->repeats = DEFAULT_REPEATS;
+  options->levels = DEFAULT_LEVELS;
+  options->timeout = DEFAULT_TIMEOUT;
+  options->threshold = DEFAULT_THRESHOLD;
+
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    if (strncmp(arg, "--solver=", 9) == 0) {
+      options->solver_path = arg + 9;
+    } else if (strncmp(arg, "--generator=", 12) == 0) {
+      options->generator_path = arg + 12;
+    } else if (strncmp(arg, "--corpus=", 9) == 0) {
+      options->corpus_dir = arg + 9;
+    } else if (strncmp(arg, "--output=", 9) == 0) {
+      options->output_path = arg + 9;
+    } else if (strncmp(arg, "--baseline=", 11) == 0) {
+      options->baseline_path = arg + 11;
+    } else if (strncmp(arg, "--repeat=", 9) == 0) {
+      options->repeats = atoi(arg + 9);
+    } else if (strncmp(arg, "--levels=", 9) == 0) {
+      options->levels = atoi(arg + 9);
+    } else if (strncmp(arg, "--timeout=", 10) == 0) {
+      options->timeout = atof(arg + 10);
+    } else if (strncmp(arg, "--threshold=", 12) == 0) {
+      options->threshold = atof(arg + 12);
+    } else {
+      printf("Usage: %s [--solver=PATH] [--generator=PATH] [--corpus=DIR] "
+             "[--repeat=N] [--levels=N] [--timeout=SEC] [--output=FILE] "
+             "[--baseline=FILE] [--threshold=PERCENT]\n",
+             argv[0]);
+      return false;
+    }
+  }
+
+  if (options->repeats <= 0 || options->repeats > MAX_REPEATS ||
+      options->levels <= 0 || options->timeout <= 0.0 ||
+      options->threshold < 0.0) {
+    printf("Invalid parameters. Please check the ranges:\n");
+    printf("Repetitions: 1-%d\n", MAX_REPEATS);
+    printf("Levels, timeout: positive; threshold: non-negative\n");
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  BenchOptions options;
+  if (!parse_args(argc, argv, &options)) {
+    return 1;
+  }
+
+  static BenchInstance instances[MAX_INSTANCES];
+  int instance_count = build_corpus(&options, instances);
+  if (instance_count < 0) {
+    return 1;
+  }
+
+  int total = instance_count * CONFIG_COUNT;
+  BenchResult *results = malloc(total * sizeof(BenchResult));
+  if (!results) {
+    printf("Error: Out of memory\n");
+    return 1;
+  }
+
+  printf("Running %d instances x %d configurations, %d repetitions each\n\n",
+         instance_count, CONFIG_COUNT, options.repeats);
+  printf("%-28s %-14s %-14s %10s %10s %12s\n", "instance", "config", "result",
+         "median_s", "wall_s", "peak_rss");
+
+  int mismatches = 0;
+  int result_count = 0;
+  for (int i = 0; i < instance_count; i++) {
+    for (int c = 0; c < CONFIG_COUNT; c++) {
+      BenchResult *result = &results[result_count++];
+      run_benchmark(&options, &instances[i], &BENCH_CONFIGS[c], result);
+      bool correct = result_matches(&instances[i], result->result);
+      if (!correct)
+        mismatches++;
+      printf("%-28s %-14s %-14s %10.4f %10.4f %12llu%s\n", result->instance,
+             result->config, result->result, result->median_seconds,
+             result->wall_seconds, result->peak_rss_bytes,
+             correct ? "" : "  WRONG");
+    }
+  }
+
+  int wrong_counts = run_count_checks(&options);
+
+  if (options.output_path && !write_results(options.output_path, results,
+                                            result_count)) {
+    free(results);
+    return 1;
+  }
+
+  int regressions = 0;
+  if (options.baseline_path) {
+    regressions = compare_with_baseline(&options, results, result_count);
+  }
+  free(results);
+
+  if (mismatches > 0) {
+    printf("\n%d results contradict the known answer\n", mismatches);
+  }
+  if (wrong_counts > 0) {
+    printf("\n%d model counts differ from the known count\n", wrong_counts);
+  }
+  return (mismatches > 0 || wrong_counts > 0 || regressions != 0) ? 1 : 0;
+}
@@ -1,100 +1,1210 @@
 /*
  * Advanced Propositional Logic Formula Generator
- * Creates random CNF formulas for testing
+ * Streams random and structured CNF formulas for testing and benchmarking
  */
 
+#include <errno.h>
+#include <stdarg.h>
 #include <stdbool.h>
 #include <stddef.h> // for NULL
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>
 
+#ifdef _WIN32
+#include <direct.h>
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
 
 // Configuration constants
-#define MAX_VARIABLES 26
-#define MAX_CLAUSES 100
-#define MAX_LITERALS_PER_CLAUSE 3
+#define MAX_LITERALS_PER_CLAUSE 1024
 #define MAX_SYMBOL_LEN 64
+#define MAX_TSEITIN_DEGREE 16
+#define MAX_COLOURS 64
+#define MAX_COUNTER_WIDTH 62
+#define MODEL_LITERALS_PER_LINE 16
+#define DEFAULT_LITERALS_PER_CLAUSE 3
+#define DEFAULT_SEED 1
+#define OUTPUT_BUFFER_SIZE (1 << 20)
+#define BLOCK_CLAUSES (1 << 16)
+#define MAX_THREADS 256
+#define MAX_PATH_LEN 512
+
+// Independent PRNG streams derived from the user seed
+#define STREAM_CLAUSES 1
+#define STREAM_MODEL 2
+#define STREAM_INSTANCE 3
+
+// Output formats
+typedef enum { FORMAT_NAMES, FORMAT_DIMACS } OutputFormat;
+
+// Instance families
+typedef enum {
+  FAMILY_RANDOM,
+  FAMILY_PLANTED,
+  FAMILY_PIGEONHOLE,
+  FAMILY_TSEITIN,
+  FAMILY_COLOURING,
+  FAMILY_BMC
+} FormulaFamily;
 
 // Structure for formula generation
 typedef struct {
-  int num_variables;
-  int num_clauses;
+  FormulaFamily family;
+  long num_variables;
+  long num_clauses;
   int literals_per_clause;
+  bool exact_width;
   bool allow_tautologies;
+  uint64_t seed;
+  OutputFormat format;
+  const char *model_path;
+  const char *output_path;
+  int threads;
+  long count;
+  // Structured family parameters
+  long holes;
+  long vertices;
+  int degree;
+  long edges;
+  int colours;
+  bool satisfiable;
+  long steps;
+  int width;
+  long long target;
 } GeneratorConfig;
 
-// Function to initialize random seed
-void init_random() { srand((unsigned int)time(NULL)); }
+// Reproducible PRNG (xoshiro256**), seeded through splitmix64
+typedef struct {
+  uint64_t s[4];
+} RandomState;
+
+// Function to initialize the random state from a seed
+void init_random(RandomState *rng, uint64_t seed) {
+  for (int i = 0; i < 4; i++) {
+    uint64_t z = (seed += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    rng->s[i] = z ^ (z >> 31);
+  }
+}
+
+// Function to draw the next 64-bit random value
+uint64_t next_random(RandomState *rng) {
+  uint64_t *s = rng->s;
+  uint64_t result = ((s[1] * 5) << 7 | (s[1] * 5) >> 57) * 9;
+  uint64_t t = s[1] << 17;
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = (s[3] << 45) | (s[3] >> 19);
+  return result;
+}
+
+// Function to draw a uniform value in [0, bound) without modulo bias
+uint64_t random_below(RandomState *rng, uint64_t bound) {
+  uint64_t threshold = -bound % bound;
+  uint64_t value;
+  do {
+    value = next_random(rng);
+  } while (value < threshold);
+  return value % bound;
+}
+
+// Function to draw a random boolean
+bool random_bool(RandomState *rng) { return (next_random(rng) >> 63) != 0; }
+
+// Function to derive the seed of an independent stream. Block b of an
+// instance always uses the same stream, whichever thread generates it.
+uint64_t derive_seed(uint64_t seed, uint64_t stream, uint64_t index) {
+  uint64_t z = seed ^ (stream * 0xD1B54A32D192ED03ULL);
+  z += (index + 1) * 0x9E3779B97F4A7C15ULL;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+// Output buffer: clauses are formatted into memory and written in blocks
+typedef struct {
+  char *data;
+  size_t length;
+  size_t capacity;
+  FILE *sink; // flushed when full; NULL keeps everything in memory
+  bool failed;
+} OutputBuffer;
+
+// Function to initialize an output buffer
+bool init_buffer(OutputBuffer *out, FILE *sink) {
+  out->capacity = OUTPUT_BUFFER_SIZE;
+  out->data = malloc(out->capacity);
+  out->length = 0;
+  out->sink = sink;
+  out->failed = out->data == NULL;
+  return !out->failed;
+}
+
+// Function to write buffered bytes to the sink
+void flush_buffer(OutputBuffer *out) {
+  if (out->sink && out->length > 0) {
+    if (fwrite(out->data, 1, out->length, out->sink) != out->length)
+      out->failed = true;
+    out->length = 0;
+  }
+}
+
+// Function to free an output buffer after flushing it
+bool free_buffer(OutputBuffer *out) {
+  flush_buffer(out);
+  free(out->data);
+  out->data = NULL;
+  return !out->failed;
+}
 
-// Function to generate a random variable name
-void generate_symbol_name(char *name, int index) {
-  name[0] = 'p' + (index % 26);
-  name[1] = '\0';
+// Function to make room for at least extra bytes
+char *reserve_buffer(OutputBuffer *out, size_t extra) {
+  if (out->length + extra > out->capacity) {
+    flush_buffer(out);
+    if (out->length + extra > out->capacity) {
+      size_t capacity = out->capacity;
+      while (capacity < out->length + extra)
+        capacity *= 2;
+      char *data = realloc(out->data, capacity);
+      if (!data) {
+        out->failed = true;
+        return NULL;
+      }
+      out->data = data;
+      out->capacity = capacity;
+    }
+  }
+  return out->data + out->length;
 }
 
-// Function to generate a random clause
-void generate_clause(char *clause, int max_literals, int num_variables) {
-  int num_literals = (rand() % max_literals) + 1;
-  int pos = 0;
+// Function to append raw bytes
+void append_buffer(OutputBuffer *out, const char *data, size_t length) {
+  char *dest = reserve_buffer(out, length);
+  if (!dest)
+    return;
+  memcpy(dest, data, length);
+  out->length += length;
+}
+
+// Function to append formatted text
+void buffer_printf(OutputBuffer *out, const char *format, ...) {
+  char line[512];
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(line, sizeof(line), format, args);
+  va_end(args);
+  if (length > 0)
+    append_buffer(out, line, (size_t)length < sizeof(line)
+                                 ? (size_t)length
+                                 : sizeof(line) - 1);
+}
+
+// Portable threads
+#ifdef _WIN32
+typedef HANDLE ThreadHandle;
+#else
+typedef pthread_t ThreadHandle;
+#endif
+
+typedef struct {
+  void (*function)(void *);
+  void *argument;
+} ThreadStart;
+
+#ifdef _WIN32
+static DWORD WINAPI thread_entry(LPVOID data) {
+  ThreadStart *start = data;
+  start->function(start->argument);
+  return 0;
+}
+#else
+static void *thread_entry(void *data) {
+  ThreadStart *start = data;
+  start->function(start->argument);
+  return NULL;
+}
+#endif
+
+// Function to start a thread; start must stay valid until it is joined
+bool start_thread(ThreadHandle *thread, ThreadStart *start) {
+#ifdef _WIN32
+  *thread = CreateThread(NULL, 0, thread_entry, start, 0, NULL);
+  return *thread != NULL;
+#else
+  return pthread_create(thread, NULL, thread_entry, start) == 0;
+#endif
+}
+
+// Function to wait for a thread to finish
+void join_thread(ThreadHandle thread) {
+#ifdef _WIN32
+  WaitForSingleObject(thread, INFINITE);
+  CloseHandle(thread);
+#else
+  pthread_join(thread, NULL);
+#endif
+}
+
+// Function to run function(arguments[i]) for i < count on up to threads
+// threads, falling back to the calling thread when a thread cannot start
+void run_parallel(void (*function)(void *), void *arguments, size_t stride,
+                  int count, int threads) {
+  ThreadHandle handles[MAX_THREADS];
+  ThreadStart starts[MAX_THREADS];
+  bool started[MAX_THREADS];
+
+  for (int first = 0; first < count; first += threads) {
+    int batch = count - first < threads ? count - first : threads;
+    for (int i = 0; i < batch; i++) {
+      starts[i].function = function;
+      starts[i].argument = (char *)arguments + (size_t)(first + i) * stride;
+      started[i] = batch > 1 && start_thread(&handles[i], &starts[i]);
+      if (!started[i])
+        function(starts[i].argument);
+    }
+    for (int i = 0; i < batch; i++) {
+      if (started[i])
+        join_thread(handles[i]);
+    }
+  }
+}
+
+// Function to generate a variable name; DIMACS output uses the index itself
+void generate_symbol_name(char *name, long index) {
+  snprintf(name, MAX_SYMBOL_LEN, "x%ld", index + 1);
+}
+
+// Function to format a non-negative number, returning its length; much
+// cheaper than sprintf in the per-literal loop
+size_t format_number(char *dest, long value) {
+  char digits[24];
+  size_t count = 0;
+  do {
+    digits[count++] = (char)('0' + value % 10);
+    value /= 10;
+  } while (value > 0);
+  for (size_t i = 0; i < count; i++)
+    dest[i] = digits[count - 1 - i];
+  return count;
+}
+
+// Function to write one clause of signed 1-based variable indices
+void write_clause(OutputBuffer *out, OutputFormat format, const long *literals,
+                  int count) {
+  char *line = reserve_buffer(out, (size_t)count * (MAX_SYMBOL_LEN + 2) + 4);
+  if (!line)
+    return;
+  size_t pos = 0;
+
+  for (int i = 0; i < count; i++) {
+    long var = literals[i] > 0 ? literals[i] : -literals[i];
+    if (format == FORMAT_DIMACS) {
+      if (literals[i] < 0)
+        line[pos++] = '-';
+      pos += format_number(line + pos, var);
+      line[pos++] = ' ';
+    } else {
+      if (i > 0)
+        line[pos++] = ' ';
+      if (literals[i] < 0)
+        line[pos++] = '!';
+      line[pos++] = 'x';
+      pos += format_number(line + pos, var);
+    }
+  }
+  if (format == FORMAT_DIMACS)
+    line[pos++] = '0';
+  line[pos++] = '\n';
+  out->length += pos;
+}
+
+// Function to write a two-literal clause
+void write_binary(OutputBuffer *out, OutputFormat format, long a, long b) {
+  long literals[2] = {a, b};
+  write_clause(out, format, literals, 2);
+}
+
+// Function to write a unit clause
+void write_unit(OutputBuffer *out, OutputFormat format, long a) {
+  write_clause(out, format, &a, 1);
+}
+
+// Function to write the header, including the documented expected result
+void write_header(OutputBuffer *out, const GeneratorConfig *config,
+                  const char *description, long variables, long clauses,
+                  const char *expected) {
+  const char *comment = config->format == FORMAT_DIMACS ? "c" : "#";
+  buffer_printf(out, "%s %s, seed %llu\n", comment, description,
+                (unsigned long long)config->seed);
+  buffer_printf(out, "%s expected: %s\n", comment, expected);
+  if (config->format == FORMAT_DIMACS)
+    buffer_printf(out, "p cnf %ld %ld\n", variables, clauses);
+}
+
+// Function to write a hidden model as "v" lines; true_vars[i] is variable i+1
+bool write_model(const GeneratorConfig *config, const bool *true_vars,
+                 long variables) {
+  if (!config->model_path)
+    return true;
+
+  FILE *file = fopen(config->model_path, "w");
+  if (!file) {
+    fprintf(stderr, "Error: Unable to write model file %s\n",
+            config->model_path);
+    return false;
+  }
+  char name[MAX_SYMBOL_LEN];
+  for (long i = 0; i < variables; i++) {
+    if (i % MODEL_LITERALS_PER_LINE == 0)
+      fprintf(file, "%sv", i > 0 ? "\n" : "");
+    if (config->format == FORMAT_DIMACS) {
+      fprintf(file, " %ld", true_vars[i] ? i + 1 : -(i + 1));
+    } else {
+      generate_symbol_name(name, i);
+      fprintf(file, " %s%s", true_vars[i] ? "" : "!", name);
+    }
+  }
+  if (variables == 0)
+    fprintf(file, "v");
+  fprintf(file, config->format == FORMAT_DIMACS ? " 0\n" : "\n");
+  fclose(file);
+  return true;
+}
+
+// Function to generate a random clause with no repeated literal; unless
+// tautologies are allowed, no variable appears twice either
+int generate_clause(RandomState *rng, const GeneratorConfig *config,
+                    long *literals) {
+  int num_literals = config->literals_per_clause;
+  if (!config->exact_width)
+    num_literals = (int)random_below(rng, num_literals) + 1;
 
   for (int i = 0; i < num_literals; i++) {
-    if (i > 0) {
-      clause[pos++] = ' ';
+    bool fresh;
+    do {
+      long var = (long)random_below(rng, config->num_variables) + 1;
+      literals[i] = random_bool(rng) ? -var : var;
+      fresh = true;
+      for (int j = 0; j < i && fresh; j++) {
+        if (literals[j] == literals[i] ||
+            (!config->allow_tautologies && literals[j] == -literals[i]))
+          fresh = false;
+      }
+    } while (!fresh);
+  }
+  return num_literals;
+}
+
+// Work item for one block of random clauses
+typedef struct {
+  const GeneratorConfig *config;
+  const bool *model; // clauses must satisfy it when not NULL
+  long first_clause;
+  long clause_count;
+  OutputBuffer out;
+} ClauseBlock;
+
+// Function to generate one block of random clauses from its own stream
+void generate_block(void *data) {
+  ClauseBlock *block = data;
+  const GeneratorConfig *config = block->config;
+  RandomState rng;
+  init_random(&rng, derive_seed(config->seed, STREAM_CLAUSES,
+                                (uint64_t)(block->first_clause /
+                                           BLOCK_CLAUSES)));
+
+  long literals[MAX_LITERALS_PER_CLAUSE];
+  for (long i = 0; i < block->clause_count; i++) {
+    int count;
+    bool satisfied;
+    do {
+      count = generate_clause(&rng, config, literals);
+      satisfied = block->model == NULL;
+      for (int j = 0; j < count && !satisfied; j++) {
+        long var = literals[j] > 0 ? literals[j] : -literals[j];
+        satisfied = block->model[var - 1] == (literals[j] > 0);
+      }
+    } while (!satisfied);
+    write_clause(&block->out, config->format, literals, count);
+  }
+}
+
+// Function to generate the clauses of a random formula in parallel blocks
+// of BLOCK_CLAUSES, written in order so the thread count never changes
+// the output
+bool generate_clause_blocks(const GeneratorConfig *config, const bool *model,
+                            OutputBuffer *out) {
+  int threads = config->threads;
+  ClauseBlock blocks[MAX_THREADS];
+  for (int t = 0; t < threads; t++) {
+    blocks[t].config = config;
+    blocks[t].model = model;
+    if (!init_buffer(&blocks[t].out, NULL)) {
+      for (int u = 0; u < t; u++)
+        free_buffer(&blocks[u].out);
+      return false;
+    }
+  }
+
+  bool ok = true;
+  for (long first = 0; first < config->num_clauses && ok;
+       first += (long)threads * BLOCK_CLAUSES) {
+    int batch = 0;
+    for (; batch < threads; batch++) {
+      long block_first = first + (long)batch * BLOCK_CLAUSES;
+      if (block_first >= config->num_clauses)
+        break;
+      long remaining = config->num_clauses - block_first;
+      blocks[batch].first_clause = block_first;
+      blocks[batch].clause_count =
+          remaining < BLOCK_CLAUSES ? remaining : BLOCK_CLAUSES;
+      blocks[batch].out.length = 0;
+    }
+
+    run_parallel(generate_block, blocks, sizeof(ClauseBlock), batch, threads);
+    for (int t = 0; t < batch; t++) {
+      ok = ok && !blocks[t].out.failed;
+      append_buffer(out, blocks[t].out.data, blocks[t].out.length);
+    }
+  }
+
+  for (int t = 0; t < threads; t++)
+    free_buffer(&blocks[t].out);
+  return ok && !out->failed;
+}
+
+// Function to generate a uniform random formula
+bool generate_random(const GeneratorConfig *config, OutputBuffer *out) {
+  char description[128];
+  snprintf(description, sizeof(description),
+           "Generated formula with %ld variables and %ld clauses",
+           config->num_variables, config->num_clauses);
+  write_header(out, config, description, config->num_variables,
+               config->num_clauses, "UNKNOWN");
+  return generate_clause_blocks(config, NULL, out);
+}
+
+// Function to generate random exact-k clauses all satisfied by a hidden
+// assignment (each clause is redrawn until the assignment satisfies it)
+bool generate_planted(const GeneratorConfig *config, OutputBuffer *out) {
+  bool *model = malloc(config->num_variables * sizeof(bool));
+  if (!model) {
+    fprintf(stderr, "Error: Out of memory\n");
+    return false;
+  }
+  RandomState rng;
+  init_random(&rng, derive_seed(config->seed, STREAM_MODEL, 0));
+  for (long v = 0; v < config->num_variables; v++)
+    model[v] = random_bool(&rng);
+
+  char description[128];
+  snprintf(description, sizeof(description),
+           "Planted %d-SAT with %ld variables and %ld clauses",
+           config->literals_per_clause, config->num_variables,
+           config->num_clauses);
+  write_header(out, config, description, config->num_variables,
+               config->num_clauses, "SATISFIABLE (hidden model)");
+
+  bool ok = generate_clause_blocks(config, model, out) &&
+            write_model(config, model, config->num_variables);
+  free(model);
+  return ok;
+}
+
+// Function to generate the pigeonhole formula PHP(n): n + 1 pigeons, n holes
+bool generate_pigeonhole(const GeneratorConfig *config, OutputBuffer *out) {
+  long holes = config->holes;
+  long pigeons = holes + 1;
+  long variables = pigeons * holes;
+  long clauses = pigeons + holes * (pigeons * (pigeons - 1) / 2);
+
+  char description[128];
+  snprintf(description, sizeof(description),
+           "Pigeonhole PHP(%ld): %ld pigeons in %ld holes", holes, pigeons,
+           holes);
+  write_header(out, config, description, variables, clauses, "UNSATISFIABLE");
+
+  long *literals = malloc(holes * sizeof(long));
+  if (!literals) {
+    fprintf(stderr, "Error: Out of memory\n");
+    return false;
+  }
+
+  // Variable p * holes + h + 1 means pigeon p sits in hole h
+  for (long p = 0; p < pigeons; p++) {
+    for (long h = 0; h < holes; h++)
+      literals[h] = p * holes + h + 1;
+    write_clause(out, config->format, literals, (int)holes);
+  }
+  for (long h = 0; h < holes; h++) {
+    for (long p = 0; p < pigeons; p++) {
+      for (long q = p + 1; q < pigeons; q++)
+        write_binary(out, config->format, -(p * holes + h + 1),
+                     -(q * holes + h + 1));
+    }
+  }
+  free(literals);
+  return true;
+}
+
+// Function to order edges for duplicate detection
+int compare_edges(const void *a, const void *b) {
+  const long *x = a;
+  const long *y = b;
+  if (x[0] != y[0])
+    return x[0] < y[0] ? -1 : 1;
+  if (x[1] != y[1])
+    return x[1] < y[1] ? -1 : 1;
+  return 0;
+}
+
+// Function to build a random simple d-regular graph with the configuration
+// model, repairing loops and parallel edges with random switches
+bool random_regular_graph(RandomState *rng, long vertices, int degree,
+                          long *edges) {
+  long edge_count = vertices * degree / 2;
+
+  for (long i = 0; i < 2 * edge_count; i++)
+    edges[i] = i / degree;
+  for (long i = 2 * edge_count - 1; i > 0; i--) {
+    long j = (long)random_below(rng, (uint64_t)i + 1);
+    long t = edges[i];
+    edges[i] = edges[j];
+    edges[j] = t;
+  }
+
+  for (int round = 0; round < 1000; round++) {
+    for (long e = 0; e < edge_count; e++) {
+      if (edges[2 * e] > edges[2 * e + 1]) {
+        long t = edges[2 * e];
+        edges[2 * e] = edges[2 * e + 1];
+        edges[2 * e + 1] = t;
+      }
     }
+    qsort(edges, edge_count, 2 * sizeof(long), compare_edges);
 
-    // Randomly negate the literal
-    if (rand() % 2) {
-      clause[pos++] = '!';
+    // Switch each loop or repeated edge (a,b) with a random edge (c,d)
+    // into (a,c),(b,d); stubs stay attached, so degrees are preserved
+    bool simple = true;
+    for (long e = 0; e < edge_count; e++) {
+      bool loop = edges[2 * e] == edges[2 * e + 1];
+      bool repeated = e > 0 && compare_edges(&edges[2 * e],
+                                             &edges[2 * (e - 1)]) == 0;
+      if (!loop && !repeated)
+        continue;
+      simple = false;
+      long f = (long)random_below(rng, (uint64_t)edge_count);
+      long t = edges[2 * e + 1];
+      edges[2 * e + 1] = edges[2 * f];
+      edges[2 * f] = t;
     }
+    if (simple)
+      return true;
+  }
+  return false;
+}
+
+// Function to generate Tseitin parity constraints on a random regular graph:
+// one variable per edge, and at every vertex the XOR of its edges equals the
+// vertex charge. Charges come from a hidden edge assignment; flipping one of
+// them makes the total parity odd and the formula unsatisfiable.
+bool generate_tseitin(const GeneratorConfig *config, RandomState *rng,
+                      OutputBuffer *out) {
+  long vertices = config->vertices;
+  int degree = config->degree;
+  long edge_count = vertices * degree / 2;
+
+  long *edges = malloc(2 * edge_count * sizeof(long));
+  long *incident = malloc(vertices * degree * sizeof(long));
+  int *filled = calloc(vertices, sizeof(int));
+  bool *model = malloc(edge_count * sizeof(bool));
+  if (!edges || !incident || !filled || !model) {
+    free(edges);
+    free(incident);
+    free(filled);
+    free(model);
+    fprintf(stderr, "Error: Out of memory\n");
+    return false;
+  }
+
+  if (!random_regular_graph(rng, vertices, degree, edges)) {
+    fprintf(stderr, "Error: Unable to build a simple %d-regular graph\n",
+            degree);
+    free(edges);
+    free(incident);
+    free(filled);
+    free(model);
+    return false;
+  }
+  for (long e = 0; e < edge_count; e++) {
+    long u = edges[2 * e], v = edges[2 * e + 1];
+    incident[u * degree + filled[u]++] = e;
+    incident[v * degree + filled[v]++] = e;
+    model[e] = random_bool(rng);
+  }
 
-    // Generate variable name
-    int var_index = rand() % num_variables;
-    generate_symbol_name(clause + pos, var_index);
-    pos++;
+  char description[128];
+  snprintf(description, sizeof(description),
+           "Tseitin parity on a random %d-regular graph with %ld vertices",
+           degree, vertices);
+  write_header(out, config, description, edge_count,
+               vertices * (1L << (degree - 1)),
+               config->satisfiable ? "SATISFIABLE (hidden model)"
+                                   : "UNSATISFIABLE");
+
+  long literals[MAX_TSEITIN_DEGREE];
+  for (long v = 0; v < vertices; v++) {
+    bool charge = false;
+    for (int i = 0; i < degree; i++)
+      charge ^= model[incident[v * degree + i]];
+    if (!config->satisfiable && v == 0)
+      charge = !charge;
+
+    // Forbid every assignment of the incident edges with the wrong parity
+    for (long mask = 0; mask < (1L << degree); mask++) {
+      bool parity = false;
+      for (int i = 0; i < degree; i++)
+        parity ^= (mask >> i) & 1;
+      if (parity == charge)
+        continue;
+      for (int i = 0; i < degree; i++) {
+        long var = incident[v * degree + i] + 1;
+        literals[i] = (mask >> i) & 1 ? -var : var;
+      }
+      write_clause(out, config->format, literals, degree);
+    }
   }
 
-  clause[pos] = '\0';
+  bool ok = !config->satisfiable || write_model(config, model, edge_count);
+  free(edges);
+  free(incident);
+  free(filled);
+  free(model);
+  return ok;
 }
 
-// Function to generate a complete formula
-void generate_formula(const GeneratorConfig *config) {
-  printf("c Generated formula with %d variables and %d clauses\n",
-         config->num_variables, config->num_clauses);
-  printf("p cnf %d %d\n", config->num_variables, config->num_clauses);
+// Function to generate k-colouring of a random graph with the given number
+// of distinct edges. With a planted colouring, only edges between vertices
+// of different hidden colours are drawn, so the formula is satisfiable.
+bool generate_colouring(const GeneratorConfig *config, RandomState *rng,
+                        OutputBuffer *out) {
+  long vertices = config->vertices;
+  int colours = config->colours;
+  long pairs = vertices * (vertices - 1) / 2;
+
+  // Open-addressing set of drawn edges keyed by u * vertices + v + 1
+  long capacity = 16;
+  while (capacity < 2 * config->edges)
+    capacity *= 2;
+  uint64_t *drawn = calloc(capacity, sizeof(uint64_t));
+  int *hidden = malloc(vertices * sizeof(int));
+  if (!drawn || !hidden) {
+    free(drawn);
+    free(hidden);
+    fprintf(stderr, "Error: Out of memory\n");
+    return false;
+  }
+  for (long v = 0; v < vertices; v++)
+    hidden[v] = (int)random_below(rng, (uint64_t)colours);
+
+  if (config->satisfiable) {
+    long compatible = 0;
+    long *per_colour = calloc(colours, sizeof(long));
+    if (!per_colour) {
+      free(drawn);
+      free(hidden);
+      return false;
+    }
+    for (long v = 0; v < vertices; v++)
+      per_colour[hidden[v]]++;
+    compatible = pairs;
+    for (int c = 0; c < colours; c++)
+      compatible -= per_colour[c] * (per_colour[c] - 1) / 2;
+    free(per_colour);
+    pairs = compatible;
+  }
+  if (config->edges > pairs) {
+    fprintf(stderr, "Error: Only %ld distinct edges are possible\n", pairs);
+    free(drawn);
+    free(hidden);
+    return false;
+  }
 
-  char clause[MAX_SYMBOL_LEN * MAX_LITERALS_PER_CLAUSE];
-  for (int i = 0; i < config->num_clauses; i++) {
-    generate_clause(clause, config->literals_per_clause, config->num_variables);
-    printf("%s\n", clause);
+  long variables = vertices * colours;
+  long clauses = vertices + vertices * (colours * (colours - 1) / 2) +
+                 config->edges * colours;
+  char description[128];
+  snprintf(description, sizeof(description),
+           "%d-colouring of a random graph with %ld vertices and %ld edges",
+           colours, vertices, config->edges);
+  write_header(out, config, description, variables, clauses,
+               config->satisfiable ? "SATISFIABLE (hidden model)"
+                                   : "UNKNOWN");
+
+  // Variable v * colours + c + 1 means vertex v has colour c
+  long literals[MAX_COLOURS];
+  for (long v = 0; v < vertices; v++) {
+    for (int c = 0; c < colours; c++)
+      literals[c] = v * colours + c + 1;
+    write_clause(out, config->format, literals, colours);
+    for (int c = 0; c < colours; c++) {
+      for (int d = c + 1; d < colours; d++)
+        write_binary(out, config->format, -(v * colours + c + 1),
+                     -(v * colours + d + 1));
+    }
+  }
+
+  for (long e = 0; e < config->edges;) {
+    long u = (long)random_below(rng, (uint64_t)vertices);
+    long v = (long)random_below(rng, (uint64_t)vertices);
+    if (u == v || (config->satisfiable && hidden[u] == hidden[v]))
+      continue;
+    if (u > v) {
+      long t = u;
+      u = v;
+      v = t;
+    }
+
+    uint64_t key = (uint64_t)u * (uint64_t)vertices + (uint64_t)v + 1;
+    uint64_t slot = (key * 0x9E3779B97F4A7C15ULL) & (uint64_t)(capacity - 1);
+    while (drawn[slot] != 0 && drawn[slot] != key)
+      slot = (slot + 1) & (uint64_t)(capacity - 1);
+    if (drawn[slot] == key)
+      continue;
+    drawn[slot] = key;
+
+    for (int c = 0; c < colours; c++)
+      write_binary(out, config->format, -(u * colours + c + 1),
+                   -(v * colours + c + 1));
+    e++;
+  }
+
+  bool ok = true;
+  if (config->satisfiable) {
+    bool *model = calloc(variables, sizeof(bool));
+    if (!model) {
+      ok = false;
+    } else {
+      for (long v = 0; v < vertices; v++)
+        model[v * colours + hidden[v]] = true;
+      ok = write_model(config, model, variables);
+      free(model);
+    }
+  }
+  free(drawn);
+  free(hidden);
+  return ok;
+}
+
+// Function to generate a bounded model-checking unrolling of a counter that
+// may increment at every step: can it hold the target value after the last
+// step? It can exactly when target <= steps.
+bool generate_bmc(const GeneratorConfig *config, OutputBuffer *out) {
+  long steps = config->steps;
+  int width = config->width;
+
+  // Variables: state bits s(t,i), enables en(t), carries c(t,i) for i >= 1
+  long state_vars = (steps + 1) * width;
+  long variables = state_vars + steps + steps * (width - 1);
+  long clauses = 2L * width + steps * (4L * width + 3L * (width - 1));
+
+  char description[128];
+  snprintf(description, sizeof(description),
+           "BMC unrolling of a %d-bit counter for %ld steps, target %lld",
+           width, steps, config->target);
+  write_header(out, config, description, variables, clauses,
+               config->target <= steps ? "SATISFIABLE" : "UNSATISFIABLE");
+
+#define STATE(t, i) ((long)(t) * width + (i) + 1)
+#define ENABLE(t) (state_vars + (t) + 1)
+#define CARRY(t, i)                                                            \
+  ((i) == 0 ? ENABLE(t) : state_vars + steps + (long)(t) * (width - 1) + (i))
+
+  for (int i = 0; i < width; i++)
+    write_unit(out, config->format, -STATE(0, i));
+
+  for (long t = 0; t < steps; t++) {
+    for (int i = 0; i < width; i++) {
+      // s(t+1,i) = s(t,i) XOR c(t,i)
+      long next = STATE(t + 1, i), cur = STATE(t, i), carry = CARRY(t, i);
+      long x1[3] = {-next, cur, carry};
+      long x2[3] = {-next, -cur, -carry};
+      long x3[3] = {next, -cur, carry};
+      long x4[3] = {next, cur, -carry};
+      write_clause(out, config->format, x1, 3);
+      write_clause(out, config->format, x2, 3);
+      write_clause(out, config->format, x3, 3);
+      write_clause(out, config->format, x4, 3);
+
+      // c(t,i+1) = s(t,i) AND c(t,i)
+      if (i + 1 < width) {
+        long gate = CARRY(t, i + 1);
+        long a1[3] = {gate, -cur, -carry};
+        write_binary(out, config->format, -gate, cur);
+        write_binary(out, config->format, -gate, carry);
+        write_clause(out, config->format, a1, 3);
+      }
+    }
+  }
+
+  for (int i = 0; i < width; i++) {
+    bool bit = (config->target >> i) & 1;
+    write_unit(out, config->format,
+               bit ? STATE(steps, i) : -STATE(steps, i));
+  }
+
+#undef STATE
+#undef ENABLE
+#undef CARRY
+  return true;
+}
+
+// Function to generate one instance into an output buffer
+bool generate_instance(const GeneratorConfig *config, OutputBuffer *out) {
+  RandomState rng;
+  init_random(&rng, derive_seed(config->seed, STREAM_CLAUSES, 0));
+
+  bool ok = false;
+  switch (config->family) {
+  case FAMILY_RANDOM:
+    ok = generate_random(config, out);
+    break;
+  case FAMILY_PLANTED:
+    ok = generate_planted(config, out);
+    break;
+  case FAMILY_PIGEONHOLE:
+    ok = generate_pigeonhole(config, out);
+    break;
+  case FAMILY_TSEITIN:
+    ok = generate_tseitin(config, &rng, out);
+    break;
+  case FAMILY_COLOURING:
+    ok = generate_colouring(config, &rng, out);
+    break;
+  case FAMILY_BMC:
+    ok = generate_bmc(config, out);
+    break;
+  }
+  flush_buffer(out);
+  return ok && !out->failed;
+}
+
+// Function to check whether a family comes with a hidden model
+bool has_hidden_model(const GeneratorConfig *config) {
+  return config->family == FAMILY_PLANTED ||
+         (config->satisfiable && (config->family == FAMILY_TSEITIN ||
+                                  config->family == FAMILY_COLOURING));
+}
+
+// Work item for one instance of a corpus
+typedef struct {
+  GeneratorConfig config;
+  long index;
+  char path[MAX_PATH_LEN];
+  char model_path[MAX_PATH_LEN];
+  bool ok;
+} CorpusJob;
+
+// Function to generate one corpus instance into its own file
+void generate_corpus_instance(void *data) {
+  CorpusJob *job = data;
+  job->ok = false;
+
+  FILE *file = fopen(job->path, "wb");
+  if (!file) {
+    fprintf(stderr, "Error: Unable to create %s\n", job->path);
+    return;
+  }
+  OutputBuffer out;
+  if (init_buffer(&out, file)) {
+    job->ok = generate_instance(&job->config, &out);
+    job->ok = free_buffer(&out) && job->ok;
+  }
+  job->ok = fclose(file) == 0 && job->ok;
+}
+
+// Function to create a directory if it does not exist yet
+bool ensure_directory(const char *path) {
+#ifdef _WIN32
+  if (_mkdir(path) == 0 || errno == EEXIST)
+    return true;
+#else
+  if (mkdir(path, 0755) == 0 || errno == EEXIST)
+    return true;
+#endif
+  fprintf(stderr, "Error: Unable to create directory %s\n", path);
+  return false;
+}
+
+// Function to generate count instances into a directory, one per thread at
+// a time; instance i is seeded from (seed, i) alone
+bool generate_corpus(const GeneratorConfig *config) {
+  static const char *family_names[] = {"random",  "planted",   "php",
+                                       "tseitin", "colouring", "bmc"};
+  if (!ensure_directory(config->output_path))
+    return false;
+
+  CorpusJob *jobs = malloc(config->threads * sizeof(CorpusJob));
+  if (!jobs) {
+    fprintf(stderr, "Error: Out of memory\n");
+    return false;
+  }
+
+  bool ok = true;
+  for (long first = 0; first < config->count && ok; first += config->threads) {
+    int batch = 0;
+    for (; batch < config->threads && first + batch < config->count; batch++) {
+      CorpusJob *job = &jobs[batch];
+      long index = first + batch;
+      job->config = *config;
+      job->config.threads = 1;
+      job->config.seed = derive_seed(config->seed, STREAM_INSTANCE,
+                                     (uint64_t)index);
+      job->index = index;
+      snprintf(job->path, sizeof(job->path), "%s/%s_%05ld.cnf",
+               config->output_path, family_names[config->family], index + 1);
+      snprintf(job->model_path, sizeof(job->model_path), "%s/%s_%05ld.model",
+               config->output_path, family_names[config->family], index + 1);
+      job->config.model_path =
+          has_hidden_model(config) ? job->model_path : NULL;
+    }
+
+    run_parallel(generate_corpus_instance, jobs, sizeof(CorpusJob), batch,
+                 config->threads);
+    for (int i = 0; i < batch; i++)
+      ok = ok && jobs[i].ok;
+  }
+
+  free(jobs);
+  return ok;
+}
+
+// Function to generate the configured formula or corpus
+bool generate_formula(const GeneratorConfig *config) {
+  if (config->count > 1)
+    return generate_corpus(config);
+
+  FILE *file = stdout;
+  if (config->output_path) {
+    file = fopen(config->output_path, "wb");
+    if (!file) {
+      fprintf(stderr, "Error: Unable to create %s\n", config->output_path);
+      return false;
+    }
+  }
+
+  OutputBuffer out;
+  bool ok = init_buffer(&out, file) && generate_instance(config, &out);
+  ok = free_buffer(&out) && ok;
+  if (file != stdout)
+    ok = fclose(file) == 0 && ok;
+  else
+    fflush(stdout);
+  return ok;
+}
+
+// Function to print the usage text
+void print_usage(const char *program) {
+  printf("Usage: %s <num_variables> <num_clauses> [literals_per_clause] "
+         "[allow_tautologies] [--exact] [--seed=N] [--format=names|dimacs]\n",
+         program);
+  printf("       %s --family=planted <num_variables> <num_clauses> "
+         "[literals_per_clause] [--model=FILE]\n",
+         program);
+  printf("       %s --family=php --holes=N\n", program);
+  printf("       %s --family=tseitin --vertices=N --degree=D [--sat] "
+         "[--model=FILE]\n",
+         program);
+  printf("       %s --family=colouring --vertices=N --edges=M --colours=K "
+         "[--sat] [--model=FILE]\n",
+         program);
+  printf("       %s --family=bmc --steps=N --width=B --target=T\n", program);
+  printf("Common options: [--threads=N] [--output=FILE] "
+         "[--count=N --output=DIR]\n");
+}
+
+// Function to parse a --family= value
+bool parse_family(const char *name, FormulaFamily *family) {
+  static const struct {
+    const char *name;
+    FormulaFamily family;
+  } families[] = {{"random", FAMILY_RANDOM},       {"planted", FAMILY_PLANTED},
+                  {"php", FAMILY_PIGEONHOLE},      {"tseitin", FAMILY_TSEITIN},
+                  {"colouring", FAMILY_COLOURING}, {"coloring", FAMILY_COLOURING},
+                  {"bmc", FAMILY_BMC}};
+  for (size_t i = 0; i < sizeof(families) / sizeof(families[0]); i++) {
+    if (strcmp(name, families[i].name) == 0) {
+      *family = families[i].family;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Function to validate the parameters of a structured family
+bool check_family_parameters(const GeneratorConfig *config) {
+  switch (config->family) {
+  case FAMILY_PIGEONHOLE:
+    if (config->holes < 1 || config->holes > MAX_LITERALS_PER_CLAUSE) {
+      printf("Holes: 1-%d\n", MAX_LITERALS_PER_CLAUSE);
+      return false;
+    }
+    return true;
+  case FAMILY_TSEITIN:
+    if (config->degree < 1 || config->degree > MAX_TSEITIN_DEGREE ||
+        config->vertices <= config->degree ||
+        (config->vertices * config->degree) % 2 != 0) {
+      printf("Degree: 1-%d; vertices: more than the degree, and "
+             "vertices * degree must be even\n",
+             MAX_TSEITIN_DEGREE);
+      return false;
+    }
+    return true;
+  case FAMILY_COLOURING:
+    if (config->vertices < 2 || config->edges < 0 || config->colours < 1 ||
+        config->colours > MAX_COLOURS) {
+      printf("Vertices: at least 2; edges: at least 0; colours: 1-%d\n",
+             MAX_COLOURS);
+      return false;
+    }
+    return true;
+  case FAMILY_BMC:
+    if (config->steps < 1 || config->width < 1 ||
+        config->width > MAX_COUNTER_WIDTH || config->target < 0 ||
+        config->target >= (1LL << config->width)) {
+      printf("Steps: at least 1; width: 1-%d; target: 0 to 2^width - 1\n",
+             MAX_COUNTER_WIDTH);
+      return false;
+    }
+    return true;
+  default:
+    return true;
   }
 }
 
 // Function to parse command line arguments
 bool parse_args(int argc, char *argv[], GeneratorConfig *config) {
-  if (argc < 3) {
-    printf("Usage: %s <num_variables> <num_clauses> [literals_per_clause] "
-           "[allow_tautologies]\n",
-           argv[0]);
+  memset(config, 0, sizeof(*config));
+  config->family = FAMILY_RANDOM;
+  config->literals_per_clause = DEFAULT_LITERALS_PER_CLAUSE;
+  config->seed = DEFAULT_SEED;
+  config->format = FORMAT_NAMES;
+  config->threads = 1;
+  config->count = 1;
+
+  int positional = 0;
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    if (strcmp(arg, "--exact") == 0) {
+      config->exact_width = true;
+    } else if (strncmp(arg, "--seed=", 7) == 0) {
+      config->seed = strtoull(arg + 7, NULL, 10);
+    } else if (strcmp(arg, "--format=dimacs") == 0) {
+      config->format = FORMAT_DIMACS;
+    } else if (strcmp(arg, "--format=names") == 0) {
+      config->format = FORMAT_NAMES;
+    } else if (strncmp(arg, "--family=", 9) == 0) {
+      if (!parse_family(arg + 9, &config->family)) {
+        print_usage(argv[0]);
+        return false;
+      }
+    } else if (strncmp(arg, "--threads=", 10) == 0) {
+      config->threads = atoi(arg + 10);
+    } else if (strncmp(arg, "--count=", 8) == 0) {
+      config->count = atol(arg + 8);
+    } else if (strncmp(arg, "--output=", 9) == 0) {
+      config->output_path = arg + 9;
+    } else if (strncmp(arg, "--model=", 8) == 0) {
+      config->model_path = arg + 8;
+    } else if (strncmp(arg, "--holes=", 8) == 0) {
+      config->holes = atol(arg + 8);
+    } else if (strncmp(arg, "--vertices=", 11) == 0) {
+      config->vertices = atol(arg + 11);
+    } else if (strncmp(arg, "--degree=", 9) == 0) {
+      config->degree = atoi(arg + 9);
+    } else if (strncmp(arg, "--edges=", 8) == 0) {
+      config->edges = atol(arg + 8);
+    } else if (strncmp(arg, "--colours=", 10) == 0) {
+      config->colours = atoi(arg + 10);
+    } else if (strcmp(arg, "--sat") == 0) {
+      config->satisfiable = true;
+    } else if (strncmp(arg, "--steps=", 8) == 0) {
+      config->steps = atol(arg + 8);
+    } else if (strncmp(arg, "--width=", 8) == 0) {
+      config->width = atoi(arg + 8);
+    } else if (strncmp(arg, "--target=", 9) == 0) {
+      config->target = atoll(arg + 9);
+    } else if (arg[0] == '-' && arg[1] == '-') {
+      print_usage(argv[0]);
+      return false;
+    } else if (positional == 0) {
+      config->num_variables = atol(arg);
+      positional++;
+    } else if (positional == 1) {
+      config->num_clauses = atol(arg);
+      positional++;
+    } else if (positional == 2) {
+      config->literals_per_clause = atoi(arg);
+      positional++;
+    } else if (positional == 3) {
+      config->allow_tautologies = strcmp(arg, "true") == 0;
+      positional++;
+    } else {
+      print_usage(argv[0]);
+      return false;
+    }
+  }
+
+  if (config->threads < 1 || config->threads > MAX_THREADS ||
+      config->count < 1 || (config->count > 1 && !config->output_path)) {
+    printf("Threads: 1-%d; count: at least 1, and a corpus of several "
+           "instances needs --output=DIR\n",
+           MAX_THREADS);
     return false;
   }
 
-  config->num_variables = atoi(argv[1]);
-  config->num_clauses = atoi(argv[2]);
-  config->literals_per_clause =
-      (argc > 3) ? atoi(argv[3]) : MAX_LITERALS_PER_CLAUSE;
-  config->allow_tautologies =
-      (argc > 4) ? (strcmp(argv[4], "true") == 0) : false;
+  if (config->family != FAMILY_RANDOM && config->family != FAMILY_PLANTED) {
+    if (!check_family_parameters(config)) {
+      printf("Invalid parameters for the selected family\n");
+      return false;
+    }
+    return true;
+  }
 
-  if (config->num_variables <= 0 || config->num_variables > MAX_VARIABLES ||
-      config->num_clauses <= 0 || config->num_clauses > MAX_CLAUSES ||
+  if (positional < 2) {
+    print_usage(argv[0]);
+    return false;
+  }
+
+  // Planted clauses always have exactly k distinct variables
+  if (config->family == FAMILY_PLANTED) {
+    config->exact_width = true;
+    config->allow_tautologies = false;
+  }
+
+  // Distinct literals need enough variables to pick from
+  long available = config->allow_tautologies ? 2 * config->num_variables
+                                             : config->num_variables;
+  if (config->num_variables <= 0 || config->num_clauses < 0 ||
       config->literals_per_clause <= 0 ||
-      config->literals_per_clause > MAX_LITERALS_PER_CLAUSE) {
+      config->literals_per_clause > MAX_LITERALS_PER_CLAUSE ||
+      config->literals_per_clause > available) {
     printf("Invalid parameters. Please check the ranges:\n");
-    printf("Variables: 1-%d\n", MAX_VARIABLES);
-    printf("Clauses: 1-%d\n", MAX_CLAUSES);
-    printf("Literals per clause: 1-%d\n", MAX_LITERALS_PER_CLAUSE);
+    printf("Variables: at least 1\n");
+    printf("Clauses: at least 0\n");
+    printf("Literals per clause: 1-%d, and no more than the number of "
+           "distinct literals available\n",
+           MAX_LITERALS_PER_CLAUSE);
     return false;
   }
 
@@ -108,8 +1218,9 @@ int main(int argc, char *argv[]) {
     return 1;
   }
 
-  init_random();
-  generate_formula(&config);
+  if (!generate_formula(&config)) {
+    return 1;
+  }
 
   return 0;
-}
\ No newline at end of file
+}
@@ -4,11 +4,32 @@
  */
 
 #include <ctype.h>
+#include <limits.h>
+#include <math.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+
+#ifdef _WIN32
 #include <windows.h>
+#include <psapi.h>
+#else
+#include <pthread.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#ifdef LOGIC_SOLVER_TRACE
+#include <stdatomic.h>
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
 
 // Console color definitions
 #define DEFAULT_COLOR 7
@@ -24,6 +45,293 @@
 #define BASE_SIZE 100
 #define EXPANSION_RATE 2
 #define MAX_BUFFER 1024
+#define SYMBOL_INDEX_SIZE 256
+#define MAX_THREADS 64
+
+// Local search defaults
+#define DEFAULT_MAX_FLIPS 100000000ULL
+#define MIN_RESTART_INTERVAL 100000ULL
+#define RESTART_FLIPS_PER_VARIABLE 1000ULL
+#define WALKSAT_NOISE 0.567
+#define PROBSAT_EPSILON 0.9
+#define PROBSAT_MAX_BREAK 64
+
+// CDCL parameters
+#define CDCL_CLAUSE_HEADER 4
+#define CDCL_VARIABLE_DECAY 0.95
+#define CDCL_RESTART_BASE 100
+#define CDCL_FIRST_REDUCE 2000
+#define CDCL_REDUCE_INCREMENT 300
+
+// XOR reasoning
+#define XOR_CUT_SIZE 5
+#define XOR_DETECT_MIN 3
+#define XOR_DETECT_MAX 6
+#define GAUSS_MAX_BITS (1 << 22)
+
+// Engine selection
+#define FEATURE_WIDTH_BUCKETS 9
+#define TINY_VARIABLES 6
+#define TINY_CLAUSES 24
+#define RANDOM_DEGREE_SPREAD 2.0
+#define RANDOM_THRESHOLD_MARGIN 0.97
+#define AUTO_FLIPS_PER_VARIABLE 1000ULL
+#define AUTO_MIN_FLIPS 100000ULL
+
+// Cube-and-conquer
+#define DEFAULT_CUBES 4096
+#define CUBE_CANDIDATES 64
+
+// Proof output
+#define PROOF_BUFFER_SIZE (1 << 20)
+
+// Resolution checkpoints
+#define CHECKPOINT_MAGIC "LSCKPT1\n"
+#define DEFAULT_CHECKPOINT_INTERVAL 60.0
+
+// MaxSAT configuration
+#define MAXSAT_CONFLICT_CHUNK 1000
+#define MAXSAT_TRIM_ROUNDS 5
+#define MAXSAT_MINIMIZE_BUDGET 1000
+
+// Model counting
+#define DEFAULT_CACHE_MB 1024
+#define CACHE_INITIAL_BUCKETS 4096
+
+// Backbone queries
+#define BACKBONE_INITIAL_CHUNK 8
+#define BACKBONE_MAX_CHUNK 256
+
+// Decision diagrams
+#define BDD_FALSE 0
+#define BDD_TRUE 1
+#define BDD_INITIAL_NODES 4096
+#define BDD_MAX_NODES (1 << 25)
+#define BDD_SUBTABLE_BUCKETS 16
+#define BDD_CACHE_SIZE (1 << 18)
+#define BDD_FORCE_ROUNDS 20
+#define BDD_FIRST_REORDER 4096
+#define BDD_SIFT_GROWTH 1.2
+#define BDD_SIFT_MAX_SWAPS 2000000L
+#define BDD_FILE_MAGIC "LSBDD01\n"
+
+// General formulas
+#define EXPR_INITIAL_NODES 1024
+#define EXPR_POSITIVE 1
+#define EXPR_NEGATIVE 2
+#define EXPR_DEFINITION_FORMAT "@%d"
+#define CARD_PAIRWISE_MAX 4
+
+// Symmetry breaking
+#define SYMMETRY_BUDGET 50000000LL
+#define SYMMETRY_MAX_GENERATORS 1024
+#define SYMMETRY_BREAK_LENGTH 64
+
+// Solver statistics, always collected; only the report is optional
+typedef enum { STATS_NONE, STATS_TEXT, STATS_JSON } StatsFormat;
+
+typedef struct {
+  const char *engine;
+  const char *engine_reason;
+  const char *unknown_reason; // NULL: search budget or memory exhausted
+  double clause_variable_ratio;
+  double binary_fraction;
+  double mean_degree;
+  unsigned long long max_degree;
+  unsigned long long pure_literals;
+  double parse_time;
+  double solve_time;
+  unsigned long long clauses_read;
+  unsigned long long preprocess_removed;
+  unsigned long long resolvents_generated;
+  unsigned long long resolvents_tautology;
+  unsigned long long resolvents_duplicate;
+  unsigned long long resolvents_subsumed;
+  unsigned long long propagations;
+  unsigned long long conflicts;
+  unsigned long long decisions;
+  unsigned long long flips;
+  unsigned long long restarts;
+  unsigned long long peak_clause_db;
+  unsigned long long peak_rss_bytes;
+  unsigned long long components;
+  unsigned long long cubes;
+  unsigned long long cubes_refuted;
+  unsigned long long proof_steps;
+  unsigned long long proof_bytes;
+  unsigned long long core_clauses;
+  unsigned long long core_solves;
+  unsigned long long soft_clauses;
+  unsigned long long cost;
+  unsigned long long cost_lower_bound;
+  unsigned long long cache_hits;
+  unsigned long long cache_evictions;
+  unsigned long long solutions;
+  unsigned long long backbone_literals;
+  unsigned long long backbone_solves;
+  unsigned long long bdd_nodes;
+  unsigned long long bdd_peak_nodes;
+  unsigned long long bdd_collections;
+  unsigned long long bdd_reorderings;
+  unsigned long long expression_nodes;
+  unsigned long long definitions;
+  unsigned long long cardinality_constraints;
+  unsigned long long xor_constraints;
+  unsigned long long gauss_propagations;
+  unsigned long long gauss_conflicts;
+  unsigned long long symmetry_generators;
+  unsigned long long symmetry_clauses;
+  unsigned long long checkpoints;
+  unsigned long long checkpoint_bytes;
+} SolverStats;
+
+static SolverStats g_stats;
+
+#define STAT_INC(field) (g_stats.field++)
+#define STAT_ADD(field, n) (g_stats.field += (n))
+#define STAT_MAX(field, n)                                                     \
+  do {                                                                         \
+    if ((unsigned long long)(n) > g_stats.field)                               \
+      g_stats.field = (unsigned long long)(n);                                 \
+  } while (0)
+
+// Timeline tracing, compiled in only with -DLOGIC_SOLVER_TRACE
+#ifdef LOGIC_SOLVER_TRACE
+#define TRACE_CHUNK_EVENTS 16384
+#define TRACE_SAMPLE_INTERVAL 1024
+
+typedef struct {
+  const char *name;
+  double timestamp;
+  long long value;
+  char phase;
+} TraceEvent;
+
+typedef struct TraceChunk {
+  TraceEvent events[TRACE_CHUNK_EVENTS];
+  int event_count;
+  struct TraceChunk *next;
+} TraceChunk;
+
+// Each thread owns one buffer and is its only writer; buffers are published
+// through a lock-free list so the writer at exit can find them.
+typedef struct TraceBuffer {
+  TraceChunk *head;
+  TraceChunk *tail;
+  int thread_id;
+  struct TraceBuffer *next;
+} TraceBuffer;
+
+static _Atomic(TraceBuffer *) g_trace_buffers;
+static atomic_int g_trace_thread_count;
+static _Thread_local TraceBuffer *t_trace_buffer;
+static double g_trace_origin;
+static bool g_trace_enabled; // set before any thread starts, with --trace
+
+void trace_record(const char *name, char phase, long long value);
+
+#define TRACE_BEGIN(name) trace_record((name), 'B', -1)
+#define TRACE_BEGIN_N(name, n) trace_record((name), 'B', (long long)(n))
+#define TRACE_END(name) trace_record((name), 'E', -1)
+#define TRACE_COUNTER(name, n) trace_record((name), 'C', (long long)(n))
+#define TRACE_SAMPLE(name, tick, n)                                            \
+  do {                                                                         \
+    if (((tick) % TRACE_SAMPLE_INTERVAL) == 0)                                 \
+      TRACE_COUNTER(name, n);                                                  \
+  } while (0)
+#else
+#define TRACE_BEGIN(name) ((void)0)
+#define TRACE_BEGIN_N(name, n) ((void)0)
+#define TRACE_END(name) ((void)0)
+#define TRACE_COUNTER(name, n) ((void)0)
+#define TRACE_SAMPLE(name, tick, n) ((void)0)
+#endif
+
+// How a satisfying assignment is printed
+typedef enum { MODEL_LINES, MODEL_JSON, MODEL_NONE } ModelFormat;
+
+// Refutation proof formats: LRAT lists the antecedents of every step, DRAT
+// only the clauses; both in the compact binary encoding or as text
+typedef enum {
+  PROOF_LRAT,
+  PROOF_DRAT,
+  PROOF_LRAT_TEXT,
+  PROOF_DRAT_TEXT
+} ProofFormat;
+
+// Unsatisfiable-core extraction: none, any core, or a minimal one (MUS)
+typedef enum { CORE_NONE, CORE_ANY, CORE_MINIMAL } CoreMode;
+
+// Outcome of an engine; local search can give up with RESULT_UNKNOWN.
+// RESULT_ERROR, only returned by solve_formula(), is a usage error already
+// reported, such as a refused checkpoint, which is no search result.
+typedef enum {
+  RESULT_SAT,
+  RESULT_UNSAT,
+  RESULT_UNKNOWN,
+  RESULT_ERROR
+} SolveResult;
+
+// Available engines
+typedef enum {
+  ENGINE_AUTO,
+  ENGINE_RESOLUTION,
+  ENGINE_WALKSAT,
+  ENGINE_PROBSAT,
+  ENGINE_CDCL,
+  ENGINE_CUBES
+} SolverEngine;
+
+// Static variable orders of the BDD compiler
+typedef enum {
+  BDD_ORDER_FORCE,
+  BDD_ORDER_OCCURRENCE,
+  BDD_ORDER_INPUT
+} BddOrder;
+
+// Clause encodings of cardinality constraints
+typedef enum {
+  CARD_SEQUENTIAL,
+  CARD_TOTALIZER,
+  CARD_NETWORK
+} CardinalityEncoding;
+
+// Command line options
+typedef struct {
+  const char *input_path;
+  StatsFormat stats_format;
+  const char *trace_path;
+  SolverEngine engine;
+  unsigned long long seed;
+  unsigned long long max_flips;
+  unsigned long long restart_interval;
+  int threads;
+  const char *cube_path;
+  int cube_target;
+  ModelFormat model_format;
+  const char *verify_path;
+  const char *proof_path;
+  ProofFormat proof_format;
+  CoreMode core_mode;
+  const char *core_path;
+  double time_limit; // seconds of MaxSAT search, 0 = unlimited
+  bool count;        // count the models instead of finding one
+  int cache_mb;      // component cache limit of the model counter
+  bool enumerate;    // list every solution
+  const char *project; // symbols the solutions are projected onto
+  bool backbone;       // list the literals true in every model
+  bool bdd;            // compile the formula into a BDD
+  BddOrder bdd_order;
+  bool sift;                   // reorder the BDD variables by sifting
+  const char *bdd_save;        // file the compiled BDD is written to
+  const char *query_path;      // partial assignments to answer with the BDD
+  const char *equivalent_path; // formula to check for equivalence
+  CardinalityEncoding cardinality;
+  bool symmetry; // add symmetry-breaking clauses before solving
+  const char *checkpoint_path; // file the saturation state is saved to
+  double checkpoint_interval;  // seconds between checkpoints
+  bool resume;                 // continue from the checkpoint file
+} SolverOptions;
 
 // Propositional logic element structures
 typedef struct {
@@ -39,6 +347,7 @@ typedef struct {
   PropositionTerm *terms;
   int term_count;
   int max_terms;
+  unsigned long long weight; // soft clause weight, 0 for hard clauses
 } PropositionClause;
 
 typedef struct {
@@ -48,12 +357,272 @@ typedef struct {
   PropositionSymbol *symbols;
   int symbol_count;
   int max_symbols;
+  int *symbol_index; // open-addressing hash of symbol positions, -1 = empty
+  int index_capacity;
 } PropositionalFormula;
 
 // Display utilities
 void set_display_color(int color_code) {
+#ifdef _WIN32
   HANDLE console = GetStdHandle(STD_OUTPUT_HANDLE);
   SetConsoleTextAttribute(console, color_code);
+#else
+  (void)color_code;
+#endif
+}
+
+// Function to read a monotonic clock, in seconds
+double stats_now() {
+#ifdef _WIN32
+  static LARGE_INTEGER frequency;
+  LARGE_INTEGER counter;
+  if (frequency.QuadPart == 0)
+    QueryPerformanceFrequency(&frequency);
+  QueryPerformanceCounter(&counter);
+  return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+// Function to query the peak resident set size of the process, in bytes
+unsigned long long stats_peak_rss() {
+#ifdef _WIN32
+  PROCESS_MEMORY_COUNTERS counters;
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    return (unsigned long long)counters.PeakWorkingSetSize;
+  return 0;
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+#ifdef __APPLE__
+  return (unsigned long long)usage.ru_maxrss;
+#else
+  return (unsigned long long)usage.ru_maxrss * 1024ULL;
+#endif
+#endif
+}
+
+// Portable threads and locks
+#ifdef _WIN32
+typedef HANDLE ThreadHandle;
+typedef SRWLOCK SolverMutex;
+#define SOLVER_MUTEX_INIT SRWLOCK_INIT
+#else
+typedef pthread_t ThreadHandle;
+typedef pthread_mutex_t SolverMutex;
+#define SOLVER_MUTEX_INIT PTHREAD_MUTEX_INITIALIZER
+#endif
+
+typedef struct {
+  void (*function)(void *);
+  void *argument;
+} ThreadStart;
+
+#ifdef _WIN32
+static DWORD WINAPI thread_entry(LPVOID data) {
+  ThreadStart *start = data;
+  start->function(start->argument);
+  return 0;
+}
+#else
+static void *thread_entry(void *data) {
+  ThreadStart *start = data;
+  start->function(start->argument);
+  return NULL;
+}
+#endif
+
+// Function to start a thread; start must stay valid until it is joined
+bool start_thread(ThreadHandle *thread, ThreadStart *start) {
+#ifdef _WIN32
+  *thread = CreateThread(NULL, 0, thread_entry, start, 0, NULL);
+  return *thread != NULL;
+#else
+  return pthread_create(thread, NULL, thread_entry, start) == 0;
+#endif
+}
+
+// Function to wait for a thread to finish
+void join_thread(ThreadHandle thread) {
+#ifdef _WIN32
+  WaitForSingleObject(thread, INFINITE);
+  CloseHandle(thread);
+#else
+  pthread_join(thread, NULL);
+#endif
+}
+
+// Function to run function(argument) on threads threads, the calling thread
+// included; threads that cannot start are simply not used
+void run_workers(void (*function)(void *), void *argument, int threads) {
+  ThreadHandle handles[MAX_THREADS];
+  ThreadStart start = {function, argument};
+  bool started[MAX_THREADS];
+
+  for (int i = 1; i < threads; i++)
+    started[i] = start_thread(&handles[i], &start);
+  function(argument);
+  for (int i = 1; i < threads; i++) {
+    if (started[i])
+      join_thread(handles[i]);
+  }
+}
+
+// Function to lock a mutex
+void lock_mutex(SolverMutex *mutex) {
+#ifdef _WIN32
+  AcquireSRWLockExclusive(mutex);
+#else
+  pthread_mutex_lock(mutex);
+#endif
+}
+
+// Function to unlock a mutex
+void unlock_mutex(SolverMutex *mutex) {
+#ifdef _WIN32
+  ReleaseSRWLockExclusive(mutex);
+#else
+  pthread_mutex_unlock(mutex);
+#endif
+}
+
+// Function to count the online processors
+int cpu_count() {
+#ifdef _WIN32
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  int count = (int)info.dwNumberOfProcessors;
+#else
+  int count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+  if (count < 1)
+    return 1;
+  return count < MAX_THREADS ? count : MAX_THREADS;
+}
+
+// Engines running on worker threads batch their counters and add them
+// under this lock
+static SolverMutex g_stats_mutex = SOLVER_MUTEX_INIT;
+
+// Function to print the collected statistics
+void print_stats(StatsFormat format, const char *result) {
+  g_stats.peak_rss_bytes = stats_peak_rss();
+
+  if (!g_stats.engine) {
+    g_stats.engine = "none";
+    g_stats.engine_reason = "not run";
+  }
+
+  // The JSON object goes to stderr, apart from the banner and the result
+  if (format == STATS_JSON) {
+    fprintf(stderr,
+            "{\"result\":\"%s\",\"engine\":\"%s\",\"engine_reason\":\"%s\","
+            "\"clause_variable_ratio\":%.4f,\"binary_fraction\":%.4f,"
+            "\"mean_degree\":%.4f,\"max_degree\":%llu,"
+            "\"pure_literals\":%llu,\"parse_time\":%.6f,\"solve_time\":%.6f,"
+            "\"clauses_read\":%llu,\"preprocess_removed\":%llu,"
+            "\"resolvents_generated\":%llu,\"resolvents_tautology\":%llu,"
+            "\"resolvents_duplicate\":%llu,\"resolvents_subsumed\":%llu,"
+            "\"propagations\":%llu,\"conflicts\":%llu,\"decisions\":%llu,"
+            "\"flips\":%llu,"
+            "\"restarts\":%llu,\"peak_clause_db\":%llu,"
+            "\"peak_rss_bytes\":%llu,\"components\":%llu,\"cubes\":%llu,"
+            "\"cubes_refuted\":%llu,\"proof_steps\":%llu,"
+            "\"proof_bytes\":%llu,\"core_clauses\":%llu,"
+            "\"core_solves\":%llu,\"soft_clauses\":%llu,\"cost\":%llu,"
+            "\"cost_lower_bound\":%llu,\"cache_hits\":%llu,"
+            "\"cache_evictions\":%llu,\"solutions\":%llu,"
+            "\"backbone_literals\":%llu,\"backbone_solves\":%llu,"
+            "\"bdd_nodes\":%llu,\"bdd_peak_nodes\":%llu,"
+            "\"bdd_collections\":%llu,\"bdd_reorderings\":%llu,"
+            "\"expression_nodes\":%llu,\"definitions\":%llu,"
+            "\"cardinality_constraints\":%llu,\"xor_constraints\":%llu,"
+            "\"gauss_propagations\":%llu,\"gauss_conflicts\":%llu,"
+            "\"symmetry_generators\":%llu,\"symmetry_clauses\":%llu,"
+            "\"checkpoints\":%llu,\"checkpoint_bytes\":%llu}\n",
+            result, g_stats.engine, g_stats.engine_reason,
+            g_stats.clause_variable_ratio, g_stats.binary_fraction,
+            g_stats.mean_degree, g_stats.max_degree, g_stats.pure_literals,
+            g_stats.parse_time, g_stats.solve_time,
+            g_stats.clauses_read, g_stats.preprocess_removed,
+            g_stats.resolvents_generated, g_stats.resolvents_tautology,
+            g_stats.resolvents_duplicate, g_stats.resolvents_subsumed,
+            g_stats.propagations, g_stats.conflicts, g_stats.decisions,
+            g_stats.flips,
+            g_stats.restarts, g_stats.peak_clause_db, g_stats.peak_rss_bytes,
+            g_stats.components, g_stats.cubes, g_stats.cubes_refuted,
+            g_stats.proof_steps, g_stats.proof_bytes, g_stats.core_clauses,
+            g_stats.core_solves, g_stats.soft_clauses, g_stats.cost,
+            g_stats.cost_lower_bound, g_stats.cache_hits,
+            g_stats.cache_evictions, g_stats.solutions,
+            g_stats.backbone_literals, g_stats.backbone_solves,
+            g_stats.bdd_nodes, g_stats.bdd_peak_nodes, g_stats.bdd_collections,
+            g_stats.bdd_reorderings, g_stats.expression_nodes,
+            g_stats.definitions, g_stats.cardinality_constraints,
+            g_stats.xor_constraints, g_stats.gauss_propagations,
+            g_stats.gauss_conflicts, g_stats.symmetry_generators,
+            g_stats.symmetry_clauses, g_stats.checkpoints,
+            g_stats.checkpoint_bytes);
+  } else if (format == STATS_TEXT) {
+    printf("\nStatistics:\n");
+    printf("  Engine:                %s (%s)\n", g_stats.engine,
+           g_stats.engine_reason);
+    printf("  Clause/variable ratio: %.4f\n", g_stats.clause_variable_ratio);
+    printf("  Binary clauses:        %.2f%%\n", 100.0 * g_stats.binary_fraction);
+    printf("  Variable degree:       mean %.2f, max %llu\n",
+           g_stats.mean_degree, g_stats.max_degree);
+    printf("  Pure literals:         %llu\n", g_stats.pure_literals);
+    printf("  Components:            %llu\n", g_stats.components);
+    printf("  Cubes:                 %llu (%llu branches refuted)\n",
+           g_stats.cubes, g_stats.cubes_refuted);
+    printf("  Parse time:            %.6f s\n", g_stats.parse_time);
+    printf("  Solve time:            %.6f s\n", g_stats.solve_time);
+    printf("  Clauses read:          %llu\n", g_stats.clauses_read);
+    printf("  Preprocess removals:   %llu\n", g_stats.preprocess_removed);
+    printf("  Resolvents generated:  %llu\n", g_stats.resolvents_generated);
+    printf("    rejected tautology:  %llu\n", g_stats.resolvents_tautology);
+    printf("    rejected duplicate:  %llu\n", g_stats.resolvents_duplicate);
+    printf("    rejected subsumed:   %llu\n", g_stats.resolvents_subsumed);
+    printf("  Propagations:          %llu\n", g_stats.propagations);
+    printf("  Conflicts:             %llu\n", g_stats.conflicts);
+    printf("  Decisions:             %llu\n", g_stats.decisions);
+    printf("  Flips:                 %llu\n", g_stats.flips);
+    printf("  Restarts:              %llu\n", g_stats.restarts);
+    printf("  Peak clause database:  %llu\n", g_stats.peak_clause_db);
+    printf("  Peak RSS:              %llu bytes\n", g_stats.peak_rss_bytes);
+    printf("  Proof:                 %llu steps, %llu bytes\n",
+           g_stats.proof_steps, g_stats.proof_bytes);
+    printf("  Core:                  %llu clauses, %llu solver calls\n",
+           g_stats.core_clauses, g_stats.core_solves);
+    printf("  MaxSAT cost:           %llu (lower bound %llu, %llu soft "
+           "clauses)\n",
+           g_stats.cost, g_stats.cost_lower_bound, g_stats.soft_clauses);
+    printf("  Component cache:       %llu hits, %llu evictions\n",
+           g_stats.cache_hits, g_stats.cache_evictions);
+    printf("  Solutions enumerated:  %llu\n", g_stats.solutions);
+    printf("  Backbone:              %llu literals, %llu solver calls\n",
+           g_stats.backbone_literals, g_stats.backbone_solves);
+    printf("  BDD:                   %llu nodes (peak %llu), %llu "
+           "collections, %llu reorderings\n",
+           g_stats.bdd_nodes, g_stats.bdd_peak_nodes, g_stats.bdd_collections,
+           g_stats.bdd_reorderings);
+    printf("  General formulas:      %llu DAG nodes, %llu definitions\n",
+           g_stats.expression_nodes, g_stats.definitions);
+    printf("  Cardinality:           %llu constraints\n",
+           g_stats.cardinality_constraints);
+    printf("  XOR reasoning:         %llu constraints, %llu propagations, "
+           "%llu conflicts\n",
+           g_stats.xor_constraints, g_stats.gauss_propagations,
+           g_stats.gauss_conflicts);
+    printf("  Symmetry:              %llu generators, %llu breaking clauses\n",
+           g_stats.symmetry_generators, g_stats.symmetry_clauses);
+    printf("  Checkpoints:           %llu written, %llu bytes\n",
+           g_stats.checkpoints, g_stats.checkpoint_bytes);
+  }
 }
 
 void display_header() {
@@ -77,6 +646,81 @@ void display_header() {
   set_display_color(DEFAULT_COLOR);
 }
 
+#ifdef LOGIC_SOLVER_TRACE
+// Function to append an event to the calling thread's trace buffer
+void trace_record(const char *name, char phase, long long value) {
+  if (!g_trace_enabled)
+    return;
+  TraceBuffer *buffer = t_trace_buffer;
+  if (!buffer) {
+    buffer = calloc(1, sizeof(TraceBuffer));
+    if (!buffer)
+      return;
+    buffer->thread_id = atomic_fetch_add(&g_trace_thread_count, 1) + 1;
+    buffer->next = atomic_load(&g_trace_buffers);
+    while (!atomic_compare_exchange_weak(&g_trace_buffers, &buffer->next,
+                                         buffer))
+      ;
+    t_trace_buffer = buffer;
+  }
+
+  TraceChunk *chunk = buffer->tail;
+  if (!chunk || chunk->event_count == TRACE_CHUNK_EVENTS) {
+    TraceChunk *new_chunk = malloc(sizeof(TraceChunk));
+    if (!new_chunk)
+      return;
+    new_chunk->event_count = 0;
+    new_chunk->next = NULL;
+    if (chunk)
+      chunk->next = new_chunk;
+    else
+      buffer->head = new_chunk;
+    buffer->tail = new_chunk;
+    chunk = new_chunk;
+  }
+
+  TraceEvent *event = &chunk->events[chunk->event_count++];
+  event->name = name;
+  event->timestamp = stats_now();
+  event->value = value;
+  event->phase = phase;
+}
+
+// Function to write all recorded events as Chrome trace-event JSON
+bool trace_write(const char *path) {
+  FILE *file = fopen(path, "w");
+  if (!file)
+    return false;
+
+  fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+  bool first = true;
+  for (TraceBuffer *buffer = atomic_load(&g_trace_buffers); buffer;
+       buffer = buffer->next) {
+    for (TraceChunk *chunk = buffer->head; chunk; chunk = chunk->next) {
+      for (int i = 0; i < chunk->event_count; i++) {
+        TraceEvent *event = &chunk->events[i];
+        fprintf(file,
+                "%s\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,"
+                "\"pid\":1,\"tid\":%d",
+                first ? "" : ",", event->name, event->phase,
+                (event->timestamp - g_trace_origin) * 1e6, buffer->thread_id);
+        if (event->phase == 'C')
+          fprintf(file, ",\"args\":{\"%s\":%lld}", event->name,
+                  event->value);
+        else if (event->value >= 0)
+          fprintf(file, ",\"args\":{\"index\":%lld}", event->value);
+        fprintf(file, "}");
+        first = false;
+      }
+    }
+  }
+  fprintf(file, "\n]}\n");
+
+  bool ok = !ferror(file);
+  return fclose(file) == 0 && ok;
+}
+#endif
+
 // Function to initialize a proposition symbol
 void init_symbol(PropositionSymbol *symbol) { symbol->symbol[0] = '\0'; }
 
@@ -92,6 +736,7 @@ bool init_clause(PropositionClause *clause) {
     return false;
   clause->term_count = 0;
   clause->max_terms = BASE_SIZE;
+  clause->weight = 0;
   return true;
 }
 
@@ -107,15 +752,19 @@ void free_clause(PropositionClause *clause) {
 bool init_formula(PropositionalFormula *formula) {
   formula->clauses = malloc(BASE_SIZE * sizeof(PropositionClause));
   formula->symbols = malloc(BASE_SIZE * sizeof(PropositionSymbol));
-  if (!formula->clauses || !formula->symbols) {
+  formula->symbol_index = malloc(SYMBOL_INDEX_SIZE * sizeof(int));
+  if (!formula->clauses || !formula->symbols || !formula->symbol_index) {
     free(formula->clauses);
     free(formula->symbols);
+    free(formula->symbol_index);
     return false;
   }
   formula->clause_count = 0;
   formula->max_clauses = BASE_SIZE;
   formula->symbol_count = 0;
   formula->max_symbols = BASE_SIZE;
+  formula->index_capacity = SYMBOL_INDEX_SIZE;
+  memset(formula->symbol_index, -1, SYMBOL_INDEX_SIZE * sizeof(int));
   return true;
 }
 
@@ -126,24 +775,83 @@ void free_formula(PropositionalFormula *formula) {
   }
   free(formula->clauses);
   free(formula->symbols);
+  free(formula->symbol_index);
   formula->clauses = NULL;
   formula->symbols = NULL;
+  formula->symbol_index = NULL;
   formula->clause_count = 0;
   formula->max_clauses = 0;
   formula->symbol_count = 0;
   formula->max_symbols = 0;
+  formula->index_capacity = 0;
+}
+
+// Function to hash a symbol name (FNV-1a)
+unsigned int hash_symbol(const char *symbol) {
+  unsigned int hash = 2166136261u;
+  for (; *symbol; symbol++) {
+    hash ^= (unsigned char)*symbol;
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+// Function to double the symbol hash index and reinsert every symbol
+bool grow_symbol_index(PropositionalFormula *formula) {
+  int new_capacity = formula->index_capacity * EXPANSION_RATE;
+  int *new_index = malloc(new_capacity * sizeof(int));
+  if (!new_index)
+    return false;
+  memset(new_index, -1, new_capacity * sizeof(int));
+
+  for (int i = 0; i < formula->symbol_count; i++) {
+    unsigned int slot = hash_symbol(formula->symbols[i].symbol) &
+                        (unsigned int)(new_capacity - 1);
+    while (new_index[slot] >= 0)
+      slot = (slot + 1) & (unsigned int)(new_capacity - 1);
+    new_index[slot] = i;
+  }
+  free(formula->symbol_index);
+  formula->symbol_index = new_index;
+  formula->index_capacity = new_capacity;
+  return true;
+}
+
+// Function to find a symbol without adding it; -1 when absent
+int find_symbol(const PropositionalFormula *formula, const char *symbol) {
+  unsigned int mask = (unsigned int)(formula->index_capacity - 1);
+  for (unsigned int slot = hash_symbol(symbol) & mask;
+       formula->symbol_index[slot] >= 0; slot = (slot + 1) & mask) {
+    int i = formula->symbol_index[slot];
+    if (strcmp(formula->symbols[i].symbol, symbol) == 0)
+      return i;
+  }
+  return -1;
 }
 
 // Function to find or add a symbol to the formula
 int find_or_add_symbol(PropositionalFormula *formula, const char *symbol) {
   // First try to find the symbol
-  for (int i = 0; i < formula->symbol_count; i++) {
+  unsigned int mask = (unsigned int)(formula->index_capacity - 1);
+  unsigned int slot = hash_symbol(symbol) & mask;
+  while (formula->symbol_index[slot] >= 0) {
+    int i = formula->symbol_index[slot];
     if (strcmp(formula->symbols[i].symbol, symbol) == 0) {
       return i;
     }
+    slot = (slot + 1) & mask;
+  }
+
+  // If not found, add it, keeping the index at most half full
+  if (2 * (formula->symbol_count + 1) > formula->index_capacity) {
+    if (!grow_symbol_index(formula))
+      return -1;
+    mask = (unsigned int)(formula->index_capacity - 1);
+    slot = hash_symbol(symbol) & mask;
+    while (formula->symbol_index[slot] >= 0)
+      slot = (slot + 1) & mask;
   }
 
-  // If not found, add it
   if (formula->symbol_count >= formula->max_symbols) {
     int new_capacity = formula->max_symbols * EXPANSION_RATE;
     PropositionSymbol *new_symbols =
@@ -157,6 +865,7 @@ int find_or_add_symbol(PropositionalFormula *formula, const char *symbol) {
   strncpy(formula->symbols[formula->symbol_count].symbol, symbol,
           MAX_SYMBOL_LEN - 1);
   formula->symbols[formula->symbol_count].symbol[MAX_SYMBOL_LEN - 1] = '\0';
+  formula->symbol_index[slot] = formula->symbol_count;
   return formula->symbol_count++;
 }
 
@@ -236,6 +945,21 @@ bool clauses_equal(PropositionClause *c1, PropositionClause *c2) {
   return true;
 }
 
+// Function to check if every term of c1 also appears in c2
+bool clause_subsumes(PropositionClause *c1, PropositionClause *c2) {
+  if (c1->term_count > c2->term_count) {
+    return false;
+  }
+
+  for (int i = 0; i < c1->term_count; i++) {
+    if (!clause_contains(c2, c1->terms[i].symbol.symbol,
+                         c1->terms[i].is_negated)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 // Function to check if a formula already contains a clause
 bool formula_contains(PropositionalFormula *formula,
                       PropositionClause *clause) {
@@ -277,6 +1001,12 @@ bool resolve(PropositionClause *c1, PropositionClause *c2,
   return true;
 }
 
+// Function to check if a symbol is a definition variable ("@1", ...) made
+// while encoding, which no valid symbol name can clash with
+bool is_definition_symbol(const char *name) {
+  return name[0] == '@';
+}
+
 // Function to check if a string is a valid symbol name
 bool is_valid_symbol_name(const char *name) {
   if (!name || !*name)
@@ -295,18 +1025,17 @@ bool is_valid_symbol_name(const char *name) {
   return true;
 }
 
-// Function to copy a clause properly
+// Function to copy a clause properly, sized to the source so stored
+// clauses do not each keep BASE_SIZE terms
 bool copy_clause(PropositionClause *dest, PropositionClause *src) {
-  if (!init_clause(dest))
+  int capacity = src->term_count > 0 ? src->term_count : 1;
+  dest->terms = malloc(capacity * sizeof(PropositionTerm));
+  if (!dest->terms)
     return false;
-
-  for (int i = 0; i < src->term_count; i++) {
-    if (!add_term(dest, src->terms[i].symbol.symbol,
-                  src->terms[i].is_negated)) {
-      free_clause(dest);
-      return false;
-    }
-  }
+  memcpy(dest->terms, src->terms, src->term_count * sizeof(PropositionTerm));
+  dest->term_count = src->term_count;
+  dest->max_terms = capacity;
+  dest->weight = src->weight;
   return true;
 }
 
@@ -339,6 +1068,7 @@ bool unit_propagation(PropositionalFormula *formula) {
       if (formula->clauses[i].term_count == 1) {
         // Found a unit clause
         PropositionTerm unit = formula->clauses[i].terms[0];
+        STAT_INC(propagations);
 
         // Propagate through other clauses
         for (int j = 0; j < formula->clause_count; j++) {
@@ -374,231 +1104,10156 @@ bool unit_propagation(PropositionalFormula *formula) {
   return true;
 }
 
-// Function to perform resolution by refutation
-bool resolution(PropositionalFormula *formula) {
-  // Create a working set of clauses
-  PropositionClause *work_clauses =
-      malloc(BASE_SIZE * sizeof(PropositionClause));
-  int work_capacity = BASE_SIZE;
-  int work_size = 0;
-
-  if (!work_clauses)
-    return true; // Memory error, assume satisfiable
-
-  // Copy original clauses to working set
-  for (int i = 0; i < formula->clause_count; i++) {
-    if (work_size >= work_capacity) {
-      int new_capacity = work_capacity * EXPANSION_RATE;
-      PropositionClause *new_work =
-          realloc(work_clauses, new_capacity * sizeof(PropositionClause));
-      if (!new_work) {
-        // Clean up and return
-        for (int j = 0; j < work_size; j++) {
-          free_clause(&work_clauses[j]);
-        }
-        free(work_clauses);
-        return true; // Memory error, assume satisfiable
-      }
-      work_clauses = new_work;
-      work_capacity = new_capacity;
-    }
+// Function to number the variables for output files (iCNF cubes, proofs).
+// Formulas read from DIMACS keep their variable numbers, so the files match
+// the input; otherwise variable v is numbered v, and *renumbered is set
+// when not NULL. Returns a malloc'd array indexed by variable, or NULL when
+// out of memory.
+int *external_numbers(const PropositionalFormula *formula, bool *renumbered) {
+  int vars = formula->symbol_count;
+  int *number = malloc((vars + 1) * sizeof(int));
+  if (!number)
+    return NULL;
 
-    if (!copy_clause(&work_clauses[work_size], &formula->clauses[i])) {
-      // Clean up and return
-      for (int j = 0; j < work_size; j++) {
-        free_clause(&work_clauses[j]);
-      }
-      free(work_clauses);
-      return true; // Memory error, assume satisfiable
-    }
-    work_size++;
+  bool dimacs_names = true;
+  for (int v = 1; v <= vars && dimacs_names; v++) {
+    const char *name = formula->symbols[v - 1].symbol;
+    dimacs_names = name[0] == 'x' && name[1] >= '1' && name[1] <= '9';
+    for (int i = 2; dimacs_names && name[i]; i++)
+      dimacs_names = isdigit((unsigned char)name[i]);
   }
+  if (renumbered)
+    *renumbered = !dimacs_names;
+  number[0] = 0;
+  for (int v = 1; v <= vars; v++)
+    number[v] = dimacs_names ? atoi(formula->symbols[v - 1].symbol + 1) : v;
+  return number;
+}
 
-  // Perform resolution
-  bool found_empty = false;
-  int start = 0;
+// Refutation proof being streamed to a file. Steps are encoded into one of
+// two buffers; a full buffer is handed to a writer thread while the solver
+// fills the other, so the solver only waits when the disk falls behind.
+typedef struct {
+  FILE *file;
+  bool hints;          // LRAT: every step lists its antecedent clause ids
+  bool binary;         // "a"/"d" bytes and variable-length numbers
+  const int *number;   // external variable numbers, by variable
+  unsigned char *buffers[2];
+  size_t fill;
+  int active;          // buffer being filled
+  ThreadHandle writer;
+  ThreadStart start;
+  bool writing;        // writer thread owns the other buffer
+  const unsigned char *pending;
+  size_t pending_size;
+  bool failed;
+  int last_id;         // newest clause id, named by text LRAT deletions
+} ProofWriter;
 
-  while (start < work_size && !found_empty) {
-    int end = work_size;
-
-    for (int i = 0; i < end && !found_empty; i++) {
-      for (int j = i + 1; j < end && !found_empty; j++) {
-        // Try each term in clause i
-        for (int k = 0; k < work_clauses[i].term_count; k++) {
-          const char *symbol = work_clauses[i].terms[k].symbol.symbol;
-          bool is_negated = work_clauses[i].terms[k].is_negated;
-
-          // Look for complementary term
-          if (clause_contains(&work_clauses[j], symbol, !is_negated)) {
-            PropositionClause resolvant;
-            if (!init_clause(&resolvant))
-              continue;
-
-            if (resolve(&work_clauses[i], &work_clauses[j], symbol, is_negated,
-                        &resolvant)) {
-              if (is_empty_clause(&resolvant)) {
-                found_empty = true;
-                free_clause(&resolvant);
-                break;
-              }
+// Function run by the writer thread: write out the pending buffer
+void proof_write_pending(void *argument) {
+  ProofWriter *proof = argument;
+  if (fwrite(proof->pending, 1, proof->pending_size, proof->file) !=
+      proof->pending_size)
+    proof->failed = true;
+}
 
-              // Check if this is a new clause
-              bool is_new = true;
-              for (int m = 0; m < work_size; m++) {
-                if (clauses_equal(&work_clauses[m], &resolvant)) {
-                  is_new = false;
-                  break;
-                }
-              }
+// Function to hand the filled buffer to the writer thread, first waiting
+// for the previous write to finish
+void proof_flush(ProofWriter *proof) {
+  if (proof->writing) {
+    join_thread(proof->writer);
+    proof->writing = false;
+  }
+  if (proof->fill == 0)
+    return;
+  STAT_ADD(proof_bytes, proof->fill);
+  proof->pending = proof->buffers[proof->active];
+  proof->pending_size = proof->fill;
+  proof->start.function = proof_write_pending;
+  proof->start.argument = proof;
+  proof->writing = start_thread(&proof->writer, &proof->start);
+  if (!proof->writing)
+    proof_write_pending(proof);
+  proof->active ^= 1;
+  proof->fill = 0;
+}
 
-              if (is_new) {
-                if (work_size >= work_capacity) {
-                  int new_capacity = work_capacity * EXPANSION_RATE;
-                  PropositionClause *new_work = realloc(
-                      work_clauses, new_capacity * sizeof(PropositionClause));
-                  if (!new_work) {
-                    free_clause(&resolvant);
-                    continue;
-                  }
-                  work_clauses = new_work;
-                  work_capacity = new_capacity;
-                }
-                work_clauses[work_size++] = resolvant;
-              } else {
-                free_clause(&resolvant);
-              }
-            }
-          }
-        }
-      }
+// Function to append one byte to the proof
+static inline void proof_byte(ProofWriter *proof, unsigned char byte) {
+  if (proof->fill == PROOF_BUFFER_SIZE)
+    proof_flush(proof);
+  proof->buffers[proof->active][proof->fill++] = byte;
+}
+
+// Function to append a signed number: in binary as the variable-length
+// encoding of 2|n| + sign, in text as a decimal followed by a space
+void proof_number(ProofWriter *proof, long long n) {
+  if (proof->binary) {
+    unsigned long long code =
+        n < 0 ? 2 * (unsigned long long)-n + 1 : 2 * (unsigned long long)n;
+    while (code > 127) {
+      proof_byte(proof, (unsigned char)(code & 127) | 128);
+      code >>= 7;
     }
-    start = end;
+    proof_byte(proof, (unsigned char)code);
+  } else {
+    char text[24];
+    int length = snprintf(text, sizeof(text), "%lld ", n);
+    for (int i = 0; i < length; i++)
+      proof_byte(proof, (unsigned char)text[i]);
   }
+}
 
-  // Clean up
-  for (int i = 0; i < work_size; i++) {
-    free_clause(&work_clauses[i]);
+// Function to end a list of literals or ids with 0, and the line when last
+void proof_terminate(ProofWriter *proof, bool last) {
+  if (proof->binary) {
+    proof_byte(proof, 0);
+  } else {
+    proof_byte(proof, '0');
+    proof_byte(proof, last ? '\n' : ' ');
   }
-  free(work_clauses);
+}
 
-  return !found_empty;
+// Function to append a literal given as a signed variable
+static inline void proof_literal(ProofWriter *proof, int lit) {
+  proof_number(proof, lit > 0 ? proof->number[lit] : -proof->number[-lit]);
 }
 
-// Function to read a formula from a file
-bool read_formula_from_file(const char *filename,
-                            PropositionalFormula *formula) {
-  FILE *file = fopen(filename, "r");
-  if (!file) {
-    printf("Error: Unable to open file %s\n", filename);
-    return false;
+// Function to start an added clause. A step is written as
+// proof_add_begin(), its literals, proof_hints_begin(), the ids of its
+// antecedents (dropped unless LRAT) and proof_add_end().
+void proof_add_begin(ProofWriter *proof, int id) {
+  STAT_INC(proof_steps);
+  proof->last_id = id;
+  if (proof->binary)
+    proof_byte(proof, 'a');
+  if (proof->hints)
+    proof_number(proof, id);
+}
+
+// Function to end the literals of an added clause
+void proof_hints_begin(ProofWriter *proof) {
+  proof_terminate(proof, !proof->hints);
+}
+
+// Function to append an antecedent id of an added clause
+static inline void proof_hint(ProofWriter *proof, int id) {
+  if (proof->hints)
+    proof_number(proof, id);
+}
+
+// Function to end an added clause
+void proof_add_end(ProofWriter *proof) {
+  if (proof->hints)
+    proof_terminate(proof, true);
+}
+
+// Function to start a deletion, followed by the clause id (LRAT) or its
+// literals (DRAT) and proof_terminate(proof, true)
+void proof_delete_begin(ProofWriter *proof) {
+  if (proof->binary) {
+    proof_byte(proof, 'd');
+    return;
   }
+  if (proof->hints)
+    proof_number(proof, proof->last_id);
+  proof_byte(proof, 'd');
+  proof_byte(proof, ' ');
+}
 
-  if (!init_formula(formula)) {
-    printf("Error: Failed to initialize formula\n");
-    fclose(file);
+// Function to open a proof file; number maps variables to the numbers
+// written and must outlive the writer
+bool open_proof(ProofWriter *proof, const char *path, ProofFormat format,
+                const int *number) {
+  memset(proof, 0, sizeof(*proof));
+  proof->hints = format == PROOF_LRAT || format == PROOF_LRAT_TEXT;
+  proof->binary = format == PROOF_LRAT || format == PROOF_DRAT;
+  proof->number = number;
+  proof->buffers[0] = malloc(PROOF_BUFFER_SIZE);
+  proof->buffers[1] = malloc(PROOF_BUFFER_SIZE);
+  proof->file = fopen(path, proof->binary ? "wb" : "w");
+  if (!proof->buffers[0] || !proof->buffers[1] || !proof->file) {
+    free(proof->buffers[0]);
+    free(proof->buffers[1]);
+    if (proof->file)
+      fclose(proof->file);
+    printf("Error: Unable to write proof file %s\n", path);
     return false;
   }
+  return true;
+}
 
-  char line[MAX_BUFFER];
-  int line_num = 0;
+// Function to write out the rest of a proof and close it
+bool close_proof(ProofWriter *proof) {
+  proof_flush(proof);
+  proof_flush(proof); // waits for the last write
+  if (fclose(proof->file) != 0)
+    proof->failed = true;
+  free(proof->buffers[0]);
+  free(proof->buffers[1]);
+  return !proof->failed;
+}
 
-  while (fgets(line, sizeof(line), file)) {
-    line_num++;
+// Function to compare ints, for qsort
+int compare_ints(const void *a, const void *b) {
+  int x = *(const int *)a, y = *(const int *)b;
+  return x < y ? -1 : x > y;
+}
 
-    // Remove trailing newline and whitespace
-    char *end = line + strlen(line) - 1;
-    while (end >= line && isspace(*end))
-      *end-- = '\0';
+// Clause built in a scratch buffer, as sorted literal codes 2v + sign with
+// v the symbol position + 1, so that a variable's two literals sit side by
+// side. The signatures have bit v % 64 set for each positive and each
+// negative literal.
+typedef struct {
+  int *literals;
+  int count;
+  unsigned long long positive;
+  unsigned long long negative;
+  unsigned long long hash;
+} Resolvent;
 
-    // Skip empty lines and comments
-    if (line[0] == '\0' || line[0] == '#')
-      continue;
+// Clauses of the saturation, in one literal array: clause c spans
+// literals[start[c] .. start[c + 1]) and keeps the signatures and hash of
+// the Resolvent it was added from. Equal clauses are found through an
+// open-addressing table over the hashes, and subsuming ones through lists
+// that hold each clause, shortest clauses first, under one of its literals:
+// the one with the fewest clauses when it was added.
+typedef struct {
+  int *literals;
+  int literal_capacity;
+  int *start; // count + 1 entries
+  unsigned long long *positive;
+  unsigned long long *negative;
+  unsigned long long *hash;
+  int count;
+  int capacity;
+  int longest; // most literals in one clause
+  int *table;  // clause indices, -1 = empty
+  int table_capacity;
+  int **occurs;         // clauses listed under each literal code
+  int *occurs_size;     // entries of each list
+  int *occurs_capacity; // room of each list
+  int code_capacity;
+} ClauseStore;
 
-    PropositionClause clause;
-    if (!init_clause(&clause)) {
-      free_formula(formula);
-      fclose(file);
-      return false;
-    }
+// Function to start an empty resolvent
+static inline void resolvent_clear(Resolvent *r) {
+  r->count = 0;
+  r->positive = 0;
+  r->negative = 0;
+  r->hash = 0xcbf29ce484222325ULL;
+}
 
-    char *token = strtok(line, " \t");
-    while (token) {
-      bool is_negated = (token[0] == '!');
-      char *symbol_name = token + (is_negated ? 1 : 0);
+// Function to append a literal code to a resolvent
+static inline void resolvent_push(Resolvent *r, int code) {
+  r->literals[r->count++] = code;
+  if (code & 1)
+    r->negative |= 1ULL << ((code >> 1) & 63);
+  else
+    r->positive |= 1ULL << ((code >> 1) & 63);
+  r->hash = (r->hash ^ (unsigned int)code) * 0x100000001b3ULL;
+}
 
-      if (!is_valid_symbol_name(symbol_name)) {
-        free_clause(&clause);
-        free_formula(formula);
-        fclose(file);
-        return false;
-      }
+// Function to merge the sorted clauses a and b into r, whose buffer holds
+// a_count + b_count codes, dropping repeated literals. Returns the number
+// of clashing variables, stopping at the second: one clash leaves their
+// resolvent on it in r, two or more (counting a complementary pair inside
+// a or b) make every resolvent a tautology, and none leaves nothing to
+// resolve on.
+int resolvent_merge(const int *a, int a_count, const int *b, int b_count,
+                    Resolvent *r) {
+  int clashes = 0, x = 0, y = 0;
+  resolvent_clear(r);
+  while (x < a_count || y < b_count) {
+    int code;
+    if (y == b_count || (x < a_count && a[x] >> 1 < b[y] >> 1)) {
+      code = a[x++];
+    } else if (x == a_count || b[y] >> 1 < a[x] >> 1) {
+      code = b[y++];
+    } else if (a[x] == b[y]) {
+      code = a[x++];
+      y++;
+    } else {
+      if (++clashes > 1)
+        return clashes;
+      x++;
+      y++;
+      continue;
+    }
+    // In sorted order a complementary pair sits side by side
+    if (r->count > 0 && r->literals[r->count - 1] == (code ^ 1))
+      return 2;
+    resolvent_push(r, code);
+  }
+  return clashes;
+}
 
-      if (!add_term(&clause, symbol_name, is_negated)) {
-        free_clause(&clause);
-        free_formula(formula);
-        fclose(file);
-        return false;
-      }
+// Function to get the number of literals of a stored clause
+static inline int clause_store_size(const ClauseStore *store, int c) {
+  return store->start[c + 1] - store->start[c];
+}
 
-      token = strtok(NULL, " \t");
-    }
+// Function to free a clause store
+void free_clause_store(ClauseStore *store) {
+  free(store->literals);
+  free(store->start);
+  free(store->positive);
+  free(store->negative);
+  free(store->hash);
+  free(store->table);
+  for (int code = 0; store->occurs && code < store->code_capacity; code++)
+    free(store->occurs[code]);
+  free(store->occurs);
+  free(store->occurs_size);
+  free(store->occurs_capacity);
+  memset(store, 0, sizeof(*store));
+}
 
-    if (clause.term_count > 0 && !is_tautology(&clause)) {
-      if (!add_clause(formula, &clause)) {
-        free_clause(&clause);
-        free_formula(formula);
-        fclose(file);
-        return false;
-      }
-    }
-    free_clause(&clause);
+// Function to initialize an empty clause store
+bool init_clause_store(ClauseStore *store) {
+  memset(store, 0, sizeof(*store));
+  store->literal_capacity = BASE_SIZE;
+  store->capacity = BASE_SIZE;
+  store->table_capacity = SYMBOL_INDEX_SIZE;
+  store->code_capacity = BASE_SIZE;
+  store->literals = malloc(BASE_SIZE * sizeof(int));
+  store->start = malloc((BASE_SIZE + 1) * sizeof(int));
+  store->positive = malloc(BASE_SIZE * sizeof(unsigned long long));
+  store->negative = malloc(BASE_SIZE * sizeof(unsigned long long));
+  store->hash = malloc(BASE_SIZE * sizeof(unsigned long long));
+  store->table = malloc(SYMBOL_INDEX_SIZE * sizeof(int));
+  store->occurs = calloc(BASE_SIZE, sizeof(int *));
+  store->occurs_size = calloc(BASE_SIZE, sizeof(int));
+  store->occurs_capacity = calloc(BASE_SIZE, sizeof(int));
+  if (!store->literals || !store->start || !store->positive ||
+      !store->negative || !store->hash || !store->table || !store->occurs ||
+      !store->occurs_size || !store->occurs_capacity) {
+    free_clause_store(store);
+    return false;
   }
-
-  fclose(file);
+  store->start[0] = 0;
+  memset(store->table, -1, SYMBOL_INDEX_SIZE * sizeof(int));
   return true;
 }
 
-// Main function
-int main(int argc, char *argv[]) {
-  display_header();
-
-  if (argc != 2) {
-    set_display_color(ERROR_COLOR);
-    printf("Error: Please provide a CNF file path\n");
-    printf("Usage: %s <input_file.cnf>\n", argv[0]);
-    set_display_color(DEFAULT_COLOR);
-    return 1;
+// Function to find a clause equal to r; -1 when there is none
+int clause_store_find(const ClauseStore *store, const Resolvent *r) {
+  unsigned int mask = (unsigned int)(store->table_capacity - 1);
+  for (unsigned int slot = (unsigned int)r->hash & mask;
+       store->table[slot] >= 0; slot = (slot + 1) & mask) {
+    int c = store->table[slot];
+    if (store->hash[c] == r->hash && clause_store_size(store, c) == r->count &&
+        memcmp(store->literals + store->start[c], r->literals,
+               r->count * sizeof(int)) == 0)
+      return c;
   }
+  return -1;
+}
 
-  PropositionalFormula formula;
-  if (!init_formula(&formula)) {
-    set_display_color(ERROR_COLOR);
-    printf("Error: Failed to initialize formula\n");
-    set_display_color(DEFAULT_COLOR);
-    return 1;
+// Function to tell whether the stored clause c has all its literals in r
+static inline bool clause_store_subsumes(const ClauseStore *store, int c,
+                                         const Resolvent *r) {
+  if (clause_store_size(store, c) > r->count ||
+      (store->positive[c] & ~r->positive) ||
+      (store->negative[c] & ~r->negative))
+    return false;
+  const int *lits = store->literals + store->start[c];
+  int size = clause_store_size(store, c), at = 0;
+  for (int k = 0; k < size; k++) {
+    while (at < r->count && r->literals[at] < lits[k])
+      at++;
+    if (at == r->count || r->literals[at] != lits[k])
+      return false;
   }
+  return true;
+}
 
-  if (!read_formula_from_file(argv[1], &formula)) {
-    set_display_color(ERROR_COLOR);
-    printf("Error: Failed to read formula from file\n");
-    set_display_color(DEFAULT_COLOR);
-    free_formula(&formula);
-    return 1;
+// Function to find a clause whose literals all appear in r; -1 when there
+// is none. Only the clauses listed under r's literals can, each of them
+// read once and each list up to its first clause longer than r. The
+// signatures rule out most without reading them. The empty clause is
+// listed under none and never found.
+int clause_store_subsumer(const ClauseStore *store, const Resolvent *r) {
+  for (int i = 0; i < r->count && r->literals[i] < store->code_capacity;
+       i++) {
+    const int *list = store->occurs[r->literals[i]];
+    int size = store->occurs_size[r->literals[i]];
+    for (int k = 0; k < size && clause_store_size(store, list[k]) <= r->count;
+         k++)
+      if (clause_store_subsumes(store, list[k], r))
+        return list[k];
   }
+  return -1;
+}
 
-  set_display_color(INFO_COLOR);
-  printf("\nAnalyzing formula...\n");
+// Function to make room in the occurrence lists for literal codes below
+// needed
+bool clause_store_grow_codes(ClauseStore *store, int needed) {
+  int capacity = store->code_capacity;
+  while (capacity < needed)
+    capacity *= EXPANSION_RATE;
+  int **occurs = realloc(store->occurs, capacity * sizeof(int *));
+  if (occurs)
+    store->occurs = occurs;
+  int *occurs_size = realloc(store->occurs_size, capacity * sizeof(int));
+  if (occurs_size)
+    store->occurs_size = occurs_size;
+  int *occurs_capacity =
+      realloc(store->occurs_capacity, capacity * sizeof(int));
+  if (occurs_capacity)
+    store->occurs_capacity = occurs_capacity;
+  if (!occurs || !occurs_size || !occurs_capacity)
+    return false;
+  for (int code = store->code_capacity; code < capacity; code++) {
+    store->occurs[code] = NULL;
+    store->occurs_size[code] = 0;
+    store->occurs_capacity[code] = 0;
+  }
+  store->code_capacity = capacity;
+  return true;
+}
+
+// Function to double the hash table and reinsert every clause
+bool clause_store_grow_table(ClauseStore *store) {
+  int capacity = store->table_capacity * EXPANSION_RATE;
+  int *table = malloc(capacity * sizeof(int));
+  if (!table)
+    return false;
+  memset(table, -1, capacity * sizeof(int));
+  unsigned int mask = (unsigned int)(capacity - 1);
+  for (int c = 0; c < store->count; c++) {
+    unsigned int slot = (unsigned int)store->hash[c] & mask;
+    while (table[slot] >= 0)
+      slot = (slot + 1) & mask;
+    table[slot] = c;
+  }
+  free(store->table);
+  store->table = table;
+  store->table_capacity = capacity;
+  return true;
+}
+
+// Function to append a copy of r, growing the arrays geometrically
+bool clause_store_add(ClauseStore *store, const Resolvent *r) {
+  int needed = store->start[store->count] + r->count;
+  if (needed > store->literal_capacity) {
+    int capacity = store->literal_capacity;
+    while (capacity < needed)
+      capacity *= EXPANSION_RATE;
+    int *literals = realloc(store->literals, capacity * sizeof(int));
+    if (!literals)
+      return false;
+    store->literals = literals;
+    store->literal_capacity = capacity;
+  }
+  if (store->count == store->capacity) {
+    int capacity = store->capacity * EXPANSION_RATE;
+    int *start = realloc(store->start, (capacity + 1) * sizeof(int));
+    if (start)
+      store->start = start;
+    unsigned long long *positive = realloc(
+        store->positive, capacity * sizeof(unsigned long long));
+    if (positive)
+      store->positive = positive;
+    unsigned long long *negative = realloc(
+        store->negative, capacity * sizeof(unsigned long long));
+    if (negative)
+      store->negative = negative;
+    unsigned long long *hash =
+        realloc(store->hash, capacity * sizeof(unsigned long long));
+    if (hash)
+      store->hash = hash;
+    if (!start || !positive || !negative || !hash)
+      return false;
+    store->capacity = capacity;
+  }
+  if (2 * (store->count + 1) > store->table_capacity &&
+      !clause_store_grow_table(store))
+    return false;
+  if (r->count > 0 && r->literals[r->count - 1] >= store->code_capacity &&
+      !clause_store_grow_codes(store, r->literals[r->count - 1] + 1))
+    return false;
+
+  int c = store->count++;
+  memcpy(store->literals + store->start[c], r->literals,
+         r->count * sizeof(int));
+  store->start[c + 1] = needed;
+  store->positive[c] = r->positive;
+  store->negative[c] = r->negative;
+  store->hash[c] = r->hash;
+  if (r->count > store->longest)
+    store->longest = r->count;
+  unsigned int mask = (unsigned int)(store->table_capacity - 1);
+  unsigned int slot = (unsigned int)r->hash & mask;
+  while (store->table[slot] >= 0)
+    slot = (slot + 1) & mask;
+  store->table[slot] = c;
+
+  if (r->count == 0)
+    return true;
+  int best = r->literals[0];
+  for (int k = 1; k < r->count; k++)
+    if (store->occurs_size[r->literals[k]] < store->occurs_size[best])
+      best = r->literals[k];
+  int size = store->occurs_size[best];
+  if (size == store->occurs_capacity[best]) {
+    int capacity = size > 0 ? size * EXPANSION_RATE : BASE_SIZE;
+    int *list = realloc(store->occurs[best], capacity * sizeof(int));
+    if (!list)
+      return false;
+    store->occurs[best] = list;
+    store->occurs_capacity[best] = capacity;
+  }
+  int *list = store->occurs[best];
+  int at = size;
+  while (at > 0 && clause_store_size(store, list[at - 1]) > r->count)
+    at--;
+  memmove(list + at + 1, list + at, (size - at) * sizeof(int));
+  list[at] = c;
+  store->occurs_size[best]++;
+  return true;
+}
+
+// Function to fill a store with the formula's clauses in order, sorted
+// and without repeated literals, registering their symbols. A tautology
+// is kept as it is, its complementary literals side by side.
+bool clause_store_load(ClauseStore *store, PropositionalFormula *formula) {
+  int longest = 0;
+  for (int c = 0; c < formula->clause_count; c++)
+    if (formula->clauses[c].term_count > longest)
+      longest = formula->clauses[c].term_count;
+  int *codes = malloc((longest > 0 ? longest : 1) * sizeof(int));
+  if (!codes || !init_clause_store(store)) {
+    free(codes);
+    return false;
+  }
+
+  bool ok = true;
+  for (int c = 0; ok && c < formula->clause_count; c++) {
+    const PropositionClause *clause = &formula->clauses[c];
+    for (int k = 0; ok && k < clause->term_count; k++) {
+      int index = find_or_add_symbol(formula, clause->terms[k].symbol.symbol);
+      ok = index >= 0;
+      codes[k] = 2 * (index + 1) + clause->terms[k].is_negated;
+    }
+    if (!ok)
+      break;
+    qsort(codes, clause->term_count, sizeof(int), compare_ints);
+    Resolvent r = {codes, 0, 0, 0, 0};
+    resolvent_clear(&r);
+    for (int k = 0; k < clause->term_count; k++) {
+      if (r.count == 0 || codes[r.count - 1] != codes[k])
+        resolvent_push(&r, codes[k]);
+    }
+    ok = clause_store_add(store, &r);
+  }
+  free(codes);
+  if (!ok)
+    free_clause_store(store);
+  return ok;
+}
+
+// Function to write a resolution step to the proof: clause work[id - 1] is
+// the resolvent of work[left - 1] and work[right - 1], which as LRAT hints
+// make it unit-propagation derivable
+void proof_resolvent(ProofWriter *proof, const Resolvent *resolvent, int id,
+                     int left, int right) {
+  proof_add_begin(proof, id);
+  for (int k = 0; k < resolvent->count; k++) {
+    int code = resolvent->literals[k];
+    proof_literal(proof, code & 1 ? -(code >> 1) : code >> 1);
+  }
+  proof_hints_begin(proof);
+  proof_hint(proof, left);
+  proof_hint(proof, right);
+  proof_add_end(proof);
+}
+
+// Function to mark in core the input clauses the empty resolvent of work
+// clauses left and right was derived from, walking the recorded parents
+// (two per derived clause) back to the first original_count clauses
+bool resolution_core(const int *parents, int original_count, int work_size,
+                     int left, int right, bool *core) {
+  bool *visited = calloc(work_size, sizeof(bool));
+  int *stack = malloc((work_size + 2) * sizeof(int));
+  if (!visited || !stack) {
+    free(visited);
+    free(stack);
+    return false;
+  }
+  int count = 0;
+  stack[count++] = left;
+  stack[count++] = right;
+  while (count > 0) {
+    int clause = stack[--count];
+    if (visited[clause])
+      continue;
+    visited[clause] = true;
+    if (clause < original_count) {
+      core[clause] = true;
+    } else {
+      stack[count++] = parents[2 * clause];
+      stack[count++] = parents[2 * clause + 1];
+    }
+  }
+  free(visited);
+  free(stack);
+  return true;
+}
+
+// Position of the saturation loop: the round, the clauses resolved against
+// each other in it and the outer clause the pairs continue from
+typedef struct {
+  int round;
+  int start; // first clause derived in the previous round
+  int end;   // clauses resolved against each other in this round
+  int next;  // outer clause of the next pairs
+} ResolutionPosition;
+
+// Checkpoints of the saturation state. A snapshot is encoded in memory
+// between two outer clauses of the pair loop, then a writer thread puts it
+// in a temporary file that replaces the checkpoint once it is complete, so
+// a crash at any moment leaves the previous checkpoint intact.
+typedef struct {
+  const char *path;
+  char *temporary; // path + ".tmp", renamed over path
+  double interval; // seconds between snapshots
+  double next;     // stats_now() time of the next snapshot
+  bool resume;     // continue from the checkpoint at path
+  unsigned long long fingerprint; // hash of the clauses being saturated
+  unsigned char *buffers[2];
+  size_t capacity[2];
+  size_t fill;
+  int active;      // buffer being encoded
+  bool truncated;  // the snapshot did not fit in memory
+  ThreadHandle writer;
+  ThreadStart start;
+  bool writing; // writer thread owns the other buffer
+  SolverMutex lock;
+  bool written; // raised by the writer thread when it is done, under lock
+  const unsigned char *pending;
+  size_t pending_size;
+  bool failed;
+  bool refused; // the checkpoint to resume from could not be used
+} CheckpointWriter;
+
+// Checkpoint being decoded
+typedef struct {
+  const unsigned char *data;
+  size_t size;
+  size_t at;
+  bool bad; // read past the end or an overlong number
+} CheckpointReader;
+
+// Function to update a 64-bit FNV-1a hash with bytes
+unsigned long long checkpoint_hash(unsigned long long hash, const void *data,
+                                   size_t size) {
+  const unsigned char *bytes = data;
+  for (size_t i = 0; i < size; i++)
+    hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+  return hash;
+}
+
+// Function to prepare checkpoints of the saturation to path
+bool open_checkpoint(CheckpointWriter *checkpoint, const char *path,
+                     double interval, bool resume) {
+  SolverMutex unlocked = SOLVER_MUTEX_INIT;
+  memset(checkpoint, 0, sizeof(*checkpoint));
+  checkpoint->lock = unlocked;
+  checkpoint->path = path;
+  checkpoint->interval = interval;
+  checkpoint->next = stats_now() + interval;
+  checkpoint->resume = resume;
+  checkpoint->temporary = malloc(strlen(path) + 5);
+  if (!checkpoint->temporary)
+    return false;
+  sprintf(checkpoint->temporary, "%s.tmp", path);
+  return true;
+}
+
+// Function to fingerprint the clauses and symbols, whose positions number
+// the saved literals, so that a checkpoint is only resumed on its own
+// formula
+void checkpoint_prepare(CheckpointWriter *checkpoint,
+                        const PropositionalFormula *formula) {
+  unsigned long long hash = 0xcbf29ce484222325ULL;
+  for (int c = 0; c < formula->clause_count; c++) {
+    const PropositionClause *clause = &formula->clauses[c];
+    for (int k = 0; k < clause->term_count; k++) {
+      const char *symbol = clause->terms[k].symbol.symbol;
+      unsigned char sign = clause->terms[k].is_negated;
+      hash = checkpoint_hash(hash, symbol, strlen(symbol) + 1);
+      hash = checkpoint_hash(hash, &sign, 1);
+    }
+    unsigned char end = 2; // no sign byte, so clauses cannot run together
+    hash = checkpoint_hash(hash, &end, 1);
+  }
+  for (int v = 0; v < formula->symbol_count; v++)
+    hash = checkpoint_hash(hash, formula->symbols[v].symbol,
+                           strlen(formula->symbols[v].symbol) + 1);
+  checkpoint->fingerprint = hash;
+}
+
+// Function to append one byte to the snapshot being encoded
+static inline void checkpoint_byte(CheckpointWriter *checkpoint,
+                                   unsigned char byte) {
+  int active = checkpoint->active;
+  if (checkpoint->fill == checkpoint->capacity[active]) {
+    size_t capacity = checkpoint->fill ? checkpoint->fill * EXPANSION_RATE
+                                       : MAX_BUFFER;
+    unsigned char *grown = realloc(checkpoint->buffers[active], capacity);
+    if (!grown) {
+      checkpoint->truncated = true;
+      return;
+    }
+    checkpoint->buffers[active] = grown;
+    checkpoint->capacity[active] = capacity;
+  }
+  checkpoint->buffers[active][checkpoint->fill++] = byte;
+}
+
+// Function to append a number in the variable-length encoding of proofs
+void checkpoint_number(CheckpointWriter *checkpoint, unsigned long long n) {
+  while (n >= 128) {
+    checkpoint_byte(checkpoint, (unsigned char)(n | 128));
+    n >>= 7;
+  }
+  checkpoint_byte(checkpoint, (unsigned char)n);
+}
+
+// Function to read the next number of a checkpoint
+unsigned long long checkpoint_read(CheckpointReader *reader) {
+  unsigned long long n = 0;
+  for (int shift = 0; shift < 64 && reader->at < reader->size; shift += 7) {
+    unsigned char byte = reader->data[reader->at++];
+    n |= (unsigned long long)(byte & 127) << shift;
+    if (!(byte & 128))
+      return n;
+  }
+  reader->bad = true;
+  return 0;
+}
+
+// Function run by the writer thread: write the pending snapshot to the
+// temporary file, force it to disk and rename it over the checkpoint
+void checkpoint_write_pending(void *argument) {
+  CheckpointWriter *checkpoint = argument;
+  FILE *file = fopen(checkpoint->temporary, "wb");
+  bool ok = file && fwrite(checkpoint->pending, 1, checkpoint->pending_size,
+                           file) == checkpoint->pending_size;
+  if (file) {
+    ok = fflush(file) == 0 && ok;
+#ifndef _WIN32
+    ok = fsync(fileno(file)) == 0 && ok;
+#endif
+    ok = fclose(file) == 0 && ok;
+  }
+#ifdef _WIN32
+  ok = ok && MoveFileExA(checkpoint->temporary, checkpoint->path,
+                         MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+  ok = ok && rename(checkpoint->temporary, checkpoint->path) == 0;
+#endif
+  if (!ok)
+    checkpoint->failed = true;
+  lock_mutex(&checkpoint->lock);
+  checkpoint->written = true;
+  unlock_mutex(&checkpoint->lock);
+}
+
+// Function to take a snapshot of the saturation at position at and hand it
+// to the writer thread. After the magic come variable-length numbers: the
+// fingerprint, the position, the count of derived clauses and the
+// resolvent counters, then each clause of work from original_count on as
+// its length and sorted literal codes; a 64-bit FNV-1a checksum of all
+// that ends the file. A snapshot due while the previous one is being
+// written waits for the next call.
+void checkpoint_save(CheckpointWriter *checkpoint, const ClauseStore *work,
+                     int original_count, const ResolutionPosition *at) {
+  if (checkpoint->writing) {
+    lock_mutex(&checkpoint->lock);
+    bool written = checkpoint->written;
+    unlock_mutex(&checkpoint->lock);
+    if (!written)
+      return;
+    join_thread(checkpoint->writer);
+    checkpoint->writing = false;
+  }
+  checkpoint->fill = 0;
+  checkpoint->truncated = false;
+  for (size_t b = 0; b < sizeof(CHECKPOINT_MAGIC) - 1; b++)
+    checkpoint_byte(checkpoint, (unsigned char)CHECKPOINT_MAGIC[b]);
+  checkpoint_number(checkpoint, checkpoint->fingerprint);
+  checkpoint_number(checkpoint, at->round);
+  checkpoint_number(checkpoint, at->start);
+  checkpoint_number(checkpoint, at->end);
+  checkpoint_number(checkpoint, at->next);
+  checkpoint_number(checkpoint, work->count - original_count);
+  checkpoint_number(checkpoint, g_stats.resolvents_generated);
+  checkpoint_number(checkpoint, g_stats.resolvents_tautology);
+  checkpoint_number(checkpoint, g_stats.resolvents_duplicate);
+  checkpoint_number(checkpoint, g_stats.resolvents_subsumed);
+  for (int c = original_count; c < work->count; c++) {
+    checkpoint_number(checkpoint, clause_store_size(work, c));
+    for (int k = work->start[c]; k < work->start[c + 1]; k++)
+      checkpoint_number(checkpoint, work->literals[k]);
+  }
+  unsigned long long sum =
+      checkpoint_hash(0xcbf29ce484222325ULL,
+                      checkpoint->buffers[checkpoint->active],
+                      checkpoint->fill);
+  for (int b = 0; b < 8; b++)
+    checkpoint_byte(checkpoint, (unsigned char)(sum >> 8 * b));
+  checkpoint->next = stats_now() + checkpoint->interval;
+  if (checkpoint->truncated)
+    return;
+
+  STAT_INC(checkpoints);
+  STAT_ADD(checkpoint_bytes, checkpoint->fill);
+  checkpoint->pending = checkpoint->buffers[checkpoint->active];
+  checkpoint->pending_size = checkpoint->fill;
+  checkpoint->written = false;
+  checkpoint->start.function = checkpoint_write_pending;
+  checkpoint->start.argument = checkpoint;
+  checkpoint->writing = start_thread(&checkpoint->writer, &checkpoint->start);
+  if (!checkpoint->writing)
+    checkpoint_write_pending(checkpoint);
+  checkpoint->active ^= 1;
+}
+
+// Function to read a whole file into memory; *data is NULL when it cannot
+// be opened
+bool checkpoint_slurp(const char *path, unsigned char **data, size_t *size) {
+  *data = NULL;
+  *size = 0;
+  FILE *file = fopen(path, "rb");
+  if (!file)
+    return true;
+  size_t capacity = MAX_BUFFER;
+  unsigned char *buffer = malloc(capacity);
+  bool ok = buffer != NULL;
+  while (ok) {
+    *size += fread(buffer + *size, 1, capacity - *size, file);
+    if (*size < capacity)
+      break;
+    unsigned char *grown = realloc(buffer, capacity * EXPANSION_RATE);
+    ok = grown != NULL;
+    if (ok) {
+      buffer = grown;
+      capacity *= EXPANSION_RATE;
+    }
+  }
+  ok = ok && !ferror(file);
+  fclose(file);
+  if (!ok) {
+    free(buffer);
+    return false;
+  }
+  *data = buffer;
+  return true;
+}
+
+// Function to restore the state written by checkpoint_save(), appending
+// the derived clauses to the input clauses in work. Without a checkpoint
+// file the saturation starts afresh; a damaged checkpoint or one taken on
+// another formula is an error.
+bool checkpoint_load(CheckpointWriter *checkpoint,
+                     const PropositionalFormula *formula, ClauseStore *work,
+                     ResolutionPosition *at) {
+  unsigned char *data;
+  size_t size;
+  if (!checkpoint_slurp(checkpoint->path, &data, &size)) {
+    printf("Error: Unable to read checkpoint %s\n", checkpoint->path);
+    return false;
+  }
+  if (!data) {
+    printf("No checkpoint %s yet, starting from the beginning\n",
+           checkpoint->path);
+    return true;
+  }
+
+  size_t magic = sizeof(CHECKPOINT_MAGIC) - 1;
+  bool ok = size >= magic + 8 && memcmp(data, CHECKPOINT_MAGIC, magic) == 0;
+  unsigned long long sum = 0;
+  for (int b = 0; ok && b < 8; b++)
+    sum |= (unsigned long long)data[size - 8 + b] << 8 * b;
+  if (!ok || sum != checkpoint_hash(0xcbf29ce484222325ULL, data, size - 8)) {
+    printf("Error: Checkpoint %s is damaged\n", checkpoint->path);
+    free(data);
+    return false;
+  }
+  CheckpointReader reader = {data, size - 8, magic, false};
+  if (checkpoint_read(&reader) != checkpoint->fingerprint) {
+    printf("Error: Checkpoint %s was taken on another formula\n",
+           checkpoint->path);
+    free(data);
+    return false;
+  }
+
+  int original_count = work->count;
+  unsigned long long position[5], counters[4];
+  for (int f = 0; f < 5; f++)
+    position[f] = checkpoint_read(&reader);
+  for (int f = 0; f < 4; f++)
+    counters[f] = checkpoint_read(&reader);
+  // Saved clauses are sorted by variable, each at most once
+  Resolvent clause = {malloc((formula->symbol_count + 1) * sizeof(int)), 0, 0,
+                      0, 0};
+  ok = clause.literals && !reader.bad &&
+       position[4] <= (unsigned long long)(INT_MAX - original_count);
+  for (unsigned long long i = 0; ok && i < position[4]; i++) {
+    unsigned long long count = checkpoint_read(&reader);
+    ok = count >= 1 && count <= (unsigned long long)formula->symbol_count;
+    resolvent_clear(&clause);
+    for (unsigned long long k = 0; ok && k < count; k++) {
+      unsigned long long code = checkpoint_read(&reader);
+      unsigned long long var = code >> 1;
+      ok = !reader.bad && var >= 1 &&
+           var <= (unsigned long long)formula->symbol_count &&
+           (k == 0 || (int)var > clause.literals[k - 1] >> 1);
+      if (ok)
+        resolvent_push(&clause, (int)code);
+    }
+    ok = ok && clause_store_add(work, &clause);
+  }
+  free(clause.literals);
+  ok = ok && !reader.bad && reader.at == reader.size &&
+       position[0] <= INT_MAX && position[1] <= position[2] &&
+       position[2] <= (unsigned long long)work->count &&
+       position[3] <= position[2];
+  free(data);
+  if (!ok) {
+    printf("Error: Checkpoint %s is damaged\n", checkpoint->path);
+    return false;
+  }
+
+  at->round = (int)position[0];
+  at->start = (int)position[1];
+  at->end = (int)position[2];
+  at->next = (int)position[3];
+  g_stats.resolvents_generated = counters[0];
+  g_stats.resolvents_tautology = counters[1];
+  g_stats.resolvents_duplicate = counters[2];
+  g_stats.resolvents_subsumed = counters[3];
+  printf("Resumed from checkpoint %s: round %d, %d derived clauses\n",
+         checkpoint->path, at->round, work->count - original_count);
+  return true;
+}
+
+// Function to wait for the last checkpoint to be written and free the
+// writer; false if any checkpoint could not be written
+bool close_checkpoint(CheckpointWriter *checkpoint) {
+  if (checkpoint->writing)
+    join_thread(checkpoint->writer);
+  free(checkpoint->buffers[0]);
+  free(checkpoint->buffers[1]);
+  free(checkpoint->temporary);
+  return !checkpoint->failed;
+}
+
+// Function to read a model off a clause set closed under resolution (up to
+// tautologies and subsumed resolvents) that lacks the empty clause, the
+// Davis-Putnam model reconstruction: variables are set in order, false
+// unless a clause whose largest variable is v is not yet satisfied by the
+// smaller ones, which then fixes v. Two clauses asking for opposite values
+// of v would have a resolvent falsified before v, which closure rules out.
+// model is indexed by symbol position + 1, like the literal codes.
+bool resolution_model(const ClauseStore *work, int variable_count,
+                      bool *model) {
+  // Clauses bucketed by their largest variable, the last sorted code
+  int *first = calloc(variable_count + 2, sizeof(int));
+  int *order = malloc((work->count > 0 ? work->count : 1) * sizeof(int));
+  if (!first || !order) {
+    free(first);
+    free(order);
+    return false;
+  }
+  for (int c = 0; c < work->count; c++)
+    if (clause_store_size(work, c) > 0)
+      first[(work->literals[work->start[c + 1] - 1] >> 1) + 1]++;
+  for (int v = 1; v <= variable_count + 1; v++)
+    first[v] += first[v - 1];
+  // Filling moves each bucket's start to its end, shifted back after
+  for (int c = 0; c < work->count; c++)
+    if (clause_store_size(work, c) > 0)
+      order[first[work->literals[work->start[c + 1] - 1] >> 1]++] = c;
+  for (int v = variable_count; v > 0; v--)
+    first[v] = first[v - 1];
+  first[0] = 0;
+
+  memset(model, 0, (variable_count + 1) * sizeof(bool));
+  for (int v = 1; v <= variable_count; v++) {
+    for (int k = first[v]; k < first[v + 1]; k++) {
+      const int *lits = work->literals + work->start[order[k]];
+      int size = clause_store_size(work, order[k]);
+      // A tautology on v ends with its two literals side by side
+      bool satisfied = size > 1 && lits[size - 2] >> 1 == v;
+      for (int i = 0; i < size - 1 && !satisfied; i++)
+        satisfied = model[lits[i] >> 1] != (lits[i] & 1);
+      if (!satisfied)
+        model[v] = !(lits[size - 1] & 1);
+    }
+  }
+  free(first);
+  free(order);
+  return true;
+}
+
+// Function to perform resolution by refutation. Running out of memory
+// gives RESULT_UNKNOWN, since a dropped clause could hide the refutation.
+// When proof is not NULL, every kept resolvent and the empty clause are
+// written to it, clause i of the formula being clause id i + 1. When core
+// is not NULL, the parents of every resolvent are kept and an UNSAT answer
+// marks the input clauses the refutation uses (none if memory ran out).
+// When checkpoint is not NULL, the saturation state is saved to it every
+// interval, and first restored from it if it resumes a run. On RESULT_SAT,
+// model (symbol_count + 1 entries, when not NULL) gets an assignment built
+// from the saturated clauses, indexed by symbol position + 1.
+SolveResult resolution(PropositionalFormula *formula, ProofWriter *proof,
+                       bool *core, CheckpointWriter *checkpoint,
+                       bool *model) {
+  // Copy original clauses to working set
+  ClauseStore work;
+  if (!clause_store_load(&work, formula))
+    return RESULT_UNKNOWN;
+
+  // Pick up where a previous run left off
+  ResolutionPosition at = {0, 0, work.count, 0};
+  if (checkpoint) {
+    checkpoint_prepare(checkpoint, formula);
+    if (checkpoint->resume &&
+        !checkpoint_load(checkpoint, formula, &work, &at)) {
+      checkpoint->refused = true;
+      free_clause_store(&work);
+      return RESULT_UNKNOWN;
+    }
+  }
+  STAT_MAX(peak_clause_db, work.count);
+
+  // Resolvents are merged into one scratch clause that fits the two
+  // longest clauses, and only those that survive are copied into the
+  // store, so the pair loop itself allocates nothing. Parents are kept by
+  // work clause index, two per clause.
+  int scratch_capacity = 2 * work.longest + 1;
+  Resolvent resolvent = {malloc(scratch_capacity * sizeof(int)), 0, 0, 0, 0};
+  int *parents = NULL;
+  int parent_capacity = work.capacity;
+  if (!resolvent.literals ||
+      (core && !(parents = malloc(2 * parent_capacity * sizeof(int))))) {
+    free(resolvent.literals);
+    free_clause_store(&work);
+    return RESULT_UNKNOWN;
+  }
+
+  // Perform resolution
+  bool found_empty = false;
+  for (int i = 0; i < work.count && !found_empty; i++) {
+    found_empty = clause_store_size(&work, i) == 0;
+    if (found_empty && core)
+      core[i] = true;
+  }
+  bool incomplete = false;
+
+  while (at.start < work.count && !found_empty) {
+    TRACE_BEGIN_N("resolution_round", at.round);
+    TRACE_COUNTER("clause_db", work.count);
+
+    for (int i = at.next; i < at.end && !found_empty; i++) {
+      // Snapshots fall between outer clauses, where the loop can resume
+      if (checkpoint && stats_now() >= checkpoint->next) {
+        at.next = i;
+        checkpoint_save(checkpoint, &work, formula->clause_count, &at);
+      }
+      // Pairs of two older clauses were resolved in an earlier round
+      int j_first = i + 1 > at.start ? i + 1 : at.start;
+      for (int j = j_first; j < at.end && !found_empty; j++) {
+        // Only clauses with opposite literals of a variable can clash
+        if (!((work.positive[i] & work.negative[j]) |
+              (work.negative[i] & work.positive[j])))
+          continue;
+        int clashes = resolvent_merge(
+            work.literals + work.start[i], clause_store_size(&work, i),
+            work.literals + work.start[j], clause_store_size(&work, j),
+            &resolvent);
+        if (clashes == 0)
+          continue;
+
+        STAT_INC(resolvents_generated);
+        TRACE_SAMPLE("clause_db", g_stats.resolvents_generated, work.count);
+        if (clashes > 1) {
+          STAT_INC(resolvents_tautology);
+          continue;
+        }
+        if (resolvent.count == 0) {
+          STAT_INC(conflicts);
+          if (proof)
+            proof_resolvent(proof, &resolvent, work.count + 1, i + 1, j + 1);
+          // Without memory for the walk the core stays empty
+          if (core)
+            resolution_core(parents, formula->clause_count, work.count, i, j,
+                            core);
+          found_empty = true;
+          break;
+        }
+
+        // Check if this is a new clause not implied by an existing one
+        if (clause_store_find(&work, &resolvent) >= 0) {
+          STAT_INC(resolvents_duplicate);
+          continue;
+        }
+        if (clause_store_subsumer(&work, &resolvent) >= 0) {
+          STAT_INC(resolvents_subsumed);
+          continue;
+        }
+
+        // Room for the parents, and for the scratch clause to merge the
+        // new clause with the longest one
+        if (parents && work.count == parent_capacity) {
+          int *new_parents = realloc(parents, 2 * EXPANSION_RATE *
+                                                  parent_capacity *
+                                                  sizeof(int));
+          if (!new_parents) {
+            incomplete = true;
+            continue;
+          }
+          parents = new_parents;
+          parent_capacity *= EXPANSION_RATE;
+        }
+        int needed = resolvent.count +
+                     (resolvent.count > work.longest ? resolvent.count
+                                                     : work.longest);
+        if (needed > scratch_capacity) {
+          int *grown = realloc(resolvent.literals, needed * sizeof(int));
+          if (!grown) {
+            incomplete = true;
+            continue;
+          }
+          resolvent.literals = grown;
+          scratch_capacity = needed;
+        }
+        if (!clause_store_add(&work, &resolvent)) {
+          incomplete = true;
+          continue;
+        }
+        if (proof)
+          proof_resolvent(proof, &resolvent, work.count, i + 1, j + 1);
+        if (parents) {
+          parents[2 * work.count - 2] = i;
+          parents[2 * work.count - 1] = j;
+        }
+        STAT_MAX(peak_clause_db, work.count);
+      }
+    }
+    TRACE_END("resolution_round");
+    at.round++;
+    at.start = at.end;
+    at.end = work.count;
+    at.next = 0;
+  }
+  TRACE_COUNTER("clause_db", work.count);
+
+  // The saturated set gives the model; without memory for it there is none
+  if (!found_empty && !incomplete && model) {
+    TRACE_BEGIN("resolution_model");
+    incomplete = !resolution_model(&work, formula->symbol_count, model);
+    TRACE_END("resolution_model");
+  }
+
+  // Clean up
+  free_clause_store(&work);
+  free(resolvent.literals);
+  free(parents);
+
+  if (found_empty)
+    return RESULT_UNSAT;
+  return incomplete ? RESULT_UNKNOWN : RESULT_SAT;
+}
+
+// Indexed clause representation shared by the search engines. Variable v
+// (1-based) is formula->symbols[v - 1]; literals are +v / -v and clause i
+// spans literals[clause_start[i] .. clause_start[i + 1]).
+typedef struct {
+  int variable_count;
+  int clause_count;
+  int *literals;
+  int *clause_start;
+} IndexedFormula;
+
+// Function to get the variable of a literal
+static inline int lit_var(int lit) { return lit > 0 ? lit : -lit; }
+
+// Function to map a literal to its slot in occurrence arrays
+static inline int lit_index(int lit) { return 2 * lit_var(lit) + (lit < 0); }
+
+// Function to build the indexed form, registering every symbol and
+// dropping repeated literals inside a clause
+bool build_indexed_formula(PropositionalFormula *formula,
+                           IndexedFormula *indexed) {
+  int total = 0;
+  for (int i = 0; i < formula->clause_count; i++)
+    total += formula->clauses[i].term_count;
+
+  indexed->literals = malloc((total > 0 ? total : 1) * sizeof(int));
+  indexed->clause_start = malloc((formula->clause_count + 1) * sizeof(int));
+  if (!indexed->literals || !indexed->clause_start) {
+    free(indexed->literals);
+    free(indexed->clause_start);
+    return false;
+  }
+
+  int count = 0;
+  for (int i = 0; i < formula->clause_count; i++) {
+    PropositionClause *clause = &formula->clauses[i];
+    indexed->clause_start[i] = count;
+    for (int j = 0; j < clause->term_count; j++) {
+      int var = find_or_add_symbol(formula, clause->terms[j].symbol.symbol);
+      if (var < 0) {
+        free(indexed->literals);
+        free(indexed->clause_start);
+        return false;
+      }
+      int lit = clause->terms[j].is_negated ? -(var + 1) : var + 1;
+      bool repeated = false;
+      for (int k = indexed->clause_start[i]; k < count && !repeated; k++)
+        repeated = indexed->literals[k] == lit;
+      if (!repeated)
+        indexed->literals[count++] = lit;
+    }
+  }
+  indexed->clause_start[formula->clause_count] = count;
+  indexed->clause_count = formula->clause_count;
+  indexed->variable_count = formula->symbol_count;
+  return true;
+}
+
+// Function to free an indexed formula
+void free_indexed_formula(IndexedFormula *indexed) {
+  free(indexed->literals);
+  free(indexed->clause_start);
+  indexed->literals = NULL;
+  indexed->clause_start = NULL;
+  indexed->clause_count = 0;
+  indexed->variable_count = 0;
+}
+
+// Reproducible PRNG (xoshiro256**), seeded through splitmix64
+typedef struct {
+  unsigned long long s[4];
+} SolverRandom;
+
+// Function to seed the solver PRNG
+void init_solver_random(SolverRandom *rng, unsigned long long seed) {
+  for (int i = 0; i < 4; i++) {
+    unsigned long long z = (seed += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    rng->s[i] = z ^ (z >> 31);
+  }
+}
+
+// Function to draw the next 64-bit random value
+unsigned long long solver_random(SolverRandom *rng) {
+  unsigned long long *s = rng->s;
+  unsigned long long result = ((s[1] * 5) << 7 | (s[1] * 5) >> 57) * 9;
+  unsigned long long t = s[1] << 17;
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = (s[3] << 45) | (s[3] >> 19);
+  return result;
+}
+
+// Function to draw a value in [0, bound)
+int solver_random_below(SolverRandom *rng, int bound) {
+  return (int)((solver_random(rng) >> 32) * (unsigned long long)bound >> 32);
+}
+
+// Function to draw a double in [0, 1)
+double solver_random_unit(SolverRandom *rng) {
+  return (double)(solver_random(rng) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Local search state. Occurrences are flat arrays indexed by lit_index, and
+// each clause keeps its number of true literals plus the XOR of their
+// variables, which is the critical variable when exactly one is true.
+typedef struct {
+  const IndexedFormula *formula;
+  int *occurrence_start;
+  int *occurrences;
+  bool *values;
+  int *true_count;
+  int *critical_xor;
+  int *break_count;
+  int *unsat;
+  int *unsat_position;
+  int unsat_count;
+  double probsat_weights[PROBSAT_MAX_BREAK + 1];
+} LocalSearch;
+
+// Function to free local search state
+void free_local_search(LocalSearch *search) {
+  free(search->occurrence_start);
+  free(search->occurrences);
+  free(search->values);
+  free(search->true_count);
+  free(search->critical_xor);
+  free(search->break_count);
+  free(search->unsat);
+  free(search->unsat_position);
+}
+
+// Function to allocate local search state and literal-to-clause occurrences
+bool init_local_search(LocalSearch *search, const IndexedFormula *formula) {
+  int vars = formula->variable_count;
+  int clauses = formula->clause_count;
+  int literal_slots = 2 * vars + 2;
+  int total = formula->clause_start[clauses];
+
+  memset(search, 0, sizeof(*search));
+  search->formula = formula;
+  search->occurrence_start = calloc(literal_slots + 1, sizeof(int));
+  search->occurrences = malloc((total > 0 ? total : 1) * sizeof(int));
+  search->values = calloc(vars + 1, sizeof(bool));
+  search->true_count = calloc(clauses + 1, sizeof(int));
+  search->critical_xor = calloc(clauses + 1, sizeof(int));
+  search->break_count = calloc(vars + 1, sizeof(int));
+  search->unsat = malloc((clauses + 1) * sizeof(int));
+  search->unsat_position = malloc((clauses + 1) * sizeof(int));
+  if (!search->occurrence_start || !search->occurrences || !search->values ||
+      !search->true_count || !search->critical_xor || !search->break_count ||
+      !search->unsat || !search->unsat_position) {
+    free_local_search(search);
+    return false;
+  }
+
+  for (int i = 0; i < total; i++)
+    search->occurrence_start[lit_index(formula->literals[i]) + 1]++;
+  for (int l = 0; l < literal_slots; l++)
+    search->occurrence_start[l + 1] += search->occurrence_start[l];
+  int *fill = malloc(literal_slots * sizeof(int));
+  if (!fill) {
+    free_local_search(search);
+    return false;
+  }
+  memcpy(fill, search->occurrence_start, literal_slots * sizeof(int));
+  for (int c = 0; c < clauses; c++) {
+    for (int i = formula->clause_start[c]; i < formula->clause_start[c + 1];
+         i++)
+      search->occurrences[fill[lit_index(formula->literals[i])]++] = c;
+  }
+  free(fill);
+  return true;
+}
+
+// Function to check whether a literal is true under the current assignment
+static inline bool literal_true(const LocalSearch *search, int lit) {
+  return search->values[lit_var(lit)] == (lit > 0);
+}
+
+// Function to rebuild all cached counts from the current values
+void rebuild_counts(LocalSearch *search) {
+  const IndexedFormula *formula = search->formula;
+  for (int v = 1; v <= formula->variable_count; v++)
+    search->break_count[v] = 0;
+
+  search->unsat_count = 0;
+  for (int c = 0; c < formula->clause_count; c++) {
+    int count = 0, critical = 0;
+    for (int i = formula->clause_start[c]; i < formula->clause_start[c + 1];
+         i++) {
+      int lit = formula->literals[i];
+      if (literal_true(search, lit)) {
+        count++;
+        critical ^= lit_var(lit);
+      }
+    }
+    search->true_count[c] = count;
+    search->critical_xor[c] = critical;
+    if (count == 0) {
+      search->unsat_position[c] = search->unsat_count;
+      search->unsat[search->unsat_count++] = c;
+    } else if (count == 1) {
+      search->break_count[critical]++;
+    }
+  }
+}
+
+// Function to assign random values and rebuild all cached counts
+void randomize_assignment(LocalSearch *search, SolverRandom *rng) {
+  for (int v = 1; v <= search->formula->variable_count; v++)
+    search->values[v] = solver_random(rng) >> 63;
+  rebuild_counts(search);
+}
+
+// Function to flip a variable, updating true counts, critical variables,
+// break counts and the unsatisfied-clause list incrementally
+void flip_variable(LocalSearch *search, int var) {
+  search->values[var] = !search->values[var];
+  int now_true = search->values[var] ? var : -var;
+
+  // Clauses containing the literal that just became true
+  int index = lit_index(now_true);
+  for (int o = search->occurrence_start[index];
+       o < search->occurrence_start[index + 1]; o++) {
+    int c = search->occurrences[o];
+    int count = ++search->true_count[c];
+    search->critical_xor[c] ^= var;
+    if (count == 1) {
+      int last = search->unsat[--search->unsat_count];
+      search->unsat[search->unsat_position[c]] = last;
+      search->unsat_position[last] = search->unsat_position[c];
+      search->break_count[var]++;
+    } else if (count == 2) {
+      search->break_count[search->critical_xor[c] ^ var]--;
+    }
+  }
+
+  // Clauses containing the literal that just became false
+  index = lit_index(-now_true);
+  for (int o = search->occurrence_start[index];
+       o < search->occurrence_start[index + 1]; o++) {
+    int c = search->occurrences[o];
+    int count = --search->true_count[c];
+    search->critical_xor[c] ^= var;
+    if (count == 0) {
+      search->unsat_position[c] = search->unsat_count;
+      search->unsat[search->unsat_count++] = c;
+      search->break_count[var]--;
+    } else if (count == 1) {
+      search->break_count[search->critical_xor[c]]++;
+    }
+  }
+}
+
+// Function to choose the variable to flip in an unsatisfied clause:
+// WalkSAT/SKC takes a zero-break variable if any, otherwise a random one
+// with probability WALKSAT_NOISE, otherwise one with minimal break count;
+// probSAT picks with probability proportional to (eps + break)^-cb.
+int pick_variable(LocalSearch *search, SolverRandom *rng, int clause,
+                  SolverEngine engine) {
+  const IndexedFormula *formula = search->formula;
+  int first = formula->clause_start[clause];
+  int width = formula->clause_start[clause + 1] - first;
+
+  if (engine == ENGINE_PROBSAT) {
+    double weights[MAX_BUFFER];
+    double sum = 0.0;
+    int limit = width < MAX_BUFFER ? width : MAX_BUFFER;
+    for (int i = 0; i < limit; i++) {
+      int breaks = search->break_count[lit_var(formula->literals[first + i])];
+      weights[i] = search->probsat_weights[breaks < PROBSAT_MAX_BREAK
+                                               ? breaks
+                                               : PROBSAT_MAX_BREAK];
+      sum += weights[i];
+    }
+    double pick = solver_random_unit(rng) * sum;
+    for (int i = 0; i < limit; i++) {
+      pick -= weights[i];
+      if (pick <= 0.0)
+        return lit_var(formula->literals[first + i]);
+    }
+    return lit_var(formula->literals[first + limit - 1]);
+  }
+
+  int best = 0, best_break = 0, ties = 0;
+  for (int i = 0; i < width; i++) {
+    int var = lit_var(formula->literals[first + i]);
+    int breaks = search->break_count[var];
+    if (i == 0 || breaks < best_break) {
+      best = var;
+      best_break = breaks;
+      ties = 1;
+    } else if (breaks == best_break &&
+               solver_random_below(rng, ++ties) == 0) {
+      best = var;
+    }
+  }
+  if (best_break > 0 && solver_random_unit(rng) < WALKSAT_NOISE)
+    return lit_var(formula->literals[first + solver_random_below(rng, width)]);
+  return best;
+}
+
+// Function to run stochastic local search. Returns RESULT_SAT with the model
+// in model[1..variable_count], or RESULT_UNKNOWN once the flip budget is
+// spent or *interrupt is raised; it can never prove unsatisfiability.
+SolveResult local_search(const IndexedFormula *formula, SolverEngine engine,
+                         const SolverOptions *options, bool *model,
+                         const volatile bool *interrupt) {
+  for (int c = 0; c < formula->clause_count; c++) {
+    if (formula->clause_start[c] == formula->clause_start[c + 1])
+      return RESULT_UNKNOWN; // an empty clause, no assignment can help
+  }
+
+  LocalSearch search;
+  if (!init_local_search(&search, formula))
+    return RESULT_UNKNOWN;
+
+  // probSAT's polynomial break exponent grows with the clause width
+  double average_width =
+      formula->clause_count > 0
+          ? (double)formula->clause_start[formula->clause_count] /
+                formula->clause_count
+          : 3.0;
+  double cb = average_width <= 3.5 ? 2.06 : average_width <= 4.5 ? 3.0
+              : average_width <= 5.5 ? 3.7 : 5.1;
+  for (int b = 0; b <= PROBSAT_MAX_BREAK; b++)
+    search.probsat_weights[b] = pow(PROBSAT_EPSILON + b, -cb);
+
+  SolverRandom rng;
+  init_solver_random(&rng, options->seed);
+
+  // Without an explicit interval, large formulas get proportionally longer
+  // tries; restarting a big instance too early throws away progress
+  unsigned long long interval = options->restart_interval;
+  if (interval == 0) {
+    interval = RESTART_FLIPS_PER_VARIABLE * formula->variable_count;
+    if (interval < MIN_RESTART_INTERVAL)
+      interval = MIN_RESTART_INTERVAL;
+  }
+
+  SolveResult result = RESULT_UNKNOWN;
+  unsigned long long flips = 0, restarts = 0;
+  bool interrupted = false;
+  for (int attempt = 0; flips < options->max_flips && !interrupted;
+       attempt++) {
+    if (attempt > 0)
+      restarts++;
+    TRACE_BEGIN_N("local_search_try", attempt);
+    randomize_assignment(&search, &rng);
+
+    unsigned long long try_end = flips + interval;
+    while (search.unsat_count > 0 && flips < try_end &&
+           flips < options->max_flips) {
+      int clause = search.unsat[solver_random_below(&rng, search.unsat_count)];
+      flip_variable(&search, pick_variable(&search, &rng, clause, engine));
+      flips++;
+      TRACE_SAMPLE("unsat_clauses", flips, search.unsat_count);
+      if (interrupt && (flips & 1023) == 0 && *interrupt) {
+        interrupted = true;
+        break;
+      }
+    }
+    TRACE_END("local_search_try");
+
+    if (search.unsat_count == 0) {
+      memcpy(model, search.values,
+             (formula->variable_count + 1) * sizeof(bool));
+      result = RESULT_SAT;
+      break;
+    }
+  }
+
+  lock_mutex(&g_stats_mutex);
+  STAT_ADD(flips, flips);
+  STAT_ADD(restarts, restarts);
+  unlock_mutex(&g_stats_mutex);
+  free_local_search(&search);
+  return result;
+}
+
+// Growable array of ints
+typedef struct {
+  int *items;
+  int count;
+  int capacity;
+} IntArray;
+
+// Function to append to an int array
+bool int_array_push(IntArray *array, int value) {
+  if (array->count == array->capacity) {
+    int capacity = array->capacity ? array->capacity * EXPANSION_RATE : 8;
+    int *items = realloc(array->items, capacity * sizeof(int));
+    if (!items)
+      return false;
+    array->items = items;
+    array->capacity = capacity;
+  }
+  array->items[array->count++] = value;
+  return true;
+}
+
+// Function to free an int array
+void free_int_array(IntArray *array) {
+  free(array->items);
+  array->items = NULL;
+  array->count = 0;
+  array->capacity = 0;
+}
+
+// Gauss-Jordan elimination over the XOR constraints found among a CDCL
+// solver's clauses. Rows are bit vectors over the XOR variables (the
+// columns), packed into 64-bit words. The matrix stays in reduced row
+// echelon form: each row has a basic column that no other row contains,
+// kept unassigned where possible by pivoting when it gets a value. Each row
+// also watches one unassigned non-basic column and needs a look only when
+// that column is assigned; with no other free column left it implies its
+// basic variable, or conflicts once that is assigned too. Row operations
+// keep the solutions of the system, so backtracking never undoes them.
+typedef struct {
+  int rows;
+  int columns;
+  int words;                    // 64-bit words per row
+  unsigned long long *bits;     // row r at bits + r * words
+  bool *rhs;                    // by row: parity of its true columns
+  int *variable;                // by column
+  int *column;                  // by variable: column or -1
+  int variables;                // size of column, less one
+  int *basic;                   // by row: its basic column
+  int *basic_row;               // by column: row it is basic in, or -1
+  int *watch;                   // by row: watched non-basic column, or -1
+  IntArray *watchers;           // by column: rows that may watch it
+  unsigned long long *assigned; // columns whose assignment was seen
+  unsigned long long *truth;    // assigned columns that are true
+  unsigned long long *basics;   // basic columns
+  int head;                     // trail entries seen
+  IntArray pending;             // rows to look at before the trail
+  bool *queued;                 // by row: in pending
+  IntArray settled;             // rows whose basic column is assigned
+  bool *listed;                 // by row: in settled
+  IntArray reasons;             // explanation clauses, in trail order
+  IntArray clause;              // scratch for a conflict clause
+} GaussMatrix;
+
+#define GAUSS_ROW(g, r) ((g)->bits + (size_t)(r) * (g)->words)
+#define GAUSS_BIT(bits, c) ((int)((bits)[(c) >> 6] >> ((c) & 63)) & 1)
+
+// Function to free a Gauss-Jordan matrix
+void free_gauss(GaussMatrix *g) {
+  if (g->watchers) {
+    for (int c = 0; c < g->columns; c++)
+      free_int_array(&g->watchers[c]);
+  }
+  free(g->watchers);
+  free(g->bits);
+  free(g->rhs);
+  free(g->variable);
+  free(g->column);
+  free(g->basic);
+  free(g->basic_row);
+  free(g->watch);
+  free(g->assigned);
+  free(g->truth);
+  free(g->basics);
+  free(g->queued);
+  free(g->listed);
+  free_int_array(&g->pending);
+  free_int_array(&g->settled);
+  free_int_array(&g->reasons);
+  free_int_array(&g->clause);
+  memset(g, 0, sizeof(*g));
+}
+
+// Function to get the index of the lowest set bit of a nonzero word
+static inline int lowest_bit(unsigned long long word) {
+  int bit = 0;
+  for (int shift = 32; shift > 0; shift >>= 1) {
+    if (!(word & ((1ULL << shift) - 1))) {
+      word >>= shift;
+      bit += shift;
+    }
+  }
+  return bit;
+}
+
+// Function to get the parity of the set bits of a word
+static inline int word_parity(unsigned long long word) {
+  for (int shift = 32; shift > 0; shift >>= 1)
+    word ^= word >> shift;
+  return (int)(word & 1);
+}
+
+// Function to add row src to row dst over GF(2), several words per
+// instruction where the target has vector registers
+static inline void gauss_add_row(unsigned long long *dst,
+                                 const unsigned long long *src, int words) {
+  int k = 0;
+#if defined(__AVX2__)
+  for (; k + 4 <= words; k += 4) {
+    __m256i a = _mm256_loadu_si256((const __m256i *)(dst + k));
+    __m256i b = _mm256_loadu_si256((const __m256i *)(src + k));
+    _mm256_storeu_si256((__m256i *)(dst + k), _mm256_xor_si256(a, b));
+  }
+#elif defined(__SSE2__) || defined(_M_X64)
+  for (; k + 2 <= words; k += 2) {
+    __m128i a = _mm_loadu_si128((const __m128i *)(dst + k));
+    __m128i b = _mm_loadu_si128((const __m128i *)(src + k));
+    _mm_storeu_si128((__m128i *)(dst + k), _mm_xor_si128(a, b));
+  }
+#endif
+  for (; k < words; k++)
+    dst[k] ^= src[k];
+}
+
+// Function to find a column of row r that is neither assigned nor basic,
+// or -1
+int gauss_free_column(const GaussMatrix *g, int r) {
+  const unsigned long long *row = GAUSS_ROW(g, r);
+  for (int k = 0; k < g->words; k++) {
+    unsigned long long free = row[k] & ~g->assigned[k] & ~g->basics[k];
+    if (free)
+      return 64 * k + lowest_bit(free);
+  }
+  return -1;
+}
+
+// Function to queue a row for a look, once
+bool gauss_queue(GaussMatrix *g, int r) {
+  if (g->queued[r])
+    return true;
+  g->queued[r] = true;
+  return int_array_push(&g->pending, r);
+}
+
+// Function to make column c basic in row r, eliminating it from every
+// other row; the rows changed are queued, as their watches may be gone
+bool gauss_pivot(GaussMatrix *g, int r, int c) {
+  int old = g->basic[r];
+  g->basics[old >> 6] &= ~(1ULL << (old & 63));
+  g->basic_row[old] = -1;
+  g->basics[c >> 6] |= 1ULL << (c & 63);
+  g->basic_row[c] = r;
+  g->basic[r] = c;
+
+  const unsigned long long *pivot = GAUSS_ROW(g, r);
+  for (int q = 0; q < g->rows; q++) {
+    unsigned long long *row = GAUSS_ROW(g, q);
+    if (q == r || !GAUSS_BIT(row, c))
+      continue;
+    gauss_add_row(row, pivot, g->words);
+    g->rhs[q] ^= g->rhs[r];
+    if (!gauss_queue(g, q))
+      return false;
+  }
+  return true;
+}
+
+// CDCL engine. Literals are coded as lit_index() values (2v for v, 2v + 1
+// for !v) so code ^ 1 is the negation. Clauses live in one int arena as
+// [size, flags, lbd, id, literals...]; the first two literals are watched,
+// and a clause that implied a literal has it in position 0. Ids number the
+// clauses for proofs: input clauses in order from 1, then derived ones.
+#define CLAUSE_SIZE(s, c) ((s)->arena[(c)])
+#define CLAUSE_FLAGS(s, c) ((s)->arena[(c) + 1])
+#define CLAUSE_LBD(s, c) ((s)->arena[(c) + 2])
+#define CLAUSE_ID(s, c) ((s)->arena[(c) + 3])
+#define CLAUSE_LITS(s, c) ((s)->arena + (c) + CDCL_CLAUSE_HEADER)
+#define CLAUSE_LEARNT 1
+#define CLAUSE_DELETED 2
+
+typedef struct {
+  int clause;
+  int blocker; // another literal of the clause; if true, nothing to do
+} Watcher;
+
+typedef struct {
+  Watcher *items;
+  int count;
+  int capacity;
+} WatchList;
+
+typedef struct {
+  int variable_count;
+  int variable_capacity;
+
+  int *arena;
+  int arena_count;
+  int arena_capacity;
+  IntArray clauses;
+  IntArray learnts;
+  WatchList *watches; // by the watched literal, visited when it turns false
+
+  signed char *values; // by literal code: 1 true, -1 false, 0 unassigned
+  int *level;
+  int *reason;   // implying clause, -1, or below it an XOR explanation
+  int *position; // index in the trail
+  bool *phase;
+  int *trail;
+  int trail_count;
+  int propagate_head;
+  IntArray trail_limits;
+
+  double *activity;
+  double activity_increment;
+  int *heap;
+  int heap_count;
+  int *heap_position; // -1 when not in the heap
+
+  bool *seen;
+  int *level_stamp;
+  int stamp;
+  IntArray learnt_clause;
+  IntArray removed;
+  IntArray assumptions;
+
+  bool inconsistent;
+  bool out_of_memory;
+  bool *model;        // valid after RESULT_SAT, indexed by variable
+  IntArray failed;    // assumptions responsible for RESULT_UNSAT
+  unsigned long long conflict_budget; // per solve call, 0 = unlimited
+  const volatile bool *interrupt;     // checked at every conflict
+  GaussMatrix *gauss; // XOR reasoning, NULL when off
+
+  ProofWriter *proof; // NULL unless a proof is being written
+  int last_id;        // newest clause id
+  int *unit_id;       // by variable: id of a unit clause fixing it at level 0
+  int units_derived;  // level-0 trail prefix whose units have ids
+  IntArray proof_units;  // level-0 variables used by the current conflict
+  IntArray proof_chain;  // clause ids resolved, from the conflict backwards
+  IntArray proof_removed; // trail positions of minimized-away literals
+
+  unsigned long long conflicts;
+  unsigned long long propagations;
+  unsigned long long decisions;
+  unsigned long long restarts;
+  unsigned long long reductions;
+  unsigned long long next_reduce;
+  unsigned long long gauss_propagations;
+  unsigned long long gauss_conflicts;
+} CdclSolver;
+
+// Function to check whether variable a should sit above b in the heap
+static inline bool heap_before(const CdclSolver *s, int a, int b) {
+  return s->activity[a] > s->activity[b];
+}
+
+// Function to move a heap entry towards the root
+void heap_up(CdclSolver *s, int i) {
+  int var = s->heap[i];
+  while (i > 0 && heap_before(s, var, s->heap[(i - 1) / 2])) {
+    s->heap[i] = s->heap[(i - 1) / 2];
+    s->heap_position[s->heap[i]] = i;
+    i = (i - 1) / 2;
+  }
+  s->heap[i] = var;
+  s->heap_position[var] = i;
+}
+
+// Function to move a heap entry towards the leaves
+void heap_down(CdclSolver *s, int i) {
+  int var = s->heap[i];
+  while (2 * i + 1 < s->heap_count) {
+    int child = 2 * i + 1;
+    if (child + 1 < s->heap_count &&
+        heap_before(s, s->heap[child + 1], s->heap[child]))
+      child++;
+    if (!heap_before(s, s->heap[child], var))
+      break;
+    s->heap[i] = s->heap[child];
+    s->heap_position[s->heap[i]] = i;
+    i = child;
+  }
+  s->heap[i] = var;
+  s->heap_position[var] = i;
+}
+
+// Function to add a variable to the decision heap
+void heap_insert(CdclSolver *s, int var) {
+  if (s->heap_position[var] >= 0)
+    return;
+  s->heap[s->heap_count] = var;
+  s->heap_position[var] = s->heap_count++;
+  heap_up(s, s->heap_count - 1);
+}
+
+// Function to remove the most active variable from the heap
+int heap_pop(CdclSolver *s) {
+  int var = s->heap[0];
+  s->heap_position[var] = -1;
+  if (--s->heap_count > 0) {
+    s->heap[0] = s->heap[s->heap_count];
+    heap_down(s, 0);
+  }
+  return var;
+}
+
+// Function to grow the per-variable arrays to hold variables 1..count
+bool cdcl_reserve_variables(CdclSolver *s, int count) {
+  if (count <= s->variable_count)
+    return true;
+
+  if (count > s->variable_capacity) {
+    int capacity = s->variable_capacity ? s->variable_capacity : BASE_SIZE;
+    while (capacity < count)
+      capacity *= EXPANSION_RATE;
+    int old_vars = s->variable_capacity + 1, vars = capacity + 1;
+    int old_codes = 2 * old_vars, codes = 2 * vars;
+
+#define CDCL_GROW(field, n, old_n)                                             \
+  do {                                                                         \
+    void *grown = realloc(s->field, (size_t)(n) * sizeof(*s->field));          \
+    if (!grown)                                                                \
+      return false;                                                            \
+    s->field = grown;                                                          \
+    memset(s->field + (old_n), 0,                                              \
+           (size_t)((n) - (old_n)) * sizeof(*s->field));                       \
+  } while (0)
+    CDCL_GROW(watches, codes, s->variable_capacity ? old_codes : 0);
+    CDCL_GROW(values, codes, s->variable_capacity ? old_codes : 0);
+    CDCL_GROW(level, vars, s->variable_capacity ? old_vars : 0);
+    CDCL_GROW(reason, vars, s->variable_capacity ? old_vars : 0);
+    CDCL_GROW(position, vars, s->variable_capacity ? old_vars : 0);
+    CDCL_GROW(unit_id, vars, s->variable_capacity ? old_vars : 0);
+    CDCL_GROW(phase, vars, s->variable_capacity ? old_vars : 0);
+    CDCL_GROW(trail, vars, s->variable_capacity ? old_vars : 0);
+    CDCL_GROW(activity, vars, s->variable_capacity ? old_vars : 0);
+    CDCL_GROW(heap, vars, s->variable_capacity ? old_vars : 0);
+    CDCL_GROW(heap_position, vars, s->variable_capacity ? old_vars : 0);
+    CDCL_GROW(seen, vars, s->variable_capacity ? old_vars : 0);
+    CDCL_GROW(level_stamp, vars, s->variable_capacity ? old_vars : 0);
+    CDCL_GROW(model, vars, s->variable_capacity ? old_vars : 0);
+#undef CDCL_GROW
+    s->variable_capacity = capacity;
+  }
+
+  for (int v = s->variable_count + 1; v <= count; v++) {
+    s->reason[v] = -1;
+    s->heap_position[v] = -1;
+    heap_insert(s, v);
+  }
+  s->variable_count = count;
+  return true;
+}
+
+// Function to initialize an empty CDCL solver
+bool init_cdcl(CdclSolver *s, int variable_count) {
+  memset(s, 0, sizeof(*s));
+  s->activity_increment = 1.0;
+  s->next_reduce = CDCL_FIRST_REDUCE;
+  return cdcl_reserve_variables(s, variable_count > 0 ? variable_count : 1);
+}
+
+// Function to free a CDCL solver
+void free_cdcl(CdclSolver *s) {
+  if (s->watches) {
+    for (int i = 0; i < 2 * (s->variable_capacity + 1); i++)
+      free(s->watches[i].items);
+  }
+  free(s->watches);
+  free(s->arena);
+  free(s->values);
+  free(s->level);
+  free(s->reason);
+  free(s->position);
+  free(s->unit_id);
+  free(s->phase);
+  free(s->trail);
+  free(s->activity);
+  free(s->heap);
+  free(s->heap_position);
+  free(s->seen);
+  free(s->level_stamp);
+  free(s->model);
+  free_int_array(&s->clauses);
+  free_int_array(&s->learnts);
+  free_int_array(&s->trail_limits);
+  free_int_array(&s->learnt_clause);
+  free_int_array(&s->removed);
+  free_int_array(&s->assumptions);
+  free_int_array(&s->failed);
+  free_int_array(&s->proof_units);
+  free_int_array(&s->proof_chain);
+  free_int_array(&s->proof_removed);
+  if (s->gauss) {
+    free_gauss(s->gauss);
+    free(s->gauss);
+  }
+  memset(s, 0, sizeof(*s));
+}
+
+// Function to append a watcher
+bool watch_push(WatchList *list, int clause, int blocker) {
+  if (list->count == list->capacity) {
+    int capacity = list->capacity ? list->capacity * EXPANSION_RATE : 4;
+    Watcher *items = realloc(list->items, capacity * sizeof(Watcher));
+    if (!items)
+      return false;
+    list->items = items;
+    list->capacity = capacity;
+  }
+  list->items[list->count].clause = clause;
+  list->items[list->count].blocker = blocker;
+  list->count++;
+  return true;
+}
+
+// Function to watch the first two literals of a clause
+bool cdcl_attach(CdclSolver *s, int clause) {
+  int *lits = CLAUSE_LITS(s, clause);
+  return watch_push(&s->watches[lits[0]], clause, lits[1]) &&
+         watch_push(&s->watches[lits[1]], clause, lits[0]);
+}
+
+// Function to copy a clause into the arena, returning its offset or -1
+int cdcl_alloc_clause(CdclSolver *s, const int *lits, int size, bool learnt,
+                      int lbd, int id) {
+  int needed = s->arena_count + CDCL_CLAUSE_HEADER + size;
+  if (needed > s->arena_capacity) {
+    int capacity = s->arena_capacity ? s->arena_capacity : BASE_SIZE * 16;
+    while (capacity < needed)
+      capacity *= EXPANSION_RATE;
+    int *arena = realloc(s->arena, capacity * sizeof(int));
+    if (!arena)
+      return -1;
+    s->arena = arena;
+    s->arena_capacity = capacity;
+  }
+  int clause = s->arena_count;
+  s->arena[clause] = size;
+  s->arena[clause + 1] = learnt ? CLAUSE_LEARNT : 0;
+  s->arena[clause + 2] = lbd;
+  s->arena[clause + 3] = id;
+  memcpy(s->arena + clause + CDCL_CLAUSE_HEADER, lits, size * sizeof(int));
+  s->arena_count = needed;
+  return clause;
+}
+
+// Function to get the current decision level
+static inline int cdcl_level(const CdclSolver *s) {
+  return s->trail_limits.count;
+}
+
+// Function to make a literal true with the given reason clause
+static inline void cdcl_assign(CdclSolver *s, int lit, int reason) {
+  int var = lit >> 1;
+  s->values[lit] = 1;
+  s->values[lit ^ 1] = -1;
+  s->level[var] = cdcl_level(s);
+  s->reason[var] = reason;
+  s->position[var] = s->trail_count;
+  s->trail[s->trail_count++] = lit;
+}
+
+// Function to get the clause behind a reason or conflict: an arena offset,
+// or below -1 an explanation of the XOR rows
+static inline const int *cdcl_clause(const CdclSolver *s, int clause) {
+  return clause >= 0 ? s->arena + clause
+                     : s->gauss->reasons.items + (-2 - clause);
+}
+
+// Function to forget the matrix's view of the trail from position limit:
+// the columns assigned there, their explanations, and the settled rows
+// whose basic variable goes. Settled rows that keep it are queued, since
+// other variables of theirs may be free again.
+void gauss_backtrack(CdclSolver *s, int limit) {
+  GaussMatrix *g = s->gauss;
+  for (int i = limit; i < s->trail_count; i++) {
+    int var = s->trail[i] >> 1;
+    if (s->reason[var] < -1) {
+      g->reasons.count = -2 - s->reason[var];
+      break;
+    }
+  }
+  for (int i = limit; i < g->head; i++) {
+    int var = s->trail[i] >> 1;
+    int c = var <= g->variables ? g->column[var] : -1;
+    if (c >= 0) {
+      g->assigned[c >> 6] &= ~(1ULL << (c & 63));
+      g->truth[c >> 6] &= ~(1ULL << (c & 63));
+    }
+  }
+  if (g->head > limit)
+    g->head = limit;
+
+  int kept = 0;
+  for (int i = 0; i < g->settled.count; i++) {
+    int r = g->settled.items[i];
+    int var = g->variable[g->basic[r]];
+    if (s->values[2 * var] != 0 && s->position[var] < limit) {
+      g->settled.items[kept++] = r;
+      if (!gauss_queue(g, r))
+        s->out_of_memory = true;
+    } else {
+      g->listed[r] = false;
+    }
+  }
+  g->settled.count = kept;
+}
+
+// Function to undo all assignments above the given level, saving phases
+void cdcl_backtrack(CdclSolver *s, int level) {
+  if (cdcl_level(s) <= level)
+    return;
+  int limit = s->trail_limits.items[level];
+  if (s->gauss)
+    gauss_backtrack(s, limit);
+  for (int i = s->trail_count - 1; i >= limit; i--) {
+    int lit = s->trail[i];
+    int var = lit >> 1;
+    s->values[lit] = 0;
+    s->values[lit ^ 1] = 0;
+    s->reason[var] = -1;
+    s->phase[var] = (lit & 1) == 0;
+    heap_insert(s, var);
+  }
+  s->trail_count = limit;
+  s->propagate_head = limit;
+  s->trail_limits.count = level;
+}
+
+// Function to act on row r once it has no free non-basic column: with its
+// basic variable free the row implies it, and with every variable assigned
+// it must have its parity. Returns the conflict clause or -1.
+int gauss_settle(CdclSolver *s, int r) {
+  GaussMatrix *g = s->gauss;
+  const unsigned long long *row = GAUSS_ROW(g, r);
+  int b = g->basic[r], var = g->variable[b];
+  unsigned long long fold = 0;
+  for (int k = 0; k < g->words; k++)
+    fold ^= row[k] & g->truth[k];
+  bool value = g->rhs[r] ^ word_parity(fold) ^ GAUSS_BIT(g->truth, b);
+  int lit = value ? 2 * var : 2 * var + 1;
+  if (s->values[lit] == 1) {
+    if (GAUSS_BIT(g->assigned, b) && cdcl_level(s) > 0 && !g->listed[r]) {
+      g->listed[r] = true;
+      if (!int_array_push(&g->settled, r))
+        s->out_of_memory = true;
+    }
+    return -1;
+  }
+
+  // The other columns are all assigned: their false literals explain lit
+  bool implied = s->values[lit] == 0;
+  IntArray *clause = implied ? &g->reasons : &g->clause;
+  int start = implied ? clause->count : 0;
+  clause->count = start;
+  int header[CDCL_CLAUSE_HEADER] = {0, CLAUSE_LEARNT, 0, 0};
+  for (int i = 0; i < CDCL_CLAUSE_HEADER; i++) {
+    if (!int_array_push(clause, header[i])) {
+      s->out_of_memory = true;
+      return -1;
+    }
+  }
+  bool ok = int_array_push(clause, lit);
+  for (int k = 0; k < g->words && ok; k++) {
+    for (unsigned long long word = row[k]; word && ok; word &= word - 1) {
+      int c = 64 * k + lowest_bit(word);
+      if (c != b)
+        ok = int_array_push(clause, 2 * g->variable[c] +
+                                        GAUSS_BIT(g->truth, c));
+    }
+  }
+  if (!ok) {
+    s->out_of_memory = true;
+    return -1;
+  }
+  int size = clause->count - start - CDCL_CLAUSE_HEADER;
+  clause->items[start] = size;
+
+  if (implied) {
+    s->gauss_propagations++;
+    cdcl_assign(s, lit, -2 - start);
+    return -1;
+  }
+  s->gauss_conflicts++;
+  int conflict = cdcl_alloc_clause(
+      s, clause->items + CDCL_CLAUSE_HEADER, size, true, 0, 0);
+  if (conflict < 0)
+    s->out_of_memory = true;
+  return conflict;
+}
+
+// Function to restore row r's invariants: an unassigned basic column where
+// the row has a free column to pivot on, and a free non-basic column
+// watched. A row left without one settles. Returns the conflict clause or
+// -1.
+int gauss_update(CdclSolver *s, int r) {
+  GaussMatrix *g = s->gauss;
+  if (GAUSS_BIT(g->assigned, g->basic[r])) {
+    int c = gauss_free_column(g, r);
+    if (c < 0)
+      return gauss_settle(s, r);
+    if (!gauss_pivot(g, r, c)) {
+      s->out_of_memory = true;
+      return -1;
+    }
+  }
+  int w = g->watch[r];
+  if (w >= 0 && GAUSS_BIT(GAUSS_ROW(g, r), w) &&
+      !GAUSS_BIT(g->assigned, w) && !GAUSS_BIT(g->basics, w))
+    return -1;
+  w = gauss_free_column(g, r);
+  if (w < 0)
+    return gauss_settle(s, r);
+  g->watch[r] = w;
+  if (!int_array_push(&g->watchers[w], r))
+    s->out_of_memory = true;
+  return -1;
+}
+
+// Function to bring the matrix up to date with the trail, after the
+// clauses: queued rows first, then the rows each newly assigned column
+// affects. Returns the conflict clause or -1.
+int gauss_propagate(CdclSolver *s) {
+  GaussMatrix *g = s->gauss;
+  int conflict = -1;
+  while (conflict < 0 && !s->out_of_memory) {
+    if (g->pending.count > 0) {
+      int r = g->pending.items[--g->pending.count];
+      g->queued[r] = false;
+      conflict = gauss_update(s, r);
+      continue;
+    }
+    if (g->head == s->trail_count)
+      break;
+    int lit = s->trail[g->head++];
+    int var = lit >> 1;
+    int c = var <= g->variables ? g->column[var] : -1;
+    if (c < 0)
+      continue;
+    g->assigned[c >> 6] |= 1ULL << (c & 63);
+    if (!(lit & 1))
+      g->truth[c >> 6] |= 1ULL << (c & 63);
+
+    if (g->basic_row[c] >= 0)
+      conflict = gauss_update(s, g->basic_row[c]);
+    IntArray *list = &g->watchers[c];
+    int kept = 0;
+    for (int i = 0; i < list->count; i++) {
+      int r = list->items[i];
+      if (g->watch[r] != c)
+        continue;
+      if (conflict < 0)
+        conflict = gauss_update(s, r);
+      if (g->watch[r] == c)
+        list->items[kept++] = r;
+    }
+    list->count = kept;
+  }
+  return conflict;
+}
+
+// Function to check a complete assignment against every row, queueing a
+// violated one so that propagation reports its conflict. Returns whether
+// one was found.
+bool gauss_violated(CdclSolver *s) {
+  GaussMatrix *g = s->gauss;
+  for (int r = 0; r < g->rows; r++) {
+    const unsigned long long *row = GAUSS_ROW(g, r);
+    unsigned long long fold = 0;
+    for (int k = 0; k < g->words; k++)
+      fold ^= row[k] & g->truth[k];
+    if (word_parity(fold) != g->rhs[r]) {
+      if (!gauss_queue(g, r))
+        s->out_of_memory = true;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Function to propagate all pending assignments through the watch lists.
+// Returns the conflicting clause, or -1 when propagation completes.
+int cdcl_propagate_clauses(CdclSolver *s) {
+  int conflict = -1;
+  while (s->propagate_head < s->trail_count && conflict < 0) {
+    int false_lit = s->trail[s->propagate_head++] ^ 1;
+    WatchList *list = &s->watches[false_lit];
+    int i = 0, j = 0;
+    s->propagations++;
+
+    while (i < list->count) {
+      Watcher watcher = list->items[i++];
+      if (s->values[watcher.blocker] == 1) {
+        list->items[j++] = watcher;
+        continue;
+      }
+
+      // Keep the false literal in position 1
+      int *lits = CLAUSE_LITS(s, watcher.clause);
+      if (lits[0] == false_lit) {
+        lits[0] = lits[1];
+        lits[1] = false_lit;
+      }
+      int first = lits[0];
+      watcher.blocker = first;
+      if (first != false_lit && s->values[first] == 1) {
+        list->items[j++] = watcher;
+        continue;
+      }
+
+      // Look for a replacement watch
+      int size = CLAUSE_SIZE(s, watcher.clause);
+      bool moved = false;
+      for (int k = 2; k < size; k++) {
+        if (s->values[lits[k]] != -1) {
+          lits[1] = lits[k];
+          lits[k] = false_lit;
+          if (!watch_push(&s->watches[lits[1]], watcher.clause, first))
+            s->out_of_memory = true;
+          moved = true;
+          break;
+        }
+      }
+      if (moved)
+        continue;
+
+      // Unit or conflicting
+      list->items[j++] = watcher;
+      if (s->values[first] == -1) {
+        conflict = watcher.clause;
+        while (i < list->count)
+          list->items[j++] = list->items[i++];
+      } else {
+        cdcl_assign(s, first, watcher.clause);
+      }
+    }
+    list->count = j;
+  }
+  if (conflict >= 0)
+    s->propagate_head = s->trail_count;
+  return conflict;
+}
+
+// Function to propagate through the clauses and, when it is on, the XOR
+// matrix, until neither implies more. Returns the conflicting clause, or
+// -1 when propagation completes.
+int cdcl_propagate(CdclSolver *s) {
+  int conflict = cdcl_propagate_clauses(s);
+  while (conflict < 0 && s->gauss) {
+    conflict = gauss_propagate(s);
+    if (conflict >= 0 || s->propagate_head == s->trail_count)
+      break;
+    conflict = cdcl_propagate_clauses(s);
+  }
+  if (conflict >= 0)
+    s->propagate_head = s->trail_count;
+  return conflict;
+}
+
+// Function to raise a variable's activity, rescaling when it grows large
+void cdcl_bump(CdclSolver *s, int var) {
+  if ((s->activity[var] += s->activity_increment) > 1e100) {
+    for (int v = 1; v <= s->variable_count; v++)
+      s->activity[v] *= 1e-100;
+    s->activity_increment *= 1e-100;
+  }
+  if (s->heap_position[var] >= 0)
+    heap_up(s, s->heap_position[var]);
+}
+
+// Function to write a literal code to the proof
+static inline void cdcl_proof_literal(CdclSolver *s, int lit) {
+  proof_literal(s->proof, lit & 1 ? -(lit >> 1) : lit >> 1);
+}
+
+// Function to give every level-0 assignment the id of a unit clause. Units
+// implied by propagation are derived from their reason clause and the
+// units of its other literals, in trail order so those exist already.
+void cdcl_proof_units(CdclSolver *s) {
+  int end = cdcl_level(s) > 0 ? s->trail_limits.items[0] : s->trail_count;
+  for (; s->units_derived < end; s->units_derived++) {
+    int lit = s->trail[s->units_derived];
+    int reason = s->reason[lit >> 1];
+    if (s->unit_id[lit >> 1] != 0 || reason < 0)
+      continue;
+    int id = ++s->last_id;
+    proof_add_begin(s->proof, id);
+    cdcl_proof_literal(s, lit);
+    proof_hints_begin(s->proof);
+    const int *lits = CLAUSE_LITS(s, reason);
+    for (int k = 1; k < CLAUSE_SIZE(s, reason); k++)
+      proof_hint(s->proof, s->unit_id[lits[k] >> 1]);
+    proof_hint(s->proof, CLAUSE_ID(s, reason));
+    proof_add_end(s->proof);
+    s->unit_id[lit >> 1] = id;
+  }
+}
+
+// Function to record a level-0 variable whose unit the current conflict's
+// proof step needs, once
+bool cdcl_proof_note_unit(CdclSolver *s, int var) {
+  if (s->seen[var])
+    return true;
+  s->seen[var] = true;
+  return int_array_push(&s->proof_units, var);
+}
+
+// Function to record a literal dropped by minimization: its reason becomes
+// an antecedent of the learnt clause
+bool cdcl_proof_note_removed(CdclSolver *s, int lit) {
+  int reason = s->reason[lit >> 1];
+  if (!int_array_push(&s->proof_removed, s->position[lit >> 1]))
+    return false;
+  const int *lits = CLAUSE_LITS(s, reason);
+  for (int k = 1; k < CLAUSE_SIZE(s, reason); k++) {
+    if (s->level[lits[k] >> 1] == 0 &&
+        !cdcl_proof_note_unit(s, lits[k] >> 1))
+      return false;
+  }
+  return true;
+}
+
+// Function to write the learnt clause as an LRAT step. Under its negation
+// the antecedents propagate in this order: the level-0 units, the reasons
+// of minimized-away literals and of the resolved literals in trail order,
+// and finally the conflict clause, which becomes false.
+void cdcl_proof_learn(CdclSolver *s, int id) {
+  ProofWriter *proof = s->proof;
+  cdcl_proof_units(s);
+  proof_add_begin(proof, id);
+  for (int i = 0; i < s->learnt_clause.count; i++)
+    cdcl_proof_literal(s, s->learnt_clause.items[i]);
+  proof_hints_begin(proof);
+  for (int i = 0; i < s->proof_units.count; i++)
+    proof_hint(proof, s->unit_id[s->proof_units.items[i]]);
+  qsort(s->proof_removed.items, s->proof_removed.count, sizeof(int),
+        compare_ints);
+  for (int i = 0; i < s->proof_removed.count; i++) {
+    int var = s->trail[s->proof_removed.items[i]] >> 1;
+    proof_hint(proof, CLAUSE_ID(s, s->reason[var]));
+  }
+  for (int i = s->proof_chain.count - 1; i >= 0; i--)
+    proof_hint(proof, s->proof_chain.items[i]);
+  proof_add_end(proof);
+}
+
+// Function to write the empty clause, derived from a clause falsified at
+// level 0 and the units of its literals
+void cdcl_proof_empty(CdclSolver *s, int conflict) {
+  cdcl_proof_units(s);
+  proof_add_begin(s->proof, ++s->last_id);
+  proof_hints_begin(s->proof);
+  const int *lits = CLAUSE_LITS(s, conflict);
+  for (int k = 0; k < CLAUSE_SIZE(s, conflict); k++)
+    proof_hint(s->proof, s->unit_id[lits[k] >> 1]);
+  proof_hint(s->proof, CLAUSE_ID(s, conflict));
+  proof_add_end(s->proof);
+}
+
+// Function to write the deletion of a clause
+void cdcl_proof_delete(CdclSolver *s, int clause) {
+  proof_delete_begin(s->proof);
+  if (s->proof->hints) {
+    proof_number(s->proof, CLAUSE_ID(s, clause));
+  } else {
+    for (int k = 0; k < CLAUSE_SIZE(s, clause); k++)
+      cdcl_proof_literal(s, CLAUSE_LITS(s, clause)[k]);
+  }
+  proof_terminate(s->proof, true);
+}
+
+// Function to check whether a learnt literal is implied by the others:
+// its reason clause contains only literals already in the clause or fixed
+// at level 0
+bool cdcl_redundant(const CdclSolver *s, int lit) {
+  int reason = s->reason[lit >> 1];
+  if (reason == -1)
+    return false;
+  const int *clause = cdcl_clause(s, reason);
+  const int *lits = clause + CDCL_CLAUSE_HEADER;
+  for (int k = 1; k < clause[0]; k++) {
+    int var = lits[k] >> 1;
+    if (!s->seen[var] && s->level[var] > 0)
+      return false;
+  }
+  return true;
+}
+
+// Function to derive the first-UIP clause of a conflict into learnt_clause,
+// asserting literal first and a literal of the backtrack level second.
+// Returns false when out of memory.
+bool cdcl_analyze(CdclSolver *s, int conflict, int *backtrack_level,
+                  int *lbd) {
+  IntArray *learnt = &s->learnt_clause;
+  learnt->count = 0;
+  s->proof_units.count = 0;
+  s->proof_chain.count = 0;
+  s->proof_removed.count = 0;
+  if (!int_array_push(learnt, 0))
+    return false;
+
+  int pending = 0, lit = -1, index = s->trail_count - 1;
+  int clause = conflict;
+  do {
+    const int *header = cdcl_clause(s, clause);
+    const int *lits = header + CDCL_CLAUSE_HEADER;
+    if (s->proof && !int_array_push(&s->proof_chain, CLAUSE_ID(s, clause)))
+      return false;
+    for (int k = lit < 0 ? 0 : 1; k < header[0]; k++) {
+      int var = lits[k] >> 1;
+      if (s->level[var] == 0) {
+        if (s->proof && !cdcl_proof_note_unit(s, var))
+          return false;
+        continue;
+      }
+      if (s->seen[var])
+        continue;
+      s->seen[var] = true;
+      cdcl_bump(s, var);
+      if (s->level[var] >= cdcl_level(s))
+        pending++;
+      else if (!int_array_push(learnt, lits[k]))
+        return false;
+    }
+    while (!s->seen[s->trail[index] >> 1])
+      index--;
+    lit = s->trail[index--];
+    clause = s->reason[lit >> 1];
+    s->seen[lit >> 1] = false;
+    pending--;
+  } while (pending > 0);
+  learnt->items[0] = lit ^ 1;
+
+  // Drop literals implied by the rest of the clause
+  s->removed.count = 0;
+  int kept = 1;
+  for (int i = 1; i < learnt->count; i++) {
+    if (cdcl_redundant(s, learnt->items[i])) {
+      if (!int_array_push(&s->removed, learnt->items[i]) ||
+          (s->proof && !cdcl_proof_note_removed(s, learnt->items[i])))
+        return false;
+    } else {
+      learnt->items[kept++] = learnt->items[i];
+    }
+  }
+  for (int i = 0; i < s->removed.count; i++)
+    s->seen[s->removed.items[i] >> 1] = false;
+  for (int i = 0; i < s->proof_units.count; i++)
+    s->seen[s->proof_units.items[i]] = false;
+  learnt->count = kept;
+
+  // Put the highest remaining level second and count distinct levels
+  *backtrack_level = 0;
+  *lbd = 1;
+  s->stamp++;
+  for (int i = 1; i < learnt->count; i++) {
+    int var = learnt->items[i] >> 1;
+    s->seen[var] = false;
+    if (s->level_stamp[s->level[var]] != s->stamp) {
+      s->level_stamp[s->level[var]] = s->stamp;
+      (*lbd)++;
+    }
+    if (s->level[var] > *backtrack_level) {
+      *backtrack_level = s->level[var];
+      int swap = learnt->items[1];
+      learnt->items[1] = learnt->items[i];
+      learnt->items[i] = swap;
+    }
+  }
+  return true;
+}
+
+// Function to collect the assumptions that imply the negation of the
+// falsified assumption lit into failed, as signed literals
+void cdcl_analyze_final(CdclSolver *s, int lit) {
+  s->failed.count = 0;
+  int_array_push(&s->failed, lit & 1 ? -(lit >> 1) : lit >> 1);
+  if (cdcl_level(s) == 0)
+    return;
+
+  s->seen[lit >> 1] = true;
+  for (int i = s->trail_count - 1; i >= s->trail_limits.items[0]; i--) {
+    int var = s->trail[i] >> 1;
+    if (!s->seen[var])
+      continue;
+    int reason = s->reason[var];
+    if (reason == -1) {
+      int decided = s->trail[i];
+      int_array_push(&s->failed, decided & 1 ? -(decided >> 1) : decided >> 1);
+    } else {
+      const int *clause = cdcl_clause(s, reason);
+      const int *lits = clause + CDCL_CLAUSE_HEADER;
+      for (int k = 1; k < clause[0]; k++) {
+        if (s->level[lits[k] >> 1] > 0)
+          s->seen[lits[k] >> 1] = true;
+      }
+    }
+    s->seen[var] = false;
+  }
+  s->seen[lit >> 1] = false;
+}
+
+// Function to compare packed 64-bit sort keys, such as (lbd, size, clause)
+int compare_sort_keys(const void *a, const void *b) {
+  unsigned long long x = *(const unsigned long long *)a;
+  unsigned long long y = *(const unsigned long long *)b;
+  return x < y ? -1 : x > y;
+}
+
+// Function to drop the worse half of the learnt clauses (by LBD, then
+// size), compact the arena and rebuild the watch lists
+bool cdcl_reduce(CdclSolver *s) {
+  int learnt_count = s->learnts.count;
+  unsigned long long *keys =
+      malloc((learnt_count > 0 ? learnt_count : 1) * sizeof(*keys));
+  if (!keys)
+    return false;
+  for (int i = 0; i < learnt_count; i++) {
+    int clause = s->learnts.items[i];
+    unsigned long long lbd = CLAUSE_LBD(s, clause);
+    unsigned long long size = CLAUSE_SIZE(s, clause);
+    keys[i] = (lbd < 0xFFFF ? lbd : 0xFFFF) << 48 |
+              (size < 0xFFFF ? size : 0xFFFF) << 32 | (unsigned)clause;
+  }
+  qsort(keys, learnt_count, sizeof(*keys), compare_sort_keys);
+  for (int i = learnt_count / 2; i < learnt_count; i++) {
+    int clause = (int)(keys[i] & 0xFFFFFFFFULL);
+    int first = CLAUSE_LITS(s, clause)[0];
+    bool locked =
+        s->values[first] == 1 && s->reason[first >> 1] == clause;
+    if (!locked && CLAUSE_LBD(s, clause) > 2) {
+      CLAUSE_FLAGS(s, clause) |= CLAUSE_DELETED;
+      if (s->proof)
+        cdcl_proof_delete(s, clause);
+    }
+  }
+  free(keys);
+
+  int *arena = malloc((s->arena_capacity > 0 ? s->arena_capacity : 1) *
+                      sizeof(int));
+  if (!arena)
+    return false;
+
+  // Copy survivors, leaving the new offset in the old LBD slot
+  int count = 0;
+  IntArray *lists[2] = {&s->clauses, &s->learnts};
+  for (int l = 0; l < 2; l++) {
+    int kept = 0;
+    for (int i = 0; i < lists[l]->count; i++) {
+      int clause = lists[l]->items[i];
+      if (CLAUSE_FLAGS(s, clause) & CLAUSE_DELETED)
+        continue;
+      int length = CDCL_CLAUSE_HEADER + CLAUSE_SIZE(s, clause);
+      memcpy(arena + count, s->arena + clause, length * sizeof(int));
+      CLAUSE_LBD(s, clause) = count;
+      lists[l]->items[kept++] = count;
+      count += length;
+    }
+    lists[l]->count = kept;
+  }
+  for (int i = 0; i < s->trail_count; i++) {
+    int var = s->trail[i] >> 1;
+    if (s->reason[var] >= 0)
+      s->reason[var] = CLAUSE_LBD(s, s->reason[var]);
+  }
+  free(s->arena);
+  s->arena = arena;
+  s->arena_count = count;
+
+  for (int i = 0; i < 2 * (s->variable_count + 1); i++)
+    s->watches[i].count = 0;
+  for (int l = 0; l < 2; l++) {
+    for (int i = 0; i < lists[l]->count; i++) {
+      if (!cdcl_attach(s, lists[l]->items[i]))
+        return false;
+    }
+  }
+  return true;
+}
+
+// Function to write the clause in learnt_clause as derived from input
+// clause id, of which it lacks the literals false at level 0. Returns the
+// id of the shortened clause.
+int cdcl_proof_shortened(CdclSolver *s, const int *literals, int count,
+                         int id) {
+  int shortened = ++s->last_id;
+  cdcl_proof_units(s);
+  proof_add_begin(s->proof, shortened);
+  for (int i = 0; i < s->learnt_clause.count; i++)
+    cdcl_proof_literal(s, s->learnt_clause.items[i]);
+  proof_hints_begin(s->proof);
+  for (int i = 0; i < count; i++) {
+    int var = lit_var(literals[i]);
+    if (s->values[lit_index(literals[i])] == -1 && !s->seen[var]) {
+      s->seen[var] = true;
+      proof_hint(s->proof, s->unit_id[var]);
+    }
+  }
+  for (int i = 0; i < count; i++)
+    s->seen[lit_var(literals[i])] = false;
+  proof_hint(s->proof, id);
+  proof_add_end(s->proof);
+  return shortened;
+}
+
+// Function to add a clause of signed literals under the given proof id.
+// Must be called between solves; returns false once the clause set is
+// known to be unsatisfiable.
+bool cdcl_add_numbered_clause(CdclSolver *s, const int *literals, int count,
+                              int id) {
+  if (s->inconsistent)
+    return false;
+  cdcl_backtrack(s, 0);
+
+  bool shortened = false;
+  s->learnt_clause.count = 0;
+  for (int i = 0; i < count; i++) {
+    int var = lit_var(literals[i]);
+    if (!cdcl_reserve_variables(s, var)) {
+      s->out_of_memory = true;
+      return false;
+    }
+    int lit = lit_index(literals[i]);
+    if (s->values[lit] == 1)
+      return true; // satisfied at level 0
+    if (s->values[lit] == -1) {
+      shortened = true;
+      continue; // false at level 0
+    }
+    bool duplicate = false;
+    for (int k = 0; k < s->learnt_clause.count; k++) {
+      if (s->learnt_clause.items[k] == (lit ^ 1))
+        return true; // tautology
+      duplicate |= s->learnt_clause.items[k] == lit;
+    }
+    if (!duplicate && !int_array_push(&s->learnt_clause, lit)) {
+      s->out_of_memory = true;
+      return false;
+    }
+  }
+
+  IntArray *lits = &s->learnt_clause;
+  if (s->proof && shortened)
+    id = cdcl_proof_shortened(s, literals, count, id);
+  if (lits->count == 0) {
+    s->inconsistent = true;
+    return false;
+  }
+  if (lits->count == 1) {
+    cdcl_assign(s, lits->items[0], -1);
+    s->unit_id[lits->items[0] >> 1] = id;
+    int conflict = cdcl_propagate(s);
+    if (conflict >= 0) {
+      if (s->proof)
+        cdcl_proof_empty(s, conflict);
+      s->inconsistent = true;
+      return false;
+    }
+    return true;
+  }
+
+  int clause = cdcl_alloc_clause(s, lits->items, lits->count, false, 0, id);
+  if (clause < 0 || !int_array_push(&s->clauses, clause) ||
+      !cdcl_attach(s, clause)) {
+    s->out_of_memory = true;
+    return false;
+  }
+  return true;
+}
+
+// Function to add a clause of signed literals, numbered after every clause
+// so far
+bool cdcl_add_clause(CdclSolver *s, const int *literals, int count) {
+  return cdcl_add_numbered_clause(s, literals, count, ++s->last_id);
+}
+
+// Function to compute the Luby restart sequence 1,1,2,1,1,2,4,...
+unsigned long long luby(int index) {
+  int size = 1, sequence = 0;
+  while (size < index + 1) {
+    sequence++;
+    size = 2 * size + 1;
+  }
+  while (size - 1 != index) {
+    size = (size - 1) >> 1;
+    sequence--;
+    index %= size;
+  }
+  return 1ULL << sequence;
+}
+
+// Function to run CDCL until a result, a restart after conflict_limit
+// conflicts (RESULT_UNKNOWN with *restart set) or the budget runs out
+SolveResult cdcl_search(CdclSolver *s, unsigned long long conflict_limit,
+                        unsigned long long budget_end, bool *restart) {
+  unsigned long long conflicts = 0;
+  *restart = false;
+
+  while (true) {
+    int conflict = cdcl_propagate(s);
+    if (s->out_of_memory)
+      return RESULT_UNKNOWN;
+
+    if (conflict >= 0) {
+      s->conflicts++;
+      conflicts++;
+      if (s->gauss) {
+        // An XOR row may notice a conflict late, below the current level
+        const int *lits = CLAUSE_LITS(s, conflict);
+        int top = 0;
+        for (int k = 0; k < CLAUSE_SIZE(s, conflict); k++) {
+          if (s->level[lits[k] >> 1] > top)
+            top = s->level[lits[k] >> 1];
+        }
+        cdcl_backtrack(s, top);
+      }
+      if (cdcl_level(s) == 0) {
+        if (s->proof)
+          cdcl_proof_empty(s, conflict);
+        s->inconsistent = true;
+        return RESULT_UNSAT;
+      }
+      if (s->interrupt && *s->interrupt)
+        return RESULT_UNKNOWN;
+
+      int backtrack_level, lbd;
+      if (!cdcl_analyze(s, conflict, &backtrack_level, &lbd)) {
+        s->out_of_memory = true;
+        return RESULT_UNKNOWN;
+      }
+      int id = ++s->last_id;
+      if (s->proof)
+        cdcl_proof_learn(s, id);
+      cdcl_backtrack(s, backtrack_level);
+
+      IntArray *learnt = &s->learnt_clause;
+      if (learnt->count == 1) {
+        cdcl_assign(s, learnt->items[0], -1);
+        s->unit_id[learnt->items[0] >> 1] = id;
+      } else {
+        int clause = cdcl_alloc_clause(s, learnt->items, learnt->count, true,
+                                       lbd, id);
+        if (clause < 0 || !int_array_push(&s->learnts, clause) ||
+            !cdcl_attach(s, clause)) {
+          s->out_of_memory = true;
+          return RESULT_UNKNOWN;
+        }
+        cdcl_assign(s, learnt->items[0], clause);
+      }
+      s->activity_increment /= CDCL_VARIABLE_DECAY;
+      continue;
+    }
+
+    if (budget_end && s->conflicts >= budget_end)
+      return RESULT_UNKNOWN;
+    if (conflicts >= conflict_limit) {
+      *restart = true;
+      return RESULT_UNKNOWN;
+    }
+    if (s->conflicts >= s->next_reduce) {
+      s->reductions++;
+      s->next_reduce = s->conflicts + CDCL_FIRST_REDUCE +
+                       CDCL_REDUCE_INCREMENT * s->reductions;
+      if (!cdcl_reduce(s)) {
+        s->out_of_memory = true;
+        return RESULT_UNKNOWN;
+      }
+    }
+
+    // Assumptions are decided first, one level each
+    int next = -1;
+    while (cdcl_level(s) < s->assumptions.count) {
+      int lit = s->assumptions.items[cdcl_level(s)];
+      if (s->values[lit] == 1) {
+        if (!int_array_push(&s->trail_limits, s->trail_count)) {
+          s->out_of_memory = true;
+          return RESULT_UNKNOWN;
+        }
+      } else if (s->values[lit] == -1) {
+        cdcl_analyze_final(s, lit);
+        return RESULT_UNSAT;
+      } else {
+        next = lit;
+        break;
+      }
+    }
+
+    if (next < 0) {
+      while (s->heap_count > 0) {
+        int var = heap_pop(s);
+        if (s->values[2 * var] == 0) {
+          next = s->phase[var] ? 2 * var : 2 * var + 1;
+          break;
+        }
+      }
+      // A complete assignment still has to satisfy the XOR rows
+      if (next < 0 && s->gauss && gauss_violated(s))
+        continue;
+      if (next < 0)
+        return RESULT_SAT;
+      s->decisions++;
+    }
+    if (!int_array_push(&s->trail_limits, s->trail_count)) {
+      s->out_of_memory = true;
+      return RESULT_UNKNOWN;
+    }
+    cdcl_assign(s, next, -1);
+  }
+}
+
+// Function to solve under the given signed assumption literals. On
+// RESULT_SAT the model is in s->model; on RESULT_UNSAT with assumptions,
+// s->failed holds the responsible subset. RESULT_UNKNOWN means the conflict
+// budget ran out or memory was exhausted.
+SolveResult cdcl_solve(CdclSolver *s, const int *assumptions, int count) {
+  unsigned long long conflicts = s->conflicts;
+  unsigned long long propagations = s->propagations;
+  unsigned long long restarts = s->restarts;
+  unsigned long long decisions = s->decisions;
+  unsigned long long gauss_propagations = s->gauss_propagations;
+  unsigned long long gauss_conflicts = s->gauss_conflicts;
+
+  s->failed.count = 0;
+  s->assumptions.count = 0;
+  if (s->inconsistent)
+    return RESULT_UNSAT;
+  for (int i = 0; i < count; i++) {
+    if (!cdcl_reserve_variables(s, lit_var(assumptions[i])) ||
+        !int_array_push(&s->assumptions, lit_index(assumptions[i])))
+      return RESULT_UNKNOWN;
+  }
+
+  unsigned long long budget_end =
+      s->conflict_budget ? s->conflicts + s->conflict_budget : 0;
+  SolveResult result = RESULT_UNKNOWN;
+  for (int attempt = 0;; attempt++) {
+    bool restart;
+    TRACE_BEGIN_N("cdcl_restart", attempt);
+    result = cdcl_search(s, luby(attempt) * CDCL_RESTART_BASE, budget_end,
+                         &restart);
+    TRACE_END("cdcl_restart");
+    TRACE_COUNTER("learnt_clauses", s->learnts.count);
+    if (!restart)
+      break;
+    s->restarts++;
+    cdcl_backtrack(s, 0);
+  }
+
+  if (result == RESULT_SAT) {
+    for (int v = 1; v <= s->variable_count; v++)
+      s->model[v] = s->values[2 * v] == 1;
+  }
+  cdcl_backtrack(s, 0);
+
+  lock_mutex(&g_stats_mutex);
+  STAT_ADD(conflicts, s->conflicts - conflicts);
+  STAT_ADD(propagations, s->propagations - propagations);
+  STAT_ADD(restarts, s->restarts - restarts);
+  STAT_ADD(decisions, s->decisions - decisions);
+  STAT_ADD(gauss_propagations, s->gauss_propagations - gauss_propagations);
+  STAT_ADD(gauss_conflicts, s->gauss_conflicts - gauss_conflicts);
+  unlock_mutex(&g_stats_mutex);
+  return result;
+}
+
+// Function to copy a clause's literals ordered by variable, telling whether
+// its variables are distinct
+bool sort_by_variable(const int *literals, int count, int *sorted) {
+  for (int i = 0; i < count; i++) {
+    int lit = literals[i], j = i;
+    for (; j > 0 && lit_var(sorted[j - 1]) > lit_var(lit); j--)
+      sorted[j] = sorted[j - 1];
+    sorted[j] = lit;
+  }
+  for (int i = 1; i < count; i++) {
+    if (lit_var(sorted[i - 1]) == lit_var(sorted[i]))
+      return false;
+  }
+  return true;
+}
+
+// Function to find the XOR constraints encoded among a formula's clauses.
+// x1 ^ ... ^ xk = rhs takes the 2^(k-1) clauses over its variables that
+// exclude the assignments of the other parity, where a clause excludes the
+// one making its negated variables true and the rest false. Clauses are
+// grouped by a hash of their variables; found constraints go to xors as
+// [k, rhs, variables...].
+bool find_xors(const IndexedFormula *formula, IntArray *xors) {
+  unsigned long long *keys =
+      malloc((formula->clause_count + 1) * sizeof(*keys));
+  if (!keys)
+    return false;
+  int count = 0;
+  for (int c = 0; c < formula->clause_count; c++) {
+    int start = formula->clause_start[c];
+    int k = formula->clause_start[c + 1] - start;
+    int sorted[XOR_DETECT_MAX];
+    if (k < XOR_DETECT_MIN || k > XOR_DETECT_MAX ||
+        !sort_by_variable(formula->literals + start, k, sorted))
+      continue;
+    unsigned int hash = (unsigned)k;
+    for (int i = 0; i < k; i++)
+      hash = hash * 2654435761u + (unsigned)lit_var(sorted[i]);
+    keys[count++] = (unsigned long long)hash << 32 | (unsigned)c;
+  }
+  qsort(keys, count, sizeof(*keys), compare_sort_keys);
+
+  bool ok = true;
+  for (int i = 0, j; i < count && ok; i = j) {
+    for (j = i + 1; j < count && keys[j] >> 32 == keys[i] >> 32; j++)
+      ;
+    int first = (int)(keys[i] & 0xFFFFFFFFULL);
+    int start = formula->clause_start[first];
+    int k = formula->clause_start[first + 1] - start;
+    if (j - i < 1 << (k - 1))
+      continue;
+    int reference[XOR_DETECT_MAX], sorted[XOR_DETECT_MAX];
+    sort_by_variable(formula->literals + start, k, reference);
+
+    // Negated positions of each clause over the same variables
+    unsigned long long patterns = 0;
+    for (int t = i; t < j; t++) {
+      int c = (int)(keys[t] & 0xFFFFFFFFULL);
+      start = formula->clause_start[c];
+      if (formula->clause_start[c + 1] - start != k)
+        continue;
+      sort_by_variable(formula->literals + start, k, sorted);
+      int mask = 0;
+      bool same = true;
+      for (int p = 0; p < k && same; p++) {
+        same = lit_var(sorted[p]) == lit_var(reference[p]);
+        mask |= (sorted[p] < 0) << p;
+      }
+      if (same)
+        patterns |= 1ULL << mask;
+    }
+    int found[2] = {0, 0};
+    for (int mask = 0; mask < 1 << k; mask++) {
+      if (patterns >> mask & 1)
+        found[word_parity((unsigned long long)mask)]++;
+    }
+    for (int parity = 0; parity < 2 && ok; parity++) {
+      if (found[parity] < 1 << (k - 1))
+        continue;
+      ok = int_array_push(xors, k) && int_array_push(xors, !parity);
+      for (int p = 0; p < k && ok; p++)
+        ok = int_array_push(xors, lit_var(reference[p]));
+    }
+  }
+  free(keys);
+  return ok;
+}
+
+// Function to turn on XOR reasoning over the constraints found among a
+// loaded formula's clauses, brought into reduced row echelon form. Systems
+// of more than GAUSS_MAX_BITS cells are left to the clauses, and a row
+// reducing to 0 = 1 makes the solver inconsistent.
+bool gauss_load(CdclSolver *s, const IndexedFormula *formula) {
+  IntArray xors = {0};
+  int vars = formula->variable_count;
+  int *column = malloc((vars + 1) * sizeof(int));
+  if (!column || !find_xors(formula, &xors)) {
+    free(column);
+    free_int_array(&xors);
+    return false;
+  }
+  int rows = 0, columns = 0;
+  for (int v = 0; v <= vars; v++)
+    column[v] = -1;
+  for (int i = 0; i < xors.count; i += 2 + xors.items[i], rows++) {
+    for (int p = 0; p < xors.items[i]; p++) {
+      if (column[xors.items[i + 2 + p]] < 0)
+        column[xors.items[i + 2 + p]] = columns++;
+    }
+  }
+  if (rows == 0 || (long long)rows * columns > GAUSS_MAX_BITS) {
+    free(column);
+    free_int_array(&xors);
+    return true;
+  }
+
+  GaussMatrix *g = calloc(1, sizeof(*g));
+  if (!g) {
+    free(column);
+    free_int_array(&xors);
+    return false;
+  }
+  s->gauss = g;
+  g->rows = rows;
+  g->columns = columns;
+  g->words = (columns + 63) / 64;
+  g->column = column;
+  g->variables = vars;
+  g->bits = calloc((size_t)rows * g->words, sizeof(*g->bits));
+  g->rhs = calloc(rows, sizeof(bool));
+  g->variable = malloc(columns * sizeof(int));
+  g->basic = malloc(rows * sizeof(int));
+  g->basic_row = malloc(columns * sizeof(int));
+  g->watch = malloc(rows * sizeof(int));
+  g->watchers = calloc(columns, sizeof(IntArray));
+  g->assigned = calloc(g->words, sizeof(*g->assigned));
+  g->truth = calloc(g->words, sizeof(*g->truth));
+  g->basics = calloc(g->words, sizeof(*g->basics));
+  g->queued = calloc(rows, sizeof(bool));
+  g->listed = calloc(rows, sizeof(bool));
+  if (!g->bits || !g->rhs || !g->variable || !g->basic || !g->basic_row ||
+      !g->watch || !g->watchers || !g->assigned || !g->truth ||
+      !g->basics || !g->queued || !g->listed) {
+    free_int_array(&xors);
+    return false;
+  }
+  for (int v = 1; v <= vars; v++) {
+    if (column[v] >= 0)
+      g->variable[column[v]] = v;
+  }
+  for (int i = 0, r = 0; i < xors.count; i += 2 + xors.items[i], r++) {
+    g->rhs[r] = xors.items[i + 1];
+    for (int p = 0; p < xors.items[i]; p++) {
+      int c = column[xors.items[i + 2 + p]];
+      GAUSS_ROW(g, r)[c >> 6] |= 1ULL << (c & 63);
+    }
+  }
+  free_int_array(&xors);
+
+  // Gauss-Jordan elimination, moving the rows that stay up over the ones
+  // that vanish
+  int kept = 0;
+  for (int c = 0; c < columns; c++)
+    g->basic_row[c] = -1;
+  for (int r = 0; r < rows; r++) {
+    unsigned long long *row = GAUSS_ROW(g, r);
+    int c = -1;
+    for (int k = 0; k < g->words && c < 0; k++) {
+      if (row[k])
+        c = 64 * k + lowest_bit(row[k]);
+    }
+    if (c < 0) {
+      s->inconsistent |= g->rhs[r];
+      continue;
+    }
+    for (int q = 0; q < rows; q++) {
+      if ((q < kept || q > r) && GAUSS_BIT(GAUSS_ROW(g, q), c)) {
+        gauss_add_row(GAUSS_ROW(g, q), row, g->words);
+        g->rhs[q] ^= g->rhs[r];
+      }
+    }
+    memmove(GAUSS_ROW(g, kept), row, g->words * sizeof(*row));
+    g->rhs[kept] = g->rhs[r];
+    g->basics[c >> 6] |= 1ULL << (c & 63);
+    g->basic_row[c] = kept;
+    g->basic[kept++] = c;
+  }
+  g->rows = kept;
+  for (int r = 0; r < kept; r++) {
+    g->watch[r] = -1;
+    if (!gauss_queue(g, r))
+      return false;
+  }
+
+  lock_mutex(&g_stats_mutex);
+  STAT_MAX(xor_constraints, rows);
+  unlock_mutex(&g_stats_mutex);
+  if (kept == 0 || s->inconsistent) {
+    free_gauss(g);
+    free(g);
+    s->gauss = NULL;
+  }
+  return true;
+}
+
+// Function to load an indexed formula into a fresh CDCL solver. Its
+// refutation is written to proof unless that is NULL; otherwise XOR
+// constraints among the clauses are also reasoned about as such.
+bool cdcl_load(CdclSolver *s, const IndexedFormula *formula,
+               ProofWriter *proof) {
+  if (!init_cdcl(s, formula->variable_count))
+    return false;
+  s->proof = proof;
+  // Input clause c is clause id c + 1, derived clauses come after them
+  s->last_id = formula->clause_count;
+  for (int c = 0; c < formula->clause_count; c++) {
+    int start = formula->clause_start[c];
+    if (!cdcl_add_numbered_clause(s, formula->literals + start,
+                                  formula->clause_start[c + 1] - start,
+                                  c + 1) &&
+        s->out_of_memory)
+      return false;
+  }
+  return proof || s->inconsistent || gauss_load(s, formula);
+}
+
+// Formula features used to choose an engine, computed in one pass over the
+// indexed formula. Width bucket 0 counts empty clauses, the last bucket
+// every clause of FEATURE_WIDTH_BUCKETS - 1 literals or more.
+typedef struct {
+  int variables;
+  int clauses;
+  double clause_variable_ratio;
+  int width_histogram[FEATURE_WIDTH_BUCKETS];
+  double binary_fraction;
+  int min_degree;
+  int max_degree;
+  double mean_degree;
+  double degree_stddev;
+  int pure_literals;
+} FormulaFeatures;
+
+// Function to extract the features of an indexed formula in linear time
+bool extract_features(const IndexedFormula *formula,
+                      FormulaFeatures *features) {
+  memset(features, 0, sizeof(*features));
+  features->variables = formula->variable_count;
+  features->clauses = formula->clause_count;
+
+  // Occurrence counts per literal give degrees and pure literals
+  int *occurrences = calloc(2 * formula->variable_count + 2, sizeof(int));
+  if (!occurrences)
+    return false;
+  for (int c = 0; c < formula->clause_count; c++) {
+    int width = formula->clause_start[c + 1] - formula->clause_start[c];
+    features->width_histogram[width < FEATURE_WIDTH_BUCKETS
+                                  ? width
+                                  : FEATURE_WIDTH_BUCKETS - 1]++;
+    for (int i = formula->clause_start[c]; i < formula->clause_start[c + 1];
+         i++)
+      occurrences[lit_index(formula->literals[i])]++;
+  }
+
+  double sum = 0.0, square_sum = 0.0;
+  for (int v = 1; v <= formula->variable_count; v++) {
+    int positive = occurrences[2 * v], negative = occurrences[2 * v + 1];
+    int degree = positive + negative;
+    if (v == 1 || degree < features->min_degree)
+      features->min_degree = degree;
+    if (degree > features->max_degree)
+      features->max_degree = degree;
+    if (degree > 0 && (positive == 0 || negative == 0))
+      features->pure_literals++;
+    sum += degree;
+    square_sum += (double)degree * degree;
+  }
+  free(occurrences);
+
+  if (formula->variable_count > 0) {
+    features->clause_variable_ratio =
+        (double)formula->clause_count / formula->variable_count;
+    features->mean_degree = sum / formula->variable_count;
+    double variance = square_sum / formula->variable_count -
+                      features->mean_degree * features->mean_degree;
+    features->degree_stddev = variance > 0.0 ? sqrt(variance) : 0.0;
+  }
+  if (formula->clause_count > 0)
+    features->binary_fraction =
+        (double)features->width_histogram[2] / formula->clause_count;
+  return true;
+}
+
+// Engine picked by the selector. A local-search choice with fallback hands
+// over to CDCL when its flip budget runs out, so the answer stays complete.
+typedef struct {
+  SolverEngine engine;
+  bool fallback;
+  const char *reason;
+} EngineChoice;
+
+// Function to get the command-line name of an engine
+const char *engine_name(SolverEngine engine) {
+  switch (engine) {
+  case ENGINE_RESOLUTION:
+    return "resolution";
+  case ENGINE_WALKSAT:
+    return "walksat";
+  case ENGINE_PROBSAT:
+    return "probsat";
+  case ENGINE_CDCL:
+    return "cdcl";
+  case ENGINE_CUBES:
+    return "cubes";
+  default:
+    return "auto";
+  }
+}
+
+// Function to choose an engine from formula features:
+//  - tiny formulas go to resolution, which needs no search state;
+//  - uniform random k-CNF (one width, Poisson-like degrees) below the
+//    satisfiability threshold goes to probSAT, backed by CDCL;
+//  - everything else is treated as structured and goes to CDCL.
+EngineChoice select_engine(const FormulaFeatures *features) {
+  // Approximate random k-SAT thresholds for k = 3..7
+  static const double thresholds[] = {4.267, 9.931, 21.117, 43.37, 87.79};
+  EngineChoice choice = {ENGINE_CDCL, false, "structured formula"};
+
+  if (features->width_histogram[0] > 0) {
+    choice.reason = "contains an empty clause";
+    return choice;
+  }
+  if (features->variables <= TINY_VARIABLES &&
+      features->clauses <= TINY_CLAUSES) {
+    choice.engine = ENGINE_RESOLUTION;
+    choice.reason = "tiny formula";
+    return choice;
+  }
+
+  for (int k = 3; k <= 7; k++) {
+    if (features->width_histogram[k] != features->clauses)
+      continue;
+    // Random formulas have Poisson degrees, stddev close to sqrt(mean);
+    // crafted ones (parity, colouring) are far more regular
+    double expected = sqrt(features->mean_degree);
+    bool poisson = features->degree_stddev >= expected / RANDOM_DEGREE_SPREAD &&
+                   features->degree_stddev <= expected * RANDOM_DEGREE_SPREAD;
+    if (poisson && features->clause_variable_ratio <
+                       RANDOM_THRESHOLD_MARGIN * thresholds[k - 3]) {
+      choice.engine = ENGINE_PROBSAT;
+      choice.fallback = true;
+      choice.reason = "uniform random k-CNF below the threshold";
+    }
+    break;
+  }
+  return choice;
+}
+
+// Function to print a model as "v" lines of literals, 16 per line, or as
+// a single-line JSON object mapping symbol names to values. Definition
+// variables are left out: the model is over the input's own symbols.
+void print_model(const PropositionalFormula *formula, const bool *model,
+                 ModelFormat format) {
+  int printed = 0;
+  if (format == MODEL_JSON)
+    printf("{\"model\":{");
+  for (int v = 1; v <= formula->symbol_count; v++) {
+    const char *symbol = formula->symbols[v - 1].symbol;
+    if (is_definition_symbol(symbol) || format == MODEL_NONE)
+      continue;
+    if (format == MODEL_JSON)
+      printf("%s\"%s\":%s", printed > 0 ? "," : "", symbol,
+             model[v] ? "true" : "false");
+    else
+      printf("%s%s%s%s", printed % 16 == 0 ? "v " : " ", model[v] ? "" : "!",
+             symbol, printed % 16 == 15 ? "\n" : "");
+    printed++;
+  }
+  if (format == MODEL_JSON)
+    printf("}}\n");
+  else if (format == MODEL_LINES && printed % 16 != 0)
+    printf("\n");
+}
+
+// Function to check whether a model satisfies a clause. Symbols left out of
+// assigned (when not NULL) satisfy no literal.
+bool clause_satisfied(const PropositionalFormula *formula,
+                      const PropositionClause *clause, const bool *model,
+                      const bool *assigned) {
+  for (int j = 0; j < clause->term_count; j++) {
+    int var = find_symbol(formula, clause->terms[j].symbol.symbol) + 1;
+    if (var > 0 && (!assigned || assigned[var]) &&
+        model[var] != clause->terms[j].is_negated)
+      return true;
+  }
+  return false;
+}
+
+// Function to check a model against the original hard clauses in time
+// linear in the formula size; soft clauses may be falsified. Returns the
+// index of the first falsified clause, or -1.
+int verify_model(const PropositionalFormula *formula, const bool *model,
+                 const bool *assigned) {
+  for (int i = 0; i < formula->clause_count; i++) {
+    if (formula->clauses[i].weight == 0 &&
+        !clause_satisfied(formula, &formula->clauses[i], model, assigned))
+      return i;
+  }
+  return -1;
+}
+
+// Function to sum the weights of the soft clauses a model falsifies
+unsigned long long model_cost(const PropositionalFormula *formula,
+                              const bool *model, const bool *assigned) {
+  unsigned long long cost = 0;
+  for (int i = 0; i < formula->clause_count; i++) {
+    if (formula->clauses[i].weight > 0 &&
+        !clause_satisfied(formula, &formula->clauses[i], model, assigned))
+      cost += formula->clauses[i].weight;
+  }
+  return cost;
+}
+
+// Function to assign one literal of a model file: "name", "!name" or
+// "-name", with DIMACS numbers n standing for xn. Symbols the formula does
+// not contain are ignored.
+void assign_model_literal(const PropositionalFormula *formula,
+                          const char *token, bool *model, bool *assigned) {
+  bool negated = token[0] == '!' || token[0] == '-';
+  const char *name = negated ? token + 1 : token;
+  char symbol_name[MAX_SYMBOL_LEN];
+  if (isdigit((unsigned char)name[0])) {
+    snprintf(symbol_name, sizeof(symbol_name), "x%s", name);
+    name = symbol_name;
+  }
+  int var = find_symbol(formula, name) + 1;
+  if (var > 0) {
+    model[var] = !negated;
+    assigned[var] = true;
+  }
+}
+
+// Function to read the next token of a model file into token, skipping
+// the separators of both model formats; quoted JSON keys come back with
+// their quotes stripped. Returns the character that ended the token, EOF at
+// the end of the file.
+int read_model_token(FILE *file, char *token, int size) {
+  int c = getc(file);
+  while (c != EOF && c != '\n' && strchr(" \t\r{}:,", c))
+    c = getc(file);
+  int length = 0;
+  if (c == '"') {
+    while ((c = getc(file)) != EOF && c != '"' && c != '\n')
+      if (length < size - 1)
+        token[length++] = (char)c;
+    c = c == '"' ? getc(file) : c;
+  } else {
+    while (c != EOF && !strchr(" \t\r\n{}:,\"", c)) {
+      if (length < size - 1)
+        token[length++] = (char)c;
+      c = getc(file);
+    }
+  }
+  token[length] = '\0';
+  if (c == '"')
+    ungetc(c, file);
+  return c;
+}
+
+// Function to read a model written by print_model(), in either format, or
+// by a DIMACS solver ("v 1 -2 0"). model and assigned have one entry per
+// symbol position + 1. Lines that are neither "v" lines nor JSON objects
+// are skipped, so a solver's full output can be checked directly.
+bool read_model_file(const char *path, const PropositionalFormula *formula,
+                     bool *model, bool *assigned) {
+  FILE *file = fopen(path, "r");
+  if (!file) {
+    printf("Error: Unable to open model file %s\n", path);
+    return false;
+  }
+
+  char token[MAX_SYMBOL_LEN + 2], key[MAX_SYMBOL_LEN + 2];
+  int c = '\n';
+  while (c != EOF) {
+    // c is the character that ended the previous line
+    int first = getc(file);
+    if (first == 'v') {
+      // "v" must stand alone: other lines starting with v are skipped
+      int next = getc(file);
+      if (next != ' ' && next != '\t')
+        first = 'x';
+      ungetc(next, file);
+    }
+    if (first == 'v' || first == '{') {
+      bool json = first == '{';
+      key[0] = '\0';
+      do {
+        c = read_model_token(file, token, sizeof(token));
+        if (!json && token[0] && strcmp(token, "0") != 0) {
+          assign_model_literal(formula, token, model, assigned);
+        } else if (json && (strcmp(token, "true") == 0 ||
+                            strcmp(token, "false") == 0)) {
+          // A false value is assigned as the negated key
+          char literal[MAX_SYMBOL_LEN + 3];
+          snprintf(literal, sizeof(literal), "%s%s", token[0] == 'f' ? "!" : "",
+                   key);
+          assign_model_literal(formula, literal, model, assigned);
+        } else if (json) {
+          strcpy(key, token);
+        }
+      } while (c != '\n' && c != EOF);
+    } else {
+      c = first;
+      while (c != '\n' && c != EOF)
+        c = getc(file);
+    }
+  }
+  fclose(file);
+  return true;
+}
+
+// Function to run one engine choice on an indexed formula. A local-search
+// choice with fallback continues with CDCL when its budget runs out, which
+// is reported through *fell_back. CDCL writes its refutation to proof
+// unless that is NULL.
+SolveResult run_engine(const IndexedFormula *formula, EngineChoice choice,
+                       const SolverOptions *options, bool *model,
+                       const volatile bool *interrupt, ProofWriter *proof,
+                       bool *fell_back) {
+  SolveResult result = RESULT_UNKNOWN;
+  *fell_back = false;
+
+  if (choice.engine == ENGINE_WALKSAT || choice.engine == ENGINE_PROBSAT) {
+    SolverOptions search = *options;
+    if (choice.fallback) {
+      // Give local search a size-proportional slice before handing over
+      unsigned long long budget =
+          AUTO_FLIPS_PER_VARIABLE * (unsigned long long)formula->variable_count;
+      if (budget < AUTO_MIN_FLIPS)
+        budget = AUTO_MIN_FLIPS;
+      if (budget < search.max_flips)
+        search.max_flips = budget;
+    }
+    result = local_search(formula, choice.engine, &search, model, interrupt);
+    if (result != RESULT_UNKNOWN || !choice.fallback ||
+        (interrupt && *interrupt))
+      return result;
+    *fell_back = true;
+  }
+
+  CdclSolver solver;
+  if (cdcl_load(&solver, formula, proof)) {
+    solver.interrupt = interrupt;
+    result = cdcl_solve(&solver, NULL, 0);
+    if (result == RESULT_SAT)
+      memcpy(model, solver.model,
+             (formula->variable_count + 1) * sizeof(bool));
+  }
+  free_cdcl(&solver);
+  return result;
+}
+
+// Clauses grouped by connected component of the variable-sharing graph
+typedef struct {
+  int count;
+  int *clause_order;    // clause indices, grouped by component
+  int *component_start; // count + 1 offsets into clause_order
+} ComponentSet;
+
+// Function to find the representative of a variable, halving paths
+static int find_root(int *parent, int var) {
+  while (parent[var] != var) {
+    parent[var] = parent[parent[var]];
+    var = parent[var];
+  }
+  return var;
+}
+
+// Function to free a component set
+void free_components(ComponentSet *components) {
+  free(components->clause_order);
+  free(components->component_start);
+  components->clause_order = NULL;
+  components->component_start = NULL;
+  components->count = 0;
+}
+
+// Function to split the clauses into variable-disjoint components with
+// union-find (union by size, path halving). Components are ordered largest
+// first so the longest jobs start early; an empty clause stands alone.
+bool split_components(const IndexedFormula *formula,
+                      ComponentSet *components) {
+  int vars = formula->variable_count, clauses = formula->clause_count;
+  int *parent = malloc((vars + 1) * sizeof(int));
+  int *size = malloc((vars + 1) * sizeof(int));
+  int *component_of = malloc((vars + 1) * sizeof(int));
+  int *clause_component = malloc((clauses + 1) * sizeof(int));
+  memset(components, 0, sizeof(*components));
+  if (!parent || !size || !component_of || !clause_component) {
+    free(parent);
+    free(size);
+    free(component_of);
+    free(clause_component);
+    return false;
+  }
+
+  for (int v = 0; v <= vars; v++) {
+    parent[v] = v;
+    size[v] = 1;
+    component_of[v] = -1;
+  }
+  for (int c = 0; c < clauses; c++) {
+    int start = formula->clause_start[c], end = formula->clause_start[c + 1];
+    if (start == end)
+      continue;
+    int root = find_root(parent, lit_var(formula->literals[start]));
+    for (int i = start + 1; i < end; i++) {
+      int other = find_root(parent, lit_var(formula->literals[i]));
+      if (other == root)
+        continue;
+      if (size[other] > size[root]) {
+        int swap = other;
+        other = root;
+        root = swap;
+      }
+      parent[other] = root;
+      size[root] += size[other];
+    }
+  }
+
+  // Number the components and weigh them by literal count
+  int count = 0;
+  for (int c = 0; c < clauses; c++) {
+    int start = formula->clause_start[c];
+    if (start == formula->clause_start[c + 1]) {
+      clause_component[c] = count++;
+      continue;
+    }
+    int root = find_root(parent, lit_var(formula->literals[start]));
+    if (component_of[root] < 0)
+      component_of[root] = count++;
+    clause_component[c] = component_of[root];
+  }
+  free(parent);
+  free(size);
+  free(component_of);
+
+  unsigned long long *keys = calloc(count + 1, sizeof(*keys));
+  int *rank = malloc((count + 1) * sizeof(int));
+  int *rank_start = malloc((count + 1) * sizeof(int));
+  components->clause_order = malloc((clauses + 1) * sizeof(int));
+  components->component_start = calloc(count + 1, sizeof(int));
+  if (!keys || !rank || !rank_start || !components->clause_order ||
+      !components->component_start) {
+    free(keys);
+    free(rank);
+    free(rank_start);
+    free(clause_component);
+    free_components(components);
+    return false;
+  }
+
+  for (int c = 0; c < clauses; c++)
+    keys[clause_component[c]] +=
+        formula->clause_start[c + 1] - formula->clause_start[c] + 1;
+  for (int k = 0; k < count; k++)
+    keys[k] = (0xFFFFFFFFULL - keys[k]) << 32 | (unsigned)k;
+  qsort(keys, count, sizeof(*keys), compare_sort_keys);
+  for (int k = 0; k < count; k++)
+    rank[keys[k] & 0xFFFFFFFFULL] = k;
+
+  // Counting sort of the clauses by component rank
+  for (int c = 0; c < clauses; c++)
+    components->component_start[rank[clause_component[c]] + 1]++;
+  for (int k = 0; k < count; k++)
+    components->component_start[k + 1] += components->component_start[k];
+  for (int k = 0; k < count; k++)
+    rank_start[k] = components->component_start[k];
+  for (int c = 0; c < clauses; c++)
+    components->clause_order[rank_start[rank[clause_component[c]]]++] = c;
+
+  free(keys);
+  free(rank);
+  free(rank_start);
+  free(clause_component);
+  components->count = count;
+  return true;
+}
+
+// Function to copy one component into its own indexed formula with
+// variables renumbered from 1; variables[local] is the original variable.
+// local_of must be zeroed and is left zeroed.
+bool extract_component(const IndexedFormula *formula,
+                       const ComponentSet *components, int component,
+                       int *local_of, IndexedFormula *part, int **variables) {
+  int first = components->component_start[component];
+  int last = components->component_start[component + 1];
+  int literal_count = 0;
+  for (int k = first; k < last; k++) {
+    int c = components->clause_order[k];
+    literal_count += formula->clause_start[c + 1] - formula->clause_start[c];
+  }
+
+  part->clause_count = last - first;
+  part->variable_count = 0;
+  part->literals = malloc((literal_count + 1) * sizeof(int));
+  part->clause_start = malloc((last - first + 1) * sizeof(int));
+  *variables = malloc((literal_count + 1) * sizeof(int));
+  if (!part->literals || !part->clause_start || !*variables) {
+    free_indexed_formula(part);
+    free(*variables);
+    return false;
+  }
+
+  int count = 0;
+  for (int k = first; k < last; k++) {
+    int c = components->clause_order[k];
+    part->clause_start[k - first] = count;
+    for (int i = formula->clause_start[c]; i < formula->clause_start[c + 1];
+         i++) {
+      int lit = formula->literals[i];
+      int var = lit_var(lit);
+      if (local_of[var] == 0) {
+        local_of[var] = ++part->variable_count;
+        (*variables)[part->variable_count] = var;
+      }
+      part->literals[count++] = lit > 0 ? local_of[var] : -local_of[var];
+    }
+  }
+  part->clause_start[last - first] = count;
+
+  for (int v = 1; v <= part->variable_count; v++)
+    local_of[(*variables)[v]] = 0;
+  return true;
+}
+
+// Shared state of the component thread pool
+typedef struct {
+  const IndexedFormula *formula;
+  const ComponentSet *components;
+  const SolverOptions *options;
+  bool *model;
+  SolverMutex lock;
+  int next;
+  volatile bool stop; // raised by the first unsatisfiable component
+  bool unsatisfiable;
+  bool unknown;
+} ComponentPool;
+
+// Function run by each pool thread: take the next component, solve it and
+// copy its model into the shared one (components never share variables)
+void component_worker(void *argument) {
+  ComponentPool *pool = argument;
+  int *local_of = calloc(pool->formula->variable_count + 1, sizeof(int));
+
+  while (local_of) {
+    lock_mutex(&pool->lock);
+    int component = -1;
+    if (!pool->stop && pool->next < pool->components->count)
+      component = pool->next++;
+    unlock_mutex(&pool->lock);
+    if (component < 0)
+      break;
+
+    TRACE_BEGIN_N("component", component);
+    IndexedFormula part;
+    int *variables;
+    SolveResult result = RESULT_UNKNOWN;
+    if (extract_component(pool->formula, pool->components, component,
+                          local_of, &part, &variables)) {
+      bool *part_model = calloc(part.variable_count + 1, sizeof(bool));
+      FormulaFeatures features;
+      EngineChoice choice = {pool->options->engine, false, "requested"};
+      bool ready = part_model != NULL;
+      if (ready && choice.engine == ENGINE_AUTO) {
+        ready = extract_features(&part, &features);
+        choice = select_engine(&features);
+        if (choice.engine == ENGINE_RESOLUTION)
+          choice.engine = ENGINE_CDCL; // resolution is not thread-safe
+      }
+      if (ready) {
+        bool fell_back;
+        result = run_engine(&part, choice, pool->options, part_model,
+                            &pool->stop, NULL, &fell_back);
+      }
+      if (result == RESULT_SAT) {
+        for (int v = 1; v <= part.variable_count; v++)
+          pool->model[variables[v]] = part_model[v];
+      }
+      free(part_model);
+      free(variables);
+      free_indexed_formula(&part);
+    }
+    TRACE_END("component");
+
+    if (result != RESULT_SAT) {
+      lock_mutex(&pool->lock);
+      if (result == RESULT_UNSAT) {
+        pool->unsatisfiable = true;
+        pool->stop = true;
+      } else {
+        pool->unknown = true;
+      }
+      unlock_mutex(&pool->lock);
+    }
+  }
+
+  if (!local_of) {
+    lock_mutex(&pool->lock);
+    pool->unknown = true;
+    unlock_mutex(&pool->lock);
+  }
+  free(local_of);
+}
+
+// Function to solve the components independently on a thread pool. Stops
+// at the first unsatisfiable component; otherwise merges the models.
+SolveResult solve_components(const IndexedFormula *formula,
+                             const ComponentSet *components,
+                             const SolverOptions *options, bool *model) {
+  ComponentPool pool;
+  SolverMutex unlocked = SOLVER_MUTEX_INIT;
+  memset(&pool, 0, sizeof(pool));
+  pool.formula = formula;
+  pool.components = components;
+  pool.options = options;
+  pool.model = model;
+  pool.lock = unlocked;
+
+  int threads = options->threads < components->count ? options->threads
+                                                      : components->count;
+  run_workers(component_worker, &pool, threads > 0 ? threads : 1);
+
+  if (pool.unsatisfiable)
+    return RESULT_UNSAT;
+  return pool.unknown ? RESULT_UNKNOWN : RESULT_SAT;
+}
+
+// Cubes (partial assignments) for cube-and-conquer, as signed variables
+// stored back to back; start holds one offset per cube plus the end
+typedef struct {
+  IntArray literals;
+  IntArray start;
+} CubeSet;
+
+// Function to initialize an empty cube set
+bool init_cubes(CubeSet *cubes) {
+  memset(cubes, 0, sizeof(*cubes));
+  return int_array_push(&cubes->start, 0);
+}
+
+// Function to free a cube set
+void free_cubes(CubeSet *cubes) {
+  free_int_array(&cubes->literals);
+  free_int_array(&cubes->start);
+}
+
+// Function to get the number of cubes
+int cube_count(const CubeSet *cubes) {
+  return cubes->start.count > 0 ? cubes->start.count - 1 : 0;
+}
+
+// Lookahead cuber state: a CDCL solver used only for its propagation
+typedef struct {
+  CdclSolver solver;
+  int *candidates; // variables by decreasing occurrence count
+  IntArray path;   // decisions of the current branch, as literal codes
+  CubeSet *cubes;
+  int refuted;
+  bool out_of_memory;
+} Cuber;
+
+// Function to count the assignments propagating lit would add, or -1 if it
+// fails; the assignment is undone
+int lookahead_literal(CdclSolver *s, int lit) {
+  int before = s->trail_count;
+  if (!int_array_push(&s->trail_limits, s->trail_count)) {
+    s->out_of_memory = true;
+    return 0;
+  }
+  cdcl_assign(s, lit, -1);
+  int conflict = cdcl_propagate(s);
+  int implied = s->trail_count - before;
+  cdcl_backtrack(s, cdcl_level(s) - 1);
+  return conflict >= 0 ? -1 : implied;
+}
+
+// Function to record the current branch as a cube
+void emit_cube(Cuber *cuber) {
+  for (int i = 0; i < cuber->path.count; i++) {
+    int lit = cuber->path.items[i];
+    if (!int_array_push(&cuber->cubes->literals,
+                        lit & 1 ? -(lit >> 1) : lit >> 1))
+      cuber->out_of_memory = true;
+  }
+  if (!int_array_push(&cuber->cubes->start, cuber->cubes->literals.count))
+    cuber->out_of_memory = true;
+}
+
+// Function to split the current branch into about budget cubes. Each node
+// looks ahead on the most frequent free variables: a literal whose
+// propagation fails fixes its complement, both failing refutes the branch,
+// and otherwise the variable maximising the product of both sides'
+// propagation counts is branched on.
+void cube_split(Cuber *cuber, int budget) {
+  CdclSolver *s = &cuber->solver;
+  int best = -1;
+
+  while (budget > 1 && !cuber->out_of_memory) {
+    long long best_score = -1;
+    bool forced = false;
+    best = -1;
+    for (int i = 0, tried = 0;
+         i < s->variable_count && tried < CUBE_CANDIDATES && !forced; i++) {
+      int var = cuber->candidates[i];
+      if (s->values[2 * var] != 0)
+        continue;
+      tried++;
+      int positive = lookahead_literal(s, 2 * var);
+      int negative = lookahead_literal(s, 2 * var + 1);
+      if (positive < 0 && negative < 0) {
+        cuber->refuted++;
+        return;
+      }
+      if (positive < 0 || negative < 0) {
+        // Failed literal: its complement holds throughout this branch
+        cdcl_assign(s, positive < 0 ? 2 * var + 1 : 2 * var, -1);
+        if (cdcl_propagate(s) >= 0) {
+          cuber->refuted++;
+          return;
+        }
+        forced = true;
+        continue;
+      }
+      long long score = (long long)(positive + 1) * (negative + 1);
+      if (score > best_score) {
+        best_score = score;
+        best = var;
+      }
+    }
+    if (!forced)
+      break;
+  }
+
+  if (budget <= 1 || best < 0) {
+    emit_cube(cuber);
+    return;
+  }
+
+  int level = cdcl_level(s);
+  for (int side = 0; side < 2; side++) {
+    int lit = 2 * best + side;
+    if (!int_array_push(&s->trail_limits, s->trail_count) ||
+        !int_array_push(&cuber->path, lit)) {
+      cuber->out_of_memory = true;
+      return;
+    }
+    cdcl_assign(s, lit, -1);
+    if (cdcl_propagate(s) >= 0)
+      cuber->refuted++;
+    else
+      cube_split(cuber, side == 0 ? budget / 2 : budget - budget / 2);
+    cuber->path.count--;
+    cdcl_backtrack(s, level);
+  }
+}
+
+// Function to split a formula into about target cubes by lookahead. No
+// cubes at all means every branch was refuted: the formula is
+// unsatisfiable.
+bool make_cubes(const IndexedFormula *formula, int target, CubeSet *cubes,
+                int *refuted) {
+  Cuber cuber;
+  memset(&cuber, 0, sizeof(cuber));
+  cuber.cubes = cubes;
+  *refuted = 0;
+  if (!cdcl_load(&cuber.solver, formula, NULL)) {
+    free_cdcl(&cuber.solver);
+    return false;
+  }
+
+  // Candidates ordered by occurrence count, a cheap static activity. The
+  // solver has a variable even for a formula without any.
+  int vars = cuber.solver.variable_count;
+  int *degree = calloc(vars + 1, sizeof(int));
+  unsigned long long *keys = malloc((vars + 1) * sizeof(*keys));
+  cuber.candidates = malloc((vars + 1) * sizeof(int));
+  bool ok = degree && keys && cuber.candidates;
+  if (ok) {
+    for (int i = 0; i < formula->clause_start[formula->clause_count]; i++)
+      degree[lit_var(formula->literals[i])]++;
+    for (int v = 1; v <= vars; v++)
+      keys[v - 1] = (0xFFFFFFFFULL - (unsigned)degree[v]) << 32 | (unsigned)v;
+    qsort(keys, vars, sizeof(*keys), compare_sort_keys);
+    for (int i = 0; i < vars; i++)
+      cuber.candidates[i] = (int)(keys[i] & 0xFFFFFFFFULL);
+
+    TRACE_BEGIN("cube");
+    if (cuber.solver.inconsistent)
+      cuber.refuted++;
+    else
+      cube_split(&cuber, target);
+    TRACE_END("cube");
+    ok = !cuber.out_of_memory && !cuber.solver.out_of_memory;
+  }
+
+  *refuted = cuber.refuted;
+  free(degree);
+  free(keys);
+  free(cuber.candidates);
+  free_int_array(&cuber.path);
+  free_cdcl(&cuber.solver);
+  return ok;
+}
+
+// Function to write a formula and its cubes in iCNF ("p inccnf", DIMACS
+// clauses, then one "a <literals> 0" line per cube). Formulas read from
+// DIMACS keep their variable numbers; otherwise variables are numbered in
+// order of appearance and named in "c" lines.
+bool write_icnf(const char *path, const PropositionalFormula *formula,
+                const IndexedFormula *indexed, const CubeSet *cubes) {
+  bool renumbered = false;
+  int *number = external_numbers(formula, &renumbered);
+  FILE *file = fopen(path, "w");
+  if (!number || !file) {
+    free(number);
+    if (file)
+      fclose(file);
+    printf("Error: Unable to write %s\n", path);
+    return false;
+  }
+
+  fprintf(file, "c %d cubes\n", cube_count(cubes));
+  for (int v = 1; v <= indexed->variable_count; v++) {
+    if (renumbered)
+      fprintf(file, "c %d %s\n", v, formula->symbols[v - 1].symbol);
+  }
+  fprintf(file, "p inccnf\n");
+
+  for (int c = 0; c < indexed->clause_count; c++) {
+    for (int i = indexed->clause_start[c]; i < indexed->clause_start[c + 1];
+         i++) {
+      int lit = indexed->literals[i];
+      fprintf(file, "%d ", lit > 0 ? number[lit] : -number[-lit]);
+    }
+    fprintf(file, "0\n");
+  }
+  for (int k = 0; k < cube_count(cubes); k++) {
+    fprintf(file, "a");
+    for (int i = cubes->start.items[k]; i < cubes->start.items[k + 1]; i++) {
+      int lit = cubes->literals.items[i];
+      fprintf(file, " %d", lit > 0 ? number[lit] : -number[-lit]);
+    }
+    fprintf(file, " 0\n");
+  }
+
+  free(number);
+  bool ok = !ferror(file);
+  if (fclose(file) != 0 || !ok) {
+    printf("Error: Unable to write %s\n", path);
+    return false;
+  }
+  return true;
+}
+
+// Shared state of the cube runner
+typedef struct {
+  const IndexedFormula *formula;
+  const CubeSet *cubes;
+  bool *model;
+  SolverMutex lock;
+  int next;
+  volatile bool stop; // raised by the first satisfiable cube
+  bool satisfiable;
+  bool unsatisfiable; // refuted without any cube assumption
+  bool unknown;
+} CubePool;
+
+// Function run by each runner thread: an incremental CDCL solver takes
+// cubes from the shared queue and solves under them as assumptions, keeping
+// its learnt clauses from one cube to the next
+void cube_worker(void *argument) {
+  CubePool *pool = argument;
+  CdclSolver solver;
+  bool ready = cdcl_load(&solver, pool->formula, NULL);
+  solver.interrupt = &pool->stop;
+
+  while (ready) {
+    lock_mutex(&pool->lock);
+    int cube = -1;
+    if (!pool->stop && pool->next < cube_count(pool->cubes))
+      cube = pool->next++;
+    unlock_mutex(&pool->lock);
+    if (cube < 0)
+      break;
+
+    int start = pool->cubes->start.items[cube];
+    int end = pool->cubes->start.items[cube + 1];
+    TRACE_BEGIN_N("conquer_cube", cube);
+    SolveResult result = cdcl_solve(
+        &solver, pool->cubes->literals.items + start, end - start);
+    TRACE_END("conquer_cube");
+
+    lock_mutex(&pool->lock);
+    if (result == RESULT_SAT && !pool->satisfiable) {
+      pool->satisfiable = true;
+      pool->stop = true;
+      memcpy(pool->model, solver.model,
+             (pool->formula->variable_count + 1) * sizeof(bool));
+    } else if (result == RESULT_UNSAT && solver.failed.count == 0) {
+      pool->unsatisfiable = true;
+      pool->stop = true;
+    } else if (result == RESULT_UNKNOWN && !pool->stop) {
+      pool->unknown = true;
+    }
+    unlock_mutex(&pool->lock);
+  }
+
+  if (!ready) {
+    lock_mutex(&pool->lock);
+    pool->unknown = true;
+    unlock_mutex(&pool->lock);
+  }
+  free_cdcl(&solver);
+}
+
+// Function to check that cubes cover the search space, i.e. that every
+// assignment satisfies one of them: the clauses negating the cubes must
+// then be unsatisfiable
+bool cubes_cover(const IndexedFormula *formula, const CubeSet *cubes) {
+  CdclSolver solver;
+  IntArray negated = {0};
+  bool ready = init_cdcl(&solver, formula->variable_count);
+  for (int i = 0; ready && i < cube_count(cubes); i++) {
+    negated.count = 0;
+    for (int k = cubes->start.items[i]; ready && k < cubes->start.items[i + 1];
+         k++)
+      ready = int_array_push(&negated, -cubes->literals.items[k]);
+    if (ready && !cdcl_add_clause(&solver, negated.items, negated.count))
+      ready = !solver.out_of_memory;
+  }
+  bool covered = ready && cdcl_solve(&solver, NULL, 0) == RESULT_UNSAT;
+  free_int_array(&negated);
+  free_cdcl(&solver);
+  return covered;
+}
+
+// Function to solve the cubes on a thread pool with a dynamic queue,
+// stopping at the first satisfiable cube. Refuting every cube proves UNSAT
+// only when the cubes cover the search space, as the ones make_cubes()
+// produces do; otherwise the answer is RESULT_UNKNOWN.
+SolveResult conquer_cubes(const IndexedFormula *formula,
+                          const CubeSet *cubes, bool covering,
+                          const SolverOptions *options, bool *model) {
+  CubePool pool;
+  SolverMutex unlocked = SOLVER_MUTEX_INIT;
+  memset(&pool, 0, sizeof(pool));
+  pool.formula = formula;
+  pool.cubes = cubes;
+  pool.model = model;
+  pool.lock = unlocked;
+
+  int threads = options->threads < cube_count(cubes) ? options->threads
+                                                     : cube_count(cubes);
+  run_workers(cube_worker, &pool, threads > 0 ? threads : 1);
+
+  if (pool.satisfiable)
+    return RESULT_SAT;
+  if (pool.unsatisfiable)
+    return RESULT_UNSAT;
+  return pool.unknown || !covering ? RESULT_UNKNOWN : RESULT_UNSAT;
+}
+
+// Where a clause stands during core extraction
+typedef enum {
+  CLAUSE_OUTSIDE,   // not in the core
+  CLAUSE_CANDIDATE, // in the core, not yet known to be necessary
+  CLAUSE_NECESSARY, // removing it makes the core satisfiable
+  CLAUSE_KEPT       // candidate used by the latest refutation
+} CoreStatus;
+
+// Core extraction state: one incremental CDCL solver over the formula with
+// clause c loaded as (C v -s) for a fresh selector s = variable_count + 1 +
+// c, so assuming s enables the clause and leaving it free disables it
+typedef struct {
+  const IndexedFormula *formula;
+  CdclSolver solver;
+  signed char *status; // CoreStatus by clause
+  IntArray assumptions;
+  IntArray frames;       // model rotation stack: clause, next literal, flip
+  int *occurrence_start; // by lit_index(): clauses containing the literal
+  int *occurrences;
+  bool *model;           // witness of the latest satisfiable check
+} CoreSearch;
+
+// Function to get the selector variable of a clause
+static inline int core_selector(const CoreSearch *search, int clause) {
+  return search->formula->variable_count + 1 + clause;
+}
+
+// Function to free core extraction state
+void free_core_search(CoreSearch *search) {
+  free_cdcl(&search->solver);
+  free(search->status);
+  free_int_array(&search->assumptions);
+  free_int_array(&search->frames);
+  free(search->occurrence_start);
+  free(search->occurrences);
+  free(search->model);
+}
+
+// Function to load the formula with selectors and index the occurrences of
+// every literal for model rotation
+bool init_core_search(CoreSearch *search, const IndexedFormula *formula) {
+  memset(search, 0, sizeof(*search));
+  search->formula = formula;
+  int vars = formula->variable_count, clauses = formula->clause_count;
+  int total = formula->clause_start[clauses];
+  search->status = calloc(clauses + 1, sizeof(signed char));
+  search->occurrence_start = calloc(2 * vars + 3, sizeof(int));
+  search->occurrences = malloc((total + 1) * sizeof(int));
+  search->model = calloc(vars + 1, sizeof(bool));
+  if (!search->status || !search->occurrence_start || !search->occurrences ||
+      !search->model || !init_cdcl(&search->solver, vars + clauses))
+    return false;
+
+  // Counting sort of clause numbers by literal
+  for (int i = 0; i < total; i++)
+    search->occurrence_start[lit_index(formula->literals[i]) + 1]++;
+  for (int l = 1; l < 2 * vars + 3; l++)
+    search->occurrence_start[l] += search->occurrence_start[l - 1];
+  int *fill = search->occurrence_start;
+  for (int c = 0; c < clauses; c++) {
+    for (int i = formula->clause_start[c]; i < formula->clause_start[c + 1];
+         i++)
+      search->occurrences[fill[lit_index(formula->literals[i])]++] = c;
+  }
+  for (int l = 2 * vars + 2; l > 0; l--)
+    fill[l] = fill[l - 1];
+  fill[0] = 0;
+
+  IntArray lits = {0};
+  bool ok = true;
+  for (int c = 0; c < clauses && ok; c++) {
+    lits.count = 0;
+    for (int i = formula->clause_start[c];
+         i < formula->clause_start[c + 1] && ok; i++)
+      ok = int_array_push(&lits, formula->literals[i]);
+    ok = ok && int_array_push(&lits, -core_selector(search, c)) &&
+         cdcl_add_clause(&search->solver, lits.items, lits.count);
+  }
+  free_int_array(&lits);
+  return ok;
+}
+
+// Function to solve with every candidate and necessary clause enabled,
+// except skip (-1 for none)
+SolveResult core_check(CoreSearch *search, int skip) {
+  search->assumptions.count = 0;
+  for (int c = 0; c < search->formula->clause_count; c++) {
+    if (c != skip && search->status[c] != CLAUSE_OUTSIDE &&
+        !int_array_push(&search->assumptions, core_selector(search, c)))
+      return RESULT_UNKNOWN;
+  }
+  g_stats.core_solves++;
+  SolveResult result = cdcl_solve(&search->solver, search->assumptions.items,
+                                  search->assumptions.count);
+  if (result == RESULT_SAT)
+    memcpy(search->model, search->solver.model,
+           (search->formula->variable_count + 1) * sizeof(bool));
+  return result;
+}
+
+// Function to drop from the candidates every clause the last refutation
+// did not need (clause-set refinement). Dropped clauses get a unit -s, so
+// the solver never branches on their selectors again.
+void core_refine(CoreSearch *search) {
+  const IntArray *failed = &search->solver.failed;
+  if (failed->count == 0)
+    return; // refuted without assumptions: nothing to learn
+  int vars = search->formula->variable_count;
+  for (int i = 0; i < failed->count; i++) {
+    int clause = failed->items[i] - vars - 1;
+    if (clause >= 0 && search->status[clause] == CLAUSE_CANDIDATE)
+      search->status[clause] = CLAUSE_KEPT;
+  }
+  for (int c = 0; c < search->formula->clause_count; c++) {
+    if (search->status[c] == CLAUSE_KEPT) {
+      search->status[c] = CLAUSE_CANDIDATE;
+    } else if (search->status[c] == CLAUSE_CANDIDATE) {
+      int unit = -core_selector(search, c);
+      search->status[c] = CLAUSE_OUTSIDE;
+      cdcl_add_clause(&search->solver, &unit, 1);
+    }
+  }
+}
+
+// Function to check whether the current model falsifies a clause
+static inline bool core_falsified(const CoreSearch *search, int clause) {
+  const IndexedFormula *formula = search->formula;
+  for (int i = formula->clause_start[clause];
+       i < formula->clause_start[clause + 1]; i++) {
+    int lit = formula->literals[i];
+    if (search->model[lit_var(lit)] == (lit > 0))
+      return false;
+  }
+  return true;
+}
+
+// Function to apply recursive model rotation from a necessary clause, the
+// only one of the core the model falsifies. Flipping one of its variables
+// can only falsify clauses containing the complement; if exactly one core
+// clause ends up falsified, the flipped model witnesses that it is
+// necessary too, and rotation continues from it. Saves one solver call per
+// clause found this way.
+void rotate_model(CoreSearch *search, int clause) {
+  const IndexedFormula *formula = search->formula;
+  IntArray *frames = &search->frames;
+  frames->count = 0;
+  if (!int_array_push(frames, clause) || !int_array_push(frames, 0) ||
+      !int_array_push(frames, 0))
+    return;
+
+  while (frames->count > 0) {
+    int *frame = frames->items + frames->count - 3;
+    int next = formula->clause_start[frame[0]] + frame[1];
+    if (next == formula->clause_start[frame[0] + 1]) {
+      if (frame[2] > 0) // undo the flip that led here
+        search->model[frame[2]] = !search->model[frame[2]];
+      frames->count -= 3;
+      continue;
+    }
+    frame[1]++;
+
+    int lit = formula->literals[next], var = lit_var(lit);
+    search->model[var] = !search->model[var];
+    int falsified = -1, count = 0;
+    int complement = lit_index(-lit);
+    for (int i = search->occurrence_start[complement];
+         i < search->occurrence_start[complement + 1] && count < 2; i++) {
+      int other = search->occurrences[i];
+      if (search->status[other] != CLAUSE_OUTSIDE &&
+          core_falsified(search, other)) {
+        falsified = other;
+        count++;
+      }
+    }
+    if (count == 1 && search->status[falsified] == CLAUSE_CANDIDATE) {
+      search->status[falsified] = CLAUSE_NECESSARY;
+      if (!int_array_push(frames, falsified) || !int_array_push(frames, 0) ||
+          !int_array_push(frames, var))
+        return;
+    } else {
+      search->model[var] = !search->model[var];
+    }
+  }
+}
+
+// Function to shrink the candidates to a minimal unsatisfiable subset by
+// deletion: a candidate whose removal leaves the rest unsatisfiable is
+// dropped along with everything that refutation did not use, otherwise it
+// is necessary and model rotation looks for more necessary clauses. All
+// checks run on the same solver, which keeps its learnt clauses.
+bool minimize_core(CoreSearch *search) {
+  for (int c = 0; c < search->formula->clause_count; c++) {
+    if (search->status[c] != CLAUSE_CANDIDATE)
+      continue;
+    TRACE_BEGIN_N("mus_check", c);
+    SolveResult result = core_check(search, c);
+    TRACE_END("mus_check");
+    if (result == RESULT_UNSAT) {
+      int unit = -core_selector(search, c);
+      search->status[c] = CLAUSE_OUTSIDE;
+      cdcl_add_clause(&search->solver, &unit, 1);
+      core_refine(search);
+    } else if (result == RESULT_SAT) {
+      search->status[c] = CLAUSE_NECESSARY;
+      rotate_model(search, c);
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Function to solve while tracking which clauses a refutation uses. The
+// clauses marked in core (if any) are the starting candidates, otherwise
+// all of them. On RESULT_UNSAT core marks an unsatisfiable subset of the
+// clauses, minimal with CORE_MINIMAL; on RESULT_SAT model holds an
+// assignment.
+SolveResult core_solve(const IndexedFormula *formula, CoreMode mode,
+                       bool *model, bool *core) {
+  CoreSearch search;
+  if (!init_core_search(&search, formula)) {
+    free_core_search(&search);
+    return RESULT_UNKNOWN;
+  }
+
+  bool marked = false;
+  for (int c = 0; c < formula->clause_count && !marked; c++)
+    marked = core[c];
+  for (int c = 0; c < formula->clause_count; c++)
+    search.status[c] =
+        !marked || core[c] ? CLAUSE_CANDIDATE : CLAUSE_OUTSIDE;
+
+  TRACE_BEGIN("core");
+  SolveResult result = core_check(&search, -1);
+  if (result == RESULT_SAT) {
+    memcpy(model, search.model, (formula->variable_count + 1) * sizeof(bool));
+  } else if (result == RESULT_UNSAT) {
+    core_refine(&search);
+    if (mode == CORE_MINIMAL && !minimize_core(&search))
+      result = RESULT_UNKNOWN;
+  }
+  TRACE_END("core");
+
+  if (result == RESULT_UNSAT) {
+    g_stats.core_clauses = 0;
+    for (int c = 0; c < formula->clause_count; c++) {
+      core[c] = search.status[c] != CLAUSE_OUTSIDE;
+      g_stats.core_clauses += core[c];
+    }
+  }
+  free_core_search(&search);
+  return result;
+}
+
+// Function to write the clauses marked in core as a formula in the input's
+// syntax: DIMACS with the original variable numbers for DIMACS inputs,
+// one clause of symbols per line otherwise
+bool write_core(const char *path, const PropositionalFormula *formula,
+                const bool *core) {
+  bool renumbered;
+  int *number = external_numbers(formula, &renumbered);
+  FILE *file = number ? fopen(path, "w") : NULL;
+  if (!file) {
+    free(number);
+    printf("Error: Unable to write %s\n", path);
+    return false;
+  }
+
+  int clauses = 0, vars = 0;
+  for (int c = 0; c < formula->clause_count; c++) {
+    if (!core[c])
+      continue;
+    clauses++;
+    const PropositionClause *clause = &formula->clauses[c];
+    for (int j = 0; j < clause->term_count; j++) {
+      int var = find_symbol(formula, clause->terms[j].symbol.symbol);
+      if (number[var + 1] > vars)
+        vars = number[var + 1];
+    }
+  }
+  if (!renumbered)
+    fprintf(file, "p cnf %d %d\n", vars, clauses);
+  for (int c = 0; c < formula->clause_count; c++) {
+    if (!core[c])
+      continue;
+    const PropositionClause *clause = &formula->clauses[c];
+    for (int j = 0; j < clause->term_count; j++) {
+      const PropositionTerm *term = &clause->terms[j];
+      if (renumbered) {
+        fprintf(file, "%s%s%s", j > 0 ? " " : "", term->is_negated ? "!" : "",
+                term->symbol.symbol);
+      } else {
+        int var = number[find_symbol(formula, term->symbol.symbol) + 1];
+        fprintf(file, "%d ", term->is_negated ? -var : var);
+      }
+    }
+    fprintf(file, renumbered ? "\n" : "0\n");
+  }
+
+  free(number);
+  bool ok = !ferror(file);
+  if (fclose(file) != 0 || !ok) {
+    printf("Error: Unable to write %s\n", path);
+    return false;
+  }
+  return true;
+}
+
+// Soft literal of the core-guided MaxSAT search: an assumption whose
+// falsification costs weight. For a totalizer output it stands for "at
+// most bound inputs of root are true".
+typedef struct {
+  int lit;
+  unsigned long long weight; // what is left of it, 0 once fully relaxed
+  int root;                  // totalizer root, -1 for a soft clause
+  int bound;
+  bool in_core;              // member of the core being reduced
+} SoftLiteral;
+
+// Totalizer node counting the true inputs below it: outputs.items[t - 1]
+// is implied true when at least t of them are. Outputs exist only up to
+// the bound asked for so far and are added as it grows.
+typedef struct {
+  int left, right; // children, -1 for an input
+  int inputs;
+  IntArray outputs;
+} TotalizerNode;
+
+// State of the MaxSAT search: one incremental CDCL solver holds the hard
+// clauses, the relaxed soft clauses and every totalizer built so far
+typedef struct {
+  const IndexedFormula *formula;
+  const unsigned long long *weights; // by clause, 0 for hard clauses
+  CdclSolver solver;
+  int variable_count; // formula variables plus fresh ones
+  SoftLiteral *softs;
+  int soft_count;
+  int soft_capacity;
+  IntArray soft_of; // by lit_index(): entry in softs, or -1
+  TotalizerNode *nodes;
+  int node_count;
+  int node_capacity;
+  IntArray assumptions;
+  IntArray clause;          // scratch clause
+  IntArray core;            // copy of the latest core
+  IntArray candidates;      // core literals still to try removing
+  unsigned long long lower_bound; // total weight of the cores so far
+  unsigned long long best_cost;   // ULLONG_MAX until a model is found
+  bool *best_model;
+} MaxsatSearch;
+
+// Function to free MaxSAT search state
+void free_maxsat(MaxsatSearch *search) {
+  free_cdcl(&search->solver);
+  free(search->softs);
+  free_int_array(&search->soft_of);
+  for (int i = 0; i < search->node_count; i++)
+    free_int_array(&search->nodes[i].outputs);
+  free(search->nodes);
+  free_int_array(&search->assumptions);
+  free_int_array(&search->clause);
+  free_int_array(&search->core);
+  free_int_array(&search->candidates);
+  free(search->best_model);
+}
+
+// Function to add weight to the soft literal lit, creating it if needed
+bool maxsat_add_soft(MaxsatSearch *search, int lit, unsigned long long weight,
+                     int root, int bound) {
+  int index = lit_index(lit);
+  while (search->soft_of.count <= index)
+    if (!int_array_push(&search->soft_of, -1))
+      return false;
+  if (search->soft_of.items[index] >= 0) {
+    search->softs[search->soft_of.items[index]].weight += weight;
+    return true;
+  }
+  if (search->soft_count == search->soft_capacity) {
+    int capacity = search->soft_capacity
+                       ? search->soft_capacity * EXPANSION_RATE
+                       : BASE_SIZE;
+    SoftLiteral *softs = realloc(search->softs, capacity * sizeof(*softs));
+    if (!softs)
+      return false;
+    search->softs = softs;
+    search->soft_capacity = capacity;
+  }
+  SoftLiteral soft = {lit, weight, root, bound, false};
+  search->soft_of.items[index] = search->soft_count;
+  search->softs[search->soft_count++] = soft;
+  return true;
+}
+
+// Function to build the tree of a totalizer over count input literals,
+// returning its root or -1 when out of memory
+int totalizer_build(MaxsatSearch *search, const int *lits, int count) {
+  int left = -1, right = -1;
+  if (count > 1) {
+    left = totalizer_build(search, lits, count / 2);
+    right = totalizer_build(search, lits + count / 2, count - count / 2);
+    if (left < 0 || right < 0)
+      return -1;
+  }
+  if (search->node_count == search->node_capacity) {
+    int capacity = search->node_capacity
+                       ? search->node_capacity * EXPANSION_RATE
+                       : BASE_SIZE;
+    TotalizerNode *nodes = realloc(search->nodes, capacity * sizeof(*nodes));
+    if (!nodes)
+      return -1;
+    search->nodes = nodes;
+    search->node_capacity = capacity;
+  }
+  int node = search->node_count++;
+  TotalizerNode *created = &search->nodes[node];
+  created->left = left;
+  created->right = right;
+  created->inputs = count;
+  memset(&created->outputs, 0, sizeof(created->outputs));
+  if (count == 1 && !int_array_push(&created->outputs, lits[0]))
+    return -1;
+  return node;
+}
+
+// Function to give a totalizer node outputs up to bound, bottom-up. Output
+// t gets one clause (-l_i v -r_j v o_t) per split t = i + j of the count
+// between the children, l_0 and r_0 being left out.
+bool totalizer_grow(MaxsatSearch *search, int node, int bound) {
+  TotalizerNode *n = &search->nodes[node];
+  if (n->left < 0)
+    return true;
+  if (!totalizer_grow(search, n->left, bound) ||
+      !totalizer_grow(search, n->right, bound))
+    return false;
+  n = &search->nodes[node];
+  const IntArray *left = &search->nodes[n->left].outputs;
+  const IntArray *right = &search->nodes[n->right].outputs;
+  int target = n->inputs < bound ? n->inputs : bound;
+
+  for (int t = n->outputs.count + 1; t <= target; t++) {
+    int output = ++search->variable_count;
+    if (!int_array_push(&n->outputs, output))
+      return false;
+    for (int i = 0; i <= left->count && i <= t; i++) {
+      int j = t - i;
+      if (j > right->count)
+        continue;
+      search->clause.count = 0;
+      if ((i > 0 && !int_array_push(&search->clause, -left->items[i - 1])) ||
+          (j > 0 && !int_array_push(&search->clause, -right->items[j - 1])) ||
+          !int_array_push(&search->clause, output))
+        return false;
+      if (!cdcl_add_clause(&search->solver, search->clause.items,
+                           search->clause.count) &&
+          search->solver.out_of_memory)
+        return false;
+    }
+  }
+  return true;
+}
+
+// Function to load the hard clauses, and each soft clause with a fresh
+// relaxation literal r as (C v -r) unless it is a unit, whose literal is
+// assumed directly
+bool init_maxsat(MaxsatSearch *search, const IndexedFormula *formula,
+                 const unsigned long long *weights) {
+  memset(search, 0, sizeof(*search));
+  search->formula = formula;
+  search->weights = weights;
+  search->variable_count = formula->variable_count;
+  search->best_cost = ULLONG_MAX;
+  search->best_model = calloc(formula->variable_count + 1, sizeof(bool));
+  if (!search->best_model ||
+      !init_cdcl(&search->solver, formula->variable_count))
+    return false;
+
+  for (int c = 0; c < formula->clause_count; c++) {
+    int start = formula->clause_start[c];
+    int size = formula->clause_start[c + 1] - start;
+    search->clause.count = 0;
+    for (int i = 0; i < size; i++)
+      if (!int_array_push(&search->clause, formula->literals[start + i]))
+        return false;
+    if (weights[c] > 0 && size == 1) {
+      if (!maxsat_add_soft(search, formula->literals[start], weights[c], -1,
+                           0))
+        return false;
+      continue;
+    }
+    int relax = weights[c] > 0 ? ++search->variable_count : 0;
+    if ((relax && (!int_array_push(&search->clause, -relax) ||
+                   !maxsat_add_soft(search, relax, weights[c], -1, 0))) ||
+        (!cdcl_add_clause(&search->solver, search->clause.items,
+                          search->clause.count) &&
+         search->solver.out_of_memory))
+      return false;
+  }
+  return true;
+}
+
+// Function to get the next stratum: the largest remaining soft weight
+// below limit, 0 when there is none
+unsigned long long maxsat_stratum(const MaxsatSearch *search,
+                                  unsigned long long limit) {
+  unsigned long long stratum = 0;
+  for (int i = 0; i < search->soft_count; i++) {
+    unsigned long long weight = search->softs[i].weight;
+    if (weight < limit && weight > stratum)
+      stratum = weight;
+  }
+  return stratum;
+}
+
+// Function to solve under the soft literals of at least the stratum's
+// weight, in slices of conflicts when a deadline is set
+SolveResult maxsat_check(MaxsatSearch *search, unsigned long long stratum,
+                         double deadline) {
+  search->assumptions.count = 0;
+  for (int i = 0; i < search->soft_count; i++) {
+    if (search->softs[i].weight >= stratum && search->softs[i].weight > 0 &&
+        !int_array_push(&search->assumptions, search->softs[i].lit))
+      return RESULT_UNKNOWN;
+  }
+  search->solver.conflict_budget = deadline > 0 ? MAXSAT_CONFLICT_CHUNK : 0;
+  SolveResult result;
+  do {
+    result = cdcl_solve(&search->solver, search->assumptions.items,
+                        search->assumptions.count);
+  } while (result == RESULT_UNKNOWN && !search->solver.out_of_memory &&
+           deadline > 0 && stats_now() < deadline);
+  return result;
+}
+
+// Function to keep a model if it beats the best one, printing its cost as
+// an "o" line so that progress is visible while the search runs
+void maxsat_record_model(MaxsatSearch *search) {
+  const IndexedFormula *formula = search->formula;
+  const bool *model = search->solver.model;
+  unsigned long long cost = 0;
+  for (int c = 0; c < formula->clause_count; c++) {
+    if (search->weights[c] == 0)
+      continue;
+    bool satisfied = false;
+    for (int i = formula->clause_start[c];
+         i < formula->clause_start[c + 1] && !satisfied; i++) {
+      int lit = formula->literals[i];
+      satisfied = model[lit_var(lit)] == (lit > 0);
+    }
+    if (!satisfied)
+      cost += search->weights[c];
+  }
+  if (cost >= search->best_cost)
+    return;
+  search->best_cost = cost;
+  memcpy(search->best_model, model,
+         (formula->variable_count + 1) * sizeof(bool));
+  printf("o %llu\n", cost);
+  fflush(stdout);
+}
+
+// Function to make lits (soft literals) the current core
+bool maxsat_set_core(MaxsatSearch *search, const IntArray *lits) {
+  IntArray *core = &search->core;
+  for (int i = 0; i < core->count; i++)
+    search->softs[search->soft_of.items[lit_index(core->items[i])]].in_core =
+        false;
+  core->count = 0;
+  for (int i = 0; i < lits->count; i++) {
+    if (!int_array_push(core, lits->items[i]))
+      return false;
+    search->softs[search->soft_of.items[lit_index(lits->items[i])]].in_core =
+        true;
+  }
+  return true;
+}
+
+// Function to shrink the core before it is relaxed, since smaller cores
+// give tighter totalizers. Trimming re-solves under the core alone while
+// that keeps shrinking it; deletion then drops each literal whose removal
+// still allows a refutation within a small conflict budget. Satisfiable
+// checks along the way are kept as models.
+bool maxsat_reduce_core(MaxsatSearch *search, double deadline) {
+  CdclSolver *s = &search->solver;
+  IntArray *core = &search->core;
+  s->conflict_budget = MAXSAT_MINIMIZE_BUDGET;
+  if (!maxsat_set_core(search, &s->failed))
+    return false;
+
+  for (int round = 0; round < MAXSAT_TRIM_ROUNDS && core->count > 1;
+       round++) {
+    if (cdcl_solve(s, core->items, core->count) != RESULT_UNSAT ||
+        s->failed.count == 0 || s->failed.count >= core->count)
+      break;
+    if (!maxsat_set_core(search, &s->failed))
+      return false;
+  }
+
+  IntArray *candidates = &search->candidates;
+  candidates->count = 0;
+  for (int i = 0; i < core->count; i++)
+    if (!int_array_push(candidates, core->items[i]))
+      return false;
+  for (int i = 0; i < candidates->count && core->count > 1; i++) {
+    int lit = candidates->items[i];
+    if (!search->softs[search->soft_of.items[lit_index(lit)]].in_core)
+      continue;
+    if (deadline > 0 && stats_now() >= deadline)
+      break;
+    search->assumptions.count = 0;
+    for (int k = 0; k < core->count; k++)
+      if (core->items[k] != lit &&
+          !int_array_push(&search->assumptions, core->items[k]))
+        return false;
+    SolveResult result = cdcl_solve(s, search->assumptions.items,
+                                    search->assumptions.count);
+    if (result == RESULT_SAT)
+      maxsat_record_model(search);
+    else if (result == RESULT_UNSAT && s->failed.count > 0 &&
+             !maxsat_set_core(search, &s->failed))
+      return false;
+  }
+  return true;
+}
+
+// Function to relax a core the OLL way. Every soft literal of the core
+// loses the core's minimum weight w, which the lower bound gains. A core of
+// several literals gets a totalizer over their negations, and "at most one
+// of them false" becomes a soft literal of weight w; a core literal that
+// was itself such a bound k moves on to bound k + 1 with weight w. A
+// one-literal core is negated as a hard unit instead.
+bool maxsat_relax_core(MaxsatSearch *search) {
+  IntArray *core = &search->core;
+  unsigned long long w = ULLONG_MAX;
+  for (int i = 0; i < core->count; i++) {
+    SoftLiteral *soft =
+        &search->softs[search->soft_of.items[lit_index(core->items[i])]];
+    soft->in_core = false;
+    if (soft->weight < w)
+      w = soft->weight;
+  }
+  search->lower_bound += w;
+
+  for (int i = 0; i < core->count; i++) {
+    SoftLiteral *soft = &search->softs[search->soft_of.items[lit_index(
+        core->items[i])]];
+    soft->weight -= w;
+    int root = soft->root, bound = soft->bound + 1;
+    if (root >= 0 && bound < search->nodes[root].inputs) {
+      if (!totalizer_grow(search, root, bound + 1) ||
+          !maxsat_add_soft(search,
+                           -search->nodes[root].outputs.items[bound], w,
+                           root, bound))
+        return false;
+    }
+    // The violated input of the new totalizer
+    core->items[i] = -core->items[i];
+  }
+
+  int count = core->count;
+  core->count = 0; // its literals are negated: no longer a core
+  if (count == 1) {
+    cdcl_add_clause(&search->solver, core->items, 1);
+    return !search->solver.out_of_memory;
+  }
+  int root = totalizer_build(search, core->items, count);
+  return root >= 0 && totalizer_grow(search, root, 2) &&
+         maxsat_add_soft(search, -search->nodes[root].outputs.items[1], w,
+                         root, 1);
+}
+
+// Function to find an assignment of the hard clauses that minimises the
+// total weight of falsified soft clauses (weighted partial MaxSAT) by
+// core-guided OLL search with stratification. Soft literals are assumed in
+// strata of decreasing weight; each core found raises the lower bound and
+// is relaxed, and each model lowers the best cost, until they meet. All
+// calls share one solver, so learnt clauses and totalizers carry over. On
+// RESULT_SAT model holds the best assignment found, which is optimal
+// unless options->time_limit ran out first; g_stats.cost and
+// g_stats.cost_lower_bound tell which.
+SolveResult maxsat(const IndexedFormula *formula,
+                   const unsigned long long *weights,
+                   const SolverOptions *options, bool *model) {
+  MaxsatSearch search;
+  if (!init_maxsat(&search, formula, weights)) {
+    free_maxsat(&search);
+    return RESULT_UNKNOWN;
+  }
+  double deadline =
+      options->time_limit > 0 ? stats_now() + options->time_limit : 0;
+
+  // A model of the hard clauses alone gives a first upper bound
+  bool hard_unsat = false;
+  unsigned long long stratum = maxsat_stratum(&search, ULLONG_MAX);
+  TRACE_BEGIN("maxsat");
+  search.assumptions.count = 0;
+  SolveResult first = cdcl_solve(&search.solver, NULL, 0);
+  if (first == RESULT_SAT)
+    maxsat_record_model(&search);
+  hard_unsat = first == RESULT_UNSAT;
+
+  while (!hard_unsat && search.lower_bound < search.best_cost) {
+    TRACE_COUNTER("maxsat_lower_bound", search.lower_bound);
+    SolveResult result = maxsat_check(&search, stratum, deadline);
+    if (result == RESULT_UNKNOWN)
+      break;
+    if (result == RESULT_SAT) {
+      maxsat_record_model(&search);
+      if (stratum == 0)
+        break; // every soft literal was assumed: the model is optimal
+      stratum = maxsat_stratum(&search, stratum);
+      continue;
+    }
+    if (search.solver.failed.count == 0) {
+      hard_unsat = true;
+      break;
+    }
+    if (!maxsat_reduce_core(&search, deadline) ||
+        !maxsat_relax_core(&search))
+      break;
+  }
+  TRACE_END("maxsat");
+
+  SolveResult result = RESULT_UNKNOWN;
+  if (search.best_cost != ULLONG_MAX) {
+    memcpy(model, search.best_model,
+           (formula->variable_count + 1) * sizeof(bool));
+    g_stats.cost = search.best_cost;
+    g_stats.cost_lower_bound = search.lower_bound < search.best_cost
+                                   ? search.lower_bound
+                                   : search.best_cost;
+    result = RESULT_SAT;
+  } else if (hard_unsat) {
+    result = RESULT_UNSAT;
+  }
+  free_maxsat(&search);
+  return result;
+}
+
+// Unsigned integer of any size, for model counts: base 2^32 limbs, least
+// significant first, with no limbs for zero
+typedef struct {
+  unsigned int *limbs;
+  int count;
+  int capacity;
+} BigNum;
+
+// Function to make room for count limbs
+bool bignum_reserve(BigNum *n, int count) {
+  if (count <= n->capacity)
+    return true;
+  int capacity = n->capacity ? n->capacity : 4;
+  while (capacity < count)
+    capacity *= EXPANSION_RATE;
+  unsigned int *limbs = realloc(n->limbs, capacity * sizeof(unsigned int));
+  if (!limbs)
+    return false;
+  n->limbs = limbs;
+  n->capacity = capacity;
+  return true;
+}
+
+// Function to drop leading zero limbs
+static inline void bignum_trim(BigNum *n) {
+  while (n->count > 0 && n->limbs[n->count - 1] == 0)
+    n->count--;
+}
+
+// Function to free a big number
+void free_bignum(BigNum *n) {
+  free(n->limbs);
+  n->limbs = NULL;
+  n->count = 0;
+  n->capacity = 0;
+}
+
+// Function to set a big number to a machine integer
+bool bignum_set(BigNum *n, unsigned long long value) {
+  n->count = 0;
+  if (!bignum_reserve(n, 2))
+    return false;
+  for (; value; value >>= 32)
+    n->limbs[n->count++] = (unsigned int)(value & 0xFFFFFFFFULL);
+  return true;
+}
+
+// Function to copy src into dest
+bool bignum_copy(BigNum *dest, const BigNum *src) {
+  if (!bignum_reserve(dest, src->count))
+    return false;
+  if (src->count > 0)
+    memcpy(dest->limbs, src->limbs, src->count * sizeof(unsigned int));
+  dest->count = src->count;
+  return true;
+}
+
+// Function to add addend to sum
+bool bignum_add(BigNum *sum, const BigNum *addend) {
+  int count = (sum->count > addend->count ? sum->count : addend->count) + 1;
+  if (!bignum_reserve(sum, count))
+    return false;
+  unsigned long long carry = 0;
+  for (int i = 0; i < count; i++) {
+    carry += i < sum->count ? sum->limbs[i] : 0;
+    carry += i < addend->count ? addend->limbs[i] : 0;
+    sum->limbs[i] = (unsigned int)(carry & 0xFFFFFFFFULL);
+    carry >>= 32;
+  }
+  sum->count = count;
+  bignum_trim(sum);
+  return true;
+}
+
+// Function to multiply product by factor, schoolbook style
+bool bignum_multiply(BigNum *product, const BigNum *factor) {
+  if (product->count == 0 || factor->count == 0) {
+    product->count = 0;
+    return true;
+  }
+  int count = product->count + factor->count;
+  unsigned int *limbs = calloc(count, sizeof(unsigned int));
+  if (!limbs)
+    return false;
+  for (int i = 0; i < product->count; i++) {
+    unsigned long long carry = 0;
+    for (int j = 0; j < factor->count; j++) {
+      carry += (unsigned long long)product->limbs[i] * factor->limbs[j] +
+               limbs[i + j];
+      limbs[i + j] = (unsigned int)(carry & 0xFFFFFFFFULL);
+      carry >>= 32;
+    }
+    limbs[i + factor->count] = (unsigned int)carry;
+  }
+  free(product->limbs);
+  product->limbs = limbs;
+  product->count = count;
+  product->capacity = count;
+  bignum_trim(product);
+  return true;
+}
+
+// Function to multiply a big number by 2^bits
+bool bignum_shift_left(BigNum *n, int bits) {
+  if (n->count == 0 || bits == 0)
+    return true;
+  int words = bits / 32, shift = bits % 32;
+  int count = n->count + words + 1;
+  if (!bignum_reserve(n, count))
+    return false;
+  // From the top down, so every limb is read before it is overwritten
+  for (int i = count - 1; i >= words; i--) {
+    int k = i - words;
+    unsigned long long high =
+        k < n->count ? (unsigned long long)n->limbs[k] << shift : 0;
+    unsigned long long low =
+        k > 0 && shift > 0 ? n->limbs[k - 1] >> (32 - shift) : 0;
+    n->limbs[i] = (unsigned int)((high | low) & 0xFFFFFFFFULL);
+  }
+  for (int i = 0; i < words; i++)
+    n->limbs[i] = 0;
+  n->count = count;
+  bignum_trim(n);
+  return true;
+}
+
+// Function to format a big number in decimal; the caller frees the text
+char *bignum_to_string(const BigNum *n) {
+  // A limb holds fewer than ten decimal digits
+  int size = n->count * 10 + 2;
+  char *text = malloc(size);
+  unsigned int *work = malloc((n->count + 1) * sizeof(unsigned int));
+  if (!text || !work) {
+    free(text);
+    free(work);
+    return NULL;
+  }
+  if (n->count > 0)
+    memcpy(work, n->limbs, n->count * sizeof(unsigned int));
+
+  int count = n->count, position = size - 1;
+  text[position] = '\0';
+  if (count == 0)
+    text[--position] = '0';
+  while (count > 0) {
+    // Divide by 10^9 and emit the remainder as nine digits, fewer for the
+    // most significant group
+    unsigned long long remainder = 0;
+    for (int i = count - 1; i >= 0; i--) {
+      unsigned long long value = remainder << 32 | work[i];
+      work[i] = (unsigned int)(value / 1000000000ULL);
+      remainder = value % 1000000000ULL;
+    }
+    while (count > 0 && work[count - 1] == 0)
+      count--;
+    for (int d = 0; d < 9 && (count > 0 || remainder > 0); d++) {
+      text[--position] = (char)('0' + remainder % 10);
+      remainder /= 10;
+    }
+  }
+  free(work);
+  memmove(text, text + position, size - position);
+  return text;
+}
+
+// Component cache entry: a component's key (its sorted variables and the
+// ids of its unsatisfied clauses) with its model count
+typedef struct CacheEntry {
+  struct CacheEntry *next;
+  unsigned long long hash;
+  unsigned long long used; // lookup tick of the last hit, for eviction
+  BigNum count;
+  int length;
+  int key[];
+} CacheEntry;
+
+// Component cache: chained hash table whose size in bytes stays under a
+// limit by evicting the least recently used entries
+typedef struct {
+  CacheEntry **buckets;
+  int bucket_count;
+  int entry_count;
+  size_t bytes;
+  size_t limit;
+  unsigned long long tick;
+} ComponentCache;
+
+// Function to hash a component key
+unsigned long long cache_hash(const int *key, int length) {
+  unsigned long long hash = 0xcbf29ce484222325ULL;
+  for (int i = 0; i < length; i++)
+    hash = (hash ^ (unsigned int)key[i]) * 0x100000001b3ULL;
+  return hash ^ hash >> 29;
+}
+
+// Function to get the memory an entry accounts for
+static inline size_t cache_entry_bytes(const CacheEntry *entry) {
+  return sizeof(CacheEntry) + entry->length * sizeof(int) +
+         entry->count.capacity * sizeof(unsigned int);
+}
+
+// Function to free a cache and its entries
+void free_cache(ComponentCache *cache) {
+  for (int b = 0; b < cache->bucket_count; b++) {
+    for (CacheEntry *entry = cache->buckets[b], *next; entry; entry = next) {
+      next = entry->next;
+      free_bignum(&entry->count);
+      free(entry);
+    }
+  }
+  free(cache->buckets);
+  memset(cache, 0, sizeof(*cache));
+}
+
+// Function to find the entry for a key, or NULL
+CacheEntry *cache_lookup(ComponentCache *cache, const int *key, int length,
+                         unsigned long long hash) {
+  CacheEntry *entry = cache->buckets[hash % cache->bucket_count];
+  for (; entry; entry = entry->next) {
+    if (entry->hash == hash && entry->length == length &&
+        memcmp(entry->key, key, length * sizeof(int)) == 0) {
+      entry->used = ++cache->tick;
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+// Function to evict entries until the cache fills at most three quarters
+// of its limit. Each pass drops every entry not used since the midpoint
+// between the oldest use and now, which removes at least the oldest one.
+void cache_evict(ComponentCache *cache) {
+  while (cache->entry_count > 0 && cache->bytes > cache->limit / 4 * 3) {
+    unsigned long long oldest = ULLONG_MAX;
+    for (int b = 0; b < cache->bucket_count; b++)
+      for (CacheEntry *entry = cache->buckets[b]; entry; entry = entry->next)
+        if (entry->used < oldest)
+          oldest = entry->used;
+
+    unsigned long long threshold = oldest + (cache->tick - oldest) / 2;
+    for (int b = 0; b < cache->bucket_count; b++) {
+      CacheEntry **link = &cache->buckets[b];
+      while (*link) {
+        CacheEntry *entry = *link;
+        if (entry->used > threshold) {
+          link = &entry->next;
+          continue;
+        }
+        *link = entry->next;
+        cache->bytes -= cache_entry_bytes(entry);
+        cache->entry_count--;
+        STAT_INC(cache_evictions);
+        free_bignum(&entry->count);
+        free(entry);
+      }
+    }
+  }
+}
+
+// Function to double the bucket array once chains grow long
+bool cache_grow(ComponentCache *cache) {
+  int bucket_count = cache->bucket_count * 2;
+  CacheEntry **buckets = calloc(bucket_count, sizeof(CacheEntry *));
+  if (!buckets)
+    return false;
+  for (int b = 0; b < cache->bucket_count; b++) {
+    for (CacheEntry *entry = cache->buckets[b], *next; entry; entry = next) {
+      next = entry->next;
+      entry->next = buckets[entry->hash % bucket_count];
+      buckets[entry->hash % bucket_count] = entry;
+    }
+  }
+  cache->bytes += (bucket_count - cache->bucket_count) * sizeof(CacheEntry *);
+  free(cache->buckets);
+  cache->buckets = buckets;
+  cache->bucket_count = bucket_count;
+  return true;
+}
+
+// Function to store the count of a component. A full cache evicts first;
+// failing to store only costs a recount later.
+void cache_store(ComponentCache *cache, const int *key, int length,
+                 unsigned long long hash, const BigNum *count) {
+  CacheEntry *entry = malloc(sizeof(CacheEntry) + length * sizeof(int));
+  if (!entry)
+    return;
+  memset(&entry->count, 0, sizeof(entry->count));
+  if (!bignum_copy(&entry->count, count)) {
+    free(entry);
+    return;
+  }
+  entry->hash = hash;
+  entry->used = ++cache->tick;
+  entry->length = length;
+  memcpy(entry->key, key, length * sizeof(int));
+
+  if (cache->bytes + cache_entry_bytes(entry) > cache->limit)
+    cache_evict(cache);
+  if (cache->entry_count >= 2 * cache->bucket_count &&
+      cache->bytes < cache->limit / 2)
+    cache_grow(cache);
+  entry->next = cache->buckets[hash % cache->bucket_count];
+  cache->buckets[hash % cache->bucket_count] = entry;
+  cache->bytes += cache_entry_bytes(entry);
+  cache->entry_count++;
+}
+
+// Model counter state. Clauses keep counts of their true and false
+// literals instead of watches, since every unsatisfied clause must be
+// known to split components. A component is stored on the components
+// stack as [variable count, variables..., clause count, clauses...], both
+// lists sorted, which is also its cache key.
+typedef struct {
+  const IndexedFormula *formula;
+  int *occurrence_start; // by lit_index(): start in occurrences, plus end
+  int *occurrences;      // clause ids containing each literal
+  signed char *values;   // by variable: 1 true, -1 false, 0 unassigned
+  int *true_count;       // by clause
+  int *false_count;      // by clause
+  int *score;            // by variable, zero between branching choices
+  int *variable_stamp;
+  int *clause_stamp;
+  int stamp;
+  IntArray trail;
+  int propagated; // trail prefix whose literals the clause counts include
+  IntArray components;
+  IntArray queue;
+  IntArray variables;
+  ComponentCache cache;
+  bool out_of_memory;
+} ModelCounter;
+
+// Function to free a model counter
+void free_counter(ModelCounter *counter) {
+  free(counter->occurrence_start);
+  free(counter->occurrences);
+  free(counter->values);
+  free(counter->true_count);
+  free(counter->false_count);
+  free(counter->score);
+  free(counter->variable_stamp);
+  free(counter->clause_stamp);
+  free_int_array(&counter->trail);
+  free_int_array(&counter->components);
+  free_int_array(&counter->queue);
+  free_int_array(&counter->variables);
+  free_cache(&counter->cache);
+}
+
+// Function to set up a counter with occurrence lists and an empty cache of
+// limit bytes
+bool init_counter(ModelCounter *counter, const IndexedFormula *formula,
+                  size_t limit) {
+  memset(counter, 0, sizeof(*counter));
+  counter->formula = formula;
+  int vars = formula->variable_count, clauses = formula->clause_count;
+  int total = formula->clause_start[clauses];
+  counter->occurrence_start = calloc(2 * vars + 3, sizeof(int));
+  counter->occurrences = malloc((total > 0 ? total : 1) * sizeof(int));
+  counter->values = calloc(vars + 1, 1);
+  counter->true_count = calloc(clauses + 1, sizeof(int));
+  counter->false_count = calloc(clauses + 1, sizeof(int));
+  counter->score = calloc(vars + 1, sizeof(int));
+  counter->variable_stamp = calloc(vars + 1, sizeof(int));
+  counter->clause_stamp = calloc(clauses + 1, sizeof(int));
+  counter->cache.bucket_count = CACHE_INITIAL_BUCKETS;
+  counter->cache.buckets = calloc(CACHE_INITIAL_BUCKETS, sizeof(CacheEntry *));
+  counter->cache.bytes = CACHE_INITIAL_BUCKETS * sizeof(CacheEntry *);
+  counter->cache.limit = limit;
+  if (!counter->occurrence_start || !counter->occurrences ||
+      !counter->values || !counter->true_count || !counter->false_count ||
+      !counter->score || !counter->variable_stamp || !counter->clause_stamp ||
+      !counter->cache.buckets)
+    return false;
+
+  // Counting sort of the literal occurrences by lit_index()
+  for (int i = 0; i < total; i++)
+    counter->occurrence_start[lit_index(formula->literals[i]) + 1]++;
+  for (int i = 1; i <= 2 * vars + 2; i++)
+    counter->occurrence_start[i] += counter->occurrence_start[i - 1];
+  int *next = malloc((2 * vars + 2) * sizeof(int));
+  if (!next)
+    return false;
+  memcpy(next, counter->occurrence_start, (2 * vars + 2) * sizeof(int));
+  for (int c = 0; c < clauses; c++)
+    for (int i = formula->clause_start[c]; i < formula->clause_start[c + 1];
+         i++)
+      counter->occurrences[next[lit_index(formula->literals[i])]++] = c;
+  free(next);
+  return true;
+}
+
+// Function to get the value of a literal: 1 true, -1 false, 0 unassigned
+static inline int counter_value(const ModelCounter *counter, int lit) {
+  int value = counter->values[lit_var(lit)];
+  return lit > 0 ? value : -value;
+}
+
+// Function to assign lit without propagating it yet
+static inline bool counter_assign(ModelCounter *counter, int lit) {
+  counter->values[lit_var(lit)] = lit > 0 ? 1 : -1;
+  return int_array_push(&counter->trail, lit);
+}
+
+// Function to propagate the pending assignments through the clause
+// counts, assigning the last literal of clauses that become unit. Returns
+// false on a conflict; the counts then cover the trail up to
+// counter->propagated, which counter_undo() relies on.
+bool counter_propagate(ModelCounter *counter) {
+  const IndexedFormula *formula = counter->formula;
+  while (counter->propagated < counter->trail.count) {
+    int lit = counter->trail.items[counter->propagated++];
+    STAT_INC(propagations);
+    int index = lit_index(lit), negated = lit_index(-lit);
+    for (int i = counter->occurrence_start[index];
+         i < counter->occurrence_start[index + 1]; i++)
+      counter->true_count[counter->occurrences[i]]++;
+
+    bool conflict = false;
+    for (int i = counter->occurrence_start[negated];
+         i < counter->occurrence_start[negated + 1]; i++) {
+      int c = counter->occurrences[i];
+      int start = formula->clause_start[c];
+      int size = formula->clause_start[c + 1] - start;
+      if (++counter->false_count[c] < size - 1 || counter->true_count[c] > 0)
+        continue;
+      if (counter->false_count[c] == size) {
+        conflict = true;
+        continue;
+      }
+      for (int k = start; k < start + size; k++) {
+        if (counter_value(counter, formula->literals[k]) == 0) {
+          if (!counter_assign(counter, formula->literals[k]))
+            counter->out_of_memory = true;
+          break;
+        }
+      }
+    }
+    if (conflict || counter->out_of_memory)
+      return false;
+  }
+  return true;
+}
+
+// Function to undo the assignments past trail position mark
+void counter_undo(ModelCounter *counter, int mark) {
+  while (counter->trail.count > mark) {
+    int lit = counter->trail.items[--counter->trail.count];
+    if (counter->trail.count < counter->propagated) {
+      counter->propagated = counter->trail.count;
+      int index = lit_index(lit), negated = lit_index(-lit);
+      for (int i = counter->occurrence_start[index];
+           i < counter->occurrence_start[index + 1]; i++)
+        counter->true_count[counter->occurrences[i]]--;
+      for (int i = counter->occurrence_start[negated];
+           i < counter->occurrence_start[negated + 1]; i++)
+        counter->false_count[counter->occurrences[i]]--;
+    }
+    counter->values[lit_var(lit)] = 0;
+  }
+}
+
+// Function to get the length of the component stored at offset
+static inline int component_length(const ModelCounter *counter, int offset) {
+  const int *items = counter->components.items;
+  return items[offset] + 2 + items[offset + 1 + items[offset]];
+}
+
+// Function to push the components that the unsatisfied clauses of the
+// component at offset form under the current assignment, found by
+// breadth-first search over shared variables. Returns the number of that
+// component's variables left unassigned but in no unsatisfied clause, or
+// -1 when out of memory.
+int counter_split(ModelCounter *counter, int offset, int *component_count) {
+  const IndexedFormula *formula = counter->formula;
+  int stamp = ++counter->stamp;
+  int variable_count = counter->components.items[offset];
+  int clause_offset = offset + 1 + variable_count;
+  int clause_count = counter->components.items[clause_offset];
+  *component_count = 0;
+
+  for (int i = 0; i < clause_count; i++) {
+    int seed = counter->components.items[clause_offset + 1 + i];
+    if (counter->true_count[seed] > 0 || counter->clause_stamp[seed] == stamp)
+      continue;
+    counter->queue.count = 0;
+    counter->variables.count = 0;
+    counter->clause_stamp[seed] = stamp;
+    if (!int_array_push(&counter->queue, seed))
+      return -1;
+    for (int q = 0; q < counter->queue.count; q++) {
+      int c = counter->queue.items[q];
+      for (int k = formula->clause_start[c]; k < formula->clause_start[c + 1];
+           k++) {
+        int var = lit_var(formula->literals[k]);
+        if (counter->values[var] != 0 || counter->variable_stamp[var] == stamp)
+          continue;
+        counter->variable_stamp[var] = stamp;
+        if (!int_array_push(&counter->variables, var))
+          return -1;
+        for (int o = counter->occurrence_start[2 * var];
+             o < counter->occurrence_start[2 * var + 2]; o++) {
+          int other = counter->occurrences[o];
+          if (counter->true_count[other] > 0 ||
+              counter->clause_stamp[other] == stamp)
+            continue;
+          counter->clause_stamp[other] = stamp;
+          if (!int_array_push(&counter->queue, other))
+            return -1;
+        }
+      }
+    }
+
+    qsort(counter->variables.items, counter->variables.count, sizeof(int),
+          compare_ints);
+    qsort(counter->queue.items, counter->queue.count, sizeof(int),
+          compare_ints);
+    if (!int_array_push(&counter->components, counter->variables.count))
+      return -1;
+    for (int k = 0; k < counter->variables.count; k++)
+      if (!int_array_push(&counter->components, counter->variables.items[k]))
+        return -1;
+    if (!int_array_push(&counter->components, counter->queue.count))
+      return -1;
+    for (int k = 0; k < counter->queue.count; k++)
+      if (!int_array_push(&counter->components, counter->queue.items[k]))
+        return -1;
+    (*component_count)++;
+  }
+
+  int free_variables = 0;
+  for (int i = 0; i < variable_count; i++) {
+    int var = counter->components.items[offset + 1 + i];
+    if (counter->values[var] == 0 && counter->variable_stamp[var] != stamp)
+      free_variables++;
+  }
+  return free_variables;
+}
+
+bool count_component(ModelCounter *counter, int offset, BigNum *count);
+
+// Function to count the models, over its variables, that the component at
+// offset has under the current (propagated) assignment: two per free
+// variable times the product of the counts of the components it splits
+// into
+bool count_split(ModelCounter *counter, int offset, BigNum *count) {
+  int base = counter->components.count, children;
+  int free_variables = counter_split(counter, offset, &children);
+  bool ok = free_variables >= 0 && bignum_set(count, 1) &&
+            bignum_shift_left(count, free_variables);
+  BigNum factor = {0};
+  for (int k = 0, child = base; ok && k < children && count->count > 0; k++) {
+    ok = count_component(counter, child, &factor) &&
+         bignum_multiply(count, &factor);
+    child += component_length(counter, child);
+  }
+  free_bignum(&factor);
+  counter->components.count = base;
+  if (!ok)
+    counter->out_of_memory = true;
+  return ok;
+}
+
+// Function to count the models of the component at offset, from the cache
+// or by branching both ways on its most frequent variable
+bool count_component(ModelCounter *counter, int offset, BigNum *count) {
+  int length = component_length(counter, offset);
+  unsigned long long hash =
+      cache_hash(counter->components.items + offset, length);
+  CacheEntry *entry = cache_lookup(&counter->cache,
+                                   counter->components.items + offset, length,
+                                   hash);
+  if (entry) {
+    STAT_INC(cache_hits);
+    return bignum_copy(count, &entry->count);
+  }
+  STAT_INC(components);
+
+  // Branch on the variable with the most occurrences in the component
+  const IndexedFormula *formula = counter->formula;
+  const int *items = counter->components.items;
+  int variable_count = items[offset];
+  int clause_offset = offset + 1 + variable_count;
+  for (int i = 0; i < items[clause_offset]; i++) {
+    int c = items[clause_offset + 1 + i];
+    for (int k = formula->clause_start[c]; k < formula->clause_start[c + 1];
+         k++)
+      counter->score[lit_var(formula->literals[k])]++;
+  }
+  int best = items[offset + 1];
+  for (int i = 0; i < variable_count; i++) {
+    int var = items[offset + 1 + i];
+    if (counter->score[var] > counter->score[best])
+      best = var;
+  }
+  for (int i = 0; i < variable_count; i++)
+    counter->score[items[offset + 1 + i]] = 0;
+
+  BigNum branch = {0};
+  bool ok = bignum_set(count, 0);
+  for (int side = 0; side < 2 && ok; side++) {
+    int mark = counter->trail.count;
+    STAT_INC(decisions);
+    ok = counter_assign(counter, side == 0 ? best : -best);
+    if (ok && counter_propagate(counter))
+      ok = count_split(counter, offset, &branch) &&
+           bignum_add(count, &branch);
+    ok = ok && !counter->out_of_memory;
+    counter_undo(counter, mark);
+  }
+  free_bignum(&branch);
+
+  if (ok)
+    cache_store(&counter->cache, counter->components.items + offset, length,
+                hash, count);
+  else
+    counter->out_of_memory = true;
+  return ok;
+}
+
+// Function to count the models of a formula exactly over all of its
+// symbols, by DPLL with dynamic component decomposition and a component
+// cache of options->cache_mb megabytes. Formulas with soft clauses are
+// refused.
+bool count_models(PropositionalFormula *formula, const SolverOptions *options,
+                  BigNum *count) {
+  for (int i = 0; i < formula->clause_count; i++) {
+    if (formula->clauses[i].weight > 0) {
+      printf("Error: --count does not support soft clauses\n");
+      return false;
+    }
+  }
+
+  IndexedFormula indexed;
+  ModelCounter counter;
+  if (!build_indexed_formula(formula, &indexed))
+    return false;
+  g_stats.engine = "count";
+  g_stats.engine_reason = "requested";
+  bool ok = init_counter(&counter, &indexed,
+                         (size_t)options->cache_mb << 20) &&
+            bignum_set(count, 0);
+
+  // Unit clauses first; the whole formula is then the root component
+  bool consistent = true;
+  for (int c = 0; c < indexed.clause_count && ok && consistent; c++) {
+    int size = indexed.clause_start[c + 1] - indexed.clause_start[c];
+    int lit = indexed.literals[indexed.clause_start[c]];
+    if (size == 0 || (size == 1 && counter_value(&counter, lit) < 0))
+      consistent = false;
+    else if (size == 1 && counter_value(&counter, lit) == 0)
+      ok = counter_assign(&counter, lit);
+  }
+  consistent = consistent && counter_propagate(&counter);
+  ok = ok && !counter.out_of_memory &&
+       int_array_push(&counter.components, indexed.variable_count);
+  for (int v = 1; v <= indexed.variable_count && ok; v++)
+    ok = int_array_push(&counter.components, v);
+  ok = ok && int_array_push(&counter.components, indexed.clause_count);
+  for (int c = 0; c < indexed.clause_count && ok; c++)
+    ok = int_array_push(&counter.components, c);
+
+  TRACE_BEGIN("count");
+  if (ok && consistent)
+    ok = count_split(&counter, 0, count);
+  TRACE_END("count");
+
+  if (!ok)
+    printf("Error: Out of memory while counting models\n");
+  free_counter(&counter);
+  free_indexed_formula(&indexed);
+  return ok;
+}
+
+// All-solutions enumerator: one incremental CDCL solver whose models are
+// shrunk to partial assignments and then blocked. Clause ids below the
+// formula's clause count are input clauses, the others blocking clauses.
+typedef struct {
+  const IndexedFormula *formula;
+  CdclSolver solver;
+  const bool *projected; // by variable, NULL to enumerate over all of them
+  IntArray blocking;     // blocking clauses back to back
+  IntArray blocking_start;
+  IntArray *occurrences; // by lit_index(): ids of the clauses containing it
+  int *true_count;       // by clause id: kept literals satisfying it
+  int true_capacity;
+  bool *kept; // by variable: part of the shrunk model
+  IntArray cube;
+} Enumerator;
+
+// Function to free an enumerator
+void free_enumerator(Enumerator *e) {
+  if (e->occurrences)
+    for (int i = 0; i < 2 * e->formula->variable_count + 2; i++)
+      free_int_array(&e->occurrences[i]);
+  free(e->occurrences);
+  free(e->true_count);
+  free(e->kept);
+  free_int_array(&e->blocking);
+  free_int_array(&e->blocking_start);
+  free_int_array(&e->cube);
+  free_cdcl(&e->solver);
+}
+
+// Function to set up an enumerator over formula, projected onto the
+// variables marked in projected when it is not NULL
+bool init_enumerator(Enumerator *e, const IndexedFormula *formula,
+                     const bool *projected) {
+  memset(e, 0, sizeof(*e));
+  e->formula = formula;
+  e->projected = projected;
+  int vars = formula->variable_count;
+  e->occurrences = calloc(2 * vars + 2, sizeof(IntArray));
+  e->kept = calloc(vars + 1, sizeof(bool));
+  if (!e->occurrences || !e->kept || !int_array_push(&e->blocking_start, 0) ||
+      !cdcl_load(&e->solver, formula, NULL))
+    return false;
+  for (int c = 0; c < formula->clause_count; c++)
+    for (int i = formula->clause_start[c]; i < formula->clause_start[c + 1];
+         i++)
+      if (!int_array_push(&e->occurrences[lit_index(formula->literals[i])], c))
+        return false;
+  return true;
+}
+
+// Function to shrink the solver's model to a prime implicant of the input
+// and blocking clauses: its literals are dropped one at a time as long as
+// every clause keeps a true one. Literals outside the projection go first,
+// so the projected part left to block is as short as possible. Keeping the
+// blocking clauses satisfied makes the solutions pairwise disjoint.
+bool shrink_model(Enumerator *e) {
+  const bool *model = e->solver.model;
+  int vars = e->formula->variable_count;
+  int clauses = e->formula->clause_count + e->blocking_start.count - 1;
+  if (clauses > e->true_capacity) {
+    int capacity = clauses * EXPANSION_RATE;
+    int *true_count = realloc(e->true_count, capacity * sizeof(int));
+    if (!true_count)
+      return false;
+    e->true_count = true_count;
+    e->true_capacity = capacity;
+  }
+  // Only clauses with a true literal are ever looked at, so only theirs
+  // are counted, walking the occurrences of the true literals
+  for (int pass = 0; pass < 2; pass++) {
+    for (int v = 1; v <= vars; v++) {
+      const IntArray *occurrences = &e->occurrences[2 * v + !model[v]];
+      for (int i = 0; i < occurrences->count; i++)
+        e->true_count[occurrences->items[i]] =
+            pass == 0 ? 0 : e->true_count[occurrences->items[i]] + 1;
+    }
+  }
+
+  for (int v = 1; v <= vars; v++)
+    e->kept[v] = true;
+  for (int pass = 0; pass < (e->projected ? 2 : 1); pass++) {
+    for (int v = 1; v <= vars; v++) {
+      if (e->projected && e->projected[v] != (pass == 1))
+        continue;
+      int lit = model[v] ? v : -v;
+      const IntArray *occurrences = &e->occurrences[lit_index(lit)];
+      bool needed = false;
+      for (int i = 0; i < occurrences->count && !needed; i++)
+        needed = e->true_count[occurrences->items[i]] == 1;
+      if (needed)
+        continue;
+      e->kept[v] = false;
+      for (int i = 0; i < occurrences->count; i++)
+        e->true_count[occurrences->items[i]]--;
+    }
+  }
+  return true;
+}
+
+// Function to block the current cube: its negation becomes a clause of
+// the solver and of the enumerator's own clause set
+bool block_cube(Enumerator *e) {
+  int id = e->formula->clause_count + e->blocking_start.count - 1;
+  for (int i = 0; i < e->cube.count; i++) {
+    e->cube.items[i] = -e->cube.items[i];
+    if (!int_array_push(&e->blocking, e->cube.items[i]) ||
+        !int_array_push(&e->occurrences[lit_index(e->cube.items[i])], id))
+      return false;
+  }
+  if (!int_array_push(&e->blocking_start, e->blocking.count))
+    return false;
+  return cdcl_add_clause(&e->solver, e->cube.items, e->cube.count) ||
+         !e->solver.out_of_memory;
+}
+
+// Function to print one enumerated solution: the literals of the cube,
+// standing for every completion of its free symbols
+void print_solution(const PropositionalFormula *formula, const IntArray *cube,
+                    int free_symbols, unsigned long long index,
+                    ModelFormat format) {
+  if (format == MODEL_JSON) {
+    printf("{\"solution\":%llu,\"free\":%d,\"model\":{", index, free_symbols);
+    for (int i = 0; i < cube->count; i++)
+      printf("%s\"%s\":%s", i > 0 ? "," : "",
+             formula->symbols[lit_var(cube->items[i]) - 1].symbol,
+             cube->items[i] > 0 ? "true" : "false");
+    printf("}}\n");
+  } else if (format == MODEL_LINES) {
+    printf("Solution %llu", index);
+    if (free_symbols > 0)
+      printf(" (%d free symbol%s)", free_symbols, free_symbols > 1 ? "s" : "");
+    printf(":\n");
+    for (int i = 0; i < cube->count; i++) {
+      printf("%s%s%s", i % 16 == 0 ? "v " : " ", cube->items[i] > 0 ? "" : "!",
+             formula->symbols[lit_var(cube->items[i]) - 1].symbol);
+      if (i % 16 == 15 || i == cube->count - 1)
+        printf("\n");
+    }
+    if (cube->count == 0)
+      printf("v\n");
+  }
+  fflush(stdout);
+}
+
+// Function to mark the projection symbols named in list, separated by
+// commas; DIMACS numbers n stand for xn
+bool parse_projection(const PropositionalFormula *formula, const char *list,
+                      bool *projected) {
+  char name[MAX_SYMBOL_LEN];
+  while (*list) {
+    int length = (int)strcspn(list, ",");
+    if (length == 0 || length >= MAX_SYMBOL_LEN - 1) {
+      printf("Error: Invalid projection symbol list\n");
+      return false;
+    }
+    if (isdigit((unsigned char)list[0]))
+      snprintf(name, sizeof(name), "x%.*s", length, list);
+    else
+      snprintf(name, sizeof(name), "%.*s", length, list);
+    int var = find_symbol(formula, name) + 1;
+    if (var <= 0) {
+      printf("Error: Projection symbol %s is not in the formula\n", name);
+      return false;
+    }
+    projected[var] = true;
+    list += list[length] == ',' ? length + 1 : length;
+  }
+  return true;
+}
+
+// Function to enumerate the solutions of a formula in one incremental
+// solver session, streaming each as it is found. A solution is a model
+// shrunk to a partial assignment (projected onto options->project when
+// set) that covers 2^free assignments; the blocked solutions are disjoint,
+// so *assignments adds up to the exact number of models.
+bool enumerate_models(PropositionalFormula *formula,
+                      const SolverOptions *options,
+                      unsigned long long *solutions, BigNum *assignments) {
+  for (int i = 0; i < formula->clause_count; i++) {
+    if (formula->clauses[i].weight > 0) {
+      printf("Error: --all does not support soft clauses\n");
+      return false;
+    }
+  }
+
+  IndexedFormula indexed;
+  if (!build_indexed_formula(formula, &indexed))
+    return false;
+  g_stats.engine = "enumerate";
+  g_stats.engine_reason = "requested";
+  // Without --project the solutions are over the input's own symbols:
+  // definition variables are left to the solver
+  bool *projected = NULL;
+  bool defined = false;
+  for (int v = 1; v <= formula->symbol_count && !defined; v++)
+    defined = is_definition_symbol(formula->symbols[v - 1].symbol);
+  int scope = indexed.variable_count;
+  if (options->project || defined) {
+    projected = calloc(indexed.variable_count + 1, sizeof(bool));
+    for (int v = 1; projected && !options->project &&
+                    v <= formula->symbol_count;
+         v++)
+      projected[v] = !is_definition_symbol(formula->symbols[v - 1].symbol);
+    if (!projected || (options->project &&
+                       !parse_projection(formula, options->project,
+                                         projected))) {
+      free(projected);
+      free_indexed_formula(&indexed);
+      return false;
+    }
+    scope = 0;
+    for (int v = 1; v <= indexed.variable_count; v++)
+      scope += projected[v];
+  }
+
+  Enumerator e;
+  BigNum covered = {0};
+  bool checked = true;
+  bool ok = init_enumerator(&e, &indexed, projected) &&
+            bignum_set(assignments, 0);
+  *solutions = 0;
+  TRACE_BEGIN("enumerate");
+  while (ok) {
+    SolveResult result = cdcl_solve(&e.solver, NULL, 0);
+    if (result != RESULT_SAT) {
+      ok = result == RESULT_UNSAT;
+      break;
+    }
+    ok = shrink_model(&e);
+    // Never report a solution that does not satisfy the input
+    int falsified = ok ? verify_model(formula, e.solver.model, e.kept) : -1;
+    if (falsified >= 0) {
+      printf("Error: Solution check failed on clause %d\n", falsified + 1);
+      ok = checked = false;
+    }
+
+    e.cube.count = 0;
+    for (int v = 1; v <= indexed.variable_count && ok; v++)
+      if (e.kept[v] && (!projected || projected[v]))
+        ok = int_array_push(&e.cube, e.solver.model[v] ? v : -v);
+    if (!ok)
+      break;
+    (*solutions)++;
+    STAT_INC(solutions);
+    int free_symbols = scope - e.cube.count;
+    print_solution(formula, &e.cube, free_symbols, *solutions,
+                   options->model_format);
+    ok = bignum_set(&covered, 1) &&
+         bignum_shift_left(&covered, free_symbols) &&
+         bignum_add(assignments, &covered) && block_cube(&e);
+  }
+  TRACE_END("enumerate");
+
+  if (!ok && checked)
+    printf("Error: Out of memory while enumerating models\n");
+  free_bignum(&covered);
+  free_enumerator(&e);
+  free(projected);
+  free_indexed_formula(&indexed);
+  return ok;
+}
+
+// Backbone search: candidate literals, true in every model found so far,
+// and the local-search counts used to find models that flip them for free
+typedef struct {
+  CdclSolver solver;
+  LocalSearch flips;
+  IntArray candidates;
+  signed char *backbone; // by variable: 1 or -1 for backbone literals
+  int next_variable;     // last variable used, activation literals included
+  IntArray clause;
+} BackboneSearch;
+
+// Function to drop the candidates a new model refutes: those it makes
+// false, and those whose variable can be flipped without falsifying a
+// clause. Each free flip is applied, so the model stays a model and later
+// candidates are checked against it.
+void filter_candidates(BackboneSearch *search) {
+  LocalSearch *flips = &search->flips;
+  int vars = flips->formula->variable_count;
+  memcpy(flips->values, search->solver.model, (vars + 1) * sizeof(bool));
+  rebuild_counts(flips);
+
+  int kept = 0;
+  for (int i = 0; i < search->candidates.count; i++) {
+    int lit = search->candidates.items[i];
+    if (!literal_true(flips, lit))
+      continue;
+    if (flips->break_count[lit_var(lit)] == 0) {
+      flip_variable(flips, lit_var(lit));
+      continue;
+    }
+    search->candidates.items[kept++] = lit;
+  }
+  search->candidates.count = kept;
+}
+
+// Function to move candidates to the backbone: the ones the solver has
+// fixed at level 0, and then the last count ones, which a query proved
+bool confirm_candidates(BackboneSearch *search, int count) {
+  CdclSolver *s = &search->solver;
+  for (int i = search->candidates.count - count; i < search->candidates.count;
+       i++) {
+    int lit = search->candidates.items[i];
+    search->backbone[lit_var(lit)] = lit > 0 ? 1 : -1;
+    if (!cdcl_add_clause(s, &lit, 1) && s->out_of_memory)
+      return false;
+  }
+  search->candidates.count -= count;
+
+  int kept = 0;
+  for (int i = 0; i < search->candidates.count; i++) {
+    int lit = search->candidates.items[i];
+    if (s->values[lit_index(lit)] == 1)
+      search->backbone[lit_var(lit)] = lit > 0 ? 1 : -1;
+    else
+      search->candidates.items[kept++] = lit;
+  }
+  search->candidates.count = kept;
+  return true;
+}
+
+// Function to compute the backbone of a formula: the literals true in
+// every model, marked in backbone by variable. One incremental solver
+// answers every query. Each model filters the candidates; the rest are
+// tested in chunks by assuming a fresh literal a with the clause
+// (!a | !l1 | ... | !lk): a model refutes at least one of them, while
+// UNSAT proves all k, which are then added as units for later queries.
+// The chunk grows after a proof and shrinks after a refutation. Returns
+// the first model's result, with that model in model on RESULT_SAT.
+SolveResult compute_backbone(const IndexedFormula *formula, bool *model,
+                             signed char *backbone) {
+  BackboneSearch search;
+  memset(&search, 0, sizeof(search));
+  search.backbone = backbone;
+  search.next_variable = formula->variable_count;
+  CdclSolver *s = &search.solver;
+  if (!cdcl_load(s, formula, NULL) ||
+      !init_local_search(&search.flips, formula)) {
+    free_cdcl(s);
+    free_local_search(&search.flips);
+    return RESULT_UNKNOWN;
+  }
+
+  SolveResult result = cdcl_solve(s, NULL, 0);
+  STAT_INC(backbone_solves);
+  bool ok = result == RESULT_SAT;
+  if (ok)
+    memcpy(model, s->model, (formula->variable_count + 1) * sizeof(bool));
+  for (int v = 1; v <= formula->variable_count && ok; v++)
+    ok = int_array_push(&search.candidates, model[v] ? v : -v);
+  if (ok) {
+    filter_candidates(&search);
+    ok = confirm_candidates(&search, 0);
+  }
+
+  TRACE_BEGIN("backbone");
+  int chunk = BACKBONE_INITIAL_CHUNK;
+  while (ok && search.candidates.count > 0) {
+    int count =
+        chunk < search.candidates.count ? chunk : search.candidates.count;
+    const int *tested =
+        search.candidates.items + search.candidates.count - count;
+    int assumption = -tested[0];
+    if (count > 1) {
+      assumption = ++search.next_variable;
+      search.clause.count = 0;
+      ok = int_array_push(&search.clause, -assumption);
+      for (int i = 0; i < count && ok; i++)
+        ok = int_array_push(&search.clause, -tested[i]);
+      ok = ok && (cdcl_add_clause(s, search.clause.items, count + 1) ||
+                  !s->out_of_memory);
+    }
+    SolveResult query = ok ? cdcl_solve(s, &assumption, 1) : RESULT_UNKNOWN;
+    STAT_INC(backbone_solves);
+    if (query == RESULT_SAT) {
+      filter_candidates(&search);
+      chunk = chunk > 1 ? chunk / 2 : 1;
+    } else if (query == RESULT_UNSAT && s->failed.count > 0) {
+      chunk = chunk < BACKBONE_MAX_CHUNK ? chunk * 2 : BACKBONE_MAX_CHUNK;
+    } else {
+      ok = false;
+      break;
+    }
+    // The activation literal is never assumed again
+    if (count > 1) {
+      int retired = -assumption;
+      ok = cdcl_add_clause(s, &retired, 1) || !s->out_of_memory;
+    }
+    ok = ok && confirm_candidates(&search, query == RESULT_UNSAT ? count : 0);
+  }
+  TRACE_END("backbone");
+
+  if (result == RESULT_SAT && !ok)
+    result = RESULT_UNKNOWN;
+  free_int_array(&search.candidates);
+  free_int_array(&search.clause);
+  free_local_search(&search.flips);
+  free_cdcl(s);
+  return result;
+}
+
+// Function to find the backbone of the parsed formula, by variable in a
+// new *backbone array. Formulas with soft clauses are refused.
+SolveResult backbone_formula(PropositionalFormula *formula,
+                             signed char **backbone) {
+  *backbone = NULL;
+  for (int i = 0; i < formula->clause_count; i++) {
+    if (formula->clauses[i].weight > 0) {
+      printf("Error: --backbone does not support soft clauses\n");
+      return RESULT_UNKNOWN;
+    }
+  }
+
+  IndexedFormula indexed;
+  if (!build_indexed_formula(formula, &indexed))
+    return RESULT_UNKNOWN;
+  g_stats.engine = "backbone";
+  g_stats.engine_reason = "requested";
+  bool *model = calloc(indexed.variable_count + 1, sizeof(bool));
+  *backbone = calloc(indexed.variable_count + 1, 1);
+  SolveResult result = model && *backbone
+                           ? compute_backbone(&indexed, model, *backbone)
+                           : RESULT_UNKNOWN;
+  if (result == RESULT_UNKNOWN)
+    printf("Error: Out of memory while computing the backbone\n");
+  // The first model vouches for the backbone literals being consistent
+  if (result == RESULT_SAT && verify_model(formula, model, NULL) >= 0) {
+    printf("Error: Model check failed\n");
+    result = RESULT_UNKNOWN;
+  }
+  for (int v = 1; v <= indexed.variable_count && result == RESULT_SAT; v++)
+    g_stats.backbone_literals += (*backbone)[v] != 0;
+  free(model);
+  free_indexed_formula(&indexed);
+  return result;
+}
+
+// Function to print the backbone literals like a model: "v" lines, 16
+// literals per line, or a JSON object of the fixed symbols
+void print_backbone(const PropositionalFormula *formula,
+                    const signed char *backbone, ModelFormat format) {
+  int printed = 0;
+  if (format == MODEL_JSON)
+    printf("{\"backbone\":{");
+  for (int v = 1; v <= formula->symbol_count; v++) {
+    if (backbone[v] == 0 || format == MODEL_NONE)
+      continue;
+    if (format == MODEL_JSON)
+      printf("%s\"%s\":%s", printed > 0 ? "," : "",
+             formula->symbols[v - 1].symbol,
+             backbone[v] > 0 ? "true" : "false");
+    else
+      printf("%s%s%s%s", printed % 16 == 0 ? "v " : " ",
+             backbone[v] > 0 ? "" : "!", formula->symbols[v - 1].symbol,
+             printed % 16 == 15 ? "\n" : "");
+    printed++;
+  }
+  if (format == MODEL_JSON)
+    printf("}}\n");
+  else if (format == MODEL_LINES && printed % 16 != 0)
+    printf("\n");
+}
+
+// Function to give values to the definition variables a model leaves out,
+// which printed models never list: CDCL solves the formula under the
+// assigned symbols, and on success its values fill in the definitions.
+// Otherwise they stay unassigned and their clauses fail the check.
+bool complete_definitions(PropositionalFormula *formula, bool *model,
+                          bool *assigned) {
+  bool missing = false;
+  for (int v = 1; v <= formula->symbol_count && !missing; v++)
+    missing = !assigned[v] &&
+              is_definition_symbol(formula->symbols[v - 1].symbol);
+  if (!missing)
+    return true;
+
+  IndexedFormula indexed;
+  CdclSolver solver;
+  IntArray assumptions = {0};
+  if (!build_indexed_formula(formula, &indexed))
+    return false;
+  bool ok = cdcl_load(&solver, &indexed, NULL);
+  for (int v = 1; v <= formula->symbol_count && ok; v++)
+    if (assigned[v])
+      ok = int_array_push(&assumptions, model[v] ? v : -v);
+  if (ok && cdcl_solve(&solver, assumptions.items, assumptions.count) ==
+                RESULT_SAT) {
+    for (int v = 1; v <= formula->symbol_count; v++) {
+      if (!assigned[v] &&
+          is_definition_symbol(formula->symbols[v - 1].symbol)) {
+        model[v] = solver.model[v];
+        assigned[v] = true;
+      }
+    }
+  }
+  free_int_array(&assumptions);
+  free_cdcl(&solver);
+  free_indexed_formula(&indexed);
+  return ok;
+}
+
+// Function to check the model in a file against the formula and report the
+// outcome; every clause needs a literal made true by an assigned symbol,
+// definition variables left out of the file being filled in first
+bool check_model_file(PropositionalFormula *formula, const char *path) {
+  // The reader leaves symbol registration to the first indexing pass
+  for (int i = 0; i < formula->clause_count; i++)
+    for (int j = 0; j < formula->clauses[i].term_count; j++)
+      if (find_or_add_symbol(formula,
+                             formula->clauses[i].terms[j].symbol.symbol) < 0)
+        return false;
+
+  bool *model = calloc(formula->symbol_count + 1, sizeof(bool));
+  bool *assigned = calloc(formula->symbol_count + 1, sizeof(bool));
+  bool ok = model && assigned &&
+            read_model_file(path, formula, model, assigned) &&
+            complete_definitions(formula, model, assigned);
+  if (ok) {
+    int falsified = verify_model(formula, model, assigned);
+    ok = falsified < 0;
+    if (ok) {
+      set_display_color(SUCCESS_COLOR);
+      printf("\nModel check passed: all %d clauses are satisfied\n",
+             formula->clause_count);
+      bool weighted = false;
+      for (int i = 0; i < formula->clause_count && !weighted; i++)
+        weighted = formula->clauses[i].weight > 0;
+      if (weighted)
+        printf("Hard clauses only; falsified soft clause weight: %llu\n",
+               model_cost(formula, model, assigned));
+    } else {
+      set_display_color(ERROR_COLOR);
+      printf("\nModel check failed: clause %d is not satisfied\n",
+             falsified + 1);
+    }
+    set_display_color(DEFAULT_COLOR);
+  }
+  free(model);
+  free(assigned);
+  return ok;
+}
+
+// Function to cube a formula and write the cubes as iCNF for an external
+// or later conquer run. Sets *refuted_all when no cube survives, i.e. the
+// formula is unsatisfiable.
+bool write_cubes(PropositionalFormula *formula, const SolverOptions *options,
+                 bool *refuted_all) {
+  IndexedFormula indexed;
+  CubeSet cubes;
+  int refuted = 0;
+  *refuted_all = false;
+  if (!build_indexed_formula(formula, &indexed))
+    return false;
+  bool ok = init_cubes(&cubes) &&
+            make_cubes(&indexed, options->cube_target, &cubes, &refuted) &&
+            write_icnf(options->cube_path, formula, &indexed, &cubes);
+  if (ok) {
+    g_stats.cubes = cube_count(&cubes);
+    g_stats.cubes_refuted = refuted;
+    *refuted_all = cube_count(&cubes) == 0;
+    printf("\nWrote %d cubes (%d branches refuted) to %s\n",
+           cube_count(&cubes), refuted, options->cube_path);
+  }
+  free_cubes(&cubes);
+  free_indexed_formula(&indexed);
+  return ok;
+}
+
+// Coloured graph of a formula for symmetry detection. Literal v is node
+// 2(v - 1) and -v node 2(v - 1) + 1, clause c is node 2n + c. An edge joins
+// every literal to its negation and every clause to its literals, so an
+// automorphism maps clauses onto clauses and respects negation.
+typedef struct {
+  int vertex_count;
+  int literal_nodes;
+  int *start; // neighbours of u are neighbour[start[u] .. start[u + 1])
+  int *neighbour;
+} SymmetryGraph;
+
+// Ordered partition of the vertices: cells are ranges of element[] named
+// by their first position. Splits are logged to be undone in reverse order.
+typedef struct {
+  int *element;
+  int *position; // of each vertex in element
+  int *cell;     // first position of each vertex's cell
+  int *length;   // by first position: size of the cell
+  int cells;
+  IntArray splits; // first positions of the cells split off
+} SymmetryPartition;
+
+// Level of the search along a path compared with the first one
+typedef struct {
+  int level;
+  int mark;  // splits logged before branching at this level
+  int begin; // candidates of the level in search->candidates
+  int next;
+  int end;
+} SymmetryFrame;
+
+// Automorphism search: the first path individualizes the first vertex of
+// the first non-singleton cell down to a discrete partition, and every
+// other path is matched with it cell by cell
+typedef struct {
+  const SymmetryGraph *graph;
+  SymmetryPartition left;  // the first path
+  SymmetryPartition right; // the path compared with it
+  int *count;              // neighbours in the splitter, during refinement
+  int *touched_count;      // by first position: vertices moved to the back
+  bool *queued;            // by first position
+  unsigned long long *keys;
+  IntArray queue, touched, touched_cells;
+  IntArray target; // by level: first position of the cell branched on
+  IntArray chosen; // by level: vertex the first path individualizes
+  IntArray marks;  // by level: splits of the first path before branching
+  IntArray traces; // by level: hash of the refinement after branching
+  IntArray candidates;
+  SymmetryFrame *frames;
+  int *leaf;  // element order at the end of the first path
+  int *image; // permutation at a leaf of another path
+  int *orbit;  // union-find over the generators found
+  int *failed; // by orbit root: level + 1 of a fruitless search from it
+  int *stamp;
+  int stamp_value;
+  long long budget; // edge visits left
+  bool out_of_memory;
+  IntArray generators; // per generator: support size, then variable and
+                       // image literal pairs by increasing variable
+  int generator_count;
+} SymmetrySearch;
+
+// Function to get the graph node of a literal
+static inline int symmetry_node(int lit) {
+  return 2 * (lit_var(lit) - 1) + (lit < 0);
+}
+
+// Function to build the coloured graph of a formula
+bool build_symmetry_graph(const IndexedFormula *formula, SymmetryGraph *g) {
+  int literals = 2 * formula->variable_count;
+  int total = formula->clause_start[formula->clause_count];
+  g->literal_nodes = literals;
+  g->vertex_count = literals + formula->clause_count;
+  g->start = calloc(g->vertex_count + 1, sizeof(int));
+  g->neighbour = malloc(((size_t)literals + 2 * (size_t)total + 1) *
+                        sizeof(int));
+  int *next = malloc((g->vertex_count + 1) * sizeof(int));
+  if (!g->start || !g->neighbour || !next) {
+    free(g->start);
+    free(g->neighbour);
+    free(next);
+    return false;
+  }
+
+  for (int u = 0; u < literals; u++)
+    g->start[u + 1] = 1;
+  for (int c = 0; c < formula->clause_count; c++) {
+    for (int i = formula->clause_start[c]; i < formula->clause_start[c + 1];
+         i++)
+      g->start[symmetry_node(formula->literals[i]) + 1]++;
+    g->start[literals + c + 1] =
+        formula->clause_start[c + 1] - formula->clause_start[c];
+  }
+  for (int u = 0; u < g->vertex_count; u++)
+    g->start[u + 1] += g->start[u];
+  memcpy(next, g->start, g->vertex_count * sizeof(int));
+
+  for (int u = 0; u < literals; u++)
+    g->neighbour[next[u]++] = u ^ 1;
+  for (int c = 0; c < formula->clause_count; c++) {
+    for (int i = formula->clause_start[c]; i < formula->clause_start[c + 1];
+         i++) {
+      int u = symmetry_node(formula->literals[i]);
+      g->neighbour[next[u]++] = literals + c;
+      g->neighbour[next[literals + c]++] = u;
+    }
+  }
+  free(next);
+  return true;
+}
+
+// Function to free a symmetry graph
+void free_symmetry_graph(SymmetryGraph *g) {
+  free(g->start);
+  free(g->neighbour);
+}
+
+// Function to allocate a partition of n vertices
+bool init_partition(SymmetryPartition *p, int n) {
+  memset(p, 0, sizeof(*p));
+  p->element = malloc(n * sizeof(int));
+  p->position = malloc(n * sizeof(int));
+  p->cell = malloc(n * sizeof(int));
+  p->length = malloc(n * sizeof(int));
+  return p->element && p->position && p->cell && p->length;
+}
+
+// Function to free a partition
+void free_partition(SymmetryPartition *p) {
+  free(p->element);
+  free(p->position);
+  free(p->cell);
+  free(p->length);
+  free_int_array(&p->splits);
+}
+
+// Function to copy a partition, without its log of splits
+void copy_partition(SymmetryPartition *dest, const SymmetryPartition *src,
+                    int n) {
+  memcpy(dest->element, src->element, n * sizeof(int));
+  memcpy(dest->position, src->position, n * sizeof(int));
+  memcpy(dest->cell, src->cell, n * sizeof(int));
+  memcpy(dest->length, src->length, n * sizeof(int));
+  dest->cells = src->cells;
+  dest->splits.count = 0;
+}
+
+// Function to exchange two positions of a partition
+static inline void partition_swap(SymmetryPartition *p, int i, int j) {
+  int u = p->element[i], w = p->element[j];
+  p->element[i] = w;
+  p->element[j] = u;
+  p->position[w] = i;
+  p->position[u] = j;
+}
+
+// Function to undo the splits logged after mark
+void partition_undo(SymmetryPartition *p, int mark) {
+  while (p->splits.count > mark) {
+    int first = p->splits.items[--p->splits.count];
+    int parent = p->cell[p->element[first - 1]];
+    p->length[parent] += p->length[first];
+    for (int i = first; i < first + p->length[first]; i++)
+      p->cell[p->element[i]] = parent;
+    p->cells--;
+  }
+}
+
+// Function to queue a cell as a splitter
+static inline bool symmetry_queue(SymmetrySearch *search, int first) {
+  search->queued[first] = true;
+  return int_array_push(&search->queue, first);
+}
+
+// Function to make positions first .. first + size - 1, the back of the
+// cell starting at parent, a cell of their own
+bool partition_split(SymmetryPartition *p, int parent, int first, int size) {
+  p->length[parent] = first - parent;
+  p->length[first] = size;
+  for (int i = first; i < first + size; i++)
+    p->cell[p->element[i]] = first;
+  p->cells++;
+  return int_array_push(&p->splits, first);
+}
+
+// Function to split off a vertex as a cell of its own and queue it
+bool partition_individualize(SymmetrySearch *search, SymmetryPartition *p,
+                             int v) {
+  int parent = p->cell[v], last = parent + p->length[parent] - 1;
+  partition_swap(p, p->position[v], last);
+  return partition_split(p, parent, last, 1) && symmetry_queue(search, last);
+}
+
+// Function to split a cell whose touched vertices sit at its back by their
+// neighbour counts, untouched vertices first, folding the outcome into
+// hash. The new cells are queued: all of them if the cell was queued, else
+// all but the largest (Hopcroft's rule). Returns false when out of memory.
+bool partition_split_cell(SymmetrySearch *search, SymmetryPartition *p,
+                          int first, unsigned int *hash) {
+  int end = first + p->length[first];
+  int back = end - search->touched_count[first];
+  search->touched_count[first] = 0;
+  for (int i = back; i < end; i++)
+    search->keys[i - back] =
+        (unsigned long long)search->count[p->element[i]] << 32 |
+        (unsigned)p->element[i];
+  qsort(search->keys, end - back, sizeof(*search->keys), compare_sort_keys);
+  for (int i = back; i < end; i++)
+    partition_swap(p, p->position[(int)(search->keys[i - back] & 0xFFFFFFFF)],
+                   i);
+
+  int parent = first, largest = first, largest_size = 0;
+  for (int start = first, i = first + 1; i <= end; i++) {
+    if (i < end && i != back &&
+        (i < back ||
+         search->count[p->element[i]] == search->count[p->element[i - 1]]))
+      continue;
+    int size = i - start;
+    *hash = (*hash ^ (unsigned)start) * 16777619u;
+    *hash = (*hash ^ (unsigned)size) * 16777619u;
+    *hash = (*hash ^ (unsigned)search->count[p->element[start]]) * 16777619u;
+    if (start > first) {
+      if (!partition_split(p, parent, start, size))
+        return false;
+      parent = start;
+    }
+    if (size > largest_size) {
+      largest = start;
+      largest_size = size;
+    }
+    start = i;
+  }
+  if (parent == first)
+    return true; // not split
+
+  bool queued = search->queued[first];
+  for (int f = first; f < end; f += p->length[f]) {
+    if ((f != first || !queued) && (queued || f != largest) &&
+        !search->queued[f] && !symmetry_queue(search, f))
+      return false;
+  }
+  return true;
+}
+
+// Function to refine a partition until it is equitable: every vertex of a
+// cell has the same number of neighbours in each cell. The splits are
+// made in an order that depends only on the cells' positions and counts,
+// so isomorphic partitions refine alike; the returned hash of the splits
+// tells apart paths that do not.
+unsigned int partition_refine(SymmetrySearch *search, SymmetryPartition *p) {
+  const SymmetryGraph *g = search->graph;
+  unsigned int hash = 2166136261u;
+  for (int head = 0; head < search->queue.count; head++) {
+    int splitter = search->queue.items[head];
+    search->queued[splitter] = false;
+    if (search->budget <= 0 || search->out_of_memory)
+      continue;
+
+    search->touched.count = 0;
+    search->touched_cells.count = 0;
+    for (int i = splitter; i < splitter + p->length[splitter]; i++) {
+      int u = p->element[i];
+      search->budget -= g->start[u + 1] - g->start[u] + 1;
+      for (int e = g->start[u]; e < g->start[u + 1]; e++) {
+        int w = g->neighbour[e];
+        if (search->count[w]++ == 0 &&
+            !int_array_push(&search->touched, w))
+          search->out_of_memory = true;
+      }
+    }
+    // The touched vertices move to the back of their cells, the splitter's
+    // own included, once it has been read
+    for (int k = 0; k < search->touched.count; k++) {
+      int w = search->touched.items[k], first = p->cell[w];
+      if (search->touched_count[first] == 0 &&
+          !int_array_push(&search->touched_cells, first))
+        search->out_of_memory = true;
+      partition_swap(p, p->position[w],
+                     first + p->length[first] - 1 -
+                         search->touched_count[first]++);
+    }
+
+    qsort(search->touched_cells.items, search->touched_cells.count,
+          sizeof(int), compare_ints);
+    for (int k = 0; k < search->touched_cells.count; k++) {
+      int first = search->touched_cells.items[k];
+      if (p->length[first] == 1) {
+        search->touched_count[first] = 0;
+        hash = (hash ^ (unsigned)first) * 16777619u;
+      } else if (!partition_split_cell(search, p, first, &hash)) {
+        search->out_of_memory = true;
+      }
+    }
+    for (int k = 0; k < search->touched.count; k++)
+      search->count[search->touched.items[k]] = 0;
+  }
+  search->queue.count = 0;
+  return hash ^ (unsigned)p->cells;
+}
+
+// Function to free an automorphism search
+void free_symmetry_search(SymmetrySearch *search) {
+  free_partition(&search->left);
+  free_partition(&search->right);
+  free(search->count);
+  free(search->touched_count);
+  free(search->queued);
+  free(search->keys);
+  free_int_array(&search->queue);
+  free_int_array(&search->touched);
+  free_int_array(&search->touched_cells);
+  free_int_array(&search->target);
+  free_int_array(&search->chosen);
+  free_int_array(&search->marks);
+  free_int_array(&search->traces);
+  free_int_array(&search->candidates);
+  free(search->frames);
+  free(search->leaf);
+  free(search->image);
+  free(search->orbit);
+  free(search->failed);
+  free(search->stamp);
+  free_int_array(&search->generators);
+}
+
+// Function to set up a search over a graph, its first partition putting
+// the literals before the clauses
+bool init_symmetry_search(SymmetrySearch *search, const SymmetryGraph *g) {
+  int n = g->vertex_count;
+  memset(search, 0, sizeof(*search));
+  search->graph = g;
+  search->budget = SYMMETRY_BUDGET;
+  search->count = calloc(n, sizeof(int));
+  search->touched_count = calloc(n, sizeof(int));
+  search->queued = calloc(n, sizeof(bool));
+  search->keys = malloc(n * sizeof(*search->keys));
+  search->leaf = malloc(n * sizeof(int));
+  search->image = malloc(n * sizeof(int));
+  search->orbit = malloc(n * sizeof(int));
+  search->failed = calloc(n, sizeof(int));
+  search->stamp = calloc(n, sizeof(int));
+  if (!init_partition(&search->left, n) ||
+      !init_partition(&search->right, n) || !search->count ||
+      !search->touched_count || !search->queued || !search->keys ||
+      !search->leaf || !search->image || !search->orbit || !search->failed ||
+      !search->stamp)
+    return false;
+
+  SymmetryPartition *p = &search->left;
+  for (int u = 0; u < n; u++) {
+    p->element[u] = p->position[u] = search->orbit[u] = u;
+    p->cell[u] = u < g->literal_nodes ? 0 : g->literal_nodes;
+  }
+  p->length[0] = g->literal_nodes;
+  p->cells = 1;
+  if (n > g->literal_nodes) {
+    p->length[g->literal_nodes] = n - g->literal_nodes;
+    p->cells = 2;
+  }
+  return true;
+}
+
+// Function to check whether the leaf of the compared path, matched with
+// the first path's position by position, gives an automorphism
+bool symmetry_leaf(SymmetrySearch *search) {
+  const SymmetryGraph *g = search->graph;
+  for (int i = 0; i < g->vertex_count; i++)
+    search->image[search->leaf[i]] = search->right.element[i];
+  for (int u = 0; u < g->vertex_count; u++) {
+    int v = search->image[u];
+    if (g->start[v + 1] - g->start[v] != g->start[u + 1] - g->start[u])
+      return false;
+    search->stamp_value++;
+    search->budget -= 2 * (g->start[u + 1] - g->start[u]);
+    for (int e = g->start[v]; e < g->start[v + 1]; e++)
+      search->stamp[g->neighbour[e]] = search->stamp_value;
+    for (int e = g->start[u]; e < g->start[u + 1]; e++) {
+      if (search->stamp[search->image[g->neighbour[e]]] != search->stamp_value)
+        return false;
+    }
+  }
+  return true;
+}
+
+// Function to look for an automorphism taking the first path's vertex at
+// level to w. The compared path follows the first path's cells down to a
+// discrete partition, trying first the vertex the first path took, and
+// backtracks where the refinements differ.
+bool symmetry_descend(SymmetrySearch *search, int level, int w) {
+  SymmetryPartition *right = &search->right;
+  int depth = search->target.count, top = 0;
+  int base = search->candidates.count;
+  if (!int_array_push(&search->candidates, w)) {
+    search->out_of_memory = true;
+    return false;
+  }
+  SymmetryFrame first = {level, right->splits.count, base, base, base + 1};
+  search->frames[0] = first;
+
+  while (top >= 0 && search->budget > 0 && !search->out_of_memory) {
+    SymmetryFrame *f = &search->frames[top];
+    if (f->next == f->end) {
+      search->candidates.count = f->begin;
+      top--;
+      continue;
+    }
+    int u = search->candidates.items[f->next++];
+    partition_undo(right, f->mark);
+    if (!partition_individualize(search, right, u)) {
+      search->out_of_memory = true;
+      break;
+    }
+    if (partition_refine(search, right) !=
+        (unsigned)search->traces.items[f->level])
+      continue;
+    if (f->level + 1 == depth) {
+      if (symmetry_leaf(search)) {
+        search->candidates.count = base;
+        return true;
+      }
+      continue;
+    }
+
+    int target = search->target.items[f->level + 1];
+    int chosen = search->chosen.items[f->level + 1];
+    int begin = search->candidates.count;
+    bool ok = right->cell[chosen] != target ||
+              int_array_push(&search->candidates, chosen);
+    for (int i = target; i < target + right->length[target] && ok; i++) {
+      if (right->element[i] != chosen)
+        ok = int_array_push(&search->candidates, right->element[i]);
+    }
+    search->out_of_memory = !ok;
+    SymmetryFrame next = {f->level + 1, right->splits.count, begin, begin,
+                          search->candidates.count};
+    search->frames[++top] = next;
+  }
+  search->candidates.count = base;
+  return false;
+}
+
+// Function to record the literal permutation of the automorphism in image
+// and merge the orbits it joins
+bool symmetry_record(SymmetrySearch *search) {
+  const SymmetryGraph *g = search->graph;
+  for (int u = 0; u < g->vertex_count; u++) {
+    int a = find_root(search->orbit, u);
+    int b = find_root(search->orbit, search->image[u]);
+    if (a != b)
+      search->orbit[a > b ? a : b] = a < b ? a : b;
+  }
+
+  int header = search->generators.count, support = 0;
+  if (!int_array_push(&search->generators, 0))
+    return false;
+  for (int u = 0; u < g->literal_nodes; u += 2) {
+    int v = search->image[u];
+    if (v == u)
+      continue;
+    support++;
+    if (!int_array_push(&search->generators, u / 2 + 1) ||
+        !int_array_push(&search->generators, v & 1 ? -(v / 2 + 1) : v / 2 + 1))
+      return false;
+  }
+  search->generators.items[header] = support;
+  if (support == 0)
+    search->generators.count = header; // only clauses moved
+  else
+    search->generator_count++;
+  return true;
+}
+
+// Function to find generators of a formula's symmetry group, in the manner
+// of nauty: the first path from the root to a leaf is searched once, then
+// from its deepest level up every other vertex of the cell branched on is
+// tried, skipping those already in the branch vertex's orbit under the
+// generators found so far. Each candidate permutation is checked on the
+// graph, so a search cut short by SYMMETRY_BUDGET finds fewer generators
+// but never a wrong one.
+bool find_symmetries(SymmetrySearch *search) {
+  SymmetryPartition *left = &search->left;
+  int n = search->graph->vertex_count;
+  bool ok = symmetry_queue(search, 0) &&
+            (left->cells == 1 || symmetry_queue(search, left->length[0]));
+  partition_refine(search, left);
+
+  for (int first = 0; ok && left->cells < n && search->budget > 0;) {
+    while (left->length[first] == 1)
+      first++;
+    ok = int_array_push(&search->target, first) &&
+         int_array_push(&search->chosen, left->element[first]) &&
+         int_array_push(&search->marks, left->splits.count) &&
+         partition_individualize(search, left, left->element[first]) &&
+         int_array_push(&search->traces, (int)partition_refine(search, left));
+  }
+  int depth = search->target.count;
+  if (!ok || search->out_of_memory || search->budget <= 0 || depth == 0)
+    return ok && !search->out_of_memory;
+  memcpy(search->leaf, left->element, n * sizeof(int));
+  if (!(search->frames = malloc((depth + 1) * sizeof(SymmetryFrame))))
+    return false;
+
+  for (int level = depth - 1; level >= 0 && search->budget > 0; level--) {
+    partition_undo(left, search->marks.items[level]);
+    copy_partition(&search->right, left, n);
+    int target = search->target.items[level];
+    int chosen = search->chosen.items[level];
+    for (int i = target; i < target + left->length[target]; i++) {
+      int w = left->element[i];
+      int root = find_root(search->orbit, w);
+      if (root == find_root(search->orbit, chosen) ||
+          search->failed[root] == level + 1)
+        continue;
+      if (symmetry_descend(search, level, w)) {
+        if (!symmetry_record(search))
+          return false;
+      } else {
+        search->failed[root] = level + 1;
+      }
+      partition_undo(&search->right, 0);
+      if (search->out_of_memory ||
+          search->generator_count >= SYMMETRY_MAX_GENERATORS)
+        return !search->out_of_memory;
+    }
+  }
+  return true;
+}
+
+// Function to append a clause of up to three literals, zeros left out, as
+// a [size, literals...] record
+bool symmetry_clause(IntArray *clauses, int a, int b, int c) {
+  int lits[3] = {a, b, c}, size = (a != 0) + (b != 0) + (c != 0);
+  bool ok = int_array_push(clauses, size);
+  for (int i = 0; i < 3 && ok; i++)
+    ok = lits[i] == 0 || int_array_push(clauses, lits[i]);
+  return ok;
+}
+
+// Function to add the lex-leader constraint of a generator over its first
+// SYMMETRY_BREAK_LENGTH moved variables: the assignment, read in variable
+// order with false before true, is no greater than its image. Fresh
+// variable e_j is forced when the first j moved variables equal their
+// images; leaving it false otherwise only weakens the constraint.
+bool lex_leader(IntArray *clauses, const int *pairs, int support,
+                int *variables) {
+  int length = support < SYMMETRY_BREAK_LENGTH ? support
+                                               : SYMMETRY_BREAK_LENGTH;
+  int equal = 0; // e_j of the prefix before this variable, 0 when empty
+  for (int j = 0; j < length; j++) {
+    int y = pairs[2 * j], z = pairs[2 * j + 1];
+    if (z == -y) // y <= !y: y is false, and the prefix cannot go on equal
+      return symmetry_clause(clauses, -equal, -y, 0);
+    if (!symmetry_clause(clauses, -equal, -y, z))
+      return false;
+    if (j + 1 == length)
+      break;
+    int next = ++*variables;
+    if (!symmetry_clause(clauses, -equal, -y, next) ||
+        !symmetry_clause(clauses, -equal, z, next))
+      return false;
+    equal = next;
+  }
+  return true;
+}
+
+// Function to break the symmetries of a formula: the lex-leader
+// constraints of the generators find_symmetries() returns are appended as
+// clauses over fresh variables numbered after the formula's own. Every
+// orbit of assignments keeps its least member, so satisfiability is
+// unchanged while the symmetric copies of each search subtree are gone.
+// Returns false when out of memory.
+bool break_symmetries(IndexedFormula *formula) {
+  SymmetryGraph graph;
+  SymmetrySearch search;
+  if (formula->variable_count == 0)
+    return true;
+  if (!build_symmetry_graph(formula, &graph))
+    return false;
+  bool ok = init_symmetry_search(&search, &graph) && find_symmetries(&search);
+
+  IntArray clauses = {0};
+  int variables = formula->variable_count, added = 0, total = 0;
+  for (int i = 0; ok && i < search.generators.count;) {
+    int support = search.generators.items[i];
+    ok = lex_leader(&clauses, search.generators.items + i + 1, support,
+                    &variables);
+    i += 1 + 2 * support;
+  }
+  for (int i = 0; ok && i < clauses.count; i += 1 + clauses.items[i]) {
+    added++;
+    total += clauses.items[i];
+  }
+
+  int old_total = formula->clause_start[formula->clause_count];
+  int *literals = ok ? realloc(formula->literals,
+                               (old_total + total + 1) * sizeof(int))
+                     : NULL;
+  if (literals)
+    formula->literals = literals;
+  int *start = literals ? realloc(formula->clause_start,
+                                  (formula->clause_count + added + 1) *
+                                      sizeof(int))
+                        : NULL;
+  if (start) {
+    formula->clause_start = start;
+    int count = old_total, c = formula->clause_count;
+    for (int i = 0; i < clauses.count; i += 1 + clauses.items[i]) {
+      start[c++] = count;
+      for (int k = 1; k <= clauses.items[i]; k++)
+        literals[count++] = clauses.items[i + k];
+    }
+    start[c] = count;
+    formula->clause_count = c;
+    formula->variable_count = variables;
+    g_stats.symmetry_generators = search.generator_count;
+    g_stats.symmetry_clauses = added;
+  }
+
+  free_int_array(&clauses);
+  free_symmetry_search(&search);
+  free_symmetry_graph(&graph);
+  return start != NULL;
+}
+
+// Function to build a formula from the clauses of an indexed one that
+// only use the symbols of names, for the engines that read named clauses.
+// The symbols keep their positions in names.
+bool formula_from_indexed(const PropositionalFormula *names,
+                          const IndexedFormula *indexed,
+                          PropositionalFormula *formula) {
+  PropositionClause clause;
+  if (!init_formula(formula))
+    return false;
+  if (!init_clause(&clause)) {
+    free_formula(formula);
+    return false;
+  }
+  bool ok = true;
+  for (int i = 0; ok && i < names->symbol_count; i++)
+    ok = find_or_add_symbol(formula, names->symbols[i].symbol) == i;
+  for (int c = 0; ok && c < indexed->clause_count; c++) {
+    clause.term_count = 0;
+    bool named = true;
+    for (int i = indexed->clause_start[c];
+         ok && named && i < indexed->clause_start[c + 1]; i++) {
+      int lit = indexed->literals[i];
+      named = lit_var(lit) <= names->symbol_count;
+      ok = !named ||
+           add_term(&clause, names->symbols[lit_var(lit) - 1].symbol, lit < 0);
+    }
+    ok = ok && (!named || add_clause(formula, &clause));
+  }
+  free_clause(&clause);
+  if (!ok)
+    free_formula(formula);
+  return ok;
+}
+
+// Function to run the requested engine, or the one select_engine() picks
+// for ENGINE_AUTO. Cubes read with the formula are conquered directly, and
+// formulas made of several variable-disjoint components are split and
+// solved in parallel, unless a refutation proof is requested. On RESULT_SAT
+// *model holds the assignment indexed by symbol position + 1, whatever the
+// engine. When core is not NULL (one entry per clause, all false) and
+// options->core_mode asks for one, an UNSAT answer marks a core in it.
+// Formulas with soft clauses go to maxsat(), whatever the options.
+SolveResult solve_formula(PropositionalFormula *formula,
+                          const SolverOptions *options, const CubeSet *cubes,
+                          bool **model, bool *core) {
+  IndexedFormula indexed;
+  FormulaFeatures features;
+  *model = NULL;
+  if (!build_indexed_formula(formula, &indexed))
+    return RESULT_UNKNOWN;
+  if (!extract_features(&indexed, &features) ||
+      !(*model = calloc(indexed.variable_count + 1, sizeof(bool)))) {
+    free_indexed_formula(&indexed);
+    return RESULT_UNKNOWN;
+  }
+
+  g_stats.clause_variable_ratio = features.clause_variable_ratio;
+  g_stats.binary_fraction = features.binary_fraction;
+  g_stats.mean_degree = features.mean_degree;
+  g_stats.max_degree = features.max_degree;
+  g_stats.pure_literals = features.pure_literals;
+
+  // Soft clauses turn the question into weighted partial MaxSAT
+  unsigned long long *weights = malloc((indexed.clause_count + 1) *
+                                       sizeof(unsigned long long));
+  g_stats.soft_clauses = 0;
+  for (int c = 0; weights && c < indexed.clause_count; c++) {
+    weights[c] = formula->clauses[c].weight;
+    g_stats.soft_clauses += weights[c] > 0;
+  }
+  if (!weights || g_stats.soft_clauses > 0) {
+    SolveResult result = RESULT_UNKNOWN;
+    if (weights) {
+      g_stats.engine = "maxsat";
+      g_stats.engine_reason = "soft clauses";
+      result = maxsat(&indexed, weights, options, *model);
+    }
+    free(weights);
+    free_indexed_formula(&indexed);
+    return result;
+  }
+  free(weights);
+
+  // Symmetric copies of each part of the search space are cut off up
+  // front; the variables this adds are never printed
+  if (options->symmetry) {
+    TRACE_BEGIN("symmetry");
+    bool broken = break_symmetries(&indexed);
+    TRACE_END("symmetry");
+    bool *grown = broken ? realloc(*model, (indexed.variable_count + 1) *
+                                               sizeof(bool))
+                         : NULL;
+    if (!grown) {
+      free(*model);
+      *model = NULL;
+      free_indexed_formula(&indexed);
+      return RESULT_UNKNOWN;
+    }
+    *model = grown;
+    memset(grown, 0, (indexed.variable_count + 1) * sizeof(bool));
+  }
+
+  EngineChoice choice = {options->engine, false, "requested"};
+  if (options->engine == ENGINE_AUTO)
+    choice = select_engine(&features);
+  if (options->checkpoint_path) {
+    choice.engine = ENGINE_RESOLUTION;
+    choice.fallback = false;
+    choice.reason = "checkpoints save the saturation state";
+  }
+
+  // A proof needs one complete engine working on the whole formula
+  ProofWriter proof, *proving = NULL;
+  int *number = NULL;
+  if (options->proof_path) {
+    if (choice.engine != ENGINE_RESOLUTION && choice.engine != ENGINE_CDCL) {
+      choice.engine = ENGINE_CDCL;
+      choice.fallback = false;
+      choice.reason = "proof logging needs a complete engine";
+    }
+    if (!(number = external_numbers(formula, NULL)) ||
+        !open_proof(&proof, options->proof_path, options->proof_format,
+                    number)) {
+      free(number);
+      free(*model);
+      *model = NULL;
+      free_indexed_formula(&indexed);
+      return RESULT_UNKNOWN;
+    }
+    proving = &proof;
+  }
+  // Cores come from resolution's parents or from CDCL's assumptions
+  if (options->core_mode == CORE_NONE)
+    core = NULL;
+  if (core && choice.engine != ENGINE_RESOLUTION) {
+    choice.engine = ENGINE_CDCL;
+    choice.reason = "core extraction tracks clauses through assumptions";
+  }
+  g_stats.engine = engine_name(choice.engine);
+  g_stats.engine_reason = choice.reason;
+
+  SolveResult result = RESULT_UNKNOWN;
+  ComponentSet components = {0};
+  if (core && choice.engine == ENGINE_CDCL) {
+    result = core_solve(&indexed, options->core_mode, *model, core);
+  } else if (!proving && !options->checkpoint_path && cubes &&
+             cube_count(cubes) > 0) {
+    g_stats.engine = engine_name(ENGINE_CUBES);
+    g_stats.engine_reason = "cubes given with the formula";
+    g_stats.cubes = cube_count(cubes);
+    // Cubes from a file may leave part of the search space out
+    bool covering = cubes_cover(&indexed, cubes);
+    result = conquer_cubes(&indexed, cubes, covering, options, *model);
+    if (result == RESULT_UNKNOWN && !covering)
+      g_stats.unknown_reason =
+          "all given cubes refuted, but they do not cover the search space";
+  } else if (choice.engine == ENGINE_CUBES) {
+    CubeSet own;
+    int refuted;
+    if (init_cubes(&own) &&
+        make_cubes(&indexed, options->cube_target, &own, &refuted)) {
+      g_stats.cubes = cube_count(&own);
+      g_stats.cubes_refuted = refuted;
+      result = cube_count(&own) > 0
+                   ? conquer_cubes(&indexed, &own, true, options, *model)
+                   : RESULT_UNSAT;
+    }
+    free_cubes(&own);
+  } else if (choice.engine == ENGINE_RESOLUTION) {
+    // The model is read off the saturated clauses. Of the
+    // symmetry-breaking clauses saturation only gets those without fresh
+    // variables, as resolving through the chains of the others costs more
+    // than the symmetric copies they remove.
+    PropositionalFormula broken;
+    CheckpointWriter checkpoint, *saving = NULL;
+    if (options->checkpoint_path &&
+        open_checkpoint(&checkpoint, options->checkpoint_path,
+                        options->checkpoint_interval, options->resume))
+      saving = &checkpoint;
+    if (options->checkpoint_path && !saving) {
+      printf("Error: Out of memory while preparing checkpoints\n");
+    } else if (g_stats.symmetry_clauses == 0) {
+      result = resolution(formula, proving, core, saving, *model);
+    } else if (formula_from_indexed(formula, &indexed, &broken)) {
+      result = resolution(&broken, NULL, NULL, saving, *model);
+      free_formula(&broken);
+    }
+    if (saving && !close_checkpoint(saving))
+      printf("Error: Unable to write checkpoint %s\n",
+             options->checkpoint_path);
+    if (saving && saving->refused)
+      result = RESULT_ERROR;
+    bool marked = false;
+    for (int c = 0; core && c < formula->clause_count && !marked; c++)
+      marked = core[c];
+    // The saturation core seeds minimization, or is rebuilt if lost
+    if (core && result == RESULT_UNSAT &&
+        (options->core_mode == CORE_MINIMAL || !marked))
+      result = core_solve(&indexed, options->core_mode, *model, core);
+    else if (marked)
+      for (int c = 0; c < formula->clause_count; c++)
+        g_stats.core_clauses += core[c];
+  } else if (!proving && split_components(&indexed, &components) &&
+             components.count > 1) {
+    // Each component picks its own engine under --engine=auto
+    g_stats.components = components.count;
+    g_stats.engine = engine_name(options->engine);
+    g_stats.engine_reason = "independent components solved in parallel";
+    result = solve_components(&indexed, &components, options, *model);
+    free_components(&components);
+  } else {
+    free_components(&components);
+    g_stats.components = 1;
+    bool fell_back;
+    result = run_engine(&indexed, choice, options, *model, NULL, proving,
+                        &fell_back);
+    if (fell_back)
+      g_stats.engine = "probsat+cdcl";
+  }
+
+  if (proving && !close_proof(proving)) {
+    printf("Error: Unable to write proof file %s\n", options->proof_path);
+    result = RESULT_UNKNOWN;
+  }
+  free(number);
+
+  free_indexed_formula(&indexed);
+  return result;
+}
+
+// Function to store a parsed clause, dropping tautologies
+bool store_clause(PropositionalFormula *formula, PropositionClause *clause) {
+  STAT_INC(clauses_read);
+  if (clause->term_count > 0 && is_tautology(clause)) {
+    STAT_INC(preprocess_removed);
+  } else if (clause->term_count > 0) {
+    if (!add_clause(formula, clause)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Function to check if a line starts with the "h" marker of a hard clause;
+// only meaningful once the file is known to be DIMACS, as native lines may
+// start with a symbol named h
+bool is_hard_marker(const char *line) {
+  return line[0] == 'h' && (line[1] == ' ' || line[1] == '\t');
+}
+
+// Function to check if a line is a DIMACS clause: signed integers, the
+// last of them 0
+bool is_dimacs_clause(const char *line) {
+  const char *last = NULL;
+  for (const char *p = line; *p;) {
+    if (isspace((unsigned char)*p)) {
+      p++;
+      continue;
+    }
+    last = p;
+    if (*p == '-')
+      p++;
+    if (!isdigit((unsigned char)*p))
+      return false;
+    while (isdigit((unsigned char)*p))
+      p++;
+    if (*p && !isspace((unsigned char)*p))
+      return false;
+  }
+  return last && last[0] == '0' && (last[1] == '\0' || isspace(last[1]));
+}
+
+// Function to check if a line opens a DIMACS file: a "p cnf", "p wcnf" or
+// "p inccnf" header, or a clause ("1 -2 0", or "h 1 -2 0" and "3 1 -2 0" in
+// the header-less WCNF format), which native lines never match
+bool is_dimacs_header(const char *line) {
+  return strncmp(line, "p cnf", 5) == 0 || strncmp(line, "p wcnf", 6) == 0 ||
+         strncmp(line, "p inccnf", 8) == 0 ||
+         (is_hard_marker(line) && is_dimacs_clause(line + 1)) ||
+         is_dimacs_clause(line);
+}
+
+// Function to tell whether a file whose first line is line is in DIMACS.
+// A leading "c" line is only a comment when a DIMACS header or clause comes
+// after the "c" lines: in the native format it is a clause on a symbol
+// named c. The file is rewound to where it was.
+bool is_dimacs_file(FILE *file, const char *line) {
+  long start = ftell(file);
+  char next[MAX_BUFFER];
+  bool dimacs = is_dimacs_header(line);
+  bool comment = line[0] == 'c' && (line[1] == '\0' || isspace(line[1]));
+  while (!dimacs && comment && fgets(next, sizeof(next), file)) {
+    char *end = next + strlen(next) - 1;
+    while (end >= next && isspace(*end))
+      *end-- = '\0';
+    if (next[0] == '\0' || next[0] == '#')
+      continue;
+    dimacs = is_dimacs_header(next);
+    comment = next[0] == 'c' && (next[1] == '\0' || isspace(next[1]));
+  }
+  fseek(file, start, SEEK_SET);
+  return dimacs;
+}
+
+// Function to tell whether a DIMACS file is weighted in the header-less
+// WCNF format, where hard clauses start with "h" and the others with their
+// weight: looks for an "h" line before any "p" line, then rewinds
+bool has_hard_markers(FILE *file) {
+  long start = ftell(file);
+  char line[MAX_BUFFER];
+  bool found = false;
+  while (!found && fgets(line, sizeof(line), file) && line[0] != 'p')
+    found = is_hard_marker(line);
+  fseek(file, start, SEEK_SET);
+  return found;
+}
+
+// Function to read a clause weight, a non-negative integer
+bool parse_weight(const char *token, unsigned long long *weight) {
+  char *rest;
+  if (!isdigit((unsigned char)token[0]))
+    return false;
+  *weight = strtoull(token, &rest, 10);
+  return *rest == '\0';
+}
+
+// Function to map a DIMACS cube line ("a <literals> 0") to signed symbol
+// positions, registering the xn symbols
+bool read_cube_line(char *line, PropositionalFormula *formula,
+                    CubeSet *cubes) {
+  for (char *token = strtok(line + 1, " \t"); token;
+       token = strtok(NULL, " \t")) {
+    char *rest;
+    long value = strtol(token, &rest, 10);
+    if (*rest != '\0')
+      return false;
+    if (value == 0)
+      break;
+    char symbol_name[MAX_SYMBOL_LEN];
+    snprintf(symbol_name, sizeof(symbol_name), "x%ld",
+             value < 0 ? -value : value);
+    int var = find_or_add_symbol(formula, symbol_name) + 1;
+    if (var <= 0 || !int_array_push(&cubes->literals, value < 0 ? -var : var))
+      return false;
+  }
+  return int_array_push(&cubes->start, cubes->literals.count);
+}
+
+// General formulas: a native line with connectives (¬ ∧ ∨ → ↔, or their
+// ASCII forms) is parsed into a DAG of hash-consed nodes, so a subformula
+// written several times is a single node; implications become disjunctions.
+// The DAG is clausified by Plaisted-Greenbaum encoding: each gate gets one
+// definition variable, and only the halves of its definition that the
+// polarities it occurs in need.
+typedef enum { EXPR_VAR, EXPR_NOT, EXPR_AND, EXPR_OR, EXPR_IFF } ExprKind;
+
+typedef enum {
+  EXPR_TOKEN_END,
+  EXPR_TOKEN_SYMBOL,
+  EXPR_TOKEN_NOT,
+  EXPR_TOKEN_AND,
+  EXPR_TOKEN_OR,
+  EXPR_TOKEN_IMPLIES,
+  EXPR_TOKEN_IFF,
+  EXPR_TOKEN_OPEN,
+  EXPR_TOKEN_CLOSE,
+  EXPR_TOKEN_INVALID
+} ExprToken;
+
+// Spellings of the connectives, longest first where one is a prefix
+typedef struct {
+  const char *text;
+  ExprToken token;
+} ExprConnective;
+
+static const ExprConnective expr_connectives[] = {
+    {"<->", EXPR_TOKEN_IFF},       {"<=>", EXPR_TOKEN_IFF},
+    {"\xE2\x86\x94", EXPR_TOKEN_IFF}, {"->", EXPR_TOKEN_IMPLIES},
+    {"=>", EXPR_TOKEN_IMPLIES},    {"\xE2\x86\x92", EXPR_TOKEN_IMPLIES},
+    {"&&", EXPR_TOKEN_AND},        {"&", EXPR_TOKEN_AND},
+    {"\xE2\x88\xA7", EXPR_TOKEN_AND}, {"||", EXPR_TOKEN_OR},
+    {"|", EXPR_TOKEN_OR},          {"\xE2\x88\xA8", EXPR_TOKEN_OR},
+    {"!", EXPR_TOKEN_NOT},         {"~", EXPR_TOKEN_NOT},
+    {"\xC2\xAC", EXPR_TOKEN_NOT},  {"(", EXPR_TOKEN_OPEN},
+    {")", EXPR_TOKEN_CLOSE}};
+
+#define EXPR_CONNECTIVE_COUNT                                                  \
+  ((int)(sizeof(expr_connectives) / sizeof(expr_connectives[0])))
+
+typedef struct {
+  ExprKind kind;
+  int a, b;    // operand nodes; a is the symbol position of an EXPR_VAR
+  int next;    // next node in the same hash bucket, -1 at the end
+  int parents; // nodes using this one as an operand
+  int literal; // signed symbol number of the definition, 0 until made
+  int encoded; // EXPR_POSITIVE and EXPR_NEGATIVE halves already emitted
+} ExprNode;
+
+typedef struct {
+  PropositionalFormula *formula;
+  ExprNode *nodes;
+  int count;
+  int capacity;
+  int *buckets; // 2 * capacity chains of nodes, -1 = empty
+  IntArray operands; // operands of the gates being encoded, as a stack
+  IntArray pending;  // nodes still to flatten
+  PropositionClause clause;
+  bool clause_ready;
+  int definitions;
+  bool exact; // both halves of every definition, whatever the polarity
+  char *text; // formula read so far, which may span several lines
+  size_t text_length;
+  size_t text_capacity;
+  const char *at;       // parser position
+  const char *error;    // first parse error, NULL when none
+  const char *error_at; // where it was found
+} ExprBuilder;
+
+// Function to free a builder; a zeroed one holds nothing
+void free_expr_builder(ExprBuilder *b) {
+  free(b->nodes);
+  free(b->buckets);
+  free(b->text);
+  free_int_array(&b->operands);
+  free_int_array(&b->pending);
+  if (b->clause_ready)
+    free_clause(&b->clause);
+  memset(b, 0, sizeof(*b));
+}
+
+// Function to hash a node by its kind and operands
+unsigned int expr_hash(ExprKind kind, int a, int b) {
+  return (unsigned int)kind * 0x9E3779B1u ^ (unsigned int)a * 0x85EBCA77u ^
+         (unsigned int)b * 0xC2B2AE3Du;
+}
+
+// Function to double the node table and rebuild the hash chains
+bool expr_grow(ExprBuilder *b) {
+  int capacity = b->capacity ? b->capacity * EXPANSION_RATE
+                             : EXPR_INITIAL_NODES;
+  ExprNode *nodes = realloc(b->nodes, capacity * sizeof(ExprNode));
+  if (!nodes)
+    return false;
+  b->nodes = nodes;
+  int *buckets = malloc(2 * capacity * sizeof(int));
+  if (!buckets)
+    return false;
+  free(b->buckets);
+  b->buckets = buckets;
+  b->capacity = capacity;
+  memset(buckets, -1, 2 * capacity * sizeof(int));
+  for (int i = 0; i < b->count; i++) {
+    unsigned int slot =
+        expr_hash(nodes[i].kind, nodes[i].a, nodes[i].b) & (2 * capacity - 1);
+    nodes[i].next = buckets[slot];
+    buckets[slot] = i;
+  }
+  return true;
+}
+
+// Function to get the node for kind(a, b), making it unless an equal node
+// exists. Operands of commutative connectives are ordered, double negations
+// cancel and x & x, x | x are x. Returns -1 when out of memory.
+int expr_node(ExprBuilder *b, ExprKind kind, int a, int operand_b) {
+  if (kind == EXPR_NOT && b->nodes[a].kind == EXPR_NOT)
+    return b->nodes[a].a;
+  if ((kind == EXPR_AND || kind == EXPR_OR) && a == operand_b)
+    return a;
+  if (kind != EXPR_VAR && kind != EXPR_NOT && a > operand_b) {
+    int swap = a;
+    a = operand_b;
+    operand_b = swap;
+  }
+
+  if (b->capacity > 0) {
+    unsigned int slot =
+        expr_hash(kind, a, operand_b) & (unsigned int)(2 * b->capacity - 1);
+    for (int i = b->buckets[slot]; i >= 0; i = b->nodes[i].next) {
+      if (b->nodes[i].kind == kind && b->nodes[i].a == a &&
+          b->nodes[i].b == operand_b)
+        return i;
+    }
+  }
+  if (b->count == b->capacity && !expr_grow(b))
+    return -1;
+
+  unsigned int slot =
+      expr_hash(kind, a, operand_b) & (unsigned int)(2 * b->capacity - 1);
+  ExprNode *node = &b->nodes[b->count];
+  node->kind = kind;
+  node->a = a;
+  node->b = operand_b;
+  node->next = b->buckets[slot];
+  node->parents = 0;
+  node->literal = 0;
+  node->encoded = 0;
+  b->buckets[slot] = b->count;
+  if (kind != EXPR_VAR) {
+    b->nodes[a].parents++;
+    if (kind != EXPR_NOT)
+      b->nodes[operand_b].parents++;
+  }
+  STAT_INC(expression_nodes);
+  return b->count++;
+}
+
+// Function to recognise the token text starts with, setting *length to
+// its size in bytes
+ExprToken expr_token(const char *text, int *length) {
+  *length = 0;
+  if (*text == '\0')
+    return EXPR_TOKEN_END;
+  if (isalpha((unsigned char)*text) || *text == '_') {
+    while (isalnum((unsigned char)text[*length]) || text[*length] == '_')
+      (*length)++;
+    return EXPR_TOKEN_SYMBOL;
+  }
+  for (int i = 0; i < EXPR_CONNECTIVE_COUNT; i++) {
+    size_t size = strlen(expr_connectives[i].text);
+    if (strncmp(text, expr_connectives[i].text, size) == 0) {
+      *length = (int)size;
+      return expr_connectives[i].token;
+    }
+  }
+  return EXPR_TOKEN_INVALID;
+}
+
+// Function to skip blanks and look at the next token
+ExprToken expr_peek(ExprBuilder *b, int *length) {
+  while (*b->at == ' ' || *b->at == '\t')
+    b->at++;
+  return expr_token(b->at, length);
+}
+
+// Function to record a parse error at the current position; returns -1
+int expr_fail(ExprBuilder *b, const char *message) {
+  if (!b->error) {
+    b->error = message;
+    b->error_at = b->at;
+  }
+  return -1;
+}
+
+int expr_parse_iff(ExprBuilder *b);
+
+// Function to parse a symbol, a negation or a parenthesised formula
+int expr_parse_unary(ExprBuilder *b) {
+  int length;
+  ExprToken token = expr_peek(b, &length);
+  if (token == EXPR_TOKEN_NOT) {
+    b->at += length;
+    int operand = expr_parse_unary(b);
+    return operand < 0 ? -1 : expr_node(b, EXPR_NOT, operand, -1);
+  }
+  if (token == EXPR_TOKEN_OPEN) {
+    b->at += length;
+    int inner = expr_parse_iff(b);
+    if (inner < 0)
+      return -1;
+    if (expr_peek(b, &length) != EXPR_TOKEN_CLOSE)
+      return expr_fail(b, "expected \")\"");
+    b->at += length;
+    return inner;
+  }
+  if (token != EXPR_TOKEN_SYMBOL)
+    return expr_fail(b, "expected a symbol, a negation or \"(\"");
+
+  // Long names are cut to MAX_SYMBOL_LEN - 1, as in clause lines
+  char name[MAX_SYMBOL_LEN];
+  int size = length < MAX_SYMBOL_LEN ? length : MAX_SYMBOL_LEN - 1;
+  memcpy(name, b->at, size);
+  name[size] = '\0';
+  b->at += length;
+  int position = find_or_add_symbol(b->formula, name);
+  return position < 0 ? -1 : expr_node(b, EXPR_VAR, position, -1);
+}
+
+// Function to parse a conjunction (left-associative)
+int expr_parse_and(ExprBuilder *b) {
+  int left = expr_parse_unary(b), length;
+  while (left >= 0 && expr_peek(b, &length) == EXPR_TOKEN_AND) {
+    b->at += length;
+    int right = expr_parse_unary(b);
+    left = right < 0 ? -1 : expr_node(b, EXPR_AND, left, right);
+  }
+  return left;
+}
+
+// Function to parse a disjunction (left-associative)
+int expr_parse_or(ExprBuilder *b) {
+  int left = expr_parse_and(b), length;
+  while (left >= 0 && expr_peek(b, &length) == EXPR_TOKEN_OR) {
+    b->at += length;
+    int right = expr_parse_and(b);
+    left = right < 0 ? -1 : expr_node(b, EXPR_OR, left, right);
+  }
+  return left;
+}
+
+// Function to parse an implication (right-associative), stored as the
+// disjunction !left | right
+int expr_parse_implies(ExprBuilder *b) {
+  int left = expr_parse_or(b), length;
+  if (left < 0 || expr_peek(b, &length) != EXPR_TOKEN_IMPLIES)
+    return left;
+  b->at += length;
+  int right = expr_parse_implies(b);
+  if (right < 0)
+    return -1;
+  int negated = expr_node(b, EXPR_NOT, left, -1);
+  return negated < 0 ? -1 : expr_node(b, EXPR_OR, negated, right);
+}
+
+// Function to parse an equivalence (left-associative), the loosest
+// connective
+int expr_parse_iff(ExprBuilder *b) {
+  int left = expr_parse_implies(b), length;
+  while (left >= 0 && expr_peek(b, &length) == EXPR_TOKEN_IFF) {
+    b->at += length;
+    int right = expr_parse_implies(b);
+    left = right < 0 ? -1 : expr_node(b, EXPR_IFF, left, right);
+  }
+  return left;
+}
+
+// Function to push the operands of an n-ary gate onto b->operands: nested
+// nodes of the same kind are merged into it when no other node uses them,
+// or always when shared is set (at the top of a constraint)
+bool expr_gather(ExprBuilder *b, int node, bool shared) {
+  ExprKind kind = b->nodes[node].kind;
+  b->pending.count = 0;
+  if (!int_array_push(&b->pending, node))
+    return false;
+  while (b->pending.count > 0) {
+    int n = b->pending.items[--b->pending.count];
+    const ExprNode *e = &b->nodes[n];
+    if (n == node || (e->kind == kind && (shared || e->parents == 1))) {
+      if (!int_array_push(&b->pending, e->b) ||
+          !int_array_push(&b->pending, e->a))
+        return false;
+    } else if (!int_array_push(&b->operands, n)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Function to add a clause over signed symbol numbers to the formula
+bool expr_emit(ExprBuilder *b, const int *lits, int count,
+               unsigned long long weight) {
+  if (!b->clause_ready) {
+    if (!init_clause(&b->clause))
+      return false;
+    b->clause_ready = true;
+  }
+  b->clause.term_count = 0;
+  b->clause.weight = weight;
+  for (int i = 0; i < count; i++) {
+    int var = lits[i] > 0 ? lits[i] : -lits[i];
+    if (!add_term(&b->clause, b->formula->symbols[var - 1].symbol,
+                  lits[i] < 0))
+      return false;
+  }
+  return store_clause(b->formula, &b->clause);
+}
+
+// Function to add a two- or three-literal clause
+bool expr_emit3(ExprBuilder *b, int x, int y, int z) {
+  int lits[3] = {x, y, z};
+  return expr_emit(b, lits, z ? 3 : 2, 0);
+}
+
+// Function to make a fresh definition variable, as a symbol number; 0 when
+// out of memory
+int expr_definition(ExprBuilder *b) {
+  char name[MAX_SYMBOL_LEN];
+  snprintf(name, sizeof(name), EXPR_DEFINITION_FORMAT, ++b->definitions);
+  int position = find_or_add_symbol(b->formula, name);
+  if (position < 0)
+    return 0;
+  STAT_INC(definitions);
+  return position + 1;
+}
+
+// Function to get the literal (a signed symbol number) standing for a
+// node, first emitting the halves of its definition that polarity asks for
+// and that are not there yet: x -> gate for EXPR_POSITIVE, gate -> x for
+// EXPR_NEGATIVE. With b->exact both halves are always emitted, so every
+// definition is a function of the input symbols. Returns 0 when out of
+// memory.
+int expr_encode(ExprBuilder *b, int node, int polarity) {
+  if (b->exact)
+    polarity = EXPR_POSITIVE | EXPR_NEGATIVE;
+  ExprNode *e = &b->nodes[node];
+  if (e->kind == EXPR_VAR)
+    return e->a + 1;
+  if (e->kind == EXPR_NOT) {
+    int flipped = (polarity & EXPR_POSITIVE ? EXPR_NEGATIVE : 0) |
+                  (polarity & EXPR_NEGATIVE ? EXPR_POSITIVE : 0);
+    return -expr_encode(b, e->a, flipped);
+  }
+
+  if (e->literal == 0 && (e->literal = expr_definition(b)) == 0)
+    return 0;
+  int x = e->literal;
+  int missing = polarity & ~e->encoded;
+  if (missing == 0)
+    return x;
+  e->encoded |= missing;
+
+  if (e->kind == EXPR_IFF) {
+    int a = expr_encode(b, e->a, EXPR_POSITIVE | EXPR_NEGATIVE);
+    int c = a ? expr_encode(b, b->nodes[node].b,
+                            EXPR_POSITIVE | EXPR_NEGATIVE)
+              : 0;
+    if (!c)
+      return 0;
+    if (missing & EXPR_POSITIVE &&
+        (!expr_emit3(b, -x, -a, c) || !expr_emit3(b, -x, a, -c)))
+      return 0;
+    if (missing & EXPR_NEGATIVE &&
+        (!expr_emit3(b, x, a, c) || !expr_emit3(b, x, -a, -c)))
+      return 0;
+    return x;
+  }
+
+  // Conjunctions and disjunctions: the operands' literals replace them on
+  // the stack, where the definition clauses are then built
+  bool conjunction = e->kind == EXPR_AND;
+  int start = b->operands.count;
+  if (!expr_gather(b, node, false))
+    return 0;
+  int end = b->operands.count;
+  for (int i = start; i < end; i++) {
+    int lit = expr_encode(b, b->operands.items[i], missing);
+    if (!lit)
+      return 0;
+    b->operands.items[i] = lit;
+  }
+
+  // x -> AND(l) gives binary clauses, x -> OR(l) one long clause, and the
+  // other half the other way round
+  bool ok = true;
+  int *lits = b->operands.items + start;
+  int count = end - start;
+  if (missing & (conjunction ? EXPR_POSITIVE : EXPR_NEGATIVE)) {
+    int sign = conjunction ? 1 : -1;
+    for (int i = 0; i < count && ok; i++)
+      ok = expr_emit3(b, -sign * x, sign * lits[i], 0);
+  }
+  if (ok && missing & (conjunction ? EXPR_NEGATIVE : EXPR_POSITIVE)) {
+    int sign = conjunction ? -1 : 1;
+    for (int i = 0; i < count; i++)
+      lits[i] *= sign;
+    ok = int_array_push(&b->operands, -sign * x) &&
+         expr_emit(b, b->operands.items + start, count + 1, 0);
+  }
+  b->operands.count = start;
+  return ok ? x : 0;
+}
+
+// Function to add a node (negated unless positive) as a constraint, hard
+// when weight is 0. Hard conjunctions are split into their operands, and
+// disjunctions and hard equivalences become clauses over their operands'
+// literals, so the top of a formula needs no definition; a soft
+// conjunction is the unit clause of its definition.
+bool expr_assert(ExprBuilder *b, int node, bool positive,
+                 unsigned long long weight) {
+  const ExprNode *e = &b->nodes[node];
+  int polarity = positive ? EXPR_POSITIVE : EXPR_NEGATIVE;
+  if (e->kind == EXPR_NOT)
+    return expr_assert(b, e->a, !positive, weight);
+  if (e->kind == EXPR_IFF && weight == 0) {
+    int a = expr_encode(b, e->a, EXPR_POSITIVE | EXPR_NEGATIVE);
+    int c = a ? expr_encode(b, b->nodes[node].b,
+                            EXPR_POSITIVE | EXPR_NEGATIVE)
+              : 0;
+    if (!positive)
+      c = -c;
+    return c && expr_emit3(b, -a, c, 0) && expr_emit3(b, a, -c, 0);
+  }
+  bool conjunction = (e->kind == EXPR_AND) == positive;
+  if (e->kind == EXPR_VAR || e->kind == EXPR_IFF ||
+      (conjunction && weight > 0)) {
+    int lit = expr_encode(b, node, polarity);
+    if (!positive)
+      lit = -lit;
+    return lit && expr_emit(b, &lit, 1, weight);
+  }
+
+  int start = b->operands.count;
+  if (!expr_gather(b, node, true))
+    return false;
+  int end = b->operands.count;
+  bool ok = true;
+  for (int i = start; i < end && ok; i++) {
+    if (conjunction) {
+      ok = expr_assert(b, b->operands.items[i], positive, 0);
+    } else {
+      int lit = expr_encode(b, b->operands.items[i], polarity);
+      b->operands.items[i] = positive ? lit : -lit;
+      ok = lit != 0;
+    }
+  }
+  if (ok && !conjunction)
+    ok = expr_emit(b, b->operands.items + start, end - start, weight);
+  b->operands.count = start;
+  return ok;
+}
+
+// Function to tell whether a native line holds a general formula: one with
+// a connective besides "!", or a parenthesis. Bytes outside ASCII count
+// too, so that ¬ ∧ ∨ → ↔ are seen and anything else reaches the parser.
+bool is_expression_line(const char *line) {
+  for (; *line; line++)
+    if (strchr("&|~()<>=", *line) || (unsigned char)*line >= 0x80)
+      return true;
+  return false;
+}
+
+// Function to append a line to the formula being read
+bool expr_append(ExprBuilder *b, const char *line) {
+  size_t size = strlen(line);
+  if (b->text_length + size + 2 > b->text_capacity) {
+    size_t capacity = b->text_capacity ? b->text_capacity : MAX_BUFFER;
+    while (b->text_length + size + 2 > capacity)
+      capacity *= EXPANSION_RATE;
+    char *text = realloc(b->text, capacity);
+    if (!text)
+      return false;
+    b->text = text;
+    b->text_capacity = capacity;
+  }
+  if (b->text_length > 0)
+    b->text[b->text_length++] = ' ';
+  memcpy(b->text + b->text_length, line, size + 1);
+  b->text_length += size;
+  return true;
+}
+
+// Function to tell whether the formula read so far goes on over the next
+// line: a parenthesis is still open, or it ends with a connective
+bool expression_continues(const ExprBuilder *b) {
+  int depth = 0;
+  for (size_t i = 0; i < b->text_length; i++)
+    depth += b->text[i] == '(' ? 1 : b->text[i] == ')' ? -1 : 0;
+  if (depth > 0)
+    return true;
+  for (int i = 0; i < EXPR_CONNECTIVE_COUNT; i++) {
+    size_t size = strlen(expr_connectives[i].text);
+    if (expr_connectives[i].token != EXPR_TOKEN_CLOSE &&
+        b->text_length >= size &&
+        strcmp(b->text + b->text_length - size, expr_connectives[i].text) ==
+            0)
+      return true;
+  }
+  return false;
+}
+
+// Function to parse the formula read so far and add its clauses. A leading
+// number makes it a soft constraint of that weight, as for clause lines.
+bool add_expression(ExprBuilder *b, PropositionalFormula *formula,
+                    int line_num) {
+  b->formula = formula;
+  b->error = NULL;
+  b->at = b->text;
+  b->text_length = 0;
+  unsigned long long weight = 0;
+  bool soft = isdigit((unsigned char)*b->at);
+  if (soft) {
+    char *rest;
+    weight = strtoull(b->at, &rest, 10);
+    b->at = rest;
+    if (*rest != ' ' && *rest != '\t')
+      expr_fail(b, "expected a space after the weight");
+  }
+
+  int length;
+  int root = b->error ? -1 : expr_parse_iff(b);
+  if (root >= 0 && expr_peek(b, &length) != EXPR_TOKEN_END)
+    root = expr_fail(b, "expected a connective");
+  if (b->error) {
+    if (*b->error_at)
+      printf("Error: Line %d: %s at \"%.20s\"\n", line_num, b->error,
+             b->error_at);
+    else
+      printf("Error: Line %d: %s at the end of the formula\n", line_num,
+             b->error);
+    return false;
+  }
+  if (root < 0)
+    return false;
+  // A soft constraint of weight 0 costs nothing and is dropped
+  return (soft && weight == 0) || expr_assert(b, root, true, weight);
+}
+
+// Cardinality constraints bound how many of their literals are true. A
+// counter turns the literals into unary outputs o1, o2, ...: its up clauses
+// make k true literals force o1..ok, its down clauses make ok hold only with
+// k true literals. An upper bound k then forbids ok+1 and a lower bound k
+// asserts ok. Only the outputs a bound looks at are built, and the
+// definitions are hard even for a soft constraint, whose bound clauses carry
+// the relax literal instead. Output 0 stands for false. An exact counter
+// writes both directions whatever its bounds, so that every output is a
+// function of the literals and model counts are not multiplied.
+typedef struct {
+  ExprBuilder *b;
+  bool up;    // an upper bound is enforced
+  bool down;  // a lower bound is enforced
+  bool exact; // both up and down clauses are written
+  int relax;  // literal added to the bound clauses, 0 when hard
+} CardinalityCounter;
+
+// Function to add a clause over the nonzero ones of up to three literals
+bool card_clause(ExprBuilder *b, int x, int y, int z) {
+  int lits[3], count = 0;
+  if (x)
+    lits[count++] = x;
+  if (y)
+    lits[count++] = y;
+  if (z)
+    lits[count++] = z;
+  return expr_emit(b, lits, count, 0);
+}
+
+// Function to count with a sequential counter (Sinz): register j after
+// input i holds "at least j of the first i literals". With an upper bound
+// the top register is never built: clauses refuse the literal that would
+// set it, and the last registers are only built for a lower bound.
+bool card_sequential(CardinalityCounter *c, const int *lits, int n, int limit,
+                     int *outputs) {
+  int *prev = calloc(limit + 1, sizeof(int));
+  int *cur = calloc(limit + 1, sizeof(int));
+  bool ok = prev && cur;
+  for (int i = 0; i < n && ok; i++) {
+    int x = lits[i];
+    int top = i + 1 < limit ? i + 1 : limit;
+    for (int j = 1; j <= top && ok; j++) {
+      cur[j] = 0;
+      if (c->up && j == limit) {
+        if (j == 1 || prev[j - 1])
+          ok = card_clause(c->b, -x, j > 1 ? -prev[j - 1] : 0, c->relax);
+        continue;
+      }
+      if (i == 0) {
+        cur[j] = x;
+        continue;
+      }
+      if (i == n - 1 && !c->down)
+        continue;
+      int s = expr_definition(c->b);
+      cur[j] = s;
+      ok = s != 0;
+      if (ok && (c->up || c->exact)) {
+        ok = card_clause(c->b, -x, j > 1 ? -prev[j - 1] : 0, s) &&
+             (!prev[j] || card_clause(c->b, -prev[j], s, 0));
+      }
+      if (ok && (c->down || c->exact)) {
+        ok = card_clause(c->b, -s, prev[j], x) &&
+             (j == 1 || card_clause(c->b, -s, prev[j], prev[j - 1]));
+      }
+    }
+    int *swap = prev;
+    prev = cur;
+    cur = swap;
+  }
+  if (ok)
+    memcpy(outputs, prev + 1, limit * sizeof(int));
+  free(prev);
+  free(cur);
+  return ok;
+}
+
+// Function to count with a totalizer: a balanced tree whose nodes count
+// their leaves in unary, up to limit; outputs gets min(n, limit) of them
+bool card_totalizer(CardinalityCounter *c, const int *lits, int n, int limit,
+                    int *outputs) {
+  if (n == 1) {
+    outputs[0] = lits[0];
+    return true;
+  }
+  int half = n / 2;
+  int p = half < limit ? half : limit;
+  int q = n - half < limit ? n - half : limit;
+  int r = n < limit ? n : limit;
+  int *a = malloc((p + q) * sizeof(int));
+  bool ok = a && card_totalizer(c, lits, half, limit, a) &&
+            card_totalizer(c, lits + half, n - half, limit, a + p);
+  const int *b = a + p;
+  for (int k = 0; k < r && ok; k++) {
+    outputs[k] = expr_definition(c->b);
+    ok = outputs[k] != 0;
+  }
+  // a_i & b_j -> o_i+j, and o_i+j+1 -> a_i+1 | b_j+1 (a_0 and b_0 true)
+  for (int i = 0; i <= p && ok; i++) {
+    for (int j = 0; j <= q && ok; j++) {
+      if ((c->up || c->exact) && i + j >= 1 && i + j <= r)
+        ok = card_clause(c->b, i ? -a[i - 1] : 0, j ? -b[j - 1] : 0,
+                         outputs[i + j - 1]);
+      if (ok && (c->down || c->exact) && i + j < r)
+        ok = card_clause(c->b, i < p ? a[i] : 0, j < q ? b[j] : 0,
+                         -outputs[i + j]);
+    }
+  }
+  free(a);
+  return ok;
+}
+
+// Function to sort two literals: *high = x | y, *low = x & y
+bool card_compare(CardinalityCounter *c, int x, int y, int *high, int *low) {
+  if (!x || !y) {
+    *high = x ? x : y;
+    *low = 0;
+    return true;
+  }
+  *high = expr_definition(c->b);
+  *low = *high ? expr_definition(c->b) : 0;
+  if (!*low)
+    return false;
+  if ((c->up || c->exact) && (!card_clause(c->b, -x, *high, 0) ||
+                              !card_clause(c->b, -y, *high, 0) ||
+                              !card_clause(c->b, -x, -y, *low)))
+    return false;
+  return !(c->down || c->exact) || (card_clause(c->b, -*high, x, y) &&
+                                    card_clause(c->b, -*low, x, 0) &&
+                                    card_clause(c->b, -*low, y, 0));
+}
+
+// Function to split a sequence into its odd and even positions
+void card_deal(const int *a, int n, int *odd, int *even) {
+  for (int i = 0; i < n / 2; i++) {
+    odd[i] = a[2 * i];
+    even[i] = a[2 * i + 1];
+  }
+}
+
+// Function to merge two sorted sequences of n (a power of two) literals
+// into 2n, odd-even style
+bool card_merge(CardinalityCounter *c, const int *a, const int *b, int n,
+                int *out) {
+  if (n == 1)
+    return card_compare(c, a[0], b[0], &out[0], &out[1]);
+  int *work = calloc(4 * n, sizeof(int));
+  if (!work)
+    return false;
+  int *a_odd = work, *a_even = work + n / 2, *b_odd = work + n,
+      *b_even = work + 3 * n / 2, *d = work + 2 * n, *e = work + 3 * n;
+  card_deal(a, n, a_odd, a_even);
+  card_deal(b, n, b_odd, b_even);
+  bool ok = card_merge(c, a_odd, b_odd, n / 2, d) &&
+            card_merge(c, a_even, b_even, n / 2, e);
+  out[0] = d[0];
+  out[2 * n - 1] = e[n - 1];
+  for (int i = 1; i < n && ok; i++)
+    ok = card_compare(c, d[i], e[i - 1], &out[2 * i - 1], &out[2 * i]);
+  free(work);
+  return ok;
+}
+
+// Function to sort n (a power of two) literals
+bool card_sort(CardinalityCounter *c, const int *a, int n, int *out) {
+  if (n == 1) {
+    out[0] = a[0];
+    return true;
+  }
+  int *halves = malloc(n * sizeof(int));
+  bool ok = halves && card_sort(c, a, n / 2, halves) &&
+            card_sort(c, a + n / 2, n / 2, halves + n / 2) &&
+            card_merge(c, halves, halves + n / 2, n / 2, out);
+  free(halves);
+  return ok;
+}
+
+// Function to merge two sorted sequences of n (a power of two) literals
+// into their top n + 1 only (simplified merge)
+bool card_simple_merge(CardinalityCounter *c, const int *a, const int *b,
+                       int n, int *out) {
+  if (n == 1)
+    return card_compare(c, a[0], b[0], &out[0], &out[1]);
+  int *work = calloc(3 * n + 2, sizeof(int));
+  if (!work)
+    return false;
+  int *a_odd = work, *a_even = work + n / 2, *b_odd = work + n,
+      *b_even = work + 3 * n / 2, *d = work + 2 * n, *e = d + n / 2 + 1;
+  card_deal(a, n, a_odd, a_even);
+  card_deal(b, n, b_odd, b_even);
+  bool ok = card_simple_merge(c, a_odd, b_odd, n / 2, d) &&
+            card_simple_merge(c, a_even, b_even, n / 2, e);
+  out[0] = d[0];
+  for (int i = 1; i <= n / 2 && ok; i++)
+    ok = card_compare(c, d[i], e[i - 1], &out[2 * i - 1], &out[2 * i]);
+  free(work);
+  return ok;
+}
+
+// Function to count with a cardinality network (Asín et al.): the inputs,
+// padded with false, are sorted in blocks of width (the power of two
+// above limit), and each block is merged into the running top width
+bool card_network(CardinalityCounter *c, const int *lits, int n, int limit,
+                  int *outputs) {
+  int width = 1;
+  while (width < limit)
+    width *= 2;
+  int *block = malloc(width * sizeof(int));
+  int *sorted = malloc(width * sizeof(int));
+  int *top = malloc(width * sizeof(int));
+  int *merged = malloc((width + 1) * sizeof(int));
+  bool ok = block && sorted && top && merged;
+  for (int start = 0; start < n && ok; start += width) {
+    for (int i = 0; i < width; i++)
+      block[i] = start + i < n ? lits[start + i] : 0;
+    ok = card_sort(c, block, width, start == 0 ? top : sorted);
+    if (ok && start > 0) {
+      ok = card_simple_merge(c, top, sorted, width, merged);
+      memcpy(top, merged, width * sizeof(int));
+    }
+  }
+  if (ok)
+    memcpy(outputs, top, limit * sizeof(int));
+  free(block);
+  free(sorted);
+  free(top);
+  free(merged);
+  return ok;
+}
+
+// Function to add "between lo and hi of the n literals are true" (signed
+// symbol numbers, which get negated in place when the false literals are
+// cheaper to count) as hard clauses, or as a soft constraint of the given
+// weight through a relax variable
+bool add_cardinality(ExprBuilder *b, int *lits, int n, int lo, int hi,
+                     unsigned long long weight,
+                     CardinalityEncoding encoding) {
+  STAT_INC(cardinality_constraints);
+  lo = lo > 0 ? lo : 0;
+  hi = hi < n ? hi : n;
+  if (lo == 0 && hi == n)
+    return true;
+  CardinalityCounter c = {b, false, false, b->exact, 0};
+  if (weight > 0) {
+    int r = expr_definition(b);
+    c.relax = -r;
+    if (!r || !expr_emit(b, &r, 1, weight))
+      return false;
+  }
+  if (lo > hi) {
+    // Unsatisfiable: a definition and its negation when hard
+    int d = c.relax ? c.relax : expr_definition(b);
+    return d && card_clause(b, d, 0, 0) &&
+           (c.relax || card_clause(b, -d, 0, 0));
+  }
+
+  // An upper bound k needs k + 1 outputs, a lower bound k needs k
+  int limit = hi < n ? hi + 1 : lo;
+  int flipped = n - lo < n ? n - lo + 1 : n - hi;
+  if (flipped < limit) {
+    for (int i = 0; i < n; i++)
+      lits[i] = -lits[i];
+    int swap = lo;
+    lo = n - hi;
+    hi = n - swap;
+  }
+
+  // Bounds that need no counter
+  bool ok = true;
+  if (hi == 0 || lo == n) {
+    for (int i = 0; i < n && ok; i++)
+      ok = card_clause(b, hi == 0 ? -lits[i] : lits[i], c.relax, 0);
+    return ok;
+  }
+  if (hi == 1 && n <= CARD_PAIRWISE_MAX) {
+    for (int i = 0; i < n && ok; i++)
+      for (int j = i + 1; j < n && ok; j++)
+        ok = card_clause(b, -lits[i], -lits[j], c.relax);
+    hi = n;
+  }
+  if (ok && lo == 1) {
+    // At least one is a single clause, so the counter only bounds above
+    int *clause = malloc((n + 1) * sizeof(int));
+    ok = clause != NULL;
+    if (ok) {
+      memcpy(clause, lits, n * sizeof(int));
+      clause[n] = c.relax;
+      ok = expr_emit(b, clause, c.relax ? n + 1 : n, 0);
+    }
+    free(clause);
+    lo = 0;
+  }
+  if (!ok || (lo == 0 && hi == n))
+    return ok;
+
+  c.up = hi < n;
+  c.down = lo > 0;
+  limit = c.up ? hi + 1 : lo;
+  int *outputs = calloc(limit, sizeof(int));
+  if (!outputs)
+    return false;
+  if (encoding == CARD_TOTALIZER)
+    ok = card_totalizer(&c, lits, n, limit, outputs);
+  else if (encoding == CARD_NETWORK)
+    ok = card_network(&c, lits, n, limit, outputs);
+  else
+    ok = card_sequential(&c, lits, n, limit, outputs);
+  if (ok && c.up && outputs[hi])
+    ok = card_clause(b, -outputs[hi], c.relax, 0);
+  if (ok && c.down)
+    ok = card_clause(b, outputs[lo - 1], c.relax, 0);
+  free(outputs);
+  return ok;
+}
+
+// Function to tell whether a line is a cardinality constraint: an optional
+// weight, then "atmost", "atleast" or "exactly" and a bound. These words
+// are reserved there, so a native clause cannot open with such a symbol.
+bool is_cardinality_line(const char *line) {
+  while (isdigit((unsigned char)*line))
+    line++;
+  while (*line == ' ' || *line == '\t')
+    line++;
+  size_t size = strncmp(line, "exactly", 7) == 0   ? 7
+                : strncmp(line, "atmost", 6) == 0  ? 6
+                : strncmp(line, "atleast", 7) == 0 ? 7
+                                                   : 0;
+  if (size == 0 || (line[size] != ' ' && line[size] != '\t'))
+    return false;
+  line += size;
+  while (*line == ' ' || *line == '\t')
+    line++;
+  return isdigit((unsigned char)*line);
+}
+
+// Function to read a literal of a constraint line as a signed symbol
+// number: a symbol, "!" negating it, or in DIMACS a signed variable number,
+// where 0 ends the line and gives 0. Returns false on an invalid literal.
+bool read_constraint_literal(const char *token, bool dimacs,
+                             PropositionalFormula *formula, int line_num,
+                             int *lit) {
+  char name[MAX_SYMBOL_LEN];
+  bool negated;
+  if (dimacs) {
+    char *rest;
+    long value = strtol(token, &rest, 10);
+    if (*rest != '\0' || value > INT_MAX || value < -INT_MAX) {
+      printf("Error: Line %d: invalid literal %s\n", line_num, token);
+      return false;
+    }
+    *lit = 0;
+    if (value == 0)
+      return true;
+    negated = value < 0;
+    snprintf(name, sizeof(name), "x%ld", negated ? -value : value);
+  } else {
+    negated = token[0] == '!';
+    if (!is_valid_symbol_name(token + negated)) {
+      printf("Error: Line %d: invalid literal %s\n", line_num, token);
+      return false;
+    }
+    snprintf(name, sizeof(name), "%s", token + negated);
+  }
+  int var = find_or_add_symbol(formula, name) + 1;
+  *lit = negated ? -var : var;
+  return var > 0;
+}
+
+// Function to read a cardinality line and add its constraint. Native lines
+// list symbols, "!" negating them, and may start with a weight; DIMACS
+// lines list signed variable numbers up to an optional 0 and are hard.
+bool read_cardinality_line(char *line, bool dimacs, ExprBuilder *b,
+                           PropositionalFormula *formula,
+                           CardinalityEncoding encoding, int line_num) {
+  b->formula = formula;
+  unsigned long long weight = 0;
+  char *token = strtok(line, " \t");
+  if (isdigit((unsigned char)token[0])) {
+    if (dimacs || !parse_weight(token, &weight)) {
+      printf("Error: Line %d: unexpected weight %s\n", line_num, token);
+      return false;
+    }
+    // A soft constraint of weight 0 costs nothing and is dropped
+    if (weight == 0)
+      return true;
+    token = strtok(NULL, " \t");
+  }
+  char kind = token[2]; // atMost, atLeast, exActly
+  token = strtok(NULL, " \t");
+  char *rest;
+  long bound = strtol(token, &rest, 10);
+  if (*rest != '\0' || bound > INT_MAX) {
+    printf("Error: Line %d: invalid bound %s\n", line_num, token);
+    return false;
+  }
+
+  IntArray lits = {0};
+  bool ok = true;
+  for (token = strtok(NULL, " \t"); token && ok; token = strtok(NULL, " \t")) {
+    int lit;
+    ok = read_constraint_literal(token, dimacs, formula, line_num, &lit);
+    if (!ok || lit == 0)
+      break;
+    ok = int_array_push(&lits, lit);
+  }
+
+  int n = lits.count;
+  int lo = kind == 'm' ? 0 : (int)bound;
+  int hi = kind == 'l' ? n : (int)bound;
+  ok = ok && add_cardinality(b, lits.items, n, lo, hi, weight, encoding);
+  free_int_array(&lits);
+  return ok;
+}
+
+// Function to add the clauses of x1 ^ ... ^ xk = rhs over distinct
+// variables, each excluding one assignment of the other parity
+bool xor_clauses(ExprBuilder *b, const int *vars, int k, bool rhs) {
+  int lits[XOR_CUT_SIZE];
+  bool ok = true;
+  for (int mask = 0; mask < 1 << k && ok; mask++) {
+    if (word_parity((unsigned long long)mask) == rhs)
+      continue;
+    for (int i = 0; i < k; i++)
+      lits[i] = mask >> i & 1 ? -vars[i] : vars[i];
+    ok = expr_emit(b, lits, k, 0);
+  }
+  return ok;
+}
+
+// Function to add an XOR constraint: an odd number of the literals hold.
+// Repeated variables cancel, and a long constraint is cut into pieces of
+// XOR_CUT_SIZE variables chained by definitions of their parity, as its
+// 2^(n-1) clauses would not do. A soft constraint asserts, with its
+// weight, a definition of whether it holds.
+bool add_xor(ExprBuilder *b, const int *lits, int n,
+             unsigned long long weight) {
+  int *vars = malloc((n + 1) * sizeof(int));
+  if (!vars)
+    return false;
+  bool rhs = true;
+  for (int i = 0; i < n; i++) {
+    vars[i] = lit_var(lits[i]);
+    rhs ^= lits[i] < 0;
+  }
+  qsort(vars, n, sizeof(int), compare_ints);
+  int count = 0;
+  for (int i = 0; i < n; i++) {
+    if (count > 0 && vars[count - 1] == vars[i])
+      count--;
+    else
+      vars[count++] = vars[i];
+  }
+
+  bool ok = true;
+  if (weight > 0) {
+    int d = expr_definition(b);
+    ok = d && expr_emit(b, &d, 1, weight);
+    vars[count++] = d;
+    rhs = !rhs;
+  }
+  if (ok && count == 0 && rhs) {
+    // Unsatisfiable: a definition and its negation
+    int d = expr_definition(b);
+    ok = d && card_clause(b, d, 0, 0) && card_clause(b, -d, 0, 0);
+  }
+  int start = 0;
+  while (ok && count - start > XOR_CUT_SIZE) {
+    int piece[XOR_CUT_SIZE];
+    memcpy(piece, vars + start, (XOR_CUT_SIZE - 1) * sizeof(int));
+    piece[XOR_CUT_SIZE - 1] = expr_definition(b);
+    ok = piece[XOR_CUT_SIZE - 1] &&
+         xor_clauses(b, piece, XOR_CUT_SIZE, false);
+    start += XOR_CUT_SIZE - 2;
+    vars[start] = piece[XOR_CUT_SIZE - 1];
+  }
+  ok = ok && (count == start || xor_clauses(b, vars + start, count - start,
+                                            rhs));
+  free(vars);
+  return ok;
+}
+
+// Function to tell whether a line is an XOR constraint: in DIMACS an "x"
+// before the literals, natively an optional weight and "xor", a word then
+// reserved like those of cardinality constraints
+bool is_xor_line(const char *line, bool dimacs) {
+  if (dimacs)
+    return line[0] == 'x';
+  while (isdigit((unsigned char)*line))
+    line++;
+  while (*line == ' ' || *line == '\t')
+    line++;
+  return strncmp(line, "xor", 3) == 0 &&
+         (line[3] == ' ' || line[3] == '\t' || line[3] == '\0');
+}
+
+// Function to read an XOR line and add its constraint. DIMACS lines are
+// "x" and signed variable numbers up to an optional 0, as in
+// "x1 -2 3 0", and are hard; native lines list symbols after "xor".
+bool read_xor_line(char *line, bool dimacs, ExprBuilder *b,
+                   PropositionalFormula *formula, int line_num) {
+  b->formula = formula;
+  unsigned long long weight = 0;
+  char *token = strtok(line, " \t");
+  if (!dimacs && isdigit((unsigned char)token[0])) {
+    if (!parse_weight(token, &weight)) {
+      printf("Error: Line %d: unexpected weight %s\n", line_num, token);
+      return false;
+    }
+    if (weight == 0)
+      return true;
+    token = strtok(NULL, " \t");
+  }
+  token = dimacs && token[1] != '\0' ? token + 1 : strtok(NULL, " \t");
+
+  IntArray lits = {0};
+  bool ok = true;
+  for (; token && ok; token = strtok(NULL, " \t")) {
+    int lit;
+    ok = read_constraint_literal(token, dimacs, formula, line_num, &lit);
+    if (!ok || lit == 0)
+      break;
+    ok = int_array_push(&lits, lit);
+  }
+  ok = ok && add_xor(b, lits.items, lits.count, weight);
+  free_int_array(&lits);
+  return ok;
+}
+
+// Function to read a cardinality encoding name
+bool parse_cardinality_encoding(const char *name,
+                                CardinalityEncoding *encoding) {
+  if (strcmp(name, "sequential") == 0)
+    *encoding = CARD_SEQUENTIAL;
+  else if (strcmp(name, "totalizer") == 0)
+    *encoding = CARD_TOTALIZER;
+  else if (strcmp(name, "network") == 0)
+    *encoding = CARD_NETWORK;
+  else
+    return false;
+  return true;
+}
+
+// Function to read a formula from a file. Besides the native format (one
+// clause per line, "!" for negation, a leading weight for soft clauses, or
+// a general formula wherever a line has other connectives), DIMACS files
+// are accepted when they open with a header or a clause, possibly after
+// "c" comments;
+// variable n is then named xn. iCNF files ("p inccnf") add "a" cube lines,
+// collected into cubes when it is not NULL. WCNF files ("p wcnf", or "h"
+// lines for hard clauses) give every clause a weight. In both formats,
+// "atmost", "atleast" and "exactly" lines are cardinality constraints,
+// turned into clauses with the given encoding, and XOR lines ("xor a b c",
+// or "x1 2 3 0" in DIMACS) parity constraints, also turned into clauses.
+// With exact, definition variables are fully defined, as counting the
+// models needs; otherwise only the halves satisfiability needs are written.
+bool read_formula_with_cubes(const char *filename,
+                             PropositionalFormula *formula, CubeSet *cubes,
+                             CardinalityEncoding encoding, bool exact) {
+  FILE *file = fopen(filename, "r");
+  if (!file) {
+    printf("Error: Unable to open file %s\n", filename);
+    return false;
+  }
+
+  if (!init_formula(formula)) {
+    printf("Error: Failed to initialize formula\n");
+    fclose(file);
+    return false;
+  }
+
+  char line[MAX_BUFFER];
+  int line_num = 0;
+  bool format_known = false;
+  bool dimacs = false;
+  bool weighted = false;        // clauses start with a weight or "h"
+  unsigned long long top = 0;   // "p wcnf" weight of hard clauses, 0 = none
+  bool weight_read = false;     // of the DIMACS clause being read
+  bool zero_weight = false;     // soft clause that costs nothing: dropped
+
+  ExprBuilder expressions;
+  memset(&expressions, 0, sizeof(expressions));
+  expressions.exact = exact;
+  PropositionClause clause;
+  if (!init_clause(&clause)) {
+    free_formula(formula);
+    fclose(file);
+    return false;
+  }
+
+  while (fgets(line, sizeof(line), file)) {
+    line_num++;
+
+    // Remove trailing newline and whitespace
+    char *end = line + strlen(line) - 1;
+    while (end >= line && isspace(*end))
+      *end-- = '\0';
+
+    // Skip empty lines and comments
+    if (line[0] == '\0' || line[0] == '#')
+      continue;
+
+    if (!format_known) {
+      dimacs = is_dimacs_file(file, line);
+      weighted = dimacs && (is_hard_marker(line) || has_hard_markers(file));
+      format_known = true;
+    }
+
+    if (dimacs) {
+      if (strncmp(line, "p wcnf", 6) == 0) {
+        weighted = true;
+        if (sscanf(line + 6, "%*d %*d %llu", &top) != 1)
+          top = 0;
+      }
+      if (line[0] == 'c' || line[0] == 'p' || line[0] == '%')
+        continue;
+      if (clause.term_count == 0 && !weight_read &&
+          is_cardinality_line(line)) {
+        if (!read_cardinality_line(line, true, &expressions, formula,
+                                   encoding, line_num)) {
+          free_expr_builder(&expressions);
+          free_clause(&clause);
+          free_formula(formula);
+          fclose(file);
+          return false;
+        }
+        continue;
+      }
+      if (clause.term_count == 0 && !weight_read && is_xor_line(line, true)) {
+        if (!read_xor_line(line, true, &expressions, formula, line_num)) {
+          free_expr_builder(&expressions);
+          free_clause(&clause);
+          free_formula(formula);
+          fclose(file);
+          return false;
+        }
+        continue;
+      }
+      if (line[0] == 'a') {
+        if (cubes && !read_cube_line(line, formula, cubes)) {
+          free_clause(&clause);
+          free_formula(formula);
+          fclose(file);
+          return false;
+        }
+        continue;
+      }
+
+      // DIMACS clauses end with 0 and may span several lines
+      char *token = strtok(line, " \t");
+      while (token) {
+        if (weighted && !weight_read) {
+          // Weighted clauses open with "h" (hard) or their weight; in
+          // "p wcnf" files a weight of at least top also means hard
+          weight_read = true;
+          clause.weight = 0;
+          if (strcmp(token, "h") != 0) {
+            if (!parse_weight(token, &clause.weight)) {
+              free_clause(&clause);
+              free_formula(formula);
+              fclose(file);
+              return false;
+            }
+            zero_weight = clause.weight == 0;
+            if (top > 0 && clause.weight >= top)
+              clause.weight = 0;
+          }
+          token = strtok(NULL, " \t");
+          continue;
+        }
+
+        char *rest;
+        long value = strtol(token, &rest, 10);
+        if (*rest != '\0') {
+          free_clause(&clause);
+          free_formula(formula);
+          fclose(file);
+          return false;
+        }
+
+        if (value == 0) {
+          if (!zero_weight && !store_clause(formula, &clause)) {
+            free_clause(&clause);
+            free_formula(formula);
+            fclose(file);
+            return false;
+          }
+          clause.term_count = 0;
+          clause.weight = 0;
+          weight_read = false;
+          zero_weight = false;
+        } else {
+          char symbol_name[MAX_SYMBOL_LEN];
+          snprintf(symbol_name, sizeof(symbol_name), "x%ld",
+                   value < 0 ? -value : value);
+          if (!add_term(&clause, symbol_name, value < 0)) {
+            free_clause(&clause);
+            free_formula(formula);
+            fclose(file);
+            return false;
+          }
+        }
+        token = strtok(NULL, " \t");
+      }
+      continue;
+    }
+
+    if (expressions.text_length == 0 && is_cardinality_line(line)) {
+      if (!read_cardinality_line(line, false, &expressions, formula,
+                                 encoding, line_num)) {
+        free_expr_builder(&expressions);
+        free_clause(&clause);
+        free_formula(formula);
+        fclose(file);
+        return false;
+      }
+      continue;
+    }
+    if (expressions.text_length == 0 && is_xor_line(line, false)) {
+      if (!read_xor_line(line, false, &expressions, formula, line_num)) {
+        free_expr_builder(&expressions);
+        free_clause(&clause);
+        free_formula(formula);
+        fclose(file);
+        return false;
+      }
+      continue;
+    }
+
+    // Lines with connectives are general formulas, which may go on over
+    // several lines and are clausified once they are complete
+    if (expressions.text_length > 0 || is_expression_line(line)) {
+      if (!expr_append(&expressions, line) ||
+          (!expression_continues(&expressions) &&
+           !add_expression(&expressions, formula, line_num))) {
+        free_expr_builder(&expressions);
+        free_clause(&clause);
+        free_formula(formula);
+        fclose(file);
+        return false;
+      }
+      continue;
+    }
+
+    // A leading number is the weight of a soft clause
+    char *token = strtok(line, " \t");
+    clause.weight = 0;
+    zero_weight = false;
+    if (token && isdigit((unsigned char)token[0])) {
+      if (!parse_weight(token, &clause.weight)) {
+        free_expr_builder(&expressions);
+        free_clause(&clause);
+        free_formula(formula);
+        fclose(file);
+        return false;
+      }
+      zero_weight = clause.weight == 0;
+      token = strtok(NULL, " \t");
+    }
+    while (token) {
+      bool is_negated = (token[0] == '!');
+      char *symbol_name = token + (is_negated ? 1 : 0);
+
+      if (!is_valid_symbol_name(symbol_name)) {
+        free_expr_builder(&expressions);
+        free_clause(&clause);
+        free_formula(formula);
+        fclose(file);
+        return false;
+      }
+
+      if (!add_term(&clause, symbol_name, is_negated)) {
+        free_expr_builder(&expressions);
+        free_clause(&clause);
+        free_formula(formula);
+        fclose(file);
+        return false;
+      }
+
+      token = strtok(NULL, " \t");
+    }
+
+    if (!zero_weight && !store_clause(formula, &clause)) {
+      free_expr_builder(&expressions);
+      free_clause(&clause);
+      free_formula(formula);
+      fclose(file);
+      return false;
+    }
+    clause.term_count = 0;
+  }
+
+  // Accept a final DIMACS clause missing its terminating 0, and report a
+  // general formula left open at the end of the file
+  bool ok = clause.term_count == 0 || zero_weight ||
+            store_clause(formula, &clause);
+  ok = ok && (expressions.text_length == 0 ||
+              add_expression(&expressions, formula, line_num));
+  free_expr_builder(&expressions);
+  free_clause(&clause);
+  fclose(file);
+  if (!ok)
+    free_formula(formula);
+  return ok;
+}
+
+// Function to read a formula from a file, ignoring any cubes and encoding
+// cardinality constraints with sequential counters. Definitions are exact,
+// as the BDD comparisons this serves look at every model.
+bool read_formula_from_file(const char *filename,
+                            PropositionalFormula *formula) {
+  return read_formula_with_cubes(filename, formula, NULL, CARD_SEQUENTIAL,
+                                 true);
+}
+
+// Binary decision diagrams. Node ids 0 and 1 are the terminals; every
+// other node tests a variable, and the variable order is kept by level.
+typedef struct {
+  int var;  // 0 for the terminals
+  int low;  // child when var is false
+  int high; // child when var is true
+  int next; // next node in its unique-table chain, or in the free list
+  int refs; // references from parent nodes and from the caller
+} BddNode;
+
+// Unique table of one variable: its nodes hashed by their children
+typedef struct {
+  int *buckets; // chains of nodes, -1 terminated
+  int bucket_count;
+  int count;
+} BddSubtable;
+
+// Operation cache slot, direct mapped; op is -1 when the slot is empty
+typedef struct {
+  int op;
+  int f;
+  int g;
+  int result;
+} BddCacheSlot;
+
+typedef enum { BDD_AND, BDD_OR, BDD_XOR } BddOperation;
+
+// BDD manager. A node whose references drop to zero is dead: it holds no
+// references to its children, but stays in the unique table, where a
+// lookup can revive it, until a collection frees it.
+typedef struct {
+  BddNode *nodes;
+  int capacity;
+  int node_count; // allocated nodes, terminals and dead nodes included
+  int dead;
+  int free_list;
+  int max_nodes;
+  int variable_count;
+  int variable_capacity;
+  int *level;             // by variable
+  int *variable_at;       // by level
+  BddSubtable *subtables; // by variable
+  BddCacheSlot *cache;
+  IntArray swapped; // nodes of the level being swapped
+} BddManager;
+
+// Function to get the level of a node; the terminals sit below every
+// variable
+static inline int bdd_level(const BddManager *m, int f) {
+  return f <= BDD_TRUE ? m->variable_count : m->level[m->nodes[f].var];
+}
+
+// Function to get the number of nodes that are not dead
+static inline int bdd_live(const BddManager *m) {
+  return m->node_count - m->dead;
+}
+
+// Function to hash the children of a node
+static inline unsigned int bdd_hash(int low, int high) {
+  return (unsigned int)low * 12582917u ^ (unsigned int)high * 4256249u;
+}
+
+// Function to add a reference to a node, reviving it and its dead
+// descendants if it was dead
+void bdd_ref(BddManager *m, int f) {
+  if (f <= BDD_TRUE || m->nodes[f].refs++ > 0)
+    return;
+  m->dead--;
+  bdd_ref(m, m->nodes[f].low);
+  bdd_ref(m, m->nodes[f].high);
+}
+
+// Function to drop a reference to a node; a node left without any
+// releases its children in turn
+void bdd_deref(BddManager *m, int f) {
+  if (f <= BDD_TRUE || --m->nodes[f].refs > 0)
+    return;
+  m->dead++;
+  bdd_deref(m, m->nodes[f].low);
+  bdd_deref(m, m->nodes[f].high);
+}
+
+// Function to empty the operation cache
+void bdd_clear_cache(BddManager *m) {
+  for (int i = 0; i < BDD_CACHE_SIZE; i++)
+    m->cache[i].op = -1;
+}
+
+// Function to add count variables at the bottom of the order
+bool bdd_add_variables(BddManager *m, int count) {
+  int vars = m->variable_count + count;
+  if (vars >= m->variable_capacity) {
+    int capacity = m->variable_capacity ? m->variable_capacity : BASE_SIZE;
+    while (capacity <= vars)
+      capacity *= EXPANSION_RATE;
+    int *level = realloc(m->level, capacity * sizeof(int));
+    if (level)
+      m->level = level;
+    int *variable_at = realloc(m->variable_at, capacity * sizeof(int));
+    if (variable_at)
+      m->variable_at = variable_at;
+    BddSubtable *subtables =
+        realloc(m->subtables, capacity * sizeof(BddSubtable));
+    if (subtables)
+      m->subtables = subtables;
+    if (!level || !variable_at || !subtables)
+      return false;
+    m->variable_capacity = capacity;
+  }
+
+  for (int v = m->variable_count + 1; v <= vars; v++) {
+    BddSubtable *t = &m->subtables[v];
+    t->buckets = malloc(BDD_SUBTABLE_BUCKETS * sizeof(int));
+    if (!t->buckets)
+      return false;
+    for (int b = 0; b < BDD_SUBTABLE_BUCKETS; b++)
+      t->buckets[b] = -1;
+    t->bucket_count = BDD_SUBTABLE_BUCKETS;
+    t->count = 0;
+    m->level[v] = v - 1;
+    m->variable_at[v - 1] = v;
+    m->variable_count = v;
+  }
+  return true;
+}
+
+// Function to free a manager
+void free_bdd(BddManager *m) {
+  for (int v = 1; v <= m->variable_count; v++)
+    free(m->subtables[v].buckets);
+  free(m->subtables);
+  free(m->level);
+  free(m->variable_at);
+  free(m->nodes);
+  free(m->cache);
+  free_int_array(&m->swapped);
+  memset(m, 0, sizeof(*m));
+}
+
+// Function to link the free slots from first to the end of the node array
+// into the free list
+void bdd_link_free(BddManager *m, int first) {
+  for (int f = m->capacity - 1; f >= first; f--) {
+    m->nodes[f].next = m->free_list;
+    m->free_list = f;
+  }
+}
+
+// Function to initialize a manager over variable_count variables in
+// input order, allowing at most max_nodes nodes
+bool init_bdd(BddManager *m, int variable_count, int max_nodes) {
+  memset(m, 0, sizeof(*m));
+  m->max_nodes = max_nodes;
+  m->free_list = -1;
+  m->capacity = BDD_INITIAL_NODES;
+  m->nodes = malloc(m->capacity * sizeof(BddNode));
+  m->cache = malloc(BDD_CACHE_SIZE * sizeof(BddCacheSlot));
+  if (!m->nodes || !m->cache || !bdd_add_variables(m, variable_count)) {
+    free_bdd(m);
+    return false;
+  }
+  bdd_clear_cache(m);
+  for (int f = BDD_FALSE; f <= BDD_TRUE; f++)
+    m->nodes[f] = (BddNode){0, f, f, -1, 1};
+  m->node_count = 2;
+  bdd_link_free(m, 2);
+  return true;
+}
+
+// Function to set the order of a manager without nodes, order listing the
+// variables from the top level down
+void bdd_set_order(BddManager *m, const int *order) {
+  for (int l = 0; l < m->variable_count; l++) {
+    m->variable_at[l] = order[l];
+    m->level[order[l]] = l;
+  }
+}
+
+// Function to double the node array, up to the node limit
+bool bdd_grow(BddManager *m) {
+  if (m->capacity >= m->max_nodes)
+    return false;
+  int capacity = m->capacity * EXPANSION_RATE;
+  if (capacity > m->max_nodes)
+    capacity = m->max_nodes;
+  BddNode *nodes = realloc(m->nodes, capacity * sizeof(BddNode));
+  if (!nodes)
+    return false;
+  int first = m->capacity;
+  m->nodes = nodes;
+  m->capacity = capacity;
+  bdd_link_free(m, first);
+  return true;
+}
+
+// Function to free every dead node. Cached results may name them, so the
+// operation cache is cleared too.
+void bdd_collect(BddManager *m) {
+  for (int v = 1; v <= m->variable_count; v++) {
+    BddSubtable *t = &m->subtables[v];
+    for (int b = 0; b < t->bucket_count; b++) {
+      int *link = &t->buckets[b];
+      while (*link >= 0) {
+        int f = *link;
+        if (m->nodes[f].refs > 0) {
+          link = &m->nodes[f].next;
+          continue;
+        }
+        *link = m->nodes[f].next;
+        m->nodes[f].next = m->free_list;
+        m->free_list = f;
+        m->node_count--;
+        t->count--;
+      }
+    }
+  }
+  m->dead = 0;
+  bdd_clear_cache(m);
+  STAT_INC(bdd_collections);
+}
+
+// Function to take a free node slot, collecting dead nodes once they make
+// up a quarter of the table, and growing it otherwise. Returns -1 at the
+// node limit.
+int bdd_alloc(BddManager *m) {
+  if (m->free_list < 0 && m->dead > m->node_count / 4)
+    bdd_collect(m);
+  if (m->free_list < 0 && !bdd_grow(m))
+    return -1;
+  int f = m->free_list;
+  m->free_list = m->nodes[f].next;
+  m->node_count++;
+  STAT_MAX(bdd_peak_nodes, bdd_live(m));
+  return f;
+}
+
+// Function to add a node to its variable's unique table, doubling the
+// buckets when the chains get long
+void bdd_insert(BddManager *m, int f) {
+  BddSubtable *t = &m->subtables[m->nodes[f].var];
+  if (t->count >= 2 * t->bucket_count) {
+    int *buckets = malloc(2 * t->bucket_count * sizeof(int));
+    if (buckets) {
+      for (int b = 0; b < 2 * t->bucket_count; b++)
+        buckets[b] = -1;
+      for (int b = 0; b < t->bucket_count; b++) {
+        for (int g = t->buckets[b], next; g >= 0; g = next) {
+          next = m->nodes[g].next;
+          unsigned int h = bdd_hash(m->nodes[g].low, m->nodes[g].high) &
+                           (2 * t->bucket_count - 1);
+          m->nodes[g].next = buckets[h];
+          buckets[h] = g;
+        }
+      }
+      free(t->buckets);
+      t->buckets = buckets;
+      t->bucket_count *= 2;
+    }
+  }
+  unsigned int h =
+      bdd_hash(m->nodes[f].low, m->nodes[f].high) & (t->bucket_count - 1);
+  m->nodes[f].next = t->buckets[h];
+  t->buckets[h] = f;
+  t->count++;
+}
+
+// Function to get the node (var, low, high), which must lie above both
+// children in the order. The caller's references to low and high pass to
+// the node, and the result carries one reference for the caller. Returns
+// -1 at the node limit.
+int bdd_make(BddManager *m, int var, int low, int high) {
+  if (low == high) {
+    bdd_deref(m, high);
+    return low;
+  }
+  BddSubtable *t = &m->subtables[var];
+  for (int f = t->buckets[bdd_hash(low, high) & (t->bucket_count - 1)];
+       f >= 0; f = m->nodes[f].next) {
+    if (m->nodes[f].low == low && m->nodes[f].high == high) {
+      bdd_ref(m, f);
+      bdd_deref(m, low);
+      bdd_deref(m, high);
+      return f;
+    }
+  }
+
+  int f = bdd_alloc(m);
+  if (f < 0) {
+    bdd_deref(m, low);
+    bdd_deref(m, high);
+    return -1;
+  }
+  m->nodes[f] = (BddNode){var, low, high, -1, 1};
+  bdd_insert(m, f);
+  return f;
+}
+
+// Function to combine two diagrams with a binary operation, by Shannon
+// expansion on the top variable with memoisation in the operation cache.
+// The result carries a reference for the caller; -1 at the node limit.
+int bdd_apply(BddManager *m, BddOperation op, int f, int g) {
+  // Every operation is commutative: the terminal, if any, goes first
+  if (f > g) {
+    int swap = f;
+    f = g;
+    g = swap;
+  }
+  int shortcut = -1;
+  if (op == BDD_AND)
+    shortcut = f == BDD_FALSE || f == g ? f : f == BDD_TRUE ? g : -1;
+  else if (op == BDD_OR)
+    shortcut = f == BDD_TRUE ? f : f == BDD_FALSE || f == g ? g : -1;
+  else
+    shortcut = f == g ? BDD_FALSE : f == BDD_FALSE ? g : -1;
+  if (shortcut >= 0) {
+    bdd_ref(m, shortcut);
+    return shortcut;
+  }
+
+  unsigned int slot = ((unsigned int)f * 12582917u +
+                       (unsigned int)g * 4256249u + (unsigned int)op) &
+                      (BDD_CACHE_SIZE - 1);
+  BddCacheSlot *cached = &m->cache[slot];
+  if (cached->op == (int)op && cached->f == f && cached->g == g) {
+    bdd_ref(m, cached->result);
+    return cached->result;
+  }
+
+  int level = bdd_level(m, f) < bdd_level(m, g) ? bdd_level(m, f)
+                                                 : bdd_level(m, g);
+  int f0 = f, f1 = f, g0 = g, g1 = g;
+  if (bdd_level(m, f) == level) {
+    f0 = m->nodes[f].low;
+    f1 = m->nodes[f].high;
+  }
+  if (bdd_level(m, g) == level) {
+    g0 = m->nodes[g].low;
+    g1 = m->nodes[g].high;
+  }
+  int low = bdd_apply(m, op, f0, g0);
+  if (low < 0)
+    return -1;
+  int high = bdd_apply(m, op, f1, g1);
+  if (high < 0) {
+    bdd_deref(m, low);
+    return -1;
+  }
+  int result = bdd_make(m, m->variable_at[level], low, high);
+  if (result >= 0)
+    m->cache[slot] = (BddCacheSlot){op, f, g, result};
+  return result;
+}
+
+// Function to swap the variables at levels l and l + 1 in place. A node of
+// the upper variable x that depends on the lower one y is rewritten as a
+// y node over two new x nodes, keeping its id, so every reference stays
+// valid; x nodes independent of y just move down. Fails, changing
+// nothing, when the new nodes cannot be allocated.
+bool bdd_swap(BddManager *m, int l) {
+  int x = m->variable_at[l], y = m->variable_at[l + 1];
+  BddSubtable *t = &m->subtables[x];
+  while (m->capacity - m->node_count < 2 * t->count)
+    if (!bdd_grow(m))
+      return false;
+  m->swapped.count = 0;
+  for (int b = 0; b < t->bucket_count; b++)
+    for (int f = t->buckets[b]; f >= 0; f = m->nodes[f].next)
+      if (!int_array_push(&m->swapped, f))
+        return false;
+
+  for (int b = 0; b < t->bucket_count; b++)
+    t->buckets[b] = -1;
+  t->count = 0;
+  m->level[x] = l + 1;
+  m->level[y] = l;
+  m->variable_at[l] = y;
+  m->variable_at[l + 1] = x;
+
+  // Independent nodes go back first, so the rewrites below find them
+  int kept = 0;
+  for (int i = 0; i < m->swapped.count; i++) {
+    int f = m->swapped.items[i];
+    BddNode *node = &m->nodes[f];
+    if (node->refs == 0) {
+      node->next = m->free_list;
+      m->free_list = f;
+      m->node_count--;
+      m->dead--;
+    } else if (m->nodes[node->low].var == y || m->nodes[node->high].var == y) {
+      m->swapped.items[kept++] = f;
+    } else {
+      bdd_insert(m, f);
+    }
+  }
+
+  for (int i = 0; i < kept; i++) {
+    int f = m->swapped.items[i];
+    int f0 = m->nodes[f].low, f1 = m->nodes[f].high;
+    int f00 = f0, f01 = f0, f10 = f1, f11 = f1; // by x, then y
+    if (m->nodes[f0].var == y) {
+      f00 = m->nodes[f0].low;
+      f01 = m->nodes[f0].high;
+    }
+    if (m->nodes[f1].var == y) {
+      f10 = m->nodes[f1].low;
+      f11 = m->nodes[f1].high;
+    }
+    bdd_ref(m, f00);
+    bdd_ref(m, f10);
+    bdd_ref(m, f01);
+    bdd_ref(m, f11);
+    int low = bdd_make(m, x, f00, f10);
+    int high = bdd_make(m, x, f01, f11);
+    m->nodes[f].var = y;
+    m->nodes[f].low = low;
+    m->nodes[f].high = high;
+    bdd_insert(m, f);
+    bdd_deref(m, f0);
+    bdd_deref(m, f1);
+  }
+  return true;
+}
+
+// Function to reorder the variables by sifting (Rudell), largest unique
+// table first: each variable is moved to the nearer end of the order and
+// then to the other by adjacent swaps, and back to the level where the
+// diagram was smallest. A direction is abandoned once the diagram grows past
+// BDD_SIFT_GROWTH times the best size, and the whole pass after
+// BDD_SIFT_MAX_SWAPS swaps.
+void bdd_sift(BddManager *m) {
+  int vars = m->variable_count;
+  unsigned long long *keys = malloc((vars + 1) * sizeof(*keys));
+  if (!keys)
+    return;
+  bdd_collect(m);
+  for (int v = 1; v <= vars; v++)
+    keys[v - 1] =
+        (0xFFFFFFFFULL - (unsigned)m->subtables[v].count) << 32 | (unsigned)v;
+  qsort(keys, vars, sizeof(*keys), compare_sort_keys);
+
+  TRACE_BEGIN("bdd_sift");
+  bool ok = true;
+  long swaps = 0;
+  for (int i = 0; i < vars && ok && swaps < BDD_SIFT_MAX_SWAPS; i++) {
+    int x = (int)(keys[i] & 0xFFFFFFFFULL);
+    int best = bdd_live(m), best_level = m->level[x];
+    // Towards the nearer end first, then all the way to the other one
+    bool down = m->level[x] >= vars / 2;
+    for (int step = 0; step < 2 && ok; step++, down = !down) {
+      while (ok && (down ? m->level[x] < vars - 1 : m->level[x] > 0) &&
+             (bdd_live(m) <= BDD_SIFT_GROWTH * best ||
+              (step == 1 && (down ? m->level[x] < best_level
+                                  : m->level[x] > best_level)))) {
+        ok = bdd_swap(m, down ? m->level[x] : m->level[x] - 1);
+        swaps++;
+        if (bdd_live(m) < best) {
+          best = bdd_live(m);
+          best_level = m->level[x];
+        }
+      }
+    }
+    while (ok && m->level[x] < best_level)
+      ok = bdd_swap(m, m->level[x]);
+    while (ok && m->level[x] > best_level)
+      ok = bdd_swap(m, m->level[x] - 1);
+  }
+  TRACE_END("bdd_sift");
+  STAT_INC(bdd_reorderings);
+  bdd_clear_cache(m);
+  free(keys);
+}
+
+// Variable with its position during FORCE
+typedef struct {
+  double position;
+  int var;
+} BddPosition;
+
+// Function to compare variables by position, then number
+int compare_positions(const void *a, const void *b) {
+  const BddPosition *x = a, *y = b;
+  if (x->position != y->position)
+    return x->position < y->position ? -1 : 1;
+  return x->var - y->var;
+}
+
+// Function to sum the spans of the clauses, in levels, under rank
+long long clause_span(const IndexedFormula *formula, const int *rank) {
+  long long span = 0;
+  for (int c = 0; c < formula->clause_count; c++) {
+    int low = INT_MAX, high = -1;
+    for (int i = formula->clause_start[c]; i < formula->clause_start[c + 1];
+         i++) {
+      int r = rank[lit_var(formula->literals[i])];
+      low = r < low ? r : low;
+      high = r > high ? r : high;
+    }
+    if (high >= 0)
+      span += high - low;
+  }
+  return span;
+}
+
+// Function to choose a static variable order, written to order from the
+// top level down:
+//  - input keeps the order of first appearance;
+//  - occurrence puts the most frequent variables on top;
+//  - force (Aloul, Markov and Sakallah) moves every variable to the mean
+//    centre of gravity of its clauses, round after round, and keeps the
+//    order with the smallest total clause span.
+bool bdd_static_order(const IndexedFormula *formula, BddOrder heuristic,
+                      int *order) {
+  int vars = formula->variable_count;
+  for (int v = 1; v <= vars; v++)
+    order[v - 1] = v;
+  if (heuristic == BDD_ORDER_INPUT || vars == 0)
+    return true;
+
+  if (heuristic == BDD_ORDER_OCCURRENCE) {
+    unsigned long long *keys = calloc(vars + 1, sizeof(*keys));
+    if (!keys)
+      return false;
+    for (int v = 1; v <= vars; v++)
+      keys[v - 1] = (unsigned)v;
+    for (int i = 0; i < formula->clause_start[formula->clause_count]; i++)
+      keys[lit_var(formula->literals[i]) - 1] -= 1ULL << 32;
+    qsort(keys, vars, sizeof(*keys), compare_sort_keys);
+    for (int i = 0; i < vars; i++)
+      order[i] = (int)(keys[i] & 0xFFFFFFFFULL);
+    free(keys);
+    return true;
+  }
+
+  int *rank = calloc(vars + 1, sizeof(int));
+  double *centre = malloc((formula->clause_count + 1) * sizeof(double));
+  double *sum = malloc((vars + 1) * sizeof(double));
+  int *degree = malloc((vars + 1) * sizeof(int));
+  BddPosition *positions = malloc(vars * sizeof(BddPosition));
+  bool ok = rank && centre && sum && degree && positions;
+  for (int v = 1; v <= vars && ok; v++)
+    rank[v] = v - 1;
+  long long best = ok ? clause_span(formula, rank) : 0;
+
+  for (int round = 0; round < BDD_FORCE_ROUNDS && ok; round++) {
+    for (int v = 1; v <= vars; v++) {
+      sum[v] = 0.0;
+      degree[v] = 0;
+    }
+    for (int c = 0; c < formula->clause_count; c++) {
+      int start = formula->clause_start[c], end = formula->clause_start[c + 1];
+      centre[c] = 0.0;
+      for (int i = start; i < end; i++)
+        centre[c] += rank[lit_var(formula->literals[i])];
+      if (end > start)
+        centre[c] /= end - start;
+      for (int i = start; i < end; i++) {
+        sum[lit_var(formula->literals[i])] += centre[c];
+        degree[lit_var(formula->literals[i])]++;
+      }
+    }
+    for (int v = 1; v <= vars; v++)
+      positions[v - 1] =
+          (BddPosition){degree[v] > 0 ? sum[v] / degree[v] : rank[v], v};
+    qsort(positions, vars, sizeof(BddPosition), compare_positions);
+    for (int i = 0; i < vars; i++)
+      rank[positions[i].var] = i;
+
+    long long span = clause_span(formula, rank);
+    if (span >= best)
+      break;
+    best = span;
+    for (int i = 0; i < vars; i++)
+      order[i] = positions[i].var;
+  }
+
+  free(rank);
+  free(centre);
+  free(sum);
+  free(degree);
+  free(positions);
+  return ok;
+}
+
+// Function to build the diagram of a clause of signed manager variables,
+// from the bottom level up; a clause with both literals of a variable is
+// always true. Returns a referenced node, or -1 at the node limit.
+int bdd_clause(BddManager *m, const int *lits, int count,
+               unsigned long long *keys) {
+  for (int i = 0; i < count; i++)
+    keys[i] =
+        (unsigned long long)m->level[lit_var(lits[i])] << 32 | (unsigned)i;
+  qsort(keys, count, sizeof(*keys), compare_sort_keys);
+
+  int f = BDD_FALSE;
+  for (int i = count - 1; i >= 0; i--) {
+    int lit = lits[keys[i] & 0xFFFFFFFFULL];
+    if (i < count - 1) {
+      int below = lits[keys[i + 1] & 0xFFFFFFFFULL];
+      if (below == -lit) {
+        bdd_deref(m, f);
+        return BDD_TRUE;
+      }
+      if (below == lit)
+        continue;
+    }
+    f = lit > 0 ? bdd_make(m, lit, f, BDD_TRUE)
+                : bdd_make(m, -lit, BDD_TRUE, f);
+    if (f < 0)
+      return -1;
+  }
+  return f;
+}
+
+// Function to compile the clauses of a formula into one diagram. map
+// gives the manager variable of each formula variable, or is NULL for the
+// identity. The clause diagrams, sorted by top level, are conjoined
+// pairwise like a balanced tree, so operands stay of similar size. With
+// sift set, the order is sifted whenever the diagram has doubled since
+// the last reordering, and once at the end. Returns the referenced root,
+// or -1 at the node limit.
+int bdd_compile(BddManager *m, const IndexedFormula *formula, const int *map,
+                bool sift) {
+  int clauses = formula->clause_count;
+  int longest = 0;
+  for (int c = 0; c < clauses; c++) {
+    int size = formula->clause_start[c + 1] - formula->clause_start[c];
+    longest = size > longest ? size : longest;
+  }
+  int *roots = malloc((clauses + 1) * sizeof(int));
+  int *lits = malloc((longest + 1) * sizeof(int));
+  unsigned long long *keys =
+      malloc(((clauses > longest ? clauses : longest) + 1) * sizeof(*keys));
+  bool ok = roots && lits && keys;
+
+  int count = 0;
+  for (int c = 0; c < clauses && ok; c++) {
+    int start = formula->clause_start[c];
+    int size = formula->clause_start[c + 1] - start;
+    for (int i = 0; i < size; i++) {
+      int lit = formula->literals[start + i];
+      lits[i] = !map ? lit : lit > 0 ? map[lit] : -map[-lit];
+    }
+    int f = bdd_clause(m, lits, size, keys);
+    ok = f >= 0;
+    if (ok && f != BDD_TRUE)
+      roots[count++] = f;
+  }
+  for (int i = 0; i < count && ok; i++)
+    keys[i] = (unsigned long long)(m->variable_count - bdd_level(m, roots[i]))
+                  << 32 |
+              (unsigned)roots[i];
+  if (ok)
+    qsort(keys, count, sizeof(*keys), compare_sort_keys);
+  for (int i = 0; i < count && ok; i++)
+    roots[i] = (int)(keys[i] & 0xFFFFFFFFULL);
+
+  TRACE_BEGIN("bdd_compile");
+  int reorder_at = BDD_FIRST_REORDER;
+  while (ok && count > 1) {
+    int merged = 0;
+    for (int i = 0; i < count; i += 2) {
+      if (!ok) {
+        bdd_deref(m, roots[i]);
+        if (i + 1 < count)
+          bdd_deref(m, roots[i + 1]);
+        continue;
+      }
+      int f = roots[i];
+      if (i + 1 < count) {
+        f = bdd_apply(m, BDD_AND, roots[i], roots[i + 1]);
+        bdd_deref(m, roots[i]);
+        bdd_deref(m, roots[i + 1]);
+        ok = f >= 0;
+      }
+      if (ok)
+        roots[merged++] = f;
+      if (ok && sift && bdd_live(m) > reorder_at) {
+        bdd_sift(m);
+        reorder_at = 2 * bdd_live(m) > BDD_FIRST_REORDER ? 2 * bdd_live(m)
+                                                          : BDD_FIRST_REORDER;
+      }
+    }
+    count = merged;
+  }
+  TRACE_END("bdd_compile");
+
+  for (int i = 0; i < count && !ok; i++)
+    bdd_deref(m, roots[i]);
+  int root = !ok ? -1 : count == 0 ? BDD_TRUE : roots[0];
+  if (ok && sift)
+    bdd_sift(m);
+  free(roots);
+  free(lits);
+  free(keys);
+  return root;
+}
+
+
+// One counting pass over a diagram under a partial assignment
+typedef struct {
+  const BddManager *m;
+  const bool *assigned; // by variable, NULL when nothing is assigned
+  const bool *value;
+  int *free_below; // by level: unassigned variables at that level or below
+  BigNum *counts;  // by node
+  bool *done;      // by node
+  IntArray visited;
+  BigNum scaled;
+} BddCountPass;
+
+// Function to count the assignments to the unassigned variables at the
+// level of f and below that satisfy f. A child's count is scaled by 2 for
+// every unassigned variable on the levels skipped to reach it.
+bool bdd_count_node(BddCountPass *pass, int f) {
+  if (pass->done[f])
+    return true;
+  const BddNode *node = &pass->m->nodes[f];
+  int level = pass->m->level[node->var];
+  bool fixed = pass->assigned && pass->assigned[node->var];
+  bool ok = bignum_set(&pass->counts[f], 0);
+  for (int side = 0; side < 2 && ok; side++) {
+    if (fixed && pass->value[node->var] != side)
+      continue;
+    int child = side ? node->high : node->low;
+    ok = bdd_count_node(pass, child) &&
+         bignum_copy(&pass->scaled, &pass->counts[child]) &&
+         bignum_shift_left(&pass->scaled,
+                           pass->free_below[level + 1] -
+                               pass->free_below[bdd_level(pass->m, child)]) &&
+         bignum_add(&pass->counts[f], &pass->scaled);
+  }
+  pass->done[f] = ok && int_array_push(&pass->visited, f);
+  return pass->done[f];
+}
+
+// Function to count the models of root that extend a partial assignment
+// (assigned and value by variable, or NULL for none), over the unassigned
+// variables, in time linear in the diagram size. When model is not NULL
+// and a model exists, it receives one, preferring false for the open
+// variables.
+bool bdd_count(const BddManager *m, int root, const bool *assigned,
+               const bool *value, BigNum *count, bool *model) {
+  BddCountPass pass;
+  memset(&pass, 0, sizeof(pass));
+  pass.m = m;
+  pass.assigned = assigned;
+  pass.value = value;
+  pass.free_below = malloc((m->variable_count + 1) * sizeof(int));
+  pass.counts = calloc(m->capacity, sizeof(BigNum));
+  pass.done = calloc(m->capacity, sizeof(bool));
+  bool ok = pass.free_below && pass.counts && pass.done &&
+            bignum_set(&pass.counts[BDD_FALSE], 0) &&
+            bignum_set(&pass.counts[BDD_TRUE], 1);
+
+  if (ok) {
+    pass.done[BDD_FALSE] = pass.done[BDD_TRUE] = true;
+    pass.free_below[m->variable_count] = 0;
+    for (int l = m->variable_count - 1; l >= 0; l--)
+      pass.free_below[l] = pass.free_below[l + 1] +
+                           !(assigned && assigned[m->variable_at[l]]);
+    ok = bdd_count_node(&pass, root) &&
+         bignum_copy(count, &pass.counts[root]) &&
+         bignum_shift_left(count, pass.free_below[0] -
+                                      pass.free_below[bdd_level(m, root)]);
+  }
+
+  if (ok && model && count->count > 0) {
+    for (int v = 1; v <= m->variable_count; v++)
+      model[v] = assigned && assigned[v] && value[v];
+    for (int f = root; f > BDD_TRUE;) {
+      int var = m->nodes[f].var;
+      model[var] = assigned && assigned[var]
+                       ? value[var]
+                       : pass.counts[m->nodes[f].low].count == 0;
+      f = model[var] ? m->nodes[f].high : m->nodes[f].low;
+    }
+  }
+
+  for (int i = 0; i < pass.visited.count; i++)
+    free_bignum(&pass.counts[pass.visited.items[i]]);
+  if (pass.counts) {
+    free_bignum(&pass.counts[BDD_FALSE]);
+    free_bignum(&pass.counts[BDD_TRUE]);
+  }
+  free_bignum(&pass.scaled);
+  free_int_array(&pass.visited);
+  free(pass.free_below);
+  free(pass.counts);
+  free(pass.done);
+  return ok;
+}
+
+// Function to evaluate a diagram under a full assignment
+bool bdd_eval(const BddManager *m, int f, const bool *model) {
+  while (f > BDD_TRUE)
+    f = model[m->nodes[f].var] ? m->nodes[f].high : m->nodes[f].low;
+  return f == BDD_TRUE;
+}
+
+// Function to number the nodes of a diagram children first, from 2 on,
+// appending them to order; number is by node id, 0 while unnumbered
+bool bdd_number(const BddManager *m, int f, int *number, IntArray *order) {
+  if (f <= BDD_TRUE || number[f] > 0)
+    return true;
+  if (!bdd_number(m, m->nodes[f].low, number, order) ||
+      !bdd_number(m, m->nodes[f].high, number, order) ||
+      !int_array_push(order, f))
+    return false;
+  number[f] = order->count + 1;
+  return true;
+}
+
+// Function to count the decision nodes of a diagram, or -1 when out of
+// memory
+int bdd_node_count(const BddManager *m, int root) {
+  int *number = calloc(m->capacity, sizeof(int));
+  IntArray order = {0};
+  int count = number && bdd_number(m, root, number, &order) ? order.count : -1;
+  free(number);
+  free_int_array(&order);
+  return count;
+}
+
+// Function to write a 32-bit number, least significant byte first
+void write_u32(FILE *file, unsigned int n) {
+  unsigned char bytes[4] = {n & 255, n >> 8 & 255, n >> 16 & 255, n >> 24};
+  fwrite(bytes, 1, 4, file);
+}
+
+// Function to read a number written by write_u32()
+bool read_u32(FILE *file, unsigned int *n) {
+  unsigned char bytes[4];
+  if (fread(bytes, 1, 4, file) != 4)
+    return false;
+  *n = bytes[0] | bytes[1] << 8 | bytes[2] << 16 | (unsigned int)bytes[3]
+                                                       << 24;
+  return true;
+}
+
+// Function to check whether a file starts like a compiled diagram
+bool is_bdd_file(const char *path) {
+  char magic[sizeof(BDD_FILE_MAGIC) - 1];
+  FILE *file = fopen(path, "rb");
+  if (!file)
+    return false;
+  bool match = fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+               memcmp(magic, BDD_FILE_MAGIC, sizeof(magic)) == 0;
+  fclose(file);
+  return match;
+}
+
+// Function to save a diagram. The file holds 32-bit little-endian numbers
+// after the magic: the variable count, each symbol name as a length and
+// its bytes, the variables from the top level down, the node count, each
+// node children first as (variable, low, high), and the root. Nodes are
+// numbered from 2 on, 0 and 1 being the terminals.
+bool bdd_save(const char *path, const BddManager *m, int root,
+              const PropositionalFormula *formula) {
+  int *number = calloc(m->capacity, sizeof(int));
+  IntArray order = {0};
+  FILE *file = fopen(path, "wb");
+  bool ok = number && file && bdd_number(m, root, number, &order);
+  if (ok) {
+    fwrite(BDD_FILE_MAGIC, 1, sizeof(BDD_FILE_MAGIC) - 1, file);
+    write_u32(file, m->variable_count);
+    for (int v = 1; v <= m->variable_count; v++) {
+      const char *name = formula->symbols[v - 1].symbol;
+      write_u32(file, (unsigned int)strlen(name));
+      fwrite(name, 1, strlen(name), file);
+    }
+    for (int l = 0; l < m->variable_count; l++)
+      write_u32(file, m->variable_at[l]);
+    write_u32(file, order.count);
+    for (int i = 0; i < order.count; i++) {
+      const BddNode *node = &m->nodes[order.items[i]];
+      write_u32(file, node->var);
+      write_u32(file, node->low <= BDD_TRUE ? node->low : number[node->low]);
+      write_u32(file,
+                node->high <= BDD_TRUE ? node->high : number[node->high]);
+    }
+    write_u32(file, root <= BDD_TRUE ? root : number[root]);
+    ok = !ferror(file);
+  }
+  if (file && fclose(file) != 0)
+    ok = false;
+  if (!ok)
+    printf("Error: Unable to write %s\n", path);
+  free(number);
+  free_int_array(&order);
+  return ok;
+}
+
+// Function to load a diagram written by bdd_save() into a new manager,
+// registering its variables as the symbols of the empty formula. Every
+// node goes through the unique table, so the result is reduced even if
+// the file is not; nodes out of order are rejected. The manager must be
+// freed whatever the outcome.
+bool bdd_load(const char *path, PropositionalFormula *formula, BddManager *m,
+              int *root) {
+  memset(m, 0, sizeof(*m));
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    printf("Error: Unable to open file %s\n", path);
+    return false;
+  }
+  char magic[sizeof(BDD_FILE_MAGIC) - 1];
+  unsigned int vars = 0, count = 0, index;
+  bool ok = fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+            memcmp(magic, BDD_FILE_MAGIC, sizeof(magic)) == 0 &&
+            read_u32(file, &vars) && vars < INT_MAX / 2 &&
+            init_bdd(m, (int)vars, BDD_MAX_NODES);
+
+  // Symbols in variable order, then the levels
+  char name[MAX_SYMBOL_LEN];
+  for (unsigned int v = 1; v <= vars && ok; v++) {
+    unsigned int length;
+    ok = read_u32(file, &length) && length > 0 && length < MAX_SYMBOL_LEN &&
+         fread(name, 1, length, file) == length;
+    if (ok) {
+      name[length] = '\0';
+      ok = is_valid_symbol_name(name) &&
+           find_or_add_symbol(formula, name) == (int)v - 1;
+    }
+  }
+  int *order = malloc((vars + 1) * sizeof(int));
+  bool *placed = calloc(vars + 1, sizeof(bool));
+  ok = ok && order && placed;
+  for (unsigned int l = 0; l < vars && ok; l++) {
+    ok = read_u32(file, &index) && index >= 1 && index <= vars &&
+         !placed[index];
+    if (ok) {
+      placed[index] = true;
+      order[l] = (int)index;
+    }
+  }
+  if (ok)
+    bdd_set_order(m, order);
+
+  // Nodes, children first, each above its children
+  int *ids = NULL;
+  ok = ok && read_u32(file, &count) && count <= BDD_MAX_NODES &&
+       (ids = malloc((count + 2) * sizeof(int))) != NULL;
+  if (ok) {
+    ids[BDD_FALSE] = BDD_FALSE;
+    ids[BDD_TRUE] = BDD_TRUE;
+  }
+  unsigned int made = 0;
+  while (ok && made < count) {
+    unsigned int var, low, high;
+    ok = read_u32(file, &var) && read_u32(file, &low) &&
+         read_u32(file, &high) && var >= 1 && var <= vars &&
+         low < made + 2 && high < made + 2 &&
+         m->level[var] < bdd_level(m, ids[low]) &&
+         m->level[var] < bdd_level(m, ids[high]);
+    if (ok) {
+      bdd_ref(m, ids[low]);
+      bdd_ref(m, ids[high]);
+      ids[made + 2] = bdd_make(m, (int)var, ids[low], ids[high]);
+      ok = ids[made + 2] >= 0;
+      made += ok;
+    }
+  }
+  ok = ok && read_u32(file, &index) && index < count + 2;
+  if (ok) {
+    *root = ids[index];
+    bdd_ref(m, *root);
+  }
+  // The loaded nodes drop the references bdd_make() gave them
+  for (unsigned int i = 0; i < made; i++)
+    bdd_deref(m, ids[i + 2]);
+
+  if (!ok)
+    printf("Error: %s is not a valid BDD file\n", path);
+  fclose(file);
+  free(order);
+  free(placed);
+  free(ids);
+  return ok;
+}
+
+// Function to answer the queries in a file, one partial assignment per
+// line in the syntax of model files ("a !b", or DIMACS "1 -2 0"); "c" and
+// "#" lines are comments. Each query is one pass over the diagram, giving
+// the number of models that extend the assignment.
+bool bdd_answer_queries(const BddManager *m, int root,
+                        const PropositionalFormula *formula,
+                        const char *path) {
+  FILE *file = fopen(path, "r");
+  if (!file) {
+    printf("Error: Unable to open query file %s\n", path);
+    return false;
+  }
+  bool *value = calloc(m->variable_count + 1, sizeof(bool));
+  bool *assigned = calloc(m->variable_count + 1, sizeof(bool));
+  BigNum count = {0};
+  bool ok = value && assigned;
+
+  char token[MAX_SYMBOL_LEN + 2];
+  int c = '\n', queries = 0;
+  while (ok && c != EOF) {
+    memset(assigned, 0, (m->variable_count + 1) * sizeof(bool));
+    int tokens = 0;
+    bool comment = false;
+    do {
+      c = read_model_token(file, token, sizeof(token));
+      if (!token[0])
+        continue;
+      if (tokens++ == 0 && (strcmp(token, "c") == 0 || token[0] == '#'))
+        comment = true;
+      if (!comment && strcmp(token, "0") != 0)
+        assign_model_literal(formula, token, value, assigned);
+    } while (c != '\n' && c != EOF);
+    if (tokens == 0 || comment)
+      continue;
+
+    char *text = NULL;
+    ok = bdd_count(m, root, assigned, value, &count, NULL) &&
+         (text = bignum_to_string(&count)) != NULL;
+    if (ok)
+      printf("Query %d: %s, %s models\n", ++queries,
+             count.count > 0 ? "satisfiable" : "unsatisfiable", text);
+    free(text);
+  }
+  if (!ok)
+    printf("Error: Out of memory while answering queries\n");
+  fclose(file);
+  free(value);
+  free(assigned);
+  free_bignum(&count);
+  return ok;
+}
+
+// Function to compile the formula in path into the manager for an
+// equivalence check, matching variables by symbol name; symbols the input
+// lacks are added to formula and at the bottom of the order. Returns the
+// referenced root, or -1.
+int bdd_compile_other(BddManager *m, PropositionalFormula *formula,
+                      const char *path, bool sift) {
+  PropositionalFormula other;
+  IndexedFormula indexed;
+  if (!read_formula_from_file(path, &other))
+    return -1;
+  for (int i = 0; i < other.clause_count; i++) {
+    if (other.clauses[i].weight > 0) {
+      printf("Error: --equivalent does not support soft clauses\n");
+      free_formula(&other);
+      return -1;
+    }
+  }
+  if (!build_indexed_formula(&other, &indexed)) {
+    free_formula(&other);
+    return -1;
+  }
+
+  int *map = malloc((indexed.variable_count + 1) * sizeof(int));
+  bool ok = map != NULL;
+  for (int v = 1; v <= indexed.variable_count && ok; v++) {
+    map[v] = find_or_add_symbol(formula, other.symbols[v - 1].symbol) + 1;
+    ok = map[v] > 0;
+  }
+  ok = ok && bdd_add_variables(m, formula->symbol_count - m->variable_count);
+  int root = ok ? bdd_compile(m, &indexed, map, sift) : -1;
+  free(map);
+  free_indexed_formula(&indexed);
+  free_formula(&other);
+  return root;
+}
+
+// Function to run the BDD mode: compile the parsed formula, or load a
+// compiled one from the input file, then report the result with a model
+// and the model count, save the diagram, answer the queries and check the
+// equivalence that options ask for. Formulas with soft clauses are
+// refused.
+SolveResult run_bdd(PropositionalFormula *formula,
+                    const SolverOptions *options, bool compiled_input) {
+  for (int i = 0; i < formula->clause_count; i++) {
+    if (formula->clauses[i].weight > 0) {
+      printf("Error: --bdd does not support soft clauses\n");
+      return RESULT_UNKNOWN;
+    }
+  }
+  g_stats.engine = "bdd";
+  g_stats.engine_reason = "requested";
+
+  BddManager m;
+  memset(&m, 0, sizeof(m));
+  int root = -1;
+  double start = stats_now();
+  bool ok;
+  if (compiled_input) {
+    ok = bdd_load(options->input_path, formula, &m, &root);
+    g_stats.parse_time += stats_now() - start;
+    start = stats_now();
+    if (ok && options->sift)
+      bdd_sift(&m);
+  } else {
+    IndexedFormula indexed;
+    if (!build_indexed_formula(formula, &indexed))
+      return RESULT_UNKNOWN;
+    int *order = malloc((indexed.variable_count + 1) * sizeof(int));
+    ok = order && init_bdd(&m, indexed.variable_count, BDD_MAX_NODES);
+    if (ok && bdd_static_order(&indexed, options->bdd_order, order)) {
+      bdd_set_order(&m, order);
+      root = bdd_compile(&m, &indexed, NULL, options->sift);
+      if (root < 0)
+        printf("Error: The BDD exceeds %d nodes\n", BDD_MAX_NODES);
+    }
+    ok = ok && root >= 0;
+    free(order);
+    free_indexed_formula(&indexed);
+  }
+  if (!ok) {
+    free_bdd(&m);
+    return RESULT_UNKNOWN;
+  }
+
+  BigNum count = {0};
+  bool *model = calloc(m.variable_count + 1, sizeof(bool));
+  char *text = NULL;
+  ok = model && bdd_count(&m, root, NULL, NULL, &count, model) &&
+       (text = bignum_to_string(&count)) != NULL;
+  SolveResult result = count.count > 0 ? RESULT_SAT : RESULT_UNSAT;
+  if (!ok) {
+    printf("Error: Out of memory\n");
+    result = RESULT_UNKNOWN;
+  } else if (result == RESULT_SAT && verify_model(formula, model, NULL) >= 0) {
+    printf("Error: Model check failed\n");
+    result = RESULT_UNKNOWN;
+  }
+  g_stats.bdd_nodes = bdd_node_count(&m, root);
+
+  if (result != RESULT_UNKNOWN) {
+    set_display_color(result == RESULT_SAT ? SUCCESS_COLOR : ERROR_COLOR);
+    printf("\nResult: Formula is %s\n",
+           result == RESULT_SAT ? "SATISFIABLE" : "UNSATISFIABLE");
+    set_display_color(DEFAULT_COLOR);
+    printf("BDD: %llu nodes, %s models\n", g_stats.bdd_nodes, text);
+    if (result == RESULT_SAT)
+      print_model(formula, model, options->model_format);
+  }
+  if (result != RESULT_UNKNOWN && options->bdd_save) {
+    if (bdd_save(options->bdd_save, &m, root, formula))
+      printf("Wrote the BDD to %s\n", options->bdd_save);
+    else
+      result = RESULT_UNKNOWN;
+  }
+  if (result != RESULT_UNKNOWN && options->query_path &&
+      !bdd_answer_queries(&m, root, formula, options->query_path))
+    result = RESULT_UNKNOWN;
+
+  if (result != RESULT_UNKNOWN && options->equivalent_path) {
+    // Canonical diagrams are equivalent exactly when they are the same node
+    int other =
+        bdd_compile_other(&m, formula, options->equivalent_path, options->sift);
+    int difference = other >= 0 ? bdd_apply(&m, BDD_XOR, root, other) : -1;
+    bool *witness = calloc(m.variable_count + 1, sizeof(bool));
+    char *differing = NULL;
+    if (difference < 0 || !witness ||
+        !bdd_count(&m, difference, NULL, NULL, &count, witness) ||
+        !(differing = bignum_to_string(&count))) {
+      printf("Error: Unable to compile %s for the equivalence check\n",
+             options->equivalent_path);
+      result = RESULT_UNKNOWN;
+    } else if (difference == BDD_FALSE) {
+      printf("Equivalent to %s: yes\n", options->equivalent_path);
+    } else {
+      printf("Equivalent to %s: no, %s assignments differ; this one "
+             "satisfies only %s:\n",
+             options->equivalent_path, differing,
+             bdd_eval(&m, root, witness) ? options->input_path
+                                         : options->equivalent_path);
+      print_model(formula, witness, options->model_format);
+    }
+    free(witness);
+    free(differing);
+  }
+
+  g_stats.solve_time = stats_now() - start;
+  free(text);
+  free(model);
+  free_bignum(&count);
+  free_bdd(&m);
+  return result;
+}
+
+// Function to print the core as "k" lines of clause numbers (in reading
+// order, tautologies excluded), 16 per line, and write it to
+// options->core_path when set
+void print_core(const PropositionalFormula *formula,
+                const SolverOptions *options, const bool *core) {
+  int size = 0;
+  for (int c = 0; c < formula->clause_count; c++)
+    size += core[c];
+  printf("\nCore: %d of %d clauses%s\n", size, formula->clause_count,
+         options->core_mode == CORE_MINIMAL ? " (minimal)" : "");
+  for (int c = 0, printed = 0; c < formula->clause_count; c++) {
+    if (!core[c])
+      continue;
+    printf("%s%d", printed % 16 == 0 ? "k " : " ", c + 1);
+    if (++printed % 16 == 0 || printed == size)
+      printf("\n");
+  }
+  if (options->core_path && write_core(options->core_path, formula, core))
+    printf("Wrote the core to %s\n", options->core_path);
+}
+
+// The benchmark programs include this file for its primitives and bring
+// their own entry point
+#ifndef LOGIC_SOLVER_NO_MAIN
+// Function to parse command line arguments
+bool parse_args(int argc, char *argv[], SolverOptions *options) {
+  options->input_path = NULL;
+  options->stats_format = STATS_NONE;
+  options->trace_path = NULL;
+  options->engine = ENGINE_AUTO;
+  options->seed = 1;
+  options->max_flips = DEFAULT_MAX_FLIPS;
+  options->restart_interval = 0;
+  options->threads = cpu_count();
+  options->cube_path = NULL;
+  options->cube_target = DEFAULT_CUBES;
+  options->model_format = MODEL_LINES;
+  options->verify_path = NULL;
+  options->proof_path = NULL;
+  options->proof_format = PROOF_LRAT;
+  options->core_mode = CORE_NONE;
+  options->core_path = NULL;
+  options->time_limit = 0;
+  options->count = false;
+  options->cache_mb = DEFAULT_CACHE_MB;
+  options->enumerate = false;
+  options->project = NULL;
+  options->backbone = false;
+  options->bdd = false;
+  options->bdd_order = BDD_ORDER_FORCE;
+  options->sift = false;
+  options->bdd_save = NULL;
+  options->query_path = NULL;
+  options->equivalent_path = NULL;
+  options->cardinality = CARD_SEQUENTIAL;
+  options->symmetry = false;
+  options->checkpoint_path = NULL;
+  options->checkpoint_interval = DEFAULT_CHECKPOINT_INTERVAL;
+  options->resume = false;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--stats") == 0 ||
+        strcmp(argv[i], "--stats=text") == 0) {
+      options->stats_format = STATS_TEXT;
+    } else if (strcmp(argv[i], "--stats=json") == 0) {
+      options->stats_format = STATS_JSON;
+    } else if (strncmp(argv[i], "--trace=", 8) == 0) {
+#ifdef LOGIC_SOLVER_TRACE
+      options->trace_path = argv[i] + 8;
+#else
+      printf("Error: Tracing requires a build with -DLOGIC_SOLVER_TRACE\n");
+      return false;
+#endif
+    } else if (strncmp(argv[i], "--engine=", 9) == 0) {
+      const char *engine = argv[i] + 9;
+      if (strcmp(engine, "auto") == 0) {
+        options->engine = ENGINE_AUTO;
+      } else if (strcmp(engine, "resolution") == 0) {
+        options->engine = ENGINE_RESOLUTION;
+      } else if (strcmp(engine, "walksat") == 0) {
+        options->engine = ENGINE_WALKSAT;
+      } else if (strcmp(engine, "probsat") == 0) {
+        options->engine = ENGINE_PROBSAT;
+      } else if (strcmp(engine, "cdcl") == 0) {
+        options->engine = ENGINE_CDCL;
+      } else if (strcmp(engine, "cubes") == 0) {
+        options->engine = ENGINE_CUBES;
+      } else {
+        printf("Error: Unknown engine %s\n", engine);
+        return false;
+      }
+    } else if (strncmp(argv[i], "--seed=", 7) == 0) {
+      options->seed = strtoull(argv[i] + 7, NULL, 10);
+    } else if (strncmp(argv[i], "--flips=", 8) == 0) {
+      options->max_flips = strtoull(argv[i] + 8, NULL, 10);
+    } else if (strncmp(argv[i], "--restart-interval=", 19) == 0) {
+      options->restart_interval = strtoull(argv[i] + 19, NULL, 10);
+      if (options->restart_interval == 0) {
+        printf("Error: The restart interval must be positive\n");
+        return false;
+      }
+    } else if (strncmp(argv[i], "--threads=", 10) == 0) {
+      options->threads = atoi(argv[i] + 10);
+      if (options->threads < 1 || options->threads > MAX_THREADS) {
+        printf("Error: The thread count must be between 1 and %d\n",
+               MAX_THREADS);
+        return false;
+      }
+    } else if (strncmp(argv[i], "--cube=", 7) == 0) {
+      options->cube_path = argv[i] + 7;
+    } else if (strncmp(argv[i], "--cubes=", 8) == 0) {
+      options->cube_target = atoi(argv[i] + 8);
+      if (options->cube_target < 1) {
+        printf("Error: The cube count must be positive\n");
+        return false;
+      }
+    } else if (strncmp(argv[i], "--model=", 8) == 0) {
+      const char *format = argv[i] + 8;
+      if (strcmp(format, "v") == 0) {
+        options->model_format = MODEL_LINES;
+      } else if (strcmp(format, "json") == 0) {
+        options->model_format = MODEL_JSON;
+      } else if (strcmp(format, "none") == 0) {
+        options->model_format = MODEL_NONE;
+      } else {
+        printf("Error: Unknown model format %s\n", format);
+        return false;
+      }
+    } else if (strncmp(argv[i], "--verify=", 9) == 0) {
+      options->verify_path = argv[i] + 9;
+    } else if (strncmp(argv[i], "--proof=", 8) == 0) {
+      options->proof_path = argv[i] + 8;
+    } else if (strncmp(argv[i], "--proof-format=", 15) == 0) {
+      const char *format = argv[i] + 15;
+      if (strcmp(format, "lrat") == 0) {
+        options->proof_format = PROOF_LRAT;
+      } else if (strcmp(format, "drat") == 0) {
+        options->proof_format = PROOF_DRAT;
+      } else if (strcmp(format, "lrat-text") == 0) {
+        options->proof_format = PROOF_LRAT_TEXT;
+      } else if (strcmp(format, "drat-text") == 0) {
+        options->proof_format = PROOF_DRAT_TEXT;
+      } else {
+        printf("Error: Unknown proof format %s\n", format);
+        return false;
+      }
+    } else if (strcmp(argv[i], "--core") == 0) {
+      if (options->core_mode == CORE_NONE)
+        options->core_mode = CORE_ANY;
+    } else if (strcmp(argv[i], "--mus") == 0) {
+      options->core_mode = CORE_MINIMAL;
+    } else if (strncmp(argv[i], "--core-file=", 12) == 0) {
+      options->core_path = argv[i] + 12;
+      if (options->core_mode == CORE_NONE)
+        options->core_mode = CORE_ANY;
+    } else if (strncmp(argv[i], "--time-limit=", 13) == 0) {
+      options->time_limit = atof(argv[i] + 13);
+      if (options->time_limit <= 0) {
+        printf("Error: The time limit must be positive\n");
+        return false;
+      }
+    } else if (strcmp(argv[i], "--count") == 0) {
+      options->count = true;
+    } else if (strncmp(argv[i], "--cache-mb=", 11) == 0) {
+      options->cache_mb = atoi(argv[i] + 11);
+      if (options->cache_mb < 1) {
+        printf("Error: The cache size must be positive\n");
+        return false;
+      }
+    } else if (strcmp(argv[i], "--all") == 0) {
+      options->enumerate = true;
+    } else if (strncmp(argv[i], "--project=", 10) == 0) {
+      options->project = argv[i] + 10;
+    } else if (strcmp(argv[i], "--backbone") == 0) {
+      options->backbone = true;
+    } else if (strcmp(argv[i], "--bdd") == 0) {
+      options->bdd = true;
+    } else if (strncmp(argv[i], "--bdd-order=", 12) == 0) {
+      const char *order = argv[i] + 12;
+      if (strcmp(order, "force") == 0) {
+        options->bdd_order = BDD_ORDER_FORCE;
+      } else if (strcmp(order, "occurrence") == 0) {
+        options->bdd_order = BDD_ORDER_OCCURRENCE;
+      } else if (strcmp(order, "input") == 0) {
+        options->bdd_order = BDD_ORDER_INPUT;
+      } else {
+        printf("Error: Unknown BDD order %s\n", order);
+        return false;
+      }
+    } else if (strncmp(argv[i], "--cardinality=", 14) == 0) {
+      if (!parse_cardinality_encoding(argv[i] + 14, &options->cardinality)) {
+        printf("Error: Unknown cardinality encoding %s\n", argv[i] + 14);
+        return false;
+      }
+    } else if (strcmp(argv[i], "--symmetry") == 0) {
+      options->symmetry = true;
+    } else if (strncmp(argv[i], "--checkpoint=", 13) == 0) {
+      options->checkpoint_path = argv[i] + 13;
+    } else if (strncmp(argv[i], "--checkpoint-interval=", 22) == 0) {
+      options->checkpoint_interval = atof(argv[i] + 22);
+      if (options->checkpoint_interval <= 0) {
+        printf("Error: The checkpoint interval must be positive\n");
+        return false;
+      }
+    } else if (strcmp(argv[i], "--resume") == 0) {
+      options->resume = true;
+    } else if (strcmp(argv[i], "--sift") == 0) {
+      options->sift = true;
+    } else if (strncmp(argv[i], "--bdd-save=", 11) == 0) {
+      options->bdd_save = argv[i] + 11;
+    } else if (strncmp(argv[i], "--query=", 8) == 0) {
+      options->query_path = argv[i] + 8;
+    } else if (strncmp(argv[i], "--equivalent=", 13) == 0) {
+      options->equivalent_path = argv[i] + 13;
+    } else if (argv[i][0] == '-' && argv[i][1] == '-') {
+      printf("Error: Unknown option %s\n", argv[i]);
+      return false;
+    } else if (!options->input_path) {
+      options->input_path = argv[i];
+    } else {
+      printf("Error: Only one CNF file can be analyzed at a time\n");
+      return false;
+    }
+  }
+
+  if (!options->input_path) {
+    printf("Error: Please provide a CNF file path\n");
+    return false;
+  }
+  if (options->proof_path && options->core_mode != CORE_NONE) {
+    printf("Error: --proof cannot be combined with core extraction\n");
+    return false;
+  }
+  int modes = options->count + options->enumerate + options->backbone +
+              options->bdd;
+  if (modes > 0 && (options->proof_path || options->cube_path ||
+                    options->core_mode != CORE_NONE)) {
+    printf("Error: --count, --all, --backbone and --bdd cannot be combined "
+           "with proofs, cores or cubes\n");
+    return false;
+  }
+  if (modes > 1) {
+    printf("Error: Only one of --count, --all, --backbone and --bdd can be "
+           "used\n");
+    return false;
+  }
+  if ((options->bdd_order != BDD_ORDER_FORCE || options->sift ||
+       options->bdd_save || options->query_path || options->equivalent_path) &&
+      !options->bdd) {
+    printf("Error: --bdd-order, --sift, --bdd-save, --query and --equivalent "
+           "require --bdd\n");
+    return false;
+  }
+  if (options->project && !options->enumerate) {
+    printf("Error: --project requires --all\n");
+    return false;
+  }
+  // Breaking symmetries keeps satisfiability, not the set of models
+  if (options->symmetry && (modes > 0 || options->proof_path ||
+                            options->cube_path ||
+                            options->core_mode != CORE_NONE)) {
+    printf("Error: --symmetry cannot be combined with --count, --all, "
+           "--backbone, --bdd, proofs, cores or cube output\n");
+    return false;
+  }
+  // Only the saturation state of the resolution engine is saved
+  if ((options->resume ||
+       options->checkpoint_interval != DEFAULT_CHECKPOINT_INTERVAL) &&
+      !options->checkpoint_path) {
+    printf("Error: --checkpoint-interval and --resume require "
+           "--checkpoint\n");
+    return false;
+  }
+  if (options->checkpoint_path &&
+      ((options->engine != ENGINE_AUTO &&
+        options->engine != ENGINE_RESOLUTION) ||
+       modes > 0 || options->proof_path || options->cube_path ||
+       options->core_mode != CORE_NONE)) {
+    printf("Error: --checkpoint needs the resolution engine and cannot be "
+           "combined with --count, --all, --backbone, --bdd, proofs, cores "
+           "or cube output\n");
+    return false;
+  }
+  return true;
+}
+
+// Function to read the input and run the mode the options ask for,
+// printing its result; returns the exit status
+int run_solver(SolverOptions *options) {
+  PropositionalFormula formula;
+  if (!init_formula(&formula)) {
+    set_display_color(ERROR_COLOR);
+    printf("Error: Failed to initialize formula\n");
+    set_display_color(DEFAULT_COLOR);
+    return 1;
+  }
+
+  double parse_start = stats_now();
+#ifdef LOGIC_SOLVER_TRACE
+  g_trace_origin = parse_start;
+#endif
+  TRACE_BEGIN("parse");
+  // A compiled BDD is loaded by the BDD mode instead
+  bool compiled = options->bdd && is_bdd_file(options->input_path);
+  CubeSet cubes;
+  if (!init_cubes(&cubes) ||
+      (!compiled &&
+       !read_formula_with_cubes(options->input_path, &formula, &cubes,
+                                options->cardinality,
+                                options->count || options->bdd))) {
+    set_display_color(ERROR_COLOR);
+    printf("Error: Failed to read formula from file\n");
+    set_display_color(DEFAULT_COLOR);
+    free_cubes(&cubes);
+    free_formula(&formula);
+    return 1;
+  }
+
+  g_stats.parse_time = stats_now() - parse_start;
+  TRACE_END("parse");
+
+  set_display_color(INFO_COLOR);
+  printf("\nAnalyzing formula...\n");
   set_display_color(DEFAULT_COLOR);
 
-  if (resolution(&formula)) {
+  if (options->verify_path) {
+    bool checked = check_model_file(&formula, options->verify_path);
+    free_cubes(&cubes);
+    free_formula(&formula);
+    return checked ? 0 : 1;
+  }
+
+  if (options->count) {
+    BigNum count = {0};
+    double count_start = stats_now();
+    bool counted = count_models(&formula, options, &count);
+    g_stats.solve_time = stats_now() - count_start;
+    char *text = counted ? bignum_to_string(&count) : NULL;
+    if (text) {
+      set_display_color(count.count > 0 ? SUCCESS_COLOR : ERROR_COLOR);
+      printf("\nResult: Formula is %s\n",
+             count.count > 0 ? "SATISFIABLE" : "UNSATISFIABLE");
+      set_display_color(DEFAULT_COLOR);
+      printf("Models: %s\n", text);
+      print_stats(options->stats_format,
+                  count.count > 0 ? "SATISFIABLE" : "UNSATISFIABLE");
+    } else if (counted) {
+      printf("Error: Out of memory\n");
+    }
+    free(text);
+    free_bignum(&count);
+    free_cubes(&cubes);
+    free_formula(&formula);
+    return text ? 0 : 1;
+  }
+
+  if (options->enumerate) {
+    unsigned long long solutions;
+    BigNum assignments = {0};
+    double enumerate_start = stats_now();
+    bool enumerated =
+        enumerate_models(&formula, options, &solutions, &assignments);
+    g_stats.solve_time = stats_now() - enumerate_start;
+    char *text = enumerated ? bignum_to_string(&assignments) : NULL;
+    if (text) {
+      set_display_color(solutions > 0 ? SUCCESS_COLOR : ERROR_COLOR);
+      printf("\nResult: Formula is %s\n",
+             solutions > 0 ? "SATISFIABLE" : "UNSATISFIABLE");
+      set_display_color(DEFAULT_COLOR);
+      printf("Solutions: %llu, covering %s %s\n", solutions, text,
+             options->project ? "projected assignments" : "models");
+      print_stats(options->stats_format,
+                  solutions > 0 ? "SATISFIABLE" : "UNSATISFIABLE");
+    } else if (enumerated) {
+      printf("Error: Out of memory\n");
+    }
+    free(text);
+    free_bignum(&assignments);
+    free_cubes(&cubes);
+    free_formula(&formula);
+    return text ? 0 : 1;
+  }
+
+  if (options->backbone) {
+    signed char *backbone;
+    double backbone_start = stats_now();
+    SolveResult result = backbone_formula(&formula, &backbone);
+    g_stats.solve_time = stats_now() - backbone_start;
+    if (result == RESULT_SAT) {
+      set_display_color(SUCCESS_COLOR);
+      printf("\nResult: Formula is SATISFIABLE\n");
+      set_display_color(DEFAULT_COLOR);
+      printf("Backbone: %llu of %d symbols\n", g_stats.backbone_literals,
+             formula.symbol_count);
+      print_backbone(&formula, backbone, options->model_format);
+    } else if (result == RESULT_UNSAT) {
+      set_display_color(ERROR_COLOR);
+      printf("\nResult: Formula is UNSATISFIABLE\n");
+      set_display_color(DEFAULT_COLOR);
+    }
+    if (result != RESULT_UNKNOWN)
+      print_stats(options->stats_format, result == RESULT_SAT
+                                            ? "SATISFIABLE"
+                                            : "UNSATISFIABLE");
+    free(backbone);
+    free_cubes(&cubes);
+    free_formula(&formula);
+    return result != RESULT_UNKNOWN ? 0 : 1;
+  }
+
+  if (options->bdd) {
+    SolveResult result = run_bdd(&formula, options, compiled);
+    if (result != RESULT_UNKNOWN)
+      print_stats(options->stats_format, result == RESULT_SAT
+                                            ? "SATISFIABLE"
+                                            : "UNSATISFIABLE");
+    free_cubes(&cubes);
+    free_formula(&formula);
+    return result != RESULT_UNKNOWN ? 0 : 1;
+  }
+
+  if (options->cube_path) {
+    bool refuted_all;
+    double cube_start = stats_now();
+    bool written = write_cubes(&formula, options, &refuted_all);
+    g_stats.solve_time = stats_now() - cube_start;
+    if (written && refuted_all) {
+      set_display_color(ERROR_COLOR);
+      printf("\nResult: Formula is UNSATISFIABLE\n");
+      set_display_color(DEFAULT_COLOR);
+    }
+    if (written)
+      print_stats(options->stats_format,
+                  refuted_all ? "UNSATISFIABLE" : "UNKNOWN");
+    free_cubes(&cubes);
+    free_formula(&formula);
+    return written ? 0 : 1;
+  }
+
+  double solve_start = stats_now();
+  TRACE_BEGIN("solve");
+  bool *model;
+  bool *core = calloc(formula.clause_count + 1, sizeof(bool));
+  SolveResult result =
+      core ? solve_formula(&formula, options, &cubes, &model, core)
+           : RESULT_UNKNOWN;
+  if (!core)
+    model = NULL;
+  TRACE_END("solve");
+  g_stats.solve_time = stats_now() - solve_start;
+  free_cubes(&cubes);
+  if (result == RESULT_ERROR) {
+    free(model);
+    free(core);
+    free_formula(&formula);
+    return 1;
+  }
+
+  // Never report a model that does not satisfy the input
+  int falsified =
+      result == RESULT_SAT ? verify_model(&formula, model, NULL) : -1;
+  if (falsified >= 0) {
+    set_display_color(ERROR_COLOR);
+    printf("\nError: Model check failed on clause %d\n", falsified + 1);
+    set_display_color(DEFAULT_COLOR);
+    result = RESULT_UNKNOWN;
+  }
+
+  if (result == RESULT_SAT && g_stats.soft_clauses > 0) {
+    // The cost is recomputed from the input, like the model check above
+    unsigned long long cost = model_cost(&formula, model, NULL);
+    set_display_color(SUCCESS_COLOR);
+    if (cost <= g_stats.cost_lower_bound)
+      printf("\nResult: Hard clauses are SATISFIABLE, optimum cost %llu\n",
+             cost);
+    else
+      printf("\nResult: Hard clauses are SATISFIABLE, best cost %llu when "
+             "the time limit ran out (lower bound %llu)\n",
+             cost, g_stats.cost_lower_bound);
+  } else if (result == RESULT_UNSAT && g_stats.soft_clauses > 0) {
+    set_display_color(ERROR_COLOR);
+    printf("\nResult: Hard clauses are UNSATISFIABLE\n");
+  } else if (result == RESULT_SAT) {
     set_display_color(SUCCESS_COLOR);
     printf("\nResult: Formula is SATISFIABLE\n");
-  } else {
+  } else if (result == RESULT_UNSAT) {
     set_display_color(ERROR_COLOR);
     printf("\nResult: Formula is UNSATISFIABLE\n");
+  } else {
+    set_display_color(INFO_COLOR);
+    printf("\nResult: UNKNOWN (%s)\n",
+           g_stats.unknown_reason ? g_stats.unknown_reason
+                                  : "search budget or memory exhausted");
   }
   set_display_color(DEFAULT_COLOR);
 
+  if (result == RESULT_SAT)
+    print_model(&formula, model, options->model_format);
+  free(model);
+
+  if (result == RESULT_UNSAT && options->core_mode != CORE_NONE)
+    print_core(&formula, options, core);
+  free(core);
+
+  print_stats(options->stats_format,
+              result == RESULT_SAT     ? "SATISFIABLE"
+              : result == RESULT_UNSAT ? "UNSATISFIABLE"
+                                       : "UNKNOWN");
+
   free_formula(&formula);
   return 0;
 }
+
+// Main function
+int main(int argc, char *argv[]) {
+  display_header();
+
+  SolverOptions options;
+  if (!parse_args(argc, argv, &options)) {
+    set_display_color(ERROR_COLOR);
+    printf("Usage: %s [--stats[=text|json]] [--trace=FILE] "
+           "[--engine=auto|resolution|walksat|probsat|cdcl|cubes] "
+           "[--seed=N] [--flips=N] [--restart-interval=N] [--threads=N] "
+           "[--cube=FILE] [--cubes=N] [--model=v|json|none] "
+           "[--verify=MODEL] [--proof=FILE] "
+           "[--proof-format=lrat|drat|lrat-text|drat-text] "
+           "[--core] [--mus] [--core-file=FILE] [--time-limit=SECONDS] "
+           "[--count] [--cache-mb=N] [--all] [--project=LIST] [--backbone] "
+           "[--bdd] [--bdd-order=force|occurrence|input] [--sift] "
+           "[--bdd-save=FILE] [--query=FILE] [--equivalent=FILE] "
+           "[--cardinality=sequential|totalizer|network] [--symmetry] "
+           "[--checkpoint=FILE] [--checkpoint-interval=SECONDS] [--resume] "
+           "<input_file.cnf>\n",
+           argv[0]);
+    set_display_color(DEFAULT_COLOR);
+    return 1;
+  }
+
+#ifdef LOGIC_SOLVER_TRACE
+  g_trace_enabled = options.trace_path != NULL;
+#endif
+  int status = run_solver(&options);
+
+  // Written here so that every mode, and a run that failed, leaves a trace
+#ifdef LOGIC_SOLVER_TRACE
+  if (options.trace_path && !trace_write(options.trace_path)) {
+    set_display_color(ERROR_COLOR);
+    printf("Error: Unable to write trace file %s\n", options.trace_path);
+    set_display_color(DEFAULT_COLOR);
+  }
+#endif
+  return status;
+}
+#endif
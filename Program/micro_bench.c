@@ -0,0 +1,330 @@
+/*
+ * Microbenchmarks for the Logic Solver's clause-level primitives
+ * Measures ns/op of the functions that dominate resolution() runtime
+ */
+
+#ifndef _WIN32
+#define _GNU_SOURCE
+#include <sched.h>
+#endif
+
+#include <math.h>
+
+#define LOGIC_SOLVER_NO_MAIN
+#include "logic_solver.c"
+
+// Configuration constants
+#define MAX_WIDTHS 16
+#define MAX_TABLE_SIZES 16
+#define MAX_SAMPLES 1000
+#define DEFAULT_SAMPLES 15
+#define SAMPLE_TARGET_SECONDS 0.01
+
+// Structure for the microbenchmark options
+typedef struct {
+  int widths[MAX_WIDTHS];
+  int width_count;
+  int table_sizes[MAX_TABLE_SIZES];
+  int table_size_count;
+  int samples;
+  int cpu;
+  const char *filter;
+} MicroOptions;
+
+// Structure holding the clauses and symbol table one benchmark works on
+typedef struct {
+  PropositionClause left;
+  PropositionClause right;
+  PropositionClause equal;
+  int *left_codes; // left and right as sorted literal codes
+  int *right_codes;
+  Resolvent scratch;
+  PropositionalFormula table;
+  const char *pivot;
+  const char *missing;
+  int table_size;
+} MicroFixture;
+
+typedef void (*MicroFunction)(MicroFixture *fixture, long iterations);
+
+// Keeps results observable so the compiler cannot drop the measured calls
+static volatile long g_sink;
+
+// Function to pin the calling thread to one CPU
+bool pin_to_cpu(int cpu) {
+#ifdef _WIN32
+  return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu) != 0;
+#else
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return sched_setaffinity(0, sizeof(set), &set) == 0;
+#endif
+}
+
+// Function to build clauses of the given width sharing one pivot variable
+bool init_fixture(MicroFixture *fixture, int width, int table_size) {
+  char name[MAX_SYMBOL_LEN];
+
+  memset(fixture, 0, sizeof(*fixture));
+  fixture->left_codes = malloc(width * sizeof(int));
+  fixture->right_codes = malloc(width * sizeof(int));
+  fixture->scratch.literals = malloc(2 * width * sizeof(int));
+  if (!fixture->left_codes || !fixture->right_codes ||
+      !fixture->scratch.literals || !init_clause(&fixture->left) ||
+      !init_clause(&fixture->right) || !init_clause(&fixture->equal) ||
+      !init_formula(&fixture->table))
+    return false;
+
+  // left = v0 a1 .. a(w-1), right = !v0 b1 .. b(w-1); equal mirrors left
+  // in reverse order so clauses_equal cannot exit on the first term
+  add_term(&fixture->left, "v0", false);
+  add_term(&fixture->right, "v0", true);
+  for (int i = 1; i < width; i++) {
+    snprintf(name, sizeof(name), "a%d", i);
+    add_term(&fixture->left, name, i % 2 == 0);
+    snprintf(name, sizeof(name), "b%d", i);
+    add_term(&fixture->right, name, i % 3 == 0);
+  }
+  // The same clauses as codes: v0 is variable 1, a<i> is 2i and b<i> is
+  // 2i + 1, so the two clauses interleave through the whole merge
+  fixture->left_codes[0] = 2;
+  fixture->right_codes[0] = 3;
+  for (int i = 1; i < width; i++) {
+    fixture->left_codes[i] = 2 * (2 * i) + (i % 2 == 0);
+    fixture->right_codes[i] = 2 * (2 * i + 1) + (i % 3 == 0);
+  }
+  for (int i = fixture->left.term_count - 1; i >= 0; i--) {
+    add_term(&fixture->equal, fixture->left.terms[i].symbol.symbol,
+             fixture->left.terms[i].is_negated);
+  }
+
+  for (int i = 0; i < table_size; i++) {
+    snprintf(name, sizeof(name), "sym_%d", i);
+    if (find_or_add_symbol(&fixture->table, name) < 0)
+      return false;
+  }
+
+  fixture->pivot = "v0";
+  fixture->missing = "absent";
+  fixture->table_size = table_size;
+  return true;
+}
+
+// Function to release a fixture
+void free_fixture(MicroFixture *fixture) {
+  free_clause(&fixture->left);
+  free_clause(&fixture->right);
+  free_clause(&fixture->equal);
+  free(fixture->left_codes);
+  free(fixture->right_codes);
+  free(fixture->scratch.literals);
+  free_formula(&fixture->table);
+}
+
+// Benchmarked operations
+
+void bench_resolve(MicroFixture *fixture, long iterations) {
+  for (long i = 0; i < iterations; i++) {
+    PropositionClause resolvant;
+    g_sink += resolve(&fixture->left, &fixture->right, fixture->pivot, false,
+                      &resolvant);
+    g_sink += resolvant.term_count;
+    free_clause(&resolvant);
+  }
+}
+
+void bench_resolvent_merge(MicroFixture *fixture, long iterations) {
+  int width = fixture->left.term_count;
+  for (long i = 0; i < iterations; i++) {
+    g_sink += resolvent_merge(fixture->left_codes, width,
+                              fixture->right_codes, width, &fixture->scratch);
+    g_sink += fixture->scratch.count;
+  }
+}
+
+void bench_clauses_equal(MicroFixture *fixture, long iterations) {
+  for (long i = 0; i < iterations; i++)
+    g_sink += clauses_equal(&fixture->left, &fixture->equal);
+}
+
+void bench_is_tautology(MicroFixture *fixture, long iterations) {
+  for (long i = 0; i < iterations; i++)
+    g_sink += is_tautology(&fixture->left);
+}
+
+void bench_clause_contains(MicroFixture *fixture, long iterations) {
+  for (long i = 0; i < iterations; i++)
+    g_sink += clause_contains(&fixture->left, fixture->missing, false);
+}
+
+void bench_find_or_add_symbol(MicroFixture *fixture, long iterations) {
+  char name[MAX_SYMBOL_LEN];
+  snprintf(name, sizeof(name), "sym_%d", fixture->table_size - 1);
+  for (long i = 0; i < iterations; i++)
+    g_sink += find_or_add_symbol(&fixture->table, name);
+}
+
+void bench_copy_clause(MicroFixture *fixture, long iterations) {
+  for (long i = 0; i < iterations; i++) {
+    PropositionClause copy;
+    g_sink += copy_clause(&copy, &fixture->left);
+    free_clause(&copy);
+  }
+}
+
+// Structure describing one benchmarked primitive
+typedef struct {
+  const char *name;
+  MicroFunction function;
+  bool uses_table;
+} MicroBenchmark;
+
+static const MicroBenchmark MICRO_BENCHMARKS[] = {
+    {"resolve", bench_resolve, false},
+    {"resolvent_merge", bench_resolvent_merge, false},
+    {"clauses_equal", bench_clauses_equal, false},
+    {"is_tautology", bench_is_tautology, false},
+    {"clause_contains", bench_clause_contains, false},
+    {"find_or_add_symbol", bench_find_or_add_symbol, true},
+    {"copy_clause", bench_copy_clause, false},
+};
+#define MICRO_COUNT                                                            \
+  ((int)(sizeof(MICRO_BENCHMARKS) / sizeof(MICRO_BENCHMARKS[0])))
+
+// Function to time one benchmark and print mean, deviation and minimum
+void run_micro(const MicroOptions *options, const MicroBenchmark *benchmark,
+               MicroFixture *fixture, int width) {
+  static double samples[MAX_SAMPLES];
+
+  // Calibrate the batch size so one sample lasts about 10 ms
+  long iterations = 1;
+  while (true) {
+    double start = stats_now();
+    benchmark->function(fixture, iterations);
+    double elapsed = stats_now() - start;
+    if (elapsed >= SAMPLE_TARGET_SECONDS / 4 || iterations > (1L << 30))
+      break;
+    iterations *= 2;
+  }
+  iterations *= 4;
+
+  double sum = 0.0, min_ns = 0.0;
+  for (int s = 0; s < options->samples; s++) {
+    double start = stats_now();
+    benchmark->function(fixture, iterations);
+    samples[s] = (stats_now() - start) * 1e9 / (double)iterations;
+    sum += samples[s];
+    if (s == 0 || samples[s] < min_ns)
+      min_ns = samples[s];
+  }
+
+  double mean = sum / options->samples;
+  double variance = 0.0;
+  for (int s = 0; s < options->samples; s++)
+    variance += (samples[s] - mean) * (samples[s] - mean);
+  variance /= options->samples > 1 ? options->samples - 1 : 1;
+
+  printf("%-20s %6d %8d %12.2f %10.2f %10.2f %12ld\n", benchmark->name,
+         benchmark->uses_table ? 0 : width,
+         benchmark->uses_table ? fixture->table_size : 0, mean, sqrt(variance),
+         min_ns, iterations);
+}
+
+// Function to parse a comma-separated list of positive integers
+int parse_int_list(const char *text, int *values, int max_values) {
+  int count = 0;
+  while (*text && count < max_values) {
+    int value = atoi(text);
+    if (value <= 0)
+      return 0;
+    values[count++] = value;
+    text = strchr(text, ',');
+    if (!text)
+      break;
+    text++;
+  }
+  return count;
+}
+
+// Function to parse command line arguments
+bool parse_micro_args(int argc, char *argv[], MicroOptions *options) {
+  static const int default_widths[] = {2, 4, 8, 16, 32, 64};
+  static const int default_tables[] = {16, 256, 4096};
+
+  options->width_count = 6;
+  memcpy(options->widths, default_widths, sizeof(default_widths));
+  options->table_size_count = 3;
+  memcpy(options->table_sizes, default_tables, sizeof(default_tables));
+  options->samples = DEFAULT_SAMPLES;
+  options->cpu = -1;
+  options->filter = NULL;
+
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    if (strncmp(arg, "--widths=", 9) == 0) {
+      options->width_count = parse_int_list(arg + 9, options->widths,
+                                            MAX_WIDTHS);
+    } else if (strncmp(arg, "--symbols=", 10) == 0) {
+      options->table_size_count = parse_int_list(arg + 10,
+                                                 options->table_sizes,
+                                                 MAX_TABLE_SIZES);
+    } else if (strncmp(arg, "--samples=", 10) == 0) {
+      options->samples = atoi(arg + 10);
+    } else if (strncmp(arg, "--cpu=", 6) == 0) {
+      options->cpu = atoi(arg + 6);
+    } else if (strncmp(arg, "--filter=", 9) == 0) {
+      options->filter = arg + 9;
+    } else {
+      printf("Usage: %s [--widths=2,4,..] [--symbols=16,256,..] "
+             "[--samples=N] [--cpu=N] [--filter=NAME]\n",
+             argv[0]);
+      return false;
+    }
+  }
+
+  if (options->width_count == 0 || options->table_size_count == 0 ||
+      options->samples < 2 || options->samples > MAX_SAMPLES) {
+    printf("Invalid parameters. Widths and symbol counts must be positive, "
+           "samples 2-%d\n",
+           MAX_SAMPLES);
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  MicroOptions options;
+  if (!parse_micro_args(argc, argv, &options)) {
+    return 1;
+  }
+
+  if (options.cpu >= 0 && !pin_to_cpu(options.cpu)) {
+    printf("Warning: Unable to pin to CPU %d\n", options.cpu);
+  }
+
+  printf("%-20s %6s %8s %12s %10s %10s %12s\n", "primitive", "width",
+         "symbols", "mean_ns/op", "stddev", "min", "batch");
+
+  for (int b = 0; b < MICRO_COUNT; b++) {
+    const MicroBenchmark *benchmark = &MICRO_BENCHMARKS[b];
+    if (options.filter && strcmp(options.filter, benchmark->name) != 0)
+      continue;
+
+    // Symbol lookups vary with the table size, everything else with width
+    int runs = benchmark->uses_table ? options.table_size_count
+                                     : options.width_count;
+    for (int r = 0; r < runs; r++) {
+      MicroFixture fixture;
+      int width = benchmark->uses_table ? 1 : options.widths[r];
+      int table_size = benchmark->uses_table ? options.table_sizes[r] : 1;
+      if (!init_fixture(&fixture, width, table_size)) {
+        printf("Error: Out of memory\n");
+        return 1;
+      }
+      run_micro(&options, benchmark, &fixture, width);
+      free_fixture(&fixture);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,374 @@
+/*
+ * Forward checker for the Logic Solver's refutation proofs
+ * Verifies text or binary LRAT against a formula in time linear in the
+ * size of the proof
+ */
+
+#include <limits.h>
+
+#define LOGIC_SOLVER_NO_MAIN
+#include "logic_solver.c"
+
+// Configuration constants
+#define CHECK_INITIAL_IDS 1024
+
+// Clauses of the formula and the proof by id, and the partial assignment
+// of the step being checked
+typedef struct {
+  IntArray literals; // [size, literals...] per clause, by external number
+  int *offset;       // by clause id: start in literals, -1 when absent
+  int id_capacity;
+  signed char *values; // by lit_index(): 1 true, -1 false, 0 unassigned
+  int variable_capacity;
+  IntArray assigned;   // literals assigned by the current step
+  unsigned long long steps;
+  bool refuted;
+} LratChecker;
+
+// Proof being read, in either encoding
+typedef struct {
+  FILE *file;
+  bool binary;
+  bool eof;
+} ProofReader;
+
+// Function to make room for clause ids up to id
+bool checker_reserve_id(LratChecker *checker, int id) {
+  if (id < checker->id_capacity)
+    return true;
+  int capacity = checker->id_capacity ? checker->id_capacity
+                                       : CHECK_INITIAL_IDS;
+  while (capacity <= id)
+    capacity *= EXPANSION_RATE;
+  int *offset = realloc(checker->offset, capacity * sizeof(int));
+  if (!offset)
+    return false;
+  for (int i = checker->id_capacity; i < capacity; i++)
+    offset[i] = -1;
+  checker->offset = offset;
+  checker->id_capacity = capacity;
+  return true;
+}
+
+// Function to make room for variables up to var
+bool checker_reserve_variable(LratChecker *checker, int var) {
+  if (var < checker->variable_capacity)
+    return true;
+  int capacity = checker->variable_capacity ? checker->variable_capacity
+                                             : BASE_SIZE;
+  while (capacity <= var)
+    capacity *= EXPANSION_RATE;
+  signed char *values = realloc(checker->values, 2 * (size_t)capacity);
+  if (!values)
+    return false;
+  memset(values + 2 * checker->variable_capacity, 0,
+         2 * (size_t)(capacity - checker->variable_capacity));
+  checker->values = values;
+  checker->variable_capacity = capacity;
+  return true;
+}
+
+// Function to store a clause under an id that must be unused
+bool checker_add(LratChecker *checker, int id, const int *lits, int count) {
+  if (id <= 0 || !checker_reserve_id(checker, id)) {
+    printf("Error: Invalid clause id %d\n", id);
+    return false;
+  }
+  if (checker->offset[id] >= 0) {
+    printf("Error: Clause id %d is used twice\n", id);
+    return false;
+  }
+  checker->offset[id] = checker->literals.count;
+  if (!int_array_push(&checker->literals, count))
+    return false;
+  for (int i = 0; i < count; i++) {
+    if (!checker_reserve_variable(checker, lit_var(lits[i])) ||
+        !int_array_push(&checker->literals, lits[i]))
+      return false;
+  }
+  if (count == 0)
+    checker->refuted = true;
+  return true;
+}
+
+// Function to make a literal true for the current step
+static inline void checker_assign(LratChecker *checker, int lit) {
+  checker->values[lit_index(lit)] = 1;
+  checker->values[lit_index(-lit)] = -1;
+  int_array_push(&checker->assigned, lit);
+}
+
+// Function to clear the assignment of the current step
+void checker_reset(LratChecker *checker) {
+  for (int i = 0; i < checker->assigned.count; i++) {
+    int lit = checker->assigned.items[i];
+    checker->values[lit_index(lit)] = 0;
+    checker->values[lit_index(-lit)] = 0;
+  }
+  checker->assigned.count = 0;
+}
+
+// Function to load the formula's clauses as ids 1, 2, ... with the
+// variable numbers the solver writes
+bool checker_load(LratChecker *checker, PropositionalFormula *formula) {
+  IndexedFormula indexed;
+  if (!build_indexed_formula(formula, &indexed))
+    return false;
+  int *number = external_numbers(formula, NULL);
+  bool ok = number != NULL;
+  for (int c = 0; c < indexed.clause_count && ok; c++) {
+    int start = indexed.clause_start[c];
+    int count = indexed.clause_start[c + 1] - start;
+    for (int i = 0; i < count; i++) {
+      int lit = indexed.literals[start + i];
+      indexed.literals[start + i] = lit > 0 ? number[lit] : -number[-lit];
+    }
+    ok = checker_add(checker, c + 1, indexed.literals + start, count);
+  }
+  free(number);
+  free_indexed_formula(&indexed);
+  return ok;
+}
+
+// Function to read the next number of a proof. In text, a "d" marker is
+// returned as *deletion with no number. Returns false at the end of the
+// file or on malformed input, setting reader->eof only for the former.
+bool read_proof_number(ProofReader *reader, long long *n, bool *deletion) {
+  *deletion = false;
+  if (reader->binary) {
+    unsigned long long code = 0;
+    int shift = 0, c;
+    do {
+      if ((c = getc(reader->file)) == EOF || shift > 56)
+        return false;
+      code |= (unsigned long long)(c & 127) << shift;
+      shift += 7;
+    } while (c & 128);
+    *n = code & 1 ? -(long long)(code >> 1) : (long long)(code >> 1);
+    return true;
+  }
+
+  int c = getc(reader->file);
+  while (c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == 'c') {
+    if (c == 'c') // comment line
+      while (c != '\n' && c != EOF)
+        c = getc(reader->file);
+    c = getc(reader->file);
+  }
+  if (c == EOF) {
+    reader->eof = true;
+    return false;
+  }
+  if (c == 'd') {
+    *deletion = true;
+    return true;
+  }
+  ungetc(c, reader->file);
+  return fscanf(reader->file, "%lld", n) == 1;
+}
+
+// Function to read a 0-terminated list of numbers into list
+bool read_proof_list(ProofReader *reader, IntArray *list) {
+  list->count = 0;
+  long long n;
+  bool deletion;
+  while (read_proof_number(reader, &n, &deletion) && !deletion) {
+    if (n == 0)
+      return true;
+    if (n > INT_MAX || n < -INT_MAX || !int_array_push(list, (int)n))
+      return false;
+  }
+  return false;
+}
+
+// Function to check one added clause by reverse unit propagation: with its
+// literals false, every hint must become unit, and the last one false
+bool check_lemma(LratChecker *checker, int id, const IntArray *lits,
+                 const IntArray *hints) {
+  bool tautology = false;
+  for (int i = 0; i < lits->count; i++) {
+    int lit = lits->items[i];
+    if (!checker_reserve_variable(checker, lit_var(lit)))
+      return false;
+    if (checker->values[lit_index(lit)] == 1)
+      tautology = true;
+    else if (checker->values[lit_index(lit)] == 0)
+      checker_assign(checker, -lit);
+  }
+
+  bool conflict = tautology, rejected = false;
+  for (int h = 0; h < hints->count && !conflict; h++) {
+    int hint = hints->items[h];
+    if (hint < 0) {
+      printf("Error: Step %d uses a RAT hint, which is not supported\n", id);
+      rejected = true;
+      break;
+    }
+    if (hint >= checker->id_capacity || checker->offset[hint] < 0) {
+      printf("Error: Step %d refers to missing clause %d\n", id, hint);
+      rejected = true;
+      break;
+    }
+    const int *clause = checker->literals.items + checker->offset[hint];
+    int unassigned = 0, unit = 0;
+    bool satisfied = false;
+    for (int k = 1; k <= clause[0] && !satisfied; k++) {
+      signed char value = checker->values[lit_index(clause[k])];
+      satisfied = value == 1;
+      if (value == 0 && clause[k] != unit) {
+        unassigned++;
+        unit = clause[k];
+      }
+    }
+    if (satisfied || unassigned > 1) {
+      printf("Error: Step %d: hint %d is not unit\n", id, hint);
+      rejected = true;
+      break;
+    }
+    if (unassigned == 0)
+      conflict = true;
+    else
+      checker_assign(checker, unit);
+  }
+  checker_reset(checker);
+
+  if (!conflict) {
+    if (!rejected)
+      printf("Error: Step %d is not implied by its hints\n", id);
+    return false;
+  }
+  return checker_add(checker, id, lits->items, lits->count);
+}
+
+// Function to check a whole proof, stopping at the empty clause
+bool check_proof(LratChecker *checker, ProofReader *reader) {
+  IntArray lits = {0}, hints = {0};
+  bool ok = true;
+  while (ok && !checker->refuted) {
+    long long id;
+    bool deletion = false;
+    if (reader->binary) {
+      int kind = getc(reader->file);
+      if (kind == EOF)
+        break;
+      deletion = kind == 'd';
+      if (kind != 'a' && kind != 'd') {
+        printf("Error: Unknown binary proof step 0x%02x\n", kind);
+        ok = false;
+        break;
+      }
+      if (deletion) {
+        ok = read_proof_list(reader, &hints);
+        for (int i = 0; ok && i < hints.count; i++) {
+          if (hints.items[i] > 0 && hints.items[i] < checker->id_capacity)
+            checker->offset[hints.items[i]] = -1;
+        }
+        continue;
+      }
+      ok = read_proof_number(reader, &id, &deletion);
+    } else {
+      bool marker;
+      if (!read_proof_number(reader, &id, &marker)) {
+        ok = reader->eof;
+        break;
+      }
+      // "<id> d <ids> 0" deletes, "<id> <literals> 0 <hints> 0" adds
+      long long first;
+      if (!read_proof_number(reader, &first, &deletion)) {
+        ok = false;
+        break;
+      }
+      if (deletion) {
+        ok = read_proof_list(reader, &hints);
+        for (int i = 0; ok && i < hints.count; i++) {
+          if (hints.items[i] > 0 && hints.items[i] < checker->id_capacity)
+            checker->offset[hints.items[i]] = -1;
+        }
+        continue;
+      }
+      lits.count = 0;
+      if (first != 0) {
+        if (!int_array_push(&lits, (int)first) ||
+            !read_proof_list(reader, &hints)) {
+          ok = false;
+          break;
+        }
+        for (int i = 0; i < hints.count && ok; i++)
+          ok = int_array_push(&lits, hints.items[i]);
+      }
+      ok = ok && read_proof_list(reader, &hints) &&
+           check_lemma(checker, (int)id, &lits, &hints);
+      checker->steps++;
+      continue;
+    }
+
+    ok = ok && id > 0 && id <= INT_MAX && read_proof_list(reader, &lits) &&
+         read_proof_list(reader, &hints) &&
+         check_lemma(checker, (int)id, &lits, &hints);
+    checker->steps++;
+  }
+  free_int_array(&lits);
+  free_int_array(&hints);
+  return ok;
+}
+
+// Function to free a checker
+void free_checker(LratChecker *checker) {
+  free_int_array(&checker->literals);
+  free_int_array(&checker->assigned);
+  free(checker->offset);
+  free(checker->values);
+}
+
+// Main function
+int main(int argc, char *argv[]) {
+  // Cardinality constraints must be encoded as they were when solving
+  CardinalityEncoding encoding = CARD_SEQUENTIAL;
+  if ((argc != 3 && argc != 4) ||
+      (argc == 4 && (strncmp(argv[3], "--cardinality=", 14) != 0 ||
+                     !parse_cardinality_encoding(argv[3] + 14, &encoding)))) {
+    printf("Usage: %s <input_file.cnf> <proof.lrat> "
+           "[--cardinality=sequential|totalizer|network]\n",
+           argv[0]);
+    return 1;
+  }
+
+  PropositionalFormula formula;
+  if (!read_formula_with_cubes(argv[1], &formula, NULL, encoding, false)) {
+    printf("Error: Failed to read formula from file\n");
+    return 1;
+  }
+
+  ProofReader reader = {fopen(argv[2], "rb"), false, false};
+  if (!reader.file) {
+    printf("Error: Unable to open proof file %s\n", argv[2]);
+    free_formula(&formula);
+    return 1;
+  }
+  // Binary steps start with an "a" or "d" byte, text ones with an id
+  int first = getc(reader.file);
+  reader.binary = first == 'a' || first == 'd';
+  ungetc(first, reader.file);
+
+  LratChecker checker;
+  memset(&checker, 0, sizeof(checker));
+  double start = stats_now();
+  bool ok = checker_load(&checker, &formula);
+  if (!ok)
+    printf("Error: Out of memory\n");
+  ok = ok && check_proof(&checker, &reader);
+  fclose(reader.file);
+
+  if (ok && checker.refuted) {
+    printf("Proof verified in %.3f s: %llu steps derive the empty clause\n",
+           stats_now() - start, checker.steps);
+  } else if (ok) {
+    printf("Error: The proof does not derive the empty clause\n");
+  } else {
+    printf("Error: Proof rejected after %llu steps\n", checker.steps);
+  }
+
+  free_checker(&checker);
+  free_formula(&formula);
+  return ok && checker.refuted ? 0 : 1;
+}